@@ -0,0 +1,302 @@
+#include "BedrockRecordModel.h"
+
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+#include "bedrock_db.h"
+#include "bedrock_keys.h"
+}
+
+namespace {
+constexpr int kBatchRecords = 4096;
+constexpr int kCancelCheckInterval = 4096;
+
+QString keyLabel(const unsigned char* key, size_t size) {
+    bool printable = size > 0;
+    for (size_t index = 0; index < size; ++index) {
+        if (key[index] < 0x20 || key[index] > 0x7e) {
+            printable = false;
+            break;
+        }
+    }
+    if (printable) {
+        return QString::fromLatin1(
+            reinterpret_cast<const char*>(key), static_cast<qsizetype>(size));
+    }
+
+    BedrockChunkKey chunk;
+    if (bedrock_chunk_key_parse(key, size, &chunk)) {
+        const QString record = QString::fromLatin1(bedrock_chunk_record_name(chunk.tag));
+        QString result = chunk.dimension != BEDROCK_DIMENSION_OVERWORLD
+            ? QObject::tr("Chunk (%1, %2), dimension %3, %4")
+                .arg(chunk.x).arg(chunk.z).arg(chunk.dimension).arg(record)
+            : QObject::tr("Chunk (%1, %2), %3").arg(chunk.x).arg(chunk.z).arg(record);
+        if (chunk.has_subchunk) result += QObject::tr(", subchunk %1").arg(static_cast<int>(chunk.subchunk));
+        return result;
+    }
+
+    return QObject::tr("%1: %2").arg(
+        QString::fromLatin1(bedrock_key_kind(key, size)),
+        QString::fromLatin1(QByteArray(reinterpret_cast<const char*>(key), size).toHex(' ')));
+}
+}  // namespace
+
+struct BedrockRecordModel::LoadContext {
+    BedrockRecordModel* model;
+    const std::atomic_bool* cancelled;
+    std::shared_ptr<Batch> batch;
+};
+
+BedrockRecordModel::BedrockRecordModel(QObject* parent) : QAbstractTableModel(parent) {}
+
+BedrockRecordModel::~BedrockRecordModel() {
+    workers_.stop();
+}
+
+// Runs on the loader thread; full batches are handed to the model as they fill.
+int BedrockRecordModel::collectRecord(
+    const unsigned char* key,
+    size_t keySize,
+    size_t valueSize,
+    const unsigned char* valuePrefix,
+    size_t valuePrefixSize,
+    void* userData
+) {
+    auto* context = static_cast<LoadContext*>(userData);
+    if (context->cancelled->load()) return 0;
+
+    Batch& batch = *context->batch;
+    batch.records.push_back({static_cast<int>(batch.keys.size()), static_cast<int>(keySize),
+                             static_cast<quint64>(valueSize), valuePrefixSize > 0 && valuePrefix[0] == 10});
+    batch.keys.append(reinterpret_cast<const char*>(key), static_cast<qsizetype>(keySize));
+    if (batch.records.size() < static_cast<size_t>(kBatchRecords)) return 1;
+
+    std::shared_ptr<const Batch> full = std::move(context->batch);
+    context->batch = std::make_shared<Batch>();
+    context->batch->records.reserve(kBatchRecords);
+    BedrockRecordModel* model = context->model;
+    QMetaObject::invokeMethod(model, [model, full] { model->appendBatch(full); }, Qt::QueuedConnection);
+    return 1;
+}
+
+void BedrockRecordModel::load(BedrockDB* database) {
+    loading_ = true;
+    workers_.run([this, database](const std::atomic_bool& cancelled) {
+        LoadContext context{this, &cancelled, std::make_shared<Batch>()};
+        context.batch->records.reserve(kBatchRecords);
+        // Only the first value byte is needed to guess the kind; a full listing
+        // would only evict useful blocks from the cache.
+        BedrockDBScanOptions options{};
+        options.value_prefix_size = 1;
+        char backendError[512]{};
+        const bool listed = bedrock_db_scan(
+            database, &options, collectRecord, &context, backendError, sizeof(backendError));
+        bedrock_db_close(database);
+        if (cancelled.load()) return;
+
+        std::shared_ptr<const Batch> rest = std::move(context.batch);
+        const QString error = listed ? QString() : QString::fromUtf8(backendError);
+        QMetaObject::invokeMethod(this, [this, rest, error] {
+            if (!rest->records.empty()) appendBatch(rest);
+            finishLoad(error);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void BedrockRecordModel::appendBatch(const std::shared_ptr<const Batch>& batch) {
+    batches_.push_back(batch);
+    recordCount_ += static_cast<int>(batch->records.size());
+    if (filter_.isEmpty() && sortColumn_ < 0 && !jobCancelled_) {
+        // Database order, unfiltered: the new records are simply the next rows.
+        beginInsertRows(QModelIndex(), static_cast<int>(rows_.size()),
+                        static_cast<int>(rows_.size()) + recordCount_ - covered_ - 1);
+        for (int id = covered_; id < recordCount_; ++id) rows_.push_back(id);
+        covered_ = recordCount_;
+        endInsertRows();
+    } else if (!jobCancelled_) {
+        startJob(sortColumn_ >= 0);
+    }
+    emit statusChanged();
+}
+
+void BedrockRecordModel::finishLoad(const QString& error) {
+    loading_ = false;
+    loadError_ = error;
+    emit statusChanged();
+}
+
+void BedrockRecordModel::setFilterText(const QString& text) {
+    if (text == filter_) return;
+    filter_ = text;
+    startJob(true);
+}
+
+void BedrockRecordModel::sort(int column, Qt::SortOrder order) {
+    if (column == sortColumn_ && order == sortOrder_) return;
+    sortColumn_ = column;
+    sortOrder_ = order;
+    startJob(true);
+}
+
+/*
+ * Recomputes the rows for records [first, end) on a worker. A reset job
+ * replaces every row; otherwise the result is appended. Only one job runs at
+ * a time, and records that arrive meanwhile are picked up when it finishes.
+ */
+void BedrockRecordModel::startJob(bool reset) {
+    if (jobCancelled_) jobCancelled_->store(true);
+    const int generation = ++generation_;
+    const int first = reset ? 0 : covered_;
+    const int end = recordCount_;
+    Batches batches = batches_;
+    const QString filter = filter_;
+    const int column = sortColumn_;
+    const Qt::SortOrder order = sortOrder_;
+    jobCancelled_ = workers_.run([this, generation, reset, first, end, batches = std::move(batches), filter,
+                               column, order](const std::atomic_bool& cancelled) {
+        std::vector<int> rows = selectRows(batches, first, end, filter, column, order, cancelled);
+        if (cancelled.load()) return;
+        QMetaObject::invokeMethod(this, [this, generation, reset, end, rows = std::move(rows)]() mutable {
+            finishJob(generation, reset, end, std::move(rows));
+        }, Qt::QueuedConnection);
+    });
+    emit statusChanged();
+}
+
+void BedrockRecordModel::finishJob(int generation, bool reset, int end, std::vector<int> rows) {
+    if (generation != generation_) return;
+    jobCancelled_.reset();
+    if (reset) {
+        beginResetModel();
+        rows_ = std::move(rows);
+        endResetModel();
+    } else if (!rows.empty()) {
+        beginInsertRows(QModelIndex(), static_cast<int>(rows_.size()),
+                        static_cast<int>(rows_.size() + rows.size()) - 1);
+        rows_.insert(rows_.end(), rows.begin(), rows.end());
+        endInsertRows();
+    }
+    covered_ = end;
+    if (covered_ < recordCount_) {
+        startJob(sortColumn_ >= 0);
+        return;
+    }
+    emit statusChanged();
+}
+
+std::vector<int> BedrockRecordModel::selectRows(
+    const Batches& batches,
+    int first,
+    int end,
+    const QString& filter,
+    int column,
+    Qt::SortOrder order,
+    const std::atomic_bool& cancelled
+) {
+    std::vector<int> rows;
+    rows.reserve(filter.isEmpty() ? static_cast<size_t>(end - first) : 0);
+    for (int id = first; id < end; ++id) {
+        if (id % kCancelCheckInterval == 0 && cancelled.load()) return {};
+        if (!filter.isEmpty()) {
+            const Batch& batch = *batches[static_cast<size_t>(id / kBatchRecords)];
+            const Record& record = batch.records[static_cast<size_t>(id % kBatchRecords)];
+            // The same columns the table shows, like a filter over every column.
+            if (!label(batch, record).contains(filter, Qt::CaseInsensitive) &&
+                !QString::number(record.valueSize).contains(filter, Qt::CaseInsensitive) &&
+                !kind(record).contains(filter, Qt::CaseInsensitive)) {
+                continue;
+            }
+        }
+        rows.push_back(id);
+    }
+    if (column < 0) return rows;
+
+    auto keyLess = [&batches](int left, int right) {
+        const Batch& leftBatch = *batches[static_cast<size_t>(left / kBatchRecords)];
+        const Batch& rightBatch = *batches[static_cast<size_t>(right / kBatchRecords)];
+        const Record& a = leftBatch.records[static_cast<size_t>(left % kBatchRecords)];
+        const Record& b = rightBatch.records[static_cast<size_t>(right % kBatchRecords)];
+        const int common = std::min(a.keySize, b.keySize);
+        const int compared = common ? std::memcmp(leftBatch.keys.constData() + a.keyOffset,
+                                                  rightBatch.keys.constData() + b.keyOffset,
+                                                  static_cast<size_t>(common)) : 0;
+        return compared ? compared < 0 : a.keySize < b.keySize;
+    };
+    auto fieldLess = [&batches, column](int left, int right) {
+        const Record& a = batches[static_cast<size_t>(left / kBatchRecords)]->records[static_cast<size_t>(left % kBatchRecords)];
+        const Record& b = batches[static_cast<size_t>(right / kBatchRecords)]->records[static_cast<size_t>(right % kBatchRecords)];
+        if (column == 1) return a.valueSize < b.valueSize;
+        return a.nbtCandidate < b.nbtCandidate;
+    };
+    if (column == 0) std::stable_sort(rows.begin(), rows.end(), keyLess);
+    else std::stable_sort(rows.begin(), rows.end(), fieldLess);
+    if (order == Qt::DescendingOrder) std::reverse(rows.begin(), rows.end());
+    return cancelled.load() ? std::vector<int>() : rows;
+}
+
+QString BedrockRecordModel::label(const Batch& batch, const Record& record) {
+    return keyLabel(reinterpret_cast<const unsigned char*>(batch.keys.constData()) + record.keyOffset,
+                    static_cast<size_t>(record.keySize));
+}
+
+QString BedrockRecordModel::kind(const Record& record) {
+    return record.nbtCandidate ? tr("NBT compound candidate") : tr("Binary/custom record");
+}
+
+const BedrockRecordModel::Batch& BedrockRecordModel::batchFor(int id) const {
+    return *batches_[static_cast<size_t>(id / kBatchRecords)];
+}
+
+const BedrockRecordModel::Record& BedrockRecordModel::record(int id) const {
+    return batchFor(id).records[static_cast<size_t>(id % kBatchRecords)];
+}
+
+int BedrockRecordModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(rows_.size());
+}
+
+int BedrockRecordModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : 3;
+}
+
+QVariant BedrockRecordModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= static_cast<int>(rows_.size())) return {};
+    const int id = rows_[static_cast<size_t>(index.row())];
+    const Record& entry = record(id);
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+            case 0: return label(batchFor(id), entry);
+            case 1: return QString::number(entry.valueSize);
+            case 2: return kind(entry);
+            default: return {};
+        }
+    }
+    if (role == Qt::ToolTipRole && index.column() == 0) {
+        return QString::fromLatin1(keyAt(index.row()).toHex(' '));
+    }
+    return {};
+}
+
+QVariant BedrockRecordModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return {};
+    switch (section) {
+        case 0: return tr("Key / decoded coordinates");
+        case 1: return tr("Bytes");
+        case 2: return tr("Value kind");
+        default: return {};
+    }
+}
+
+QByteArray BedrockRecordModel::keyAt(int row) const {
+    if (row < 0 || row >= static_cast<int>(rows_.size())) return {};
+    const int id = rows_[static_cast<size_t>(row)];
+    const Record& entry = record(id);
+    return batchFor(id).keys.mid(entry.keyOffset, entry.keySize);
+}
+
+QString BedrockRecordModel::labelAt(int row) const {
+    if (row < 0 || row >= static_cast<int>(rows_.size())) return {};
+    const int id = rows_[static_cast<size_t>(row)];
+    return label(batchFor(id), record(id));
+}
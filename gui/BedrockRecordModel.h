@@ -0,0 +1,94 @@
+#ifndef CNBT_BEDROCK_RECORD_MODEL_H
+#define CNBT_BEDROCK_RECORD_MODEL_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QString>
+
+#include "WorkerSet.h"
+
+struct BedrockDB;
+
+/*
+ * The keys of a Bedrock world database as a flat table. Keys are listed on a
+ * worker into fixed-size batches of packed bytes, and row text is formatted
+ * only when a view asks for it, so there is no record limit. Filtering and
+ * sorting also run on a worker; the current rows stay visible until the new
+ * ones are ready.
+ */
+class BedrockRecordModel final : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    explicit BedrockRecordModel(QObject* parent = nullptr);
+    ~BedrockRecordModel() override;
+
+    // Takes ownership of database and closes it once every key is listed.
+    void load(BedrockDB* database);
+    void setFilterText(const QString& text);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    // Column 0 sorts in key byte order; a negative column restores database order.
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    QByteArray keyAt(int row) const;
+    QString labelAt(int row) const;
+    qsizetype recordCount() const { return recordCount_; }
+    bool isLoading() const { return loading_; }
+    bool isFiltering() const { return jobCancelled_ != nullptr; }
+    bool isFiltered() const { return !filter_.isEmpty(); }
+    const QString& loadError() const { return loadError_; }
+
+signals:
+    void statusChanged();
+
+private:
+    struct Record {
+        int keyOffset;
+        int keySize;
+        quint64 valueSize;
+        bool nbtCandidate;
+    };
+    struct Batch {
+        QByteArray keys;
+        std::vector<Record> records;
+    };
+    using Batches = std::vector<std::shared_ptr<const Batch>>;
+    struct LoadContext;
+
+    static int collectRecord(const unsigned char* key, size_t keySize, size_t valueSize,
+                             const unsigned char* valuePrefix, size_t valuePrefixSize, void* userData);
+    static QString label(const Batch& batch, const Record& record);
+    static QString kind(const Record& record);
+    static std::vector<int> selectRows(const Batches& batches, int first, int end, const QString& filter,
+                                       int column, Qt::SortOrder order, const std::atomic_bool& cancelled);
+
+    void appendBatch(const std::shared_ptr<const Batch>& batch);
+    void finishLoad(const QString& error);
+    void startJob(bool reset);
+    void finishJob(int generation, bool reset, int end, std::vector<int> rows);
+    const Record& record(int id) const;
+    const Batch& batchFor(int id) const;
+
+    Batches batches_;
+    int recordCount_ = 0;
+    std::vector<int> rows_;  // record ids, in display order
+    int covered_ = 0;        // records already considered for rows_
+    QString filter_;
+    int sortColumn_ = -1;
+    Qt::SortOrder sortOrder_ = Qt::AscendingOrder;
+    bool loading_ = false;
+    QString loadError_;
+    std::shared_ptr<std::atomic_bool> jobCancelled_;
+    int generation_ = 0;
+    NbtWorkerSet workers_{this};
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <climits>
 #include <cstring>
 #include <limits>
+#include <utility>
 
 #include <QDateTime>
 #include <QCryptographicHash>
@@ -22,6 +23,7 @@ extern "C" {
 #include "nbt_builder.h"
 #include "nbt_binary.h"
 #include "nbt_json.h"
+#include "nbt_lazy.h"
 #include "nbt_tree.h"
 #include "region_read.h"
 #include "region_write.h"
@@ -34,19 +36,59 @@ QString cError(const char* error, const QString& fallback) {
     return error && error[0] ? QString::fromUtf8(error) : fallback;
 }
 
-bool containsTag(const NBTTag* root, const NBTTag* candidate) {
-    if (!root || !candidate) return false;
-    if (root == candidate) return true;
-    if (root->type == TAG_Compound) {
-        for (int i = 0; i < root->value.compound.count; ++i) {
-            if (containsTag(root->value.compound.items[i], candidate)) return true;
-        }
-    } else if (root->type == TAG_List) {
-        for (int i = 0; i < root->value.list.count; ++i) {
-            if (containsTag(root->value.list.items[i], candidate)) return true;
-        }
+bool isContainer(const NBTTag* tag) {
+    return tag && (tag->type == TAG_Compound || tag->type == TAG_List);
+}
+
+// Matches nbt_list_insert: an emptied list keeps its element type, so every
+// root of a synthetic Bedrock root list stays the type the record was read with.
+bool listAccepts(const NBTTag* list, TagType type) {
+    return list->value.list.element_type == TAG_End || list->value.list.element_type == type;
+}
+
+// Tags retained by undo commands beyond this are dropped, oldest first.
+constexpr size_t kUndoMemoryLimit = size_t{256} << 20;
+
+size_t tagFootprint(const NBTTag* tag) {
+    if (!tag) return 0;
+    size_t bytes = sizeof(NBTTag) + (tag->name ? strlen(tag->name) + 1 : 0);
+    switch (tag->type) {
+        case TAG_String:
+            if (tag->value.string_val) bytes += strlen(tag->value.string_val) + 1;
+            break;
+        case TAG_Byte_Array:
+            bytes += static_cast<size_t>(std::max<int32_t>(tag->value.byte_array.length, 0));
+            break;
+        case TAG_Int_Array:
+            bytes += static_cast<size_t>(std::max<int32_t>(tag->value.int_array.length, 0)) * sizeof(int32_t);
+            break;
+        case TAG_Long_Array:
+            bytes += static_cast<size_t>(std::max<int32_t>(tag->value.long_array.length, 0)) * sizeof(int64_t);
+            break;
+        case TAG_List:
+            for (int i = 0; i < tag->value.list.count; ++i) {
+                bytes += sizeof(NBTTag*) + tagFootprint(tag->value.list.items[i]);
+            }
+            break;
+        case TAG_Compound:
+            for (int i = 0; i < tag->value.compound.count; ++i) {
+                bytes += sizeof(NBTTag*) + tagFootprint(tag->value.compound.items[i]);
+            }
+            break;
+        default:
+            break;
     }
-    return false;
+    return bytes;
+}
+
+bool beginStep(const NbtTaskControl* control, const QString& step, QString* error) {
+    if (!control) return true;
+    if (control->cancelled.load()) {
+        if (error) *error = QObject::tr("The operation was cancelled.");
+        return false;
+    }
+    if (control->reportStep) control->reportStep(step);
+    return true;
 }
 
 QByteArray compressNbt(const QByteArray& raw, NBTInputFormat format, QString* error) {
@@ -92,33 +134,203 @@ QByteArray compressNbt(const QByteArray& raw, NBTInputFormat format, QString* er
 
 }  // namespace
 
-class DocumentSnapshotCommand final : public QUndoCommand {
+// Undo commands record one operation and only the tags it touched. The
+// operation has already been applied when a command is pushed, so the first
+// redo() is skipped.
+class DocumentCommand : public QUndoCommand {
 public:
-    DocumentSnapshotCommand(NbtDocument* document, QByteArray before, QByteArray after, const QString& label)
-        : document_(document), before_(std::move(before)), after_(std::move(after)) {
+    DocumentCommand(NbtDocument* document, const QString& label) : document_(document) {
         setText(label);
     }
 
+    ~DocumentCommand() override {
+        setCost(0);
+    }
+
     void undo() override {
         QString error;
-        if (!document_->restoreSnapshot(before_, &error)) {
-            emit document_->statusMessage(QObject::tr("Undo failed: %1").arg(error));
-        }
+        if (!revert(&error)) emit document_->statusMessage(QObject::tr("Undo failed: %1").arg(error));
     }
 
     void redo() override {
+        if (pushed_) {
+            pushed_ = false;
+            return;
+        }
         QString error;
-        if (!document_->restoreSnapshot(after_, &error)) {
-            emit document_->statusMessage(QObject::tr("Redo failed: %1").arg(error));
+        if (!apply(&error)) emit document_->statusMessage(QObject::tr("Redo failed: %1").arg(error));
+    }
+
+    // Frees what the command holds once the history is over budget. QUndoStack
+    // deletes obsolete commands instead of undoing them.
+    void release() {
+        discard();
+        setCost(0);
+        setObsolete(true);
+    }
+
+protected:
+    virtual bool apply(QString* error) = 0;
+    virtual bool revert(QString* error) = 0;
+    virtual void discard() {}
+
+    void setCost(size_t cost) {
+        document_->undoBytes_ = document_->undoBytes_ - cost_ + cost;
+        cost_ = cost;
+    }
+
+    NbtDocument* document_;
+
+private:
+    size_t cost_ = 0;
+    bool pushed_ = true;
+};
+
+// Holds the other value of an edited tag; undo and redo swap it back in.
+class TagValueCommand final : public DocumentCommand {
+public:
+    TagValueCommand(NbtDocument* document, const QString& label, NBTTag* tag, NBTTag* state)
+        : DocumentCommand(document, label), tag_(tag), state_(state) {
+        setCost(tagFootprint(state_));
+    }
+
+    ~TagValueCommand() override {
+        free_nbt_tree(state_);
+    }
+
+protected:
+    bool apply(QString* error) override { return exchange(error); }
+    bool revert(QString* error) override { return exchange(error); }
+
+    void discard() override {
+        free_nbt_tree(state_);
+        state_ = nullptr;
+    }
+
+private:
+    bool exchange(QString* error) {
+        if (!state_) {
+            if (error) *error = QObject::tr("The edit was dropped from the undo history.");
+            return false;
         }
+        document_->exchangeValue(tag_, state_);
+        setCost(tagFootprint(state_));
+        return true;
+    }
+
+    NBTTag* tag_;
+    NBTTag* state_;
+};
+
+class RenameTagCommand final : public DocumentCommand {
+public:
+    RenameTagCommand(NbtDocument* document, NBTTag* parent, NBTTag* tag, QByteArray before, QByteArray after)
+        : DocumentCommand(document, QObject::tr("Rename tag")),
+          parent_(parent), tag_(tag), before_(std::move(before)), after_(std::move(after)) {
+        setCost(sizeof(*this) + static_cast<size_t>(before_.size() + after_.size()));
     }
 
+protected:
+    bool apply(QString* error) override { return rename(after_, error); }
+    bool revert(QString* error) override { return rename(before_, error); }
+
 private:
-    NbtDocument* document_;
+    bool rename(const QByteArray& name, QString* error) {
+        if (document_->setTagName(parent_, tag_, name)) return true;
+        if (error) *error = QObject::tr("Out of memory while renaming the tag.");
+        return false;
+    }
+
+    NBTTag* parent_;
+    NBTTag* tag_;
     QByteArray before_;
     QByteArray after_;
 };
 
+// Inserts or removes one child. The command owns the tag while it is detached.
+class ChildTagCommand final : public DocumentCommand {
+public:
+    enum Kind { Insert, Remove };
+
+    ChildTagCommand(NbtDocument* document, const QString& label, Kind kind, NBTTag* parent, int row, NBTTag* tag)
+        : DocumentCommand(document, label), kind_(kind), parent_(parent), row_(row), tag_(tag),
+          owned_(kind == Remove) {
+        setCost(tagFootprint(tag_));
+    }
+
+    ~ChildTagCommand() override {
+        if (owned_) free_nbt_tree(tag_);
+    }
+
+protected:
+    bool apply(QString* error) override { return kind_ == Insert ? attach(error) : detach(error); }
+    bool revert(QString* error) override { return kind_ == Insert ? detach(error) : attach(error); }
+
+    void discard() override {
+        if (owned_) free_nbt_tree(tag_);
+        owned_ = false;
+        tag_ = nullptr;
+    }
+
+private:
+    bool attach(QString* error) {
+        if (!owned_ || !document_->insertChild(parent_, row_, tag_)) {
+            if (error) *error = QObject::tr("Could not insert the tag.");
+            return false;
+        }
+        owned_ = false;
+        return true;
+    }
+
+    bool detach(QString* error) {
+        if (owned_ || document_->childAt(parent_, row_) != tag_) {
+            if (error) *error = QObject::tr("The tag is no longer at its recorded position.");
+            return false;
+        }
+        document_->takeChild(parent_, row_);
+        owned_ = true;
+        return true;
+    }
+
+    Kind kind_;
+    NBTTag* parent_;
+    int row_;
+    NBTTag* tag_;
+    bool owned_;
+};
+
+// Rows are final positions, so the same move reversed undoes it.
+class MoveTagCommand final : public DocumentCommand {
+public:
+    MoveTagCommand(NbtDocument* document, const QString& label,
+                   NBTTag* sourceParent, int sourceRow, NBTTag* destination, int destinationRow)
+        : DocumentCommand(document, label), sourceParent_(sourceParent), sourceRow_(sourceRow),
+          destination_(destination), destinationRow_(destinationRow) {
+        setCost(sizeof(*this));
+    }
+
+protected:
+    bool apply(QString* error) override {
+        return move(sourceParent_, sourceRow_, destination_, destinationRow_, error);
+    }
+
+    bool revert(QString* error) override {
+        return move(destination_, destinationRow_, sourceParent_, sourceRow_, error);
+    }
+
+private:
+    bool move(NBTTag* fromParent, int fromRow, NBTTag* toParent, int toRow, QString* error) {
+        if (document_->moveChild(fromParent, fromRow, toParent, toRow)) return true;
+        if (error) *error = QObject::tr("Could not move the tag.");
+        return false;
+    }
+
+    NBTTag* sourceParent_;
+    int sourceRow_;
+    NBTTag* destination_;
+    int destinationRow_;
+};
+
 NbtDocument::NbtDocument(QObject* parent) : QObject(parent) {
     connect(&undoStack_, &QUndoStack::cleanChanged, this, [this] {
         emit titleChanged();
@@ -127,6 +339,7 @@ NbtDocument::NbtDocument(QObject* parent) : QObject(parent) {
 
 NbtDocument::~NbtDocument() {
     free_nbt_tree(root_);
+    releaseLazy();
 }
 
 bool NbtDocument::createNew(NBTBinaryFormat format, bool snbt, QString* error) {
@@ -145,6 +358,7 @@ bool NbtDocument::createNew(NBTBinaryFormat format, bool snbt, QString* error) {
     replaceRoot(root);
     filePath_.clear();
     bedrockDatabaseRecord_ = false;
+    bedrockRootList_ = false;
     bedrockDatabaseDirectory_.clear();
     bedrockDatabaseKey_.clear();
     bedrockDatabaseKeyLabel_.clear();
@@ -165,15 +379,238 @@ bool NbtDocument::createNew(NBTBinaryFormat format, bool snbt, QString* error) {
     return true;
 }
 
-void NbtDocument::replaceRoot(NBTTag* replacement) {
+void NbtDocument::replaceRoot(NBTTag* replacement, unsigned char* lazyBytes, NBTLazyDocument* lazy) {
     if (root_ == replacement) return;
     free_nbt_tree(root_);
+    releaseLazy();
+    parents_.clear();
     root_ = replacement;
+    if (root_) linkSubtree(root_, nullptr);
+    if (lazy) {
+        lazyBytes_.reset(lazyBytes, [](const unsigned char* bytes) {
+            free(const_cast<unsigned char*>(bytes));
+        });
+        lazy_ = lazy;
+        pending_.insert(root_, nbt_lazy_root(lazy));
+    }
     emit treeChanged();
     emit titleChanged();
 }
 
+void NbtDocument::linkSubtree(NBTTag* tag, NBTTag* parent) {
+    parents_.insert(tag, parent);
+    linkChildren(tag);
+}
+
+// Placeholders that are still pending have no decoded children to visit.
+void NbtDocument::linkChildren(NBTTag* tag) {
+    const int count = isLoaded(tag) ? childCount(tag) : 0;
+    for (int i = 0; i < count; ++i) linkSubtree(childAt(tag, i), tag);
+}
+
+void NbtDocument::unlinkSubtree(const NBTTag* tag) {
+    parents_.remove(tag);
+    unlinkChildren(tag);
+}
+
+void NbtDocument::unlinkChildren(const NBTTag* tag) {
+    const int count = isLoaded(tag) ? childCount(tag) : 0;
+    for (int i = 0; i < count; ++i) unlinkSubtree(childAt(tag, i));
+}
+
+bool NbtDocument::isAncestor(const NBTTag* ancestor, const NBTTag* tag) const {
+    for (const NBTTag* current = tag; current; current = parents_.value(current)) {
+        if (current == ancestor) return true;
+    }
+    return false;
+}
+
+void NbtDocument::releaseLazy() {
+    pending_.clear();
+    nbt_lazy_close(lazy_);
+    lazy_ = nullptr;
+    lazyBytes_.reset();
+}
+
+int NbtDocument::childCount(const NBTTag* tag) const {
+    if (!tag) return 0;
+    const auto pending = pending_.constFind(tag);
+    if (pending != pending_.cend()) {
+        const NBTLazyEntry* children = nullptr;
+        int count = 0;
+        return nbt_lazy_children(lazy_, pending.value(), &children, &count, nullptr, 0) ? count : 0;
+    }
+    if (tag->type == TAG_Compound) return tag->value.compound.count;
+    if (tag->type == TAG_List) return tag->value.list.count;
+    return 0;
+}
+
+bool NbtDocument::loadChildren(NBTTag* tag, QString* error) {
+    const auto pending = pending_.constFind(tag);
+    if (pending == pending_.cend()) return true;
+
+    char lazyError[512]{};
+    const NBTLazyEntry* entries = nullptr;
+    int count = 0;
+    if (!nbt_lazy_children(lazy_, pending.value(), &entries, &count, lazyError, sizeof(lazyError))) {
+        if (error) *error = cError(lazyError, tr("Could not index the children of this tag."));
+        return false;
+    }
+    NBTTag** items = count > 0 ? static_cast<NBTTag**>(calloc(static_cast<size_t>(count), sizeof(NBTTag*))) : nullptr;
+    if (count > 0 && !items) {
+        if (error) *error = tr("Out of memory while loading child tags.");
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        items[i] = nbt_lazy_materialize_shallow(lazy_, &entries[i], lazyError, sizeof(lazyError));
+        if (!items[i]) {
+            for (int j = 0; j < i; ++j) free_nbt_tree(items[j]);
+            free(items);
+            if (error) *error = cError(lazyError, tr("Could not decode a child tag."));
+            return false;
+        }
+    }
+
+    /* Placeholders are empty, so the decoded children can be handed over as
+     * they are; duplicate compound names are kept just like a full parse. */
+    if (tag->type == TAG_Compound) {
+        tag->value.compound.items = items;
+        tag->value.compound.count = count;
+        nbt_compound_invalidate_index(tag);
+    } else {
+        tag->value.list.items = items;
+        tag->value.list.count = count;
+    }
+    pending_.erase(pending);
+    for (int i = 0; i < count; ++i) {
+        parents_.insert(items[i], tag);
+        if (isContainer(items[i])) pending_.insert(items[i], &entries[i]);
+    }
+    if (pending_.isEmpty()) releaseLazy();
+    return true;
+}
+
+bool NbtDocument::loadSubtree(NBTTag* tag, QString* error) {
+    if (!tag || pending_.isEmpty()) return true;
+    const auto pending = pending_.constFind(tag);
+    if (pending != pending_.cend()) {
+        char lazyError[512]{};
+        NBTTag* full = nbt_lazy_materialize(lazy_, pending.value(), lazyError, sizeof(lazyError));
+        if (!full) {
+            if (error) *error = cError(lazyError, tr("Could not decode the selected tag."));
+            return false;
+        }
+        /* Swap the decoded payload into the placeholder so pointers held by
+         * the model and the undo stack stay valid. */
+        std::swap(tag->value, full->value);
+        std::swap(tag->array_length, full->array_length);
+        free_nbt_tree(full);
+        pending_.erase(pending);
+        linkChildren(tag);
+    } else if (tag->type == TAG_Compound) {
+        for (int i = 0; i < tag->value.compound.count; ++i) {
+            if (!loadSubtree(tag->value.compound.items[i], error)) return false;
+        }
+    } else if (tag->type == TAG_List) {
+        for (int i = 0; i < tag->value.list.count; ++i) {
+            if (!loadSubtree(tag->value.list.items[i], error)) return false;
+        }
+    }
+    if (pending_.isEmpty()) releaseLazy();
+    return true;
+}
+
+NbtDocumentSnapshot::~NbtDocumentSnapshot() {
+    free_nbt_tree(root);
+}
+
+namespace {
+bool materializeTag(NbtDocumentSnapshot* snapshot, NBTTag* tag, const NbtTaskControl* control, QString* error) {
+    const auto pending = snapshot->pending.constFind(tag);
+    if (pending != snapshot->pending.cend()) {
+        if (control && control->cancelled.load()) {
+            if (error) *error = QObject::tr("The operation was cancelled.");
+            return false;
+        }
+        char decodeError[512]{};
+        NBTTag* full = nbt_binary_parse_payload_at(
+            snapshot->bytes.get(), snapshot->size, pending->offset, pending->type, "",
+            snapshot->format, nullptr, decodeError, sizeof(decodeError));
+        if (!full) {
+            if (error) *error = cError(decodeError, QObject::tr("Could not decode a collapsed tag."));
+            return false;
+        }
+        // The placeholder keeps its name; only the payload is filled in.
+        std::swap(tag->value, full->value);
+        std::swap(tag->array_length, full->array_length);
+        free_nbt_tree(full);
+        return true;
+    }
+    const int count = tag->type == TAG_Compound ? tag->value.compound.count
+        : tag->type == TAG_List ? tag->value.list.count : 0;
+    for (int i = 0; i < count; ++i) {
+        NBTTag* child = tag->type == TAG_Compound ? tag->value.compound.items[i] : tag->value.list.items[i];
+        if (!materializeTag(snapshot, child, control, error)) return false;
+    }
+    return true;
+}
+}  // namespace
+
+bool NbtDocumentSnapshot::materialize(const NbtTaskControl* control, QString* error) {
+    if (pending.isEmpty()) return true;
+    if (!beginStep(control, QObject::tr("Decoding collapsed tags…"), error) ||
+        !materializeTag(this, root, control, error)) return false;
+    pending.clear();
+    bytes.reset();
+    size = 0;
+    return true;
+}
+
+std::shared_ptr<NbtDocumentSnapshot> NbtDocument::snapshot(QString* error) const {
+    auto copy = std::make_shared<NbtDocumentSnapshot>();
+    if (!root_) return copy;
+    copy->root = nbt_tag_clone(root_);
+    if (!copy->root) {
+        if (error) *error = tr("Could not copy the document.");
+        return nullptr;
+    }
+    if (!pending_.isEmpty()) {
+        const NBTLazyEntry* root = nbt_lazy_root(lazy_);
+        copy->bytes = lazyBytes_;
+        copy->size = root->offset + root->length;
+        copy->format = binaryInfo_.format == NBT_BINARY_JAVA ? NBT_BINARY_JAVA : NBT_BINARY_BEDROCK;
+        recordPending(root_, copy->root, copy.get());
+    }
+    return copy;
+}
+
+// The clone has the same shape as the tree, so pending tags line up by row.
+void NbtDocument::recordPending(const NBTTag* tag, const NBTTag* copy, NbtDocumentSnapshot* snapshot) const {
+    const auto pending = pending_.constFind(tag);
+    if (pending != pending_.cend()) {
+        snapshot->pending.insert(copy, *pending.value());
+        return;
+    }
+    const int count = tag->type == TAG_Compound ? tag->value.compound.count
+        : tag->type == TAG_List ? tag->value.list.count : 0;
+    for (int i = 0; i < count; ++i) recordPending(childAt(tag, i), childAt(copy, i), snapshot);
+}
+
 bool NbtDocument::openFile(const QString& path, QString* error, int chunkX, int chunkZ) {
+    NbtLoadResult loaded;
+    if (!readFile(path, chunkX, chunkZ, nullptr, &loaded, error)) return false;
+    adoptFile(&loaded);
+    return true;
+}
+
+bool NbtDocument::readFile(
+    const QString& path,
+    int chunkX,
+    int chunkZ,
+    const NbtTaskControl* control,
+    NbtLoadResult* result,
+    QString* error
+) {
     const QByteArray nativePath = path.toUtf8();
     NBTLoadOptions options{};
     NBTLoadInfo info{};
@@ -194,6 +631,9 @@ bool NbtDocument::openFile(const QString& path, QString* error, int chunkX, int
 
     const bool isSnbt = QFileInfo(path).suffix().compare(QStringLiteral("snbt"), Qt::CaseInsensitive) == 0;
     NBTTag* parsed = nullptr;
+    unsigned char* lazyBytes = nullptr;
+    NBTLazyDocument* lazy = nullptr;
+    if (!beginStep(control, tr("Reading %1…").arg(QFileInfo(path).fileName()), error)) return false;
     if (isSnbt) {
         QFile input(path);
         if (!input.open(QIODevice::ReadOnly)) {
@@ -215,31 +655,60 @@ bool NbtDocument::openFile(const QString& path, QString* error, int chunkX, int
             if (error) *error = cError(loadError, tr("Could not load the NBT file."));
             return false;
         }
+        if (!beginStep(control, tr("Indexing tags…"), error)) {
+            free(bytes);
+            return false;
+        }
         const NBTBinaryFormat requested = info.source_type == NBT_SOURCE_REGION_CHUNK
             ? NBT_BINARY_JAVA : NBT_BINARY_AUTO;
-        parsed = nbt_binary_parse(
-            bytes, size, requested, &binaryInfo, parseError, sizeof(parseError));
-        free(bytes);
+        lazy = nbt_lazy_open(bytes, size, requested, &binaryInfo, parseError, sizeof(parseError));
+        if (lazy) parsed = nbt_lazy_materialize_shallow(lazy, nbt_lazy_root(lazy), parseError, sizeof(parseError));
+        if (isContainer(parsed)) {
+            lazyBytes = bytes;
+        } else {
+            nbt_lazy_close(lazy);
+            lazy = nullptr;
+            free(bytes);
+        }
     }
     if (!parsed) {
         if (error) *error = cError(parseError, tr("Could not parse the NBT document."));
         return false;
     }
 
-    replaceRoot(parsed);
-    filePath_ = QFileInfo(path).absoluteFilePath();
+    result->root = parsed;
+    result->lazyBytes = lazyBytes;
+    result->lazy = lazy;
+    result->info = info;
+    result->binaryInfo = binaryInfo;
+    result->snbt = isSnbt;
+    result->path = QFileInfo(path).absoluteFilePath();
+    return true;
+}
+
+void NbtDocument::discardLoad(NbtLoadResult* result) {
+    free_nbt_tree(result->root);
+    nbt_lazy_close(result->lazy);
+    free(result->lazyBytes);
+    *result = NbtLoadResult{};
+}
+
+void NbtDocument::adoptFile(NbtLoadResult* result) {
+    replaceRoot(result->root, result->lazyBytes, result->lazy);
+    filePath_ = result->path;
     bedrockDatabaseRecord_ = false;
+    bedrockRootList_ = false;
     bedrockDatabaseDirectory_.clear();
     bedrockDatabaseKey_.clear();
     bedrockDatabaseKeyLabel_.clear();
-    loadInfo_ = info;
-    binaryInfo_ = binaryInfo;
-    sourceIsSnbt_ = isSnbt;
+    loadInfo_ = result->info;
+    binaryInfo_ = result->binaryInfo;
+    sourceIsSnbt_ = result->snbt;
+    *result = NbtLoadResult{};
     undoStack_.clear();
     undoStack_.setClean();
     emit titleChanged();
     emit statusMessage(tr("Opened %1").arg(QFileInfo(filePath_).fileName()));
-    return true;
 }
 
 bool NbtDocument::openBedrockDatabaseRecord(
@@ -263,6 +732,7 @@ bool NbtDocument::openBedrockDatabaseRecord(
         return false;
     }
     int found = 0;
+    bool rootList = false;
     NBTTag* parsed = bedrock_db_get_nbt(
         database,
         reinterpret_cast<const unsigned char*>(key.constData()),
@@ -270,11 +740,22 @@ bool NbtDocument::openBedrockDatabaseRecord(
         &found,
         backendError,
         sizeof(backendError));
+    if (!parsed && found) {
+        // Block entities, entities and similar records store roots back to back.
+        parsed = bedrock_db_get_nbt_roots(
+            database,
+            reinterpret_cast<const unsigned char*>(key.constData()),
+            static_cast<size_t>(key.size()),
+            &found,
+            backendError,
+            sizeof(backendError));
+        rootList = parsed != nullptr;
+    }
     bedrock_db_close(database);
     if (!parsed) {
         if (error) {
             *error = found
-                ? cError(backendError, tr("The selected record is not one complete little-endian NBT document."))
+                ? cError(backendError, tr("The selected record is not a sequence of little-endian NBT roots."))
                 : tr("The selected Bedrock database record no longer exists.");
         }
         return false;
@@ -291,6 +772,7 @@ bool NbtDocument::openBedrockDatabaseRecord(
     binaryInfo_.format = NBT_BINARY_BEDROCK;
     sourceIsSnbt_ = false;
     bedrockDatabaseRecord_ = true;
+    bedrockRootList_ = rootList;
     bedrockDatabaseDirectory_ = QDir(databaseDirectory).absolutePath();
     bedrockDatabaseKey_ = key;
     bedrockDatabaseKeyLabel_ = keyLabel;
@@ -324,7 +806,10 @@ QString NbtDocument::displayName() const {
 
 QString NbtDocument::formatDescription() const {
     if (bedrockDatabaseRecord_) {
-        return tr("Bedrock LevelDB record · little-endian NBT");
+        return bedrockRootList_
+            ? tr("Bedrock LevelDB record · %n back-to-back little-endian NBT root(s)", nullptr,
+                 root_ ? root_->value.list.count : 0)
+            : tr("Bedrock LevelDB record · little-endian NBT");
     }
     if (sourceIsSnbt_) return tr("SNBT text document");
     QString compression = QString::fromLatin1(nbt_input_format_name(loadInfo_.input_format));
@@ -335,88 +820,114 @@ QString NbtDocument::formatDescription() const {
         .arg(QString::fromLatin1(nbt_binary_format_name(binaryInfo_.format)), compression);
 }
 
-QByteArray NbtDocument::snapshot(QString* error) const {
-    unsigned char* bytes = nullptr;
-    size_t size = 0;
-    char serializationError[512]{};
-    if (!root_) {
-        if (error) *error = tr("No document is loaded.");
-        return {};
+NBTTag* NbtDocument::childAt(const NBTTag* parent, int row) const {
+    if (!parent || row < 0) return nullptr;
+    if (parent->type == TAG_Compound) {
+        return row < parent->value.compound.count ? parent->value.compound.items[row] : nullptr;
     }
-    if (!serialize_tag_to_nbt_bytes(root_, &bytes, &size, serializationError, sizeof(serializationError))) {
-        if (error) *error = cError(serializationError, tr("Could not serialize the document."));
-        return {};
+    if (parent->type == TAG_List) {
+        return row < parent->value.list.count ? parent->value.list.items[row] : nullptr;
     }
-    QByteArray result(reinterpret_cast<const char*>(bytes), static_cast<qsizetype>(size));
-    free(bytes);
-    return result;
+    return nullptr;
 }
 
-bool NbtDocument::restoreSnapshot(const QByteArray& bytes, QString* error) {
-    char parseError[512]{};
-    size_t offset = 0;
-    NBTTag* parsed = build_nbt_tree(
-        reinterpret_cast<const unsigned char*>(bytes.constData()),
-        static_cast<size_t>(bytes.size()),
-        &offset,
-        parseError,
-        sizeof(parseError)
-    );
-    if (!parsed) {
-        if (error) *error = cError(parseError, tr("Could not restore the document snapshot."));
-        return false;
-    }
-    replaceRoot(parsed);
+void NbtDocument::exchangeValue(NBTTag* tag, NBTTag* state) {
+    const int previousCount = childCount(tag);
+    if (previousCount > 0) emit tagsAboutToBeRemoved(tag, 0, previousCount - 1);
+    unlinkChildren(tag);
+    std::swap(tag->value, state->value);
+    std::swap(tag->array_length, state->array_length);
+    linkChildren(tag);
+    const int currentCount = childCount(tag);
+    if (currentCount > 0) emit tagsInserted(tag, 0, currentCount - 1);
+    emit tagChanged(tag);
+}
+
+bool NbtDocument::setTagName(NBTTag* parent, NBTTag* tag, const QByteArray& name) {
+    if (!nbt_compound_rename_child(parent, tag, name.constData())) return false;
+    emit tagChanged(tag);
     return true;
 }
 
-bool NbtDocument::performMutation(
-    const QString& label,
-    const std::function<bool(QString*)>& operation,
-    QString* error
-) {
-    QString localError;
-    const QByteArray before = snapshot(&localError);
-    if (before.isEmpty() && !localError.isEmpty()) {
-        if (error) *error = localError;
-        return false;
-    }
-    if (!operation(&localError)) {
-        if (error) *error = localError;
-        return false;
-    }
-    const QByteArray after = snapshot(&localError);
-    if (after.isEmpty() && !localError.isEmpty()) {
-        restoreSnapshot(before, nullptr);
-        if (error) *error = localError;
-        return false;
-    }
+bool NbtDocument::insertChild(NBTTag* parent, int row, NBTTag* child) {
+    const bool inserted = parent->type == TAG_Compound
+        ? nbt_compound_insert(parent, row, child) != 0
+        : parent->type == TAG_List && nbt_list_insert(parent, row, child) != 0;
+    if (!inserted) return false;
+    linkSubtree(child, parent);
+    emit tagsInserted(parent, row, row);
+    emit tagChanged(parent);
+    return true;
+}
+
+NBTTag* NbtDocument::takeChild(NBTTag* parent, int row) {
+    if (!childAt(parent, row)) return nullptr;
+    emit tagsAboutToBeRemoved(parent, row, row);
+    NBTTag* removed = parent->type == TAG_Compound
+        ? nbt_compound_take(parent, row)
+        : nbt_list_take(parent, row);
+    unlinkSubtree(removed);
+    emit tagChanged(parent);
+    return removed;
+}
 
-    if (!restoreSnapshot(before, &localError)) {
-        if (error) *error = localError;
+bool NbtDocument::moveChild(NBTTag* sourceParent, int sourceRow, NBTTag* destination, int destinationRow) {
+    if (!childAt(sourceParent, sourceRow) || !isContainer(destination)) return false;
+    NBTTag* removed = sourceParent->type == TAG_Compound
+        ? nbt_compound_take(sourceParent, sourceRow)
+        : nbt_list_take(sourceParent, sourceRow);
+    const bool inserted = destination->type == TAG_Compound
+        ? nbt_compound_insert(destination, destinationRow, removed) != 0
+        : nbt_list_insert(destination, destinationRow, removed) != 0;
+    if (!inserted) {
+        if (sourceParent->type == TAG_Compound) nbt_compound_insert(sourceParent, sourceRow, removed);
+        else nbt_list_insert(sourceParent, sourceRow, removed);
         return false;
     }
-    undoStack_.push(new DocumentSnapshotCommand(this, before, after, label));
+    parents_.insert(removed, destination);
+    emit tagMoved(sourceParent, sourceRow, destination, destinationRow);
+    if (destination != sourceParent) emit tagChanged(sourceParent);
+    emit tagChanged(destination);
     return true;
 }
 
+void NbtDocument::pushCommand(DocumentCommand* command) {
+    undoStack_.push(command);
+    // Retire the oldest steps once the history holds too many tags, but always
+    // keep the newest one even if it alone is over budget.
+    for (int i = 0; undoBytes_ > kUndoMemoryLimit && i < undoStack_.index() - 1; ++i) {
+        const auto* oldest = static_cast<const DocumentCommand*>(undoStack_.command(i));
+        const_cast<DocumentCommand*>(oldest)->release();
+    }
+}
+
 bool NbtDocument::editTag(NBTTag* tag, const QString& jsonValue, QString* error) {
     if (!tag) {
         if (error) *error = tr("No tag is selected.");
         return false;
     }
-    return performMutation(tr("Edit %1").arg(QString::fromUtf8(tag->name)), [=](QString* localError) {
-        char editError[512]{};
-        const QByteArray value = jsonValue.toUtf8();
-        EditStatus status = tag->type == TAG_Compound
-            ? apply_json_patch_to_compound(tag, value.constData(), editError, sizeof(editError))
-            : parse_json_for_tag_type(tag, value.constData(), editError, sizeof(editError));
-        if (status != EDIT_OK) {
-            *localError = cError(editError, QString::fromLatin1(edit_status_name(status)));
-            return false;
-        }
-        return true;
-    }, error);
+    if (!loadSubtree(tag, error)) return false;
+
+    // Edit a copy so a failed edit leaves the tree untouched; the copy then
+    // keeps the previous value for undo.
+    NBTTag* edited = nbt_tag_clone(tag);
+    if (!edited) {
+        if (error) *error = tr("Out of memory while editing the tag.");
+        return false;
+    }
+    char editError[512]{};
+    const QByteArray value = jsonValue.toUtf8();
+    const EditStatus status = edited->type == TAG_Compound
+        ? apply_json_patch_to_compound(edited, value.constData(), editError, sizeof(editError))
+        : parse_json_for_tag_type(edited, value.constData(), editError, sizeof(editError));
+    if (status != EDIT_OK) {
+        free_nbt_tree(edited);
+        if (error) *error = cError(editError, QString::fromLatin1(edit_status_name(status)));
+        return false;
+    }
+    exchangeValue(tag, edited);
+    pushCommand(new TagValueCommand(this, tr("Edit %1").arg(QString::fromUtf8(tag->name)), tag, edited));
+    return true;
 }
 
 bool NbtDocument::renameTag(NBTTag* tag, NBTTag* parent, const QString& newName, QString* error) {
@@ -424,6 +935,7 @@ bool NbtDocument::renameTag(NBTTag* tag, NBTTag* parent, const QString& newName,
         if (error) *error = tr("Only named tags inside compounds can be renamed.");
         return false;
     }
+    if (!loadChildren(parent, error)) return false;
     const QByteArray encoded = newName.toUtf8();
     if (encoded.size() > 65535) {
         if (error) *error = tr("NBT tag names cannot exceed 65,535 bytes.");
@@ -435,13 +947,13 @@ bool NbtDocument::renameTag(NBTTag* tag, NBTTag* parent, const QString& newName,
         return false;
     }
 
-    return performMutation(tr("Rename tag"), [=](QString* localError) {
-        if (!nbt_tag_rename(tag, encoded.constData())) {
-            *localError = tr("Out of memory while renaming the tag.");
-            return false;
-        }
-        return true;
-    }, error);
+    const QByteArray previous(tag->name ? tag->name : "");
+    if (!setTagName(parent, tag, encoded)) {
+        if (error) *error = tr("Out of memory while renaming the tag.");
+        return false;
+    }
+    pushCommand(new RenameTagCommand(this, parent, tag, previous, encoded));
+    return true;
 }
 
 bool NbtDocument::addTag(NBTTag* parent, TagType type, const QString& name, QString* error) {
@@ -449,7 +961,8 @@ bool NbtDocument::addTag(NBTTag* parent, TagType type, const QString& name, QStr
         if (error) *error = tr("Tags can only be added to compounds or lists.");
         return false;
     }
-    if (parent->type == TAG_List && parent->value.list.count > 0 && parent->value.list.element_type != type) {
+    if (!loadChildren(parent, error)) return false;
+    if (parent->type == TAG_List && !listAccepts(parent, type)) {
         if (error) *error = tr("Every element in an NBT list must have the same type (%1).")
             .arg(QString::fromLatin1(nbt_tag_type_name(parent->value.list.element_type)));
         return false;
@@ -460,22 +973,21 @@ bool NbtDocument::addTag(NBTTag* parent, TagType type, const QString& name, QStr
         return false;
     }
 
-    return performMutation(tr("Add %1").arg(QString::fromLatin1(nbt_tag_type_name(type))), [=](QString* localError) {
-        NBTTag* child = nbt_tag_create(type, encodedName.constData());
-        if (!child) {
-            *localError = tr("Out of memory while creating the tag.");
-            return false;
-        }
-        const bool appended = parent->type == TAG_Compound
-            ? nbt_compound_append(parent, child) != 0
-            : nbt_list_append(parent, child) != 0;
-        if (!appended) {
-            free_nbt_tree(child);
-            *localError = tr("Could not insert the tag.");
-            return false;
-        }
-        return true;
-    }, error);
+    NBTTag* child = nbt_tag_create(type, encodedName.constData());
+    if (!child) {
+        if (error) *error = tr("Out of memory while creating the tag.");
+        return false;
+    }
+    const int row = childCount(parent);
+    if (!insertChild(parent, row, child)) {
+        free_nbt_tree(child);
+        if (error) *error = tr("Could not insert the tag.");
+        return false;
+    }
+    pushCommand(new ChildTagCommand(
+        this, tr("Add %1").arg(QString::fromLatin1(nbt_tag_type_name(type))),
+        ChildTagCommand::Insert, parent, row, child));
+    return true;
 }
 
 bool NbtDocument::deleteTag(NBTTag* tag, NBTTag* parent, int row, QString* error) {
@@ -483,17 +995,16 @@ bool NbtDocument::deleteTag(NBTTag* tag, NBTTag* parent, int row, QString* error
         if (error) *error = tr("The root tag cannot be deleted.");
         return false;
     }
-    return performMutation(tr("Delete %1").arg(QString::fromUtf8(tag->name)), [=](QString* localError) {
-        NBTTag* removed = parent->type == TAG_Compound
-            ? nbt_compound_take(parent, row)
-            : parent->type == TAG_List ? nbt_list_take(parent, row) : nullptr;
-        if (!removed) {
-            *localError = tr("Could not remove the selected tag.");
-            return false;
-        }
-        free_nbt_tree(removed);
-        return true;
-    }, error);
+    // A detached subtree must not keep pending lazy entries.
+    if (!loadSubtree(tag, error)) return false;
+    if (childAt(parent, row) != tag) {
+        if (error) *error = tr("Could not remove the selected tag.");
+        return false;
+    }
+    const QString label = tr("Delete %1").arg(QString::fromUtf8(tag->name));
+    takeChild(parent, row);
+    pushCommand(new ChildTagCommand(this, label, ChildTagCommand::Remove, parent, row, tag));
+    return true;
 }
 
 bool NbtDocument::insertTag(NBTTag* parent, const NBTTag* source, QString* error) {
@@ -501,38 +1012,38 @@ bool NbtDocument::insertTag(NBTTag* parent, const NBTTag* source, QString* error
         if (error) *error = tr("Choose a compound or list as the destination.");
         return false;
     }
-    if (parent->type == TAG_List && parent->value.list.count > 0 &&
-        parent->value.list.element_type != source->type) {
+    if (!loadChildren(parent, error)) return false;
+    if (parent->type == TAG_List && !listAccepts(parent, source->type)) {
         if (error) *error = tr("The copied tag does not match the destination list type.");
         return false;
     }
 
-    return performMutation(tr("Paste tag"), [=](QString* localError) {
-        NBTTag* copy = nbt_tag_clone(source);
-        if (!copy) {
-            *localError = tr("Out of memory while copying the tag.");
-            return false;
+    NBTTag* copy = nbt_tag_clone(source);
+    if (!copy) {
+        if (error) *error = tr("Out of memory while copying the tag.");
+        return false;
+    }
+    if (parent->type == TAG_Compound) {
+        QString base = QString::fromUtf8(copy->name);
+        QString candidate = base;
+        int suffix = 2;
+        while (nbt_compound_find_index(parent, candidate.toUtf8().constData()) >= 0) {
+            candidate = base + tr(" Copy %1").arg(suffix++);
         }
-        if (parent->type == TAG_Compound) {
-            QString base = QString::fromUtf8(copy->name);
-            QString candidate = base;
-            int suffix = 2;
-            while (nbt_compound_find_index(parent, candidate.toUtf8().constData()) >= 0) {
-                candidate = base + tr(" Copy %1").arg(suffix++);
-            }
-            if (!nbt_tag_rename(copy, candidate.toUtf8().constData()) ||
-                !nbt_compound_append(parent, copy)) {
-                free_nbt_tree(copy);
-                *localError = tr("Could not insert the copied tag.");
-                return false;
-            }
-        } else if (!nbt_list_append(parent, copy)) {
+        if (!nbt_tag_rename(copy, candidate.toUtf8().constData())) {
             free_nbt_tree(copy);
-            *localError = tr("Could not insert the copied tag.");
+            if (error) *error = tr("Could not insert the copied tag.");
             return false;
         }
-        return true;
-    }, error);
+    }
+    const int row = childCount(parent);
+    if (!insertChild(parent, row, copy)) {
+        free_nbt_tree(copy);
+        if (error) *error = tr("Could not insert the copied tag.");
+        return false;
+    }
+    pushCommand(new ChildTagCommand(this, tr("Paste tag"), ChildTagCommand::Insert, parent, row, copy));
+    return true;
 }
 
 bool NbtDocument::duplicateTag(NBTTag* tag, NBTTag* parent, int row, QString* error) {
@@ -540,37 +1051,35 @@ bool NbtDocument::duplicateTag(NBTTag* tag, NBTTag* parent, int row, QString* er
         if (error) *error = tr("The root tag cannot be duplicated here.");
         return false;
     }
-    return performMutation(tr("Duplicate %1").arg(QString::fromUtf8(tag->name)), [=](QString* localError) {
-        NBTTag* copy = nbt_tag_clone(tag);
-        if (!copy) {
-            *localError = tr("Out of memory while duplicating the tag.");
-            return false;
-        }
+    if (!loadSubtree(tag, error)) return false;
+    NBTTag* copy = nbt_tag_clone(tag);
+    if (!copy) {
+        if (error) *error = tr("Out of memory while duplicating the tag.");
+        return false;
+    }
 
-        bool inserted = false;
-        if (parent->type == TAG_Compound) {
-            QString base = QString::fromUtf8(copy->name);
-            QString candidate = base + tr(" Copy");
-            int suffix = 2;
-            while (nbt_compound_find_index(parent, candidate.toUtf8().constData()) >= 0) {
-                candidate = base + tr(" Copy %1").arg(suffix++);
-            }
-            if (!nbt_tag_rename(copy, candidate.toUtf8().constData())) {
-                free_nbt_tree(copy);
-                *localError = tr("Out of memory while naming the duplicate.");
-                return false;
-            }
-            inserted = nbt_compound_insert(parent, row + 1, copy) != 0;
-        } else if (parent->type == TAG_List) {
-            inserted = nbt_list_insert(parent, row + 1, copy) != 0;
+    if (parent->type == TAG_Compound) {
+        QString base = QString::fromUtf8(copy->name);
+        QString candidate = base + tr(" Copy");
+        int suffix = 2;
+        while (nbt_compound_find_index(parent, candidate.toUtf8().constData()) >= 0) {
+            candidate = base + tr(" Copy %1").arg(suffix++);
         }
-        if (!inserted) {
+        if (!nbt_tag_rename(copy, candidate.toUtf8().constData())) {
             free_nbt_tree(copy);
-            *localError = tr("Could not insert the duplicate.");
+            if (error) *error = tr("Out of memory while naming the duplicate.");
             return false;
         }
-        return true;
-    }, error);
+    }
+    if (!insertChild(parent, row + 1, copy)) {
+        free_nbt_tree(copy);
+        if (error) *error = tr("Could not insert the duplicate.");
+        return false;
+    }
+    pushCommand(new ChildTagCommand(
+        this, tr("Duplicate %1").arg(QString::fromUtf8(tag->name)),
+        ChildTagCommand::Insert, parent, row + 1, copy));
+    return true;
 }
 
 bool NbtDocument::moveTag(
@@ -586,7 +1095,16 @@ bool NbtDocument::moveTag(
         if (error) *error = tr("Choose a compound or list as the destination.");
         return false;
     }
-    if (containsTag(source, destination)) {
+    if (!isAttached(source) || !isAttached(destination) || parents_.value(source) != sourceParent) {
+        if (error) *error = tr("The dragged tag is no longer part of this document.");
+        return false;
+    }
+    if (!loadChildren(destination, error)) return false;
+    if (childAt(sourceParent, sourceRow) != source) {
+        if (error) *error = tr("Could not detach the selected tag.");
+        return false;
+    }
+    if (isAncestor(source, destination)) {
         if (error) *error = tr("A tag cannot be moved into itself or one of its descendants.");
         return false;
     }
@@ -595,36 +1113,24 @@ bool NbtDocument::moveTag(
         if (error) *error = tr("The destination already contains a tag with that name.");
         return false;
     }
-    if (destination->type == TAG_List && destination->value.list.count > 0 &&
-        destination->value.list.element_type != source->type) {
+    if (destination->type == TAG_List && !listAccepts(destination, source->type)) {
         if (error) *error = tr("The tag type does not match the destination list.");
         return false;
     }
 
-    return performMutation(tr("Move %1").arg(QString::fromUtf8(source->name)), [=](QString* localError) {
-        NBTTag* removed = sourceParent->type == TAG_Compound
-            ? nbt_compound_take(sourceParent, sourceRow)
-            : sourceParent->type == TAG_List ? nbt_list_take(sourceParent, sourceRow) : nullptr;
-        if (!removed) {
-            *localError = tr("Could not detach the selected tag.");
-            return false;
-        }
-        int insertAt = destinationRow;
-        const int destinationCount = destination->type == TAG_Compound
-            ? destination->value.compound.count : destination->value.list.count;
-        if (destination == sourceParent && insertAt > sourceRow) --insertAt;
-        if (insertAt < 0 || insertAt > destinationCount) insertAt = destinationCount;
-        const bool inserted = destination->type == TAG_Compound
-            ? nbt_compound_insert(destination, insertAt, removed) != 0
-            : nbt_list_insert(destination, insertAt, removed) != 0;
-        if (!inserted) {
-            if (sourceParent->type == TAG_Compound) nbt_compound_insert(sourceParent, sourceRow, removed);
-            else nbt_list_insert(sourceParent, sourceRow, removed);
-            *localError = tr("Could not insert the tag at the destination.");
-            return false;
-        }
-        return true;
-    }, error);
+    // Drop rows count the dragged tag itself; the command records final rows.
+    int insertAt = destinationRow;
+    const int destinationCount = childCount(destination) - (destination == sourceParent ? 1 : 0);
+    if (destination == sourceParent && insertAt > sourceRow) --insertAt;
+    if (insertAt < 0 || insertAt > destinationCount) insertAt = destinationCount;
+    if (!moveChild(sourceParent, sourceRow, destination, insertAt)) {
+        if (error) *error = tr("Could not insert the tag at the destination.");
+        return false;
+    }
+    pushCommand(new MoveTagCommand(
+        this, tr("Move %1").arg(QString::fromUtf8(source->name)),
+        sourceParent, sourceRow, destination, insertAt));
+    return true;
 }
 
 bool NbtDocument::createBackupIfNeeded(const QString& targetPath, QString* backupPath, QString* error) const {
@@ -675,12 +1181,18 @@ bool NbtDocument::createBackupIfNeeded(const QString& targetPath, QString* backu
     return true;
 }
 
-bool NbtDocument::writeStandalone(const QString& path, QString* error) {
-    const bool writeSnbt = QFileInfo(path).suffix().compare(QStringLiteral("snbt"), Qt::CaseInsensitive) == 0;
+bool NbtDocument::writeStandalone(
+    const NBTTag* root,
+    const QString& path,
+    const NbtTaskControl* control,
+    QString* error
+) const {
+    if (!beginStep(control, tr("Serializing…"), error)) return false;
+    const bool asSnbt = QFileInfo(path).suffix().compare(QStringLiteral("snbt"), Qt::CaseInsensitive) == 0;
     QByteArray encoded;
-    if (writeSnbt) {
+    if (asSnbt) {
         char serializationError[512]{};
-        char* text = snbt_serialize(root_, 1, serializationError, sizeof(serializationError));
+        char* text = snbt_serialize(root, 1, serializationError, sizeof(serializationError));
         if (!text) {
             if (error) *error = cError(serializationError, tr("Could not serialize SNBT."));
             return false;
@@ -695,7 +1207,7 @@ bool NbtDocument::writeStandalone(const QString& path, QString* error) {
         if (format == NBT_BINARY_AUTO) format = NBT_BINARY_JAVA;
         const uint32_t storageVersion = sourceIsSnbt_ ? 0 : binaryInfo_.bedrock_storage_version;
         if (!nbt_binary_serialize(
-                root_, format, storageVersion, &bytes, &size,
+                root, format, storageVersion, &bytes, &size,
                 serializationError, sizeof(serializationError))) {
             if (error) *error = cError(serializationError, tr("Could not serialize binary NBT."));
             return false;
@@ -711,9 +1223,11 @@ bool NbtDocument::writeStandalone(const QString& path, QString* error) {
         if (outputFormat == NBT_INPUT_FORMAT_UNKNOWN || outputFormat == NBT_INPUT_FORMAT_LZ4) {
             outputFormat = NBT_INPUT_FORMAT_GZIP;
         }
+        if (!beginStep(control, tr("Compressing…"), error)) return false;
         encoded = compressNbt(raw, outputFormat, error);
         if (encoded.isEmpty() && !raw.isEmpty()) return false;
     }
+    if (!beginStep(control, tr("Writing %1…").arg(QFileInfo(path).fileName()), error)) return false;
 
     QSaveFile output(path);
     output.setDirectWriteFallback(false);
@@ -733,7 +1247,13 @@ bool NbtDocument::writeStandalone(const QString& path, QString* error) {
     return true;
 }
 
-bool NbtDocument::writeRegion(const QString& path, QString* error) {
+bool NbtDocument::writeRegion(
+    const NBTTag* root,
+    const QString& path,
+    const NbtTaskControl* control,
+    QString* error
+) const {
+    if (!beginStep(control, tr("Updating the region chunk…"), error)) return false;
     const QByteArray sourcePath = filePath_.toUtf8();
     const QByteArray outputPath = path.toUtf8();
     char regionError[512]{};
@@ -743,11 +1263,15 @@ bool NbtDocument::writeRegion(const QString& path, QString* error) {
         return false;
     }
     if (!region_file_update_chunk_from_nbt(
-            region, chunkX(), chunkZ(), root_, -1, regionError, sizeof(regionError))) {
+            region, chunkX(), chunkZ(), root, -1, regionError, sizeof(regionError))) {
         if (error) *error = cError(regionError, tr("Could not update the selected region chunk."));
         region_file_free(region);
         return false;
     }
+    if (!beginStep(control, tr("Writing %1…").arg(QFileInfo(path).fileName()), error)) {
+        region_file_free(region);
+        return false;
+    }
     const int ok = region_file_write_atomic(region, outputPath.constData(), regionError, sizeof(regionError));
     region_file_free(region);
     if (!ok) {
@@ -757,11 +1281,22 @@ bool NbtDocument::writeRegion(const QString& path, QString* error) {
     return true;
 }
 
-bool NbtDocument::writeBedrockDatabaseRecord(QString* error) {
+bool NbtDocument::writeBedrockDatabaseRecord(
+    const NBTTag* root,
+    const NbtTaskControl* control,
+    QString* backupPath,
+    QString* error
+) const {
     if (!bedrockDatabaseRecord_ || bedrockDatabaseDirectory_.isEmpty()) {
         if (error) *error = tr("This document is not linked to a Bedrock database record.");
         return false;
     }
+    if (bedrockRootList_ && root->value.list.count == 0) {
+        // An empty value is not NBT at all and could not be opened again.
+        if (error) *error = tr("The record has no roots left. Add one before saving.");
+        return false;
+    }
+    if (!beginStep(control, tr("Writing Bedrock record %1…").arg(bedrockDatabaseKeyLabel_), error)) return false;
 
     char backendError[512]{};
     const QByteArray encodedDirectory = bedrockDatabaseDirectory_.toUtf8();
@@ -777,7 +1312,6 @@ bool NbtDocument::writeBedrockDatabaseRecord(QString* error) {
         return false;
     }
 
-    QString backupPath;
     if (backupOnSave_) {
         unsigned char* previousValue = nullptr;
         size_t previousSize = 0;
@@ -821,10 +1355,10 @@ bool NbtDocument::writeBedrockDatabaseRecord(QString* error) {
         }
         const QByteArray keyHash = QCryptographicHash::hash(
             bedrockDatabaseKey_, QCryptographicHash::Sha256).toHex().left(16);
-        backupPath = QDir(backupDirectoryPath).filePath(
+        *backupPath = QDir(backupDirectoryPath).filePath(
             QDateTime::currentDateTimeUtc().toString(QStringLiteral("yyyyMMdd-HHmmss-zzz-")) +
             QString::fromLatin1(keyHash) + QStringLiteral(".bin"));
-        QSaveFile backup(backupPath);
+        QSaveFile backup(*backupPath);
         backup.setDirectWriteFallback(false);
         const bool backedUp = backup.open(QIODevice::WriteOnly) &&
             backup.write(reinterpret_cast<const char*>(previousValue),
@@ -839,49 +1373,81 @@ bool NbtDocument::writeBedrockDatabaseRecord(QString* error) {
         }
     }
 
-    const bool written = bedrock_db_put_nbt(
-        database,
-        reinterpret_cast<const unsigned char*>(bedrockDatabaseKey_.constData()),
-        static_cast<size_t>(bedrockDatabaseKey_.size()),
-        root_,
-        backendError,
-        sizeof(backendError));
+    const auto* key = reinterpret_cast<const unsigned char*>(bedrockDatabaseKey_.constData());
+    const auto keySize = static_cast<size_t>(bedrockDatabaseKey_.size());
+    const bool written = bedrockRootList_
+        ? bedrock_db_put_nbt_roots(database, key, keySize, root, backendError, sizeof(backendError))
+        : bedrock_db_put_nbt(database, key, keySize, root, backendError, sizeof(backendError));
     bedrock_db_close(database);
     if (!written) {
         if (error) *error = cError(backendError, tr("Could not update the Bedrock database record."));
         return false;
     }
-
-    undoStack_.setClean();
-    emit titleChanged();
-    emit statusMessage(backupPath.isEmpty()
-        ? tr("Saved Bedrock database record %1").arg(bedrockDatabaseKeyLabel_)
-        : tr("Saved Bedrock database record (backup: %1)").arg(backupPath));
     return true;
 }
 
 bool NbtDocument::save(QString* error) {
-    if (bedrockDatabaseRecord_) return writeBedrockDatabaseRecord(error);
-    if (filePath_.isEmpty()) {
-        if (error) *error = tr("Choose a destination with Save As.");
-        return false;
-    }
-    return saveAs(filePath_, error);
+    return saveAs(QString(), error);
 }
 
 bool NbtDocument::saveAs(const QString& path, QString* error) {
     QString backupPath;
-    if (!createBackupIfNeeded(path, &backupPath, error)) return false;
-    const bool ok = isRegion() ? writeRegion(path, error) : writeStandalone(path, error);
-    if (!ok) return false;
+    const std::shared_ptr<NbtDocumentSnapshot> snapshot = prepareForWriting(error);
+    if (!snapshot || !writeDocument(snapshot.get(), path, nullptr, &backupPath, error)) return false;
+    finishSave(path, backupPath);
+    return true;
+}
 
-    filePath_ = QFileInfo(path).absoluteFilePath();
+// Copies only what is decoded; the rest stays in the shared file bytes.
+std::shared_ptr<NbtDocumentSnapshot> NbtDocument::prepareForWriting(QString* error) const {
+    if (!root_) {
+        if (error) *error = tr("No document is loaded.");
+        return nullptr;
+    }
+    return snapshot(error);
+}
+
+bool NbtDocument::writeDocument(
+    NbtDocumentSnapshot* snapshot,
+    const QString& path,
+    const NbtTaskControl* control,
+    QString* backupPath,
+    QString* error
+) const {
+    if (path.isEmpty()) {
+        if (!bedrockDatabaseRecord_ && filePath_.isEmpty()) {
+            if (error) *error = tr("Choose a destination with Save As.");
+            return false;
+        }
+        if (!bedrockDatabaseRecord_) return writeDocument(snapshot, filePath_, control, backupPath, error);
+    }
+    if (!snapshot->materialize(control, error)) return false;
+    if (path.isEmpty()) return writeBedrockDatabaseRecord(snapshot->root, control, backupPath, error);
+    if (!beginStep(control, tr("Backing up %1…").arg(QFileInfo(path).fileName()), error)) return false;
+    if (!createBackupIfNeeded(path, backupPath, error)) return false;
+    return isRegion()
+        ? writeRegion(snapshot->root, path, control, error)
+        : writeStandalone(snapshot->root, path, control, error);
+}
+
+void NbtDocument::finishSave(const QString& path, const QString& backupPath) {
+    if (path.isEmpty() && bedrockDatabaseRecord_) {
+        undoStack_.setClean();
+        emit titleChanged();
+        emit statusMessage(backupPath.isEmpty()
+            ? tr("Saved Bedrock database record %1").arg(bedrockDatabaseKeyLabel_)
+            : tr("Saved Bedrock database record (backup: %1)").arg(backupPath));
+        return;
+    }
+
+    filePath_ = QFileInfo(path.isEmpty() ? filePath_ : path).absoluteFilePath();
     bedrockDatabaseRecord_ = false;
+    bedrockRootList_ = false;
     bedrockDatabaseDirectory_.clear();
     bedrockDatabaseKey_.clear();
     bedrockDatabaseKeyLabel_.clear();
     if (!isRegion()) {
-        const bool nowSnbt = QFileInfo(path).suffix().compare(QStringLiteral("snbt"), Qt::CaseInsensitive) == 0;
+        const bool nowSnbt = QFileInfo(filePath_).suffix().compare(QStringLiteral("snbt"), Qt::CaseInsensitive) == 0;
         if (sourceIsSnbt_ && !nowSnbt) {
             memset(&binaryInfo_, 0, sizeof(binaryInfo_));
             binaryInfo_.format = NBT_BINARY_JAVA;
@@ -895,30 +1461,43 @@ bool NbtDocument::saveAs(const QString& path, QString* error) {
     emit statusMessage(backupPath.isEmpty()
         ? tr("Saved %1").arg(QFileInfo(filePath_).fileName())
         : tr("Saved %1 (backup: %2)").arg(QFileInfo(filePath_).fileName(), backupPath));
-    return true;
 }
 
-bool NbtDocument::exportJson(const QString& path, QString* error) const {
-    if (!root_) {
-        if (error) *error = tr("No document is loaded.");
-        return false;
-    }
+bool NbtDocument::exportJson(const QString& path, QString* error) {
+    const std::shared_ptr<NbtDocumentSnapshot> snapshot = prepareForWriting(error);
+    return snapshot && writeJson(snapshot.get(), path, nullptr, error);
+}
+
+bool NbtDocument::writeJson(
+    NbtDocumentSnapshot* snapshot,
+    const QString& path,
+    const NbtTaskControl* control,
+    QString* error
+) const {
+    if (!snapshot->materialize(control, error)) return false;
     const QByteArray outputPath = path.toUtf8();
     char jsonError[512]{};
-    if (!nbt_write_typed_json_file(outputPath.constData(), root_, 1, jsonError, sizeof(jsonError))) {
+    if (!nbt_write_typed_json_file(outputPath.constData(), snapshot->root, 1, jsonError, sizeof(jsonError))) {
         if (error) *error = cError(jsonError, tr("Could not export JSON."));
         return false;
     }
     return true;
 }
 
-bool NbtDocument::exportSnbt(const QString& path, QString* error) const {
-    if (!root_) {
-        if (error) *error = tr("No document is loaded.");
-        return false;
-    }
+bool NbtDocument::exportSnbt(const QString& path, QString* error) {
+    const std::shared_ptr<NbtDocumentSnapshot> snapshot = prepareForWriting(error);
+    return snapshot && writeSnbt(snapshot.get(), path, nullptr, error);
+}
+
+bool NbtDocument::writeSnbt(
+    NbtDocumentSnapshot* snapshot,
+    const QString& path,
+    const NbtTaskControl* control,
+    QString* error
+) const {
+    if (!snapshot->materialize(control, error)) return false;
     char serializationError[512]{};
-    char* text = snbt_serialize(root_, 1, serializationError, sizeof(serializationError));
+    char* text = snbt_serialize(snapshot->root, 1, serializationError, sizeof(serializationError));
     if (!text) {
         if (error) *error = cError(serializationError, tr("Could not export SNBT."));
         return false;
@@ -1,9 +1,12 @@
 #ifndef CNBT_DOCUMENT_H
 #define CNBT_DOCUMENT_H
 
+#include <atomic>
 #include <functional>
+#include <memory>
 
 #include <QByteArray>
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QUndoStack>
@@ -11,9 +14,48 @@
 extern "C" {
 #include "nbt_io.h"
 #include "nbt_binary.h"
+#include "nbt_lazy.h"
 #include "nbt_parser.h"
 }
 
+class DocumentCommand;
+
+// Shared between a background load or save and the window waiting for it.
+struct NbtTaskControl {
+    std::atomic_bool cancelled{false};
+    std::function<void(const QString&)> reportStep;  // called on the worker thread
+};
+
+// A document read off the GUI thread, not yet shown anywhere.
+struct NbtLoadResult {
+    NBTTag* root = nullptr;
+    unsigned char* lazyBytes = nullptr;
+    NBTLazyDocument* lazy = nullptr;
+    NBTLoadInfo info{};
+    NBTBinaryInfo binaryInfo{};
+    bool snbt = false;
+    QString path;
+};
+
+// A private copy of a document's tree for reading on another thread. Containers
+// that were never expanded are empty in root; their payload is still in bytes.
+struct NbtDocumentSnapshot {
+    NbtDocumentSnapshot() = default;
+    NbtDocumentSnapshot(const NbtDocumentSnapshot&) = delete;
+    NbtDocumentSnapshot& operator=(const NbtDocumentSnapshot&) = delete;
+    ~NbtDocumentSnapshot();
+
+    // Decodes every collapsed container in place, so root is the whole tree.
+    // Runs on the worker that needs it; a cancel stops it between containers.
+    bool materialize(const NbtTaskControl* control, QString* error);
+
+    NBTTag* root = nullptr;
+    QHash<const NBTTag*, NBTLazyEntry> pending;
+    std::shared_ptr<const unsigned char> bytes;
+    size_t size = 0;
+    NBTBinaryFormat format = NBT_BINARY_JAVA;  // JAVA or BEDROCK payload encoding
+};
+
 class NbtDocument final : public QObject {
     Q_OBJECT
 
@@ -32,8 +74,28 @@ public:
     bool loadRegionChunk(int chunkX, int chunkZ, QString* error);
     bool save(QString* error);
     bool saveAs(const QString& path, QString* error);
-    bool exportJson(const QString& path, QString* error) const;
-    bool exportSnbt(const QString& path, QString* error) const;
+    bool exportJson(const QString& path, QString* error);
+    bool exportSnbt(const QString& path, QString* error);
+
+    /*
+     * The pieces of the calls above, for running the slow part on a worker.
+     * readFile and the write functions touch no GUI-thread state. A write
+     * works on the snapshot prepareForWriting takes, and decodes the parts
+     * of a lazily opened file that were never expanded itself. An empty save
+     * path saves the document back to where it came from.
+     */
+    static bool readFile(const QString& path, int chunkX, int chunkZ, const NbtTaskControl* control,
+                         NbtLoadResult* result, QString* error);
+    static void discardLoad(NbtLoadResult* result);
+    void adoptFile(NbtLoadResult* result);
+    std::shared_ptr<NbtDocumentSnapshot> prepareForWriting(QString* error) const;
+    bool writeDocument(NbtDocumentSnapshot* snapshot, const QString& path, const NbtTaskControl* control,
+                       QString* backupPath, QString* error) const;
+    void finishSave(const QString& path, const QString& backupPath);
+    bool writeJson(NbtDocumentSnapshot* snapshot, const QString& path, const NbtTaskControl* control,
+                   QString* error) const;
+    bool writeSnbt(NbtDocumentSnapshot* snapshot, const QString& path, const NbtTaskControl* control,
+                   QString* error) const;
 
     NBTTag* root() const { return root_; }
     const QString& filePath() const { return filePath_; }
@@ -51,6 +113,17 @@ public:
     void setBackupOnSave(bool enabled) { backupOnSave_ = enabled; }
     bool backupOnSave() const { return backupOnSave_; }
 
+    /*
+     * Binary documents open lazily: containers start out empty and their
+     * children are decoded from the retained file bytes on first use.
+     */
+    bool isLoaded(const NBTTag* tag) const { return !pending_.contains(tag); }
+    bool isAttached(const NBTTag* tag) const { return parents_.contains(tag); }
+    int childCount(const NBTTag* tag) const;
+    bool loadChildren(NBTTag* tag, QString* error);
+    bool loadSubtree(NBTTag* tag, QString* error);
+    std::shared_ptr<NbtDocumentSnapshot> snapshot(QString* error) const;
+
     bool editTag(NBTTag* tag, const QString& jsonValue, QString* error);
     bool renameTag(NBTTag* tag, NBTTag* parent, const QString& newName, QString* error);
     bool addTag(NBTTag* parent, TagType type, const QString& name, QString* error);
@@ -61,31 +134,65 @@ public:
                  NBTTag* destination, int destinationRow, QString* error);
 
 signals:
+    // Emitted when the whole root is replaced.
     void treeChanged();
+    // In-place edits. Removal is announced before the tags are freed; the
+    // other signals follow the change.
+    void tagsInserted(NBTTag* parent, int first, int last);
+    void tagsAboutToBeRemoved(NBTTag* parent, int first, int last);
+    void tagMoved(NBTTag* sourceParent, int sourceRow, NBTTag* destination, int destinationRow);
+    void tagChanged(NBTTag* tag);
     void titleChanged();
     void statusMessage(const QString& message);
 
 private:
-    bool performMutation(const QString& label, const std::function<bool(QString*)>& operation, QString* error);
-    QByteArray snapshot(QString* error) const;
-    bool restoreSnapshot(const QByteArray& bytes, QString* error);
-    bool writeStandalone(const QString& path, QString* error);
-    bool writeRegion(const QString& path, QString* error);
-    bool writeBedrockDatabaseRecord(QString* error);
+    // Tree primitives shared by the edit methods and their undo commands;
+    // each one notifies the model.
+    NBTTag* childAt(const NBTTag* parent, int row) const;
+    void exchangeValue(NBTTag* tag, NBTTag* state);
+    bool setTagName(NBTTag* parent, NBTTag* tag, const QByteArray& name);
+    bool insertChild(NBTTag* parent, int row, NBTTag* child);
+    NBTTag* takeChild(NBTTag* parent, int row);
+    bool moveChild(NBTTag* sourceParent, int sourceRow, NBTTag* destination, int destinationRow);
+    void pushCommand(DocumentCommand* command);
+    bool writeStandalone(const NBTTag* root, const QString& path, const NbtTaskControl* control,
+                         QString* error) const;
+    bool writeRegion(const NBTTag* root, const QString& path, const NbtTaskControl* control,
+                     QString* error) const;
+    bool writeBedrockDatabaseRecord(const NBTTag* root, const NbtTaskControl* control, QString* backupPath,
+                                    QString* error) const;
     bool createBackupIfNeeded(const QString& targetPath, QString* backupPath, QString* error) const;
-    void replaceRoot(NBTTag* replacement);
+    void replaceRoot(NBTTag* replacement, unsigned char* lazyBytes = nullptr, NBTLazyDocument* lazy = nullptr);
+    void releaseLazy();
+    void linkSubtree(NBTTag* tag, NBTTag* parent);
+    void linkChildren(NBTTag* tag);
+    void unlinkSubtree(const NBTTag* tag);
+    void unlinkChildren(const NBTTag* tag);
+    bool isAncestor(const NBTTag* ancestor, const NBTTag* tag) const;
+    void recordPending(const NBTTag* tag, const NBTTag* copy, NbtDocumentSnapshot* snapshot) const;
 
-    friend class DocumentSnapshotCommand;
+    friend class DocumentCommand;
+    friend class TagValueCommand;
+    friend class RenameTagCommand;
+    friend class ChildTagCommand;
+    friend class MoveTagCommand;
 
     NBTTag* root_ = nullptr;
+    std::shared_ptr<const unsigned char> lazyBytes_;  // shared with snapshots
+    NBTLazyDocument* lazy_ = nullptr;
+    QHash<const NBTTag*, const NBTLazyEntry*> pending_;
+    // Parent of every decoded tag in the tree (the root maps to null).
+    QHash<const NBTTag*, NBTTag*> parents_;
     QString filePath_;
     NBTLoadInfo loadInfo_{};
     NBTBinaryInfo binaryInfo_{};
     bool sourceIsSnbt_ = false;
     bool bedrockDatabaseRecord_ = false;
+    bool bedrockRootList_ = false;  // root_ is a synthetic list of back-to-back record roots
     QString bedrockDatabaseDirectory_;
     QByteArray bedrockDatabaseKey_;
     QString bedrockDatabaseKeyLabel_;
+    size_t undoBytes_ = 0;  // declared first so commands can update it while the stack is destroyed
     QUndoStack undoStack_;
     bool backupOnSave_ = true;
 };
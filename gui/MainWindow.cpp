@@ -1,6 +1,6 @@
 #include "MainWindow.h"
 
-#include <algorithm>
+#include <memory>
 
 #include <QAbstractItemView>
 #include <QAction>
@@ -11,6 +11,7 @@
 #include <QDialogButtonBox>
 #include <QDragEnterEvent>
 #include <QDir>
+#include <QEventLoop>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QFontDatabase>
@@ -27,10 +28,12 @@
 #include <QMessageBox>
 #include <QMimeData>
 #include <QPlainTextEdit>
+#include <QProgressDialog>
 #include <QSettings>
-#include <QSortFilterProxyModel>
 #include <QStatusBar>
 #include <QTabWidget>
+#include <QThread>
+#include <QTimer>
 #include <QToolBar>
 #include <QTreeView>
 #include <QUrl>
@@ -39,6 +42,7 @@
 #include "Document.h"
 #include "BedrockDatabaseDialog.h"
 #include "NbtTreeModel.h"
+#include "SearchIndex.h"
 
 extern "C" {
 #include "nbt_builder.h"
@@ -148,6 +152,8 @@ bool editLargeText(QWidget* parent, const QString& title, const QString& label,
     return true;
 }
 
+constexpr qsizetype kMaxShownMatches = 10000;
+
 bool isContainer(const NBTTag* tag) {
     return tag && (tag->type == TAG_Compound || tag->type == TAG_List);
 }
@@ -162,6 +168,38 @@ QString compressionName(uint8_t compression) {
     }
 }
 
+// A busy dialog that stays up until the task it covers has returned, even
+// after Cancel, so the window stays blocked while a worker is still running.
+class TaskProgressDialog final : public QProgressDialog {
+public:
+    TaskProgressDialog(const QString& label, QWidget* parent)
+        : QProgressDialog(label, QObject::tr("Cancel"), 0, 0, parent) {
+        disconnect(this, SIGNAL(canceled()), this, SLOT(cancel()));
+        setWindowModality(Qt::WindowModal);
+        setMinimumDuration(400);
+        setAutoClose(false);
+        setAutoReset(false);
+    }
+
+    bool isCancelling() const { return cancelling_; }
+
+    void markCancelled() {
+        cancelling_ = true;
+        setLabelText(QObject::tr("Cancelling…"));
+    }
+
+    void reject() override { emit canceled(); }
+
+protected:
+    void closeEvent(QCloseEvent* event) override {
+        event->ignore();
+        emit canceled();
+    }
+
+private:
+    bool cancelling_ = false;
+};
+
 }  // namespace
 
 DocumentView::DocumentView(NbtDocument* document, QWidget* parent)
@@ -175,13 +213,13 @@ DocumentView::DocumentView(NbtDocument* document, QWidget* parent)
     search_->setClearButtonEnabled(true);
     search_->setProperty("searchField", true);
 
+    searchStatus_ = new QLabel(this);
+    searchStatus_->setContentsMargins(6, 2, 6, 2);
+    searchStatus_->hide();
+
     model_ = new NbtTreeModel(document_, this);
-    proxy_ = new QSortFilterProxyModel(this);
+    proxy_ = new NbtSearchProxy(this);
     proxy_->setSourceModel(model_);
-    proxy_->setFilterCaseSensitivity(Qt::CaseInsensitive);
-    proxy_->setFilterKeyColumn(-1);
-    proxy_->setRecursiveFilteringEnabled(true);
-    proxy_->setAutoAcceptChildRows(true);
 
     tree_ = new QTreeView(this);
     tree_->setModel(proxy_);
@@ -200,19 +238,173 @@ DocumentView::DocumentView(NbtDocument* document, QWidget* parent)
     tree_->header()->resizeSection(1, 135);
     tree_->expandToDepth(1);
 
-    connect(search_, &QLineEdit::textChanged, proxy_, &QSortFilterProxyModel::setFilterFixedString);
+    // Typing restarts the query after a pause; edits rebuild the index after
+    // a longer one; streamed matches are shown at most every refresh tick.
+    searchTimer_ = new QTimer(this);
+    searchTimer_->setSingleShot(true);
+    searchTimer_->setInterval(200);
+    indexTimer_ = new QTimer(this);
+    indexTimer_->setSingleShot(true);
+    indexTimer_->setInterval(500);
+    refreshTimer_ = new QTimer(this);
+    refreshTimer_->setSingleShot(true);
+    refreshTimer_->setInterval(100);
+    connect(searchTimer_, &QTimer::timeout, this, [this] { startSearch(); });
+    connect(indexTimer_, &QTimer::timeout, this, [this] { startIndex(); });
+    connect(refreshTimer_, &QTimer::timeout, proxy_, &NbtSearchProxy::refresh);
+
+    connect(search_, &QLineEdit::textChanged, searchTimer_, qOverload<>(&QTimer::start));
     connect(search_, &QLineEdit::returnPressed, this, [this] {
-        if (proxy_->rowCount() > 0) {
-            const QModelIndex first = proxy_->index(0, 0);
+        if (searchTimer_->isActive()) {
+            searchTimer_->stop();
+            startSearch();
+        }
+        const QModelIndex first = firstMatch_
+            ? proxy_->mapFromSource(model_->indexForTag(firstMatch_))
+            : proxy_->index(0, 0);
+        if (first.isValid()) {
             tree_->setCurrentIndex(first);
             tree_->scrollTo(first);
         }
     });
+    connect(document_, &NbtDocument::treeChanged, this, [this] { invalidateIndex(); });
+    connect(document_, &NbtDocument::tagsInserted, this, [this] { invalidateIndex(); });
+    connect(document_, &NbtDocument::tagsAboutToBeRemoved, this, [this] { invalidateIndex(); });
+    connect(document_, &NbtDocument::tagMoved, this, [this] { invalidateIndex(); });
+    connect(document_, &NbtDocument::tagChanged, this, [this] { invalidateIndex(); });
 
     layout->addWidget(search_);
+    layout->addWidget(searchStatus_);
     layout->addWidget(tree_, 1);
 }
 
+DocumentView::~DocumentView() {
+    workers_.stop();
+}
+
+// Index entries are positions in the tree, so any edit makes them stale.
+void DocumentView::invalidateIndex() {
+    index_.reset();
+    ++indexGeneration_;
+    if (indexCancelled_) indexCancelled_->store(true);
+    indexCancelled_.reset();
+    if (searchCancelled_) searchCancelled_->store(true);
+    ++searchGeneration_;
+    resolved_.clear();
+    firstMatch_ = nullptr;
+    // The shown set may point at removed tags and misses new ones; show the
+    // whole tree until the next search fills it again.
+    refreshTimer_->stop();
+    proxy_->setFilterActive(false);
+    if (!search_->text().isEmpty()) indexTimer_->start();
+}
+
+void DocumentView::startIndex() {
+    if (indexCancelled_) indexCancelled_->store(true);
+    QString error;
+    std::shared_ptr<const NbtDocumentSnapshot> snapshot = document_->snapshot(&error);
+    if (!snapshot) {
+        setSearchStatus(tr("Search is unavailable: %1").arg(error));
+        return;
+    }
+    const int generation = ++indexGeneration_;
+    indexCancelled_ = workers_.run([this, snapshot, generation](const std::atomic_bool& cancelled) {
+        QString buildError;
+        std::shared_ptr<const NbtSearchIndex> index = NbtSearchIndex::build(*snapshot, cancelled, &buildError);
+        if (cancelled.load()) return;
+        QMetaObject::invokeMethod(this, [this, index, generation, buildError] {
+            if (generation != indexGeneration_) return;
+            indexCancelled_.reset();
+            if (!index) {
+                setSearchStatus(tr("Search is unavailable: %1").arg(buildError));
+                return;
+            }
+            index_ = index;
+            if (!search_->text().isEmpty()) startSearch();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void DocumentView::startSearch() {
+    if (searchCancelled_) searchCancelled_->store(true);
+    const int generation = ++searchGeneration_;
+    resolved_.clear();
+    firstMatch_ = nullptr;
+    refreshTimer_->stop();
+
+    const QString text = search_->text();
+    if (text.isEmpty()) {
+        proxy_->setFilterActive(false);
+        setSearchStatus(QString());
+        return;
+    }
+    if (!index_) {
+        setSearchStatus(tr("Indexing…"));
+        if (!indexCancelled_ && !indexTimer_->isActive()) startIndex();
+        return;
+    }
+
+    proxy_->setFilterActive(true);
+    setSearchStatus(tr("Searching…"));
+    std::shared_ptr<const NbtSearchIndex> index = index_;
+    searchCancelled_ = workers_.run([this, index, text, generation](const std::atomic_bool& cancelled) {
+        const qsizetype total = index->search(text, kMaxShownMatches, cancelled, [this, generation](std::vector<int> entries) {
+            QMetaObject::invokeMethod(this, [this, generation, entries = std::move(entries)] {
+                showMatches(generation, entries);
+            }, Qt::QueuedConnection);
+        });
+        if (total < 0) return;
+        QMetaObject::invokeMethod(this, [this, generation, total] { finishSearch(generation, total); },
+                                  Qt::QueuedConnection);
+    });
+}
+
+void DocumentView::showMatches(int generation, const std::vector<int>& entries) {
+    if (generation != searchGeneration_ || !index_) return;
+    for (int entry : entries) {
+        NBTTag* tag = resolveEntry(entry);
+        if (!tag) continue;
+        if (!firstMatch_) firstMatch_ = tag;
+        // Ancestors are shown too; stop at the first one an earlier match added.
+        for (int current = entry; current >= 0 && proxy_->showTag(resolved_.value(current));
+             current = index_->parent(current)) {}
+    }
+    if (!refreshTimer_->isActive()) refreshTimer_->start();
+}
+
+void DocumentView::finishSearch(int generation, qsizetype total) {
+    if (generation != searchGeneration_) return;
+    refreshTimer_->stop();
+    proxy_->refresh();
+    if (total == 0) setSearchStatus(tr("No matches"));
+    else if (total > kMaxShownMatches) {
+        setSearchStatus(tr("Showing the first %1 of %2 matches").arg(kMaxShownMatches).arg(total));
+    } else setSearchStatus(tr("%n match(es)", nullptr, static_cast<int>(total)));
+}
+
+// Entries come in tree order, so parents are normally resolved already; the
+// model decodes any collapsed container on the way.
+NBTTag* DocumentView::resolveEntry(int entry) {
+    const auto cached = resolved_.constFind(entry);
+    if (cached != resolved_.cend()) return cached.value();
+    const int parent = index_->parent(entry);
+    QModelIndex item;
+    if (parent < 0) {
+        item = model_->index(0, 0);
+    } else {
+        NBTTag* parentTag = resolveEntry(parent);
+        if (parentTag) item = model_->index(index_->row(entry), 0, model_->indexForTag(parentTag));
+    }
+    NBTTag* tag = model_->tagForIndex(item);
+    resolved_.insert(entry, tag);
+    return tag;
+}
+
+void DocumentView::setSearchStatus(const QString& status) {
+    searchStatus_->setText(status);
+    searchStatus_->setVisible(!status.isEmpty());
+}
+
 QModelIndex DocumentView::selectedSourceIndex() const {
     const QModelIndex selected = tree_->currentIndex();
     return selected.isValid() ? proxy_->mapToSource(selected) : QModelIndex();
@@ -652,13 +844,21 @@ bool MainWindow::openOne(const QString& path) {
         return false;
     }
 
-    auto* document = new NbtDocument();
+    NbtLoadResult loaded;
     QString error;
-    if (!document->openFile(absolutePath, &error, chunkX, chunkZ)) {
-        document->deleteLater();
-        showError(tr("Could Not Open File"), error);
+    const bool read = runInBackground(
+        tr("Opening %1…").arg(QFileInfo(absolutePath).fileName()),
+        [&](const NbtTaskControl& control, QString* taskError) {
+            return NbtDocument::readFile(absolutePath, chunkX, chunkZ, &control, &loaded, taskError);
+        },
+        &error);
+    if (!read) {
+        NbtDocument::discardLoad(&loaded);
+        if (!error.isEmpty()) showError(tr("Could Not Open File"), error);
         return false;
     }
+    auto* document = new NbtDocument();
+    document->adoptFile(&loaded);
 
     addDocumentTab(document, absolutePath + QLatin1Char('\n') + document->formatDescription());
     return true;
@@ -706,11 +906,19 @@ bool MainWindow::saveView(DocumentView* view, bool saveAs) {
         );
         if (path.isEmpty()) return false;
     }
+    NbtDocument* document = view->document();
+    const QString target = needsDestination ? path : QString();
+    QString backupPath;
     QString error;
-    const bool ok = needsDestination
-        ? view->document()->saveAs(path, &error)
-        : view->document()->save(&error);
-    if (!ok) showError(tr("Could Not Save File"), error);
+    const std::shared_ptr<NbtDocumentSnapshot> snapshot = document->prepareForWriting(&error);
+    const bool ok = snapshot && runInBackground(
+        tr("Saving %1…").arg(document->displayName()),
+        [&](const NbtTaskControl& control, QString* taskError) {
+            return document->writeDocument(snapshot.get(), target, &control, &backupPath, taskError);
+        },
+        &error);
+    if (ok) document->finishSave(target, backupPath);
+    else if (!error.isEmpty()) showError(tr("Could Not Save File"), error);
     return ok;
 }
 
@@ -725,9 +933,18 @@ void MainWindow::exportCurrentJson() {
         this, tr("Export Typed JSON"), suggested, tr("JSON document (*.json)")
     );
     if (path.isEmpty()) return;
+    NbtDocument* document = view->document();
     QString error;
-    if (!view->document()->exportJson(path, &error)) showError(tr("Could Not Export JSON"), error);
-    else statusBar()->showMessage(tr("Exported %1").arg(QFileInfo(path).fileName()), 5000);
+    const std::shared_ptr<NbtDocumentSnapshot> snapshot = document->prepareForWriting(&error);
+    const bool ok = snapshot && runInBackground(
+        tr("Exporting %1…").arg(QFileInfo(path).fileName()),
+        [&](const NbtTaskControl& control, QString* taskError) {
+            return document->writeJson(snapshot.get(), path, &control, taskError);
+        },
+        &error);
+    if (!ok) {
+        if (!error.isEmpty()) showError(tr("Could Not Export JSON"), error);
+    } else statusBar()->showMessage(tr("Exported %1").arg(QFileInfo(path).fileName()), 5000);
 }
 
 void MainWindow::exportCurrentSnbt() {
@@ -738,9 +955,18 @@ void MainWindow::exportCurrentSnbt() {
         this, tr("Export SNBT"), suggested, tr("Stringified NBT (*.snbt)")
     );
     if (path.isEmpty()) return;
+    NbtDocument* document = view->document();
     QString error;
-    if (!view->document()->exportSnbt(path, &error)) showError(tr("Could Not Export SNBT"), error);
-    else statusBar()->showMessage(tr("Exported %1").arg(QFileInfo(path).fileName()), 5000);
+    const std::shared_ptr<NbtDocumentSnapshot> snapshot = document->prepareForWriting(&error);
+    const bool ok = snapshot && runInBackground(
+        tr("Exporting %1…").arg(QFileInfo(path).fileName()),
+        [&](const NbtTaskControl& control, QString* taskError) {
+            return document->writeSnbt(snapshot.get(), path, &control, taskError);
+        },
+        &error);
+    if (!ok) {
+        if (!error.isEmpty()) showError(tr("Could Not Export SNBT"), error);
+    } else statusBar()->showMessage(tr("Exported %1").arg(QFileInfo(path).fileName()), 5000);
 }
 
 void MainWindow::closeCurrentTab() {
@@ -758,6 +984,11 @@ void MainWindow::editSelected() {
     const QModelIndex index = view->selectedSourceIndex();
     NBTTag* tag = view->model()->tagForIndex(index);
     if (!tag || tag->type == TAG_Compound || tag->type == TAG_End) return;
+    QString error;
+    if (!view->document()->loadSubtree(tag, &error)) {
+        showError(tr("Could Not Edit Tag"), error);
+        return;
+    }
     QString value = editExpression(tag);
     if (value.isNull() || (tag->type == TAG_List && value.isEmpty())) {
         showError(tr("Unsupported Direct Edit"),
@@ -769,7 +1000,6 @@ void MainWindow::editSelected() {
             tr("Edit %1").arg(QString::fromUtf8(tag->name && tag->name[0] ? tag->name : "value")),
             tr("Enter a JSON value. Numeric NBT types retain their current type."),
             &value)) return;
-    QString error;
     if (!view->document()->editTag(tag, value, &error)) showError(tr("Could Not Edit Tag"), error);
 }
 
@@ -863,6 +1093,11 @@ void MainWindow::copySelected() {
     if (!view) return;
     NBTTag* tag = view->model()->tagForIndex(view->selectedSourceIndex());
     if (!tag) return;
+    QString error;
+    if (!view->document()->loadSubtree(tag, &error)) {
+        showError(tr("Could Not Copy Tag"), error);
+        return;
+    }
     NBTTag* copy = nbt_tag_clone(tag);
     if (!copy) {
         showError(tr("Could Not Copy Tag"), tr("Out of memory while copying the selected tag."));
@@ -914,10 +1149,21 @@ void MainWindow::chooseRegionChunk() {
     int x = -1;
     int z = -1;
     if (!chooseChunk(view->document()->filePath(), &x, &z)) return;
+    const QString path = view->document()->filePath();
+    NbtLoadResult loaded;
     QString error;
-    if (!view->document()->openFile(view->document()->filePath(), &error, x, z)) {
-        showError(tr("Could Not Load Chunk"), error);
+    const bool read = runInBackground(
+        tr("Loading chunk (%1, %2)…").arg(x).arg(z),
+        [&](const NbtTaskControl& control, QString* taskError) {
+            return NbtDocument::readFile(path, x, z, &control, &loaded, taskError);
+        },
+        &error);
+    if (read) {
+        view->document()->adoptFile(&loaded);
+        return;
     }
+    NbtDocument::discardLoad(&loaded);
+    if (!error.isEmpty()) showError(tr("Could Not Load Chunk"), error);
 }
 
 void MainWindow::updateActions() {
@@ -980,6 +1226,48 @@ void MainWindow::showError(const QString& title, const QString& error) {
     QMessageBox::critical(this, title, error.isEmpty() ? tr("An unknown error occurred.") : error);
 }
 
+bool MainWindow::runInBackground(const QString& label,
+                                 const std::function<bool(const NbtTaskControl&, QString*)>& work,
+                                 QString* error) {
+    NbtTaskControl control;
+    QString taskError;
+    bool ok = false;
+
+    TaskProgressDialog progress(label, this);
+    control.reportStep = [&progress](const QString& step) {
+        QMetaObject::invokeMethod(&progress, [&progress, step] {
+            if (!progress.isCancelling()) progress.setLabelText(step);
+        }, Qt::QueuedConnection);
+    };
+
+    std::unique_ptr<QThread> thread(QThread::create([&] { ok = work(control, &taskError); }));
+    bool done = false;
+    QEventLoop loop;
+    connect(thread.get(), &QThread::finished, &loop, [&] {
+        done = true;
+        loop.quit();
+    });
+    connect(&progress, &QProgressDialog::canceled, &loop, [&] {
+        control.cancelled = true;
+        progress.markCancelled();
+    });
+    thread->start();
+
+    // The worker may be reading the tree, so keep input away from the window
+    // until the modal dialog is up to do that for us.
+    while (!done && !progress.isVisible()) {
+        QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents | QEventLoop::WaitForMoreEvents);
+    }
+    if (!done) loop.exec();
+    thread->wait();
+
+    // A worker that finished anyway has done its work (a save may already be
+    // on disk), so only a failure after the request counts as a cancel.
+    if (!ok && control.cancelled) taskError.clear();
+    if (error) *error = taskError;
+    return ok;
+}
+
 void MainWindow::closeEvent(QCloseEvent* event) {
     for (int i = tabs_->count() - 1; i >= 0; --i) {
         auto* view = static_cast<DocumentView*>(tabs_->widget(i));
@@ -1,24 +1,37 @@
 #ifndef CNBT_MAIN_WINDOW_H
 #define CNBT_MAIN_WINDOW_H
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QHash>
 #include <QMainWindow>
 
+#include "WorkerSet.h"
+
 class QAction;
 class QCloseEvent;
 class QDragEnterEvent;
 class QDropEvent;
+class QLabel;
 class QLineEdit;
-class QSortFilterProxyModel;
 class QTabWidget;
+class QTimer;
 class QTreeView;
 
 class NbtDocument;
+class NbtSearchIndex;
+class NbtSearchProxy;
 class NbtTreeModel;
 struct NBTTag;
+struct NbtTaskControl;
 
 class DocumentView final : public QWidget {
 public:
     explicit DocumentView(NbtDocument* document, QWidget* parent = nullptr);
+    ~DocumentView() override;
 
     NbtDocument* document() const { return document_; }
     NbtTreeModel* model() const { return model_; }
@@ -27,11 +40,33 @@ public:
     void focusSearch();
 
 private:
+    // Searches run against an index built on a worker from a snapshot of the
+    // tree; edits drop the index and it is rebuilt once the search is in use.
+    void invalidateIndex();
+    void startIndex();
+    void startSearch();
+    void showMatches(int generation, const std::vector<int>& entries);
+    void finishSearch(int generation, qsizetype total);
+    NBTTag* resolveEntry(int entry);
+    void setSearchStatus(const QString& status);
+
     NbtDocument* document_;
     NbtTreeModel* model_;
-    QSortFilterProxyModel* proxy_;
+    NbtSearchProxy* proxy_;
     QTreeView* tree_;
     QLineEdit* search_;
+    QLabel* searchStatus_;
+    QTimer* searchTimer_;
+    QTimer* indexTimer_;
+    QTimer* refreshTimer_;
+    std::shared_ptr<const NbtSearchIndex> index_;
+    std::shared_ptr<std::atomic_bool> indexCancelled_;
+    std::shared_ptr<std::atomic_bool> searchCancelled_;
+    int indexGeneration_ = 0;
+    int searchGeneration_ = 0;
+    QHash<int, NBTTag*> resolved_;  // index entry -> tag, for the current search
+    NBTTag* firstMatch_ = nullptr;
+    NbtWorkerSet workers_{this};
 };
 
 class MainWindow final : public QMainWindow {
@@ -80,6 +115,9 @@ private:
     bool saveView(DocumentView* view, bool saveAs);
     bool chooseChunk(const QString& path, int* chunkX, int* chunkZ);
     void showError(const QString& title, const QString& error);
+    bool runInBackground(const QString& label,
+                         const std::function<bool(const NbtTaskControl&, QString*)>& work,
+                         QString* error);
     NBTTag* destinationForPaste(DocumentView* view) const;
 
     QTabWidget* tabs_;
@@ -1,5 +1,6 @@
 #include "NbtTreeModel.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <QBrush>
@@ -25,36 +26,135 @@ QString tagName(const NBTTag* tag) {
 NbtTreeModel::NbtTreeModel(NbtDocument* document, QObject* parent)
     : QAbstractItemModel(parent), document_(document) {
     connect(document_, &NbtDocument::treeChanged, this, &NbtTreeModel::rebuild);
+    connect(document_, &NbtDocument::tagsInserted, this, &NbtTreeModel::insertTags);
+    connect(document_, &NbtDocument::tagsAboutToBeRemoved, this, &NbtTreeModel::removeTags);
+    connect(document_, &NbtDocument::tagMoved, this, &NbtTreeModel::moveTag);
+    connect(document_, &NbtDocument::tagChanged, this, &NbtTreeModel::updateTag);
     rebuild();
 }
 
-std::unique_ptr<NbtTreeModel::Node> NbtTreeModel::buildNode(NBTTag* tag, Node* parent, int row) {
+std::unique_ptr<NbtTreeModel::Node> NbtTreeModel::createNode(NBTTag* tag, Node* parent, int row) const {
     auto node = std::make_unique<Node>();
     node->tag = tag;
     node->parent = parent;
     node->row = row;
-    if (!tag) return node;
+    if (tag) nodes_.insert(tag, node.get());
+    return node;
+}
 
-    if (tag->type == TAG_Compound) {
-        node->children.reserve(tag->value.compound.count);
-        for (int i = 0; i < tag->value.compound.count; ++i) {
-            node->children.push_back(buildNode(tag->value.compound.items[i], node.get(), i));
-        }
-    } else if (tag->type == TAG_List) {
-        node->children.reserve(tag->value.list.count);
-        for (int i = 0; i < tag->value.list.count; ++i) {
-            node->children.push_back(buildNode(tag->value.list.items[i], node.get(), i));
-        }
+void NbtTreeModel::forgetNodes(const Node* node) const {
+    nodes_.remove(node->tag);
+    for (const auto& child : node->children) forgetNodes(child.get());
+}
+
+NBTTag* NbtTreeModel::childTag(const NBTTag* parent, int row) {
+    if (!parent || row < 0) return nullptr;
+    if (parent->type == TAG_Compound) {
+        return row < parent->value.compound.count ? parent->value.compound.items[row] : nullptr;
+    }
+    if (parent->type == TAG_List) {
+        return row < parent->value.list.count ? parent->value.list.items[row] : nullptr;
+    }
+    return nullptr;
+}
+
+void NbtTreeModel::renumberChildren(Node* node, int first) {
+    for (size_t i = static_cast<size_t>(std::max(first, 0)); i < node->children.size(); ++i) {
+        node->children[i]->row = static_cast<int>(i);
+    }
+}
+
+void NbtTreeModel::loadChildren(Node* node) const {
+    if (!node || node->loaded) return;
+    node->loaded = true;
+    NBTTag* tag = node->tag;
+    if (!tag || (tag->type != TAG_Compound && tag->type != TAG_List)) return;
+
+    // Views ask for rows before they display them, so filling the node here
+    // needs no insert notifications.
+    QString error;
+    if (!document_->loadChildren(tag, &error)) {
+        emit const_cast<NbtTreeModel*>(this)->operationError(error);
+        return;
+    }
+    const int count = tag->type == TAG_Compound ? tag->value.compound.count : tag->value.list.count;
+    NBTTag** items = tag->type == TAG_Compound ? tag->value.compound.items : tag->value.list.items;
+    node->children.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        node->children.push_back(createNode(items[i], node, i));
     }
-    return node;
 }
 
 void NbtTreeModel::rebuild() {
     beginResetModel();
-    rootNode_ = buildNode(document_ ? document_->root() : nullptr, nullptr, 0);
+    nodes_.clear();
+    rootNode_ = createNode(document_ ? document_->root() : nullptr, nullptr, 0);
     endResetModel();
 }
 
+// Parents whose rows were never requested are skipped: their nodes are
+// created from the current tags the first time a view asks.
+void NbtTreeModel::insertTags(NBTTag* parentTag, int first, int last) {
+    Node* parentNode = findNode(parentTag);
+    if (!parentNode || !parentNode->loaded || first < 0 || last < first ||
+        static_cast<size_t>(first) > parentNode->children.size()) return;
+    beginInsertRows(indexForNode(parentNode), first, last);
+    for (int row = first; row <= last; ++row) {
+        parentNode->children.insert(
+            parentNode->children.begin() + row, createNode(childTag(parentTag, row), parentNode, row));
+    }
+    renumberChildren(parentNode, last + 1);
+    endInsertRows();
+}
+
+void NbtTreeModel::removeTags(NBTTag* parentTag, int first, int last) {
+    Node* parentNode = findNode(parentTag);
+    if (!parentNode || !parentNode->loaded || first < 0 || last < first ||
+        static_cast<size_t>(last) >= parentNode->children.size()) return;
+    beginRemoveRows(indexForNode(parentNode), first, last);
+    for (int row = first; row <= last; ++row) forgetNodes(parentNode->children[row].get());
+    parentNode->children.erase(
+        parentNode->children.begin() + first, parentNode->children.begin() + last + 1);
+    renumberChildren(parentNode, first);
+    endRemoveRows();
+}
+
+void NbtTreeModel::moveTag(NBTTag* sourceTag, int sourceRow, NBTTag* destinationTag, int destinationRow) {
+    Node* source = findNode(sourceTag);
+    Node* destination = findNode(destinationTag);
+    const bool sourceLoaded = source && source->loaded &&
+        sourceRow >= 0 && static_cast<size_t>(sourceRow) < source->children.size();
+    const bool destinationLoaded = destination && destination->loaded;
+
+    if (sourceLoaded && destinationLoaded) {
+        // Qt counts the destination row before the source row is taken out.
+        const int qtRow = source == destination && destinationRow > sourceRow ? destinationRow + 1 : destinationRow;
+        if (!beginMoveRows(indexForNode(source), sourceRow, sourceRow, indexForNode(destination), qtRow)) return;
+        std::unique_ptr<Node> moved = std::move(source->children[sourceRow]);
+        source->children.erase(source->children.begin() + sourceRow);
+        moved->parent = destination;
+        destination->children.insert(destination->children.begin() + destinationRow, std::move(moved));
+        renumberChildren(source, 0);
+        if (destination != source) renumberChildren(destination, 0);
+        endMoveRows();
+        return;
+    }
+    if (sourceLoaded) {
+        beginRemoveRows(indexForNode(source), sourceRow, sourceRow);
+        forgetNodes(source->children[sourceRow].get());
+        source->children.erase(source->children.begin() + sourceRow);
+        renumberChildren(source, sourceRow);
+        endRemoveRows();
+    }
+    if (destinationLoaded) insertTags(destinationTag, destinationRow, destinationRow);
+}
+
+void NbtTreeModel::updateTag(NBTTag* tag) {
+    const Node* node = findNode(tag);
+    if (!node) return;
+    emit dataChanged(indexForNode(node, 0), indexForNode(node, columnCount() - 1));
+}
+
 NbtTreeModel::Node* NbtTreeModel::nodeFromIndex(const QModelIndex& index) {
     return index.isValid() ? static_cast<Node*>(index.internalPointer()) : nullptr;
 }
@@ -65,6 +165,7 @@ QModelIndex NbtTreeModel::index(int row, int column, const QModelIndex& parentIn
         return row == 0 ? createIndex(0, column, rootNode_.get()) : QModelIndex();
     }
     Node* parentNode = nodeFromIndex(parentIndex);
+    loadChildren(parentNode);
     if (!parentNode || static_cast<size_t>(row) >= parentNode->children.size()) return {};
     return createIndex(row, column, parentNode->children[row].get());
 }
@@ -80,14 +181,36 @@ int NbtTreeModel::rowCount(const QModelIndex& parentIndex) const {
     if (!parentIndex.isValid()) return 1;
     if (parentIndex.column() != 0) return 0;
     Node* parentNode = nodeFromIndex(parentIndex);
+    loadChildren(parentNode);
     return parentNode ? parentNode->children.size() : 0;
 }
 
+bool NbtTreeModel::hasChildren(const QModelIndex& parentIndex) const {
+    if (!rootNode_) return false;
+    if (!parentIndex.isValid()) return true;
+    if (parentIndex.column() != 0) return false;
+    Node* parentNode = nodeFromIndex(parentIndex);
+    if (!parentNode) return false;
+    // Collapsed rows only need to know whether to draw an expander.
+    return parentNode->loaded ? !parentNode->children.empty() : document_->childCount(parentNode->tag) > 0;
+}
+
+// rowCount() already reports the full count, so fetching never changes what a
+// view has seen; advertising it keeps proxies from loading collapsed rows.
+bool NbtTreeModel::canFetchMore(const QModelIndex& parentIndex) const {
+    Node* parentNode = nodeFromIndex(parentIndex);
+    return parentNode && !parentNode->loaded && document_->childCount(parentNode->tag) > 0;
+}
+
+void NbtTreeModel::fetchMore(const QModelIndex& parentIndex) {
+    loadChildren(nodeFromIndex(parentIndex));
+}
+
 int NbtTreeModel::columnCount(const QModelIndex&) const {
     return 3;
 }
 
-QString NbtTreeModel::valueSummary(const NBTTag* tag) {
+QString NbtTreeModel::valueSummary(const NBTTag* tag) const {
     if (!tag) return {};
     switch (tag->type) {
         case TAG_End: return QStringLiteral("End");
@@ -103,9 +226,9 @@ QString NbtTreeModel::valueSummary(const NBTTag* tag) {
         case TAG_Long_Array: return tr("%1 longs").arg(tag->value.long_array.length);
         case TAG_List:
             return tr("%1 × %2")
-                .arg(tag->value.list.count)
+                .arg(document_->childCount(tag))
                 .arg(QString::fromLatin1(nbt_tag_type_name(tag->value.list.element_type)));
-        case TAG_Compound: return tr("%1 tags").arg(tag->value.compound.count);
+        case TAG_Compound: return tr("%1 tags").arg(document_->childCount(tag));
         default: return {};
     }
 }
@@ -210,12 +333,19 @@ bool NbtTreeModel::dropMimeData(
     qint32 sourceRow = -1;
     stream >> sourceAddress >> parentAddress >> sourceRow;
 
+    // The payload may come from another tab or a stale drag; only tags that
+    // still sit at the recorded place in this model are accepted.
+    const Node* sourceNode = findNode(reinterpret_cast<const NBTTag*>(static_cast<quintptr>(sourceAddress)));
+    if (!sourceNode || !sourceNode->parent || sourceNode->row != sourceRow ||
+        sourceNode->parent->tag != reinterpret_cast<const NBTTag*>(static_cast<quintptr>(parentAddress))) {
+        return false;
+    }
     Node* destinationNode = parentIndex.isValid() ? nodeFromIndex(parentIndex) : rootNode_.get();
     if (!destinationNode || !destinationNode->tag) return false;
     QString error;
     const bool ok = document_->moveTag(
-        reinterpret_cast<NBTTag*>(static_cast<quintptr>(sourceAddress)),
-        reinterpret_cast<NBTTag*>(static_cast<quintptr>(parentAddress)),
+        sourceNode->tag,
+        sourceNode->parent->tag,
         sourceRow,
         destinationNode->tag,
         row,
@@ -249,15 +379,6 @@ QModelIndex NbtTreeModel::indexForNode(const Node* node, int column) const {
     return createIndex(node->row, column, const_cast<Node*>(node));
 }
 
-NbtTreeModel::Node* NbtTreeModel::findNode(const Node* node, const NBTTag* tag) const {
-    if (!node) return nullptr;
-    if (node->tag == tag) return const_cast<Node*>(node);
-    for (const auto& child : node->children) {
-        if (Node* match = findNode(child.get(), tag)) return match;
-    }
-    return nullptr;
-}
-
 QModelIndex NbtTreeModel::indexForTag(const NBTTag* tag) const {
-    return indexForNode(findNode(rootNode_.get(), tag));
+    return indexForNode(findNode(tag));
 }
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include <QAbstractItemModel>
+#include <QHash>
 
 #include "Document.h"
 
@@ -17,6 +18,9 @@ public:
     QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
     QModelIndex parent(const QModelIndex& child) const override;
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
@@ -36,25 +40,39 @@ public:
 public slots:
     void rebuild();
 
+private slots:
+    void insertTags(NBTTag* parent, int first, int last);
+    void removeTags(NBTTag* parent, int first, int last);
+    void moveTag(NBTTag* sourceParent, int sourceRow, NBTTag* destination, int destinationRow);
+    void updateTag(NBTTag* tag);
+
 signals:
     void operationError(const QString& message);
 
 private:
+    // Child nodes are created the first time a view asks for a parent's rows.
     struct Node {
         NBTTag* tag = nullptr;
         Node* parent = nullptr;
         int row = 0;
+        bool loaded = false;
         std::vector<std::unique_ptr<Node>> children;
     };
 
-    static std::unique_ptr<Node> buildNode(NBTTag* tag, Node* parent, int row);
-    static QString valueSummary(const NBTTag* tag);
+    std::unique_ptr<Node> createNode(NBTTag* tag, Node* parent, int row) const;
+    void forgetNodes(const Node* node) const;
+    static NBTTag* childTag(const NBTTag* parent, int row);
+    static void renumberChildren(Node* node, int first);
+    void loadChildren(Node* node) const;
+    QString valueSummary(const NBTTag* tag) const;
     static Node* nodeFromIndex(const QModelIndex& index);
     QModelIndex indexForNode(const Node* node, int column = 0) const;
-    Node* findNode(const Node* node, const NBTTag* tag) const;
+    Node* findNode(const NBTTag* tag) const { return nodes_.value(tag); }
 
     NbtDocument* document_;
     std::unique_ptr<Node> rootNode_;
+    // Every live node by tag, so edits and selection restore need no search.
+    mutable QHash<const NBTTag*, Node*> nodes_;
 };
 
 #endif
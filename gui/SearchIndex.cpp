@@ -0,0 +1,158 @@
+#include "SearchIndex.h"
+
+#include <QStringView>
+
+#include "Document.h"
+#include "NbtTreeModel.h"
+
+extern "C" {
+#include "nbt_binary.h"
+#include "nbt_builder.h"
+#include "nbt_json.h"
+}
+
+namespace {
+constexpr size_t kBatchSize = 256;
+constexpr size_t kCancelCheckInterval = 4096;
+
+// The text the tree's value column shows; containers and arrays only show
+// counts, which are not worth matching.
+QString valueText(const NBTTag* tag) {
+    switch (tag->type) {
+        case TAG_Byte: return QString::number(tag->value.byte_val);
+        case TAG_Short: return QString::number(tag->value.short_val);
+        case TAG_Int: return QString::number(tag->value.int_val);
+        case TAG_Long: return QString::number(tag->value.long_val);
+        case TAG_Float: return QString::number(tag->value.float_val, 'g', 9);
+        case TAG_Double: return QString::number(tag->value.double_val, 'g', 17);
+        case TAG_String: return QString::fromUtf8(tag->value.string_val ? tag->value.string_val : "");
+        default: return {};
+    }
+}
+}
+
+std::shared_ptr<const NbtSearchIndex> NbtSearchIndex::build(
+    const NbtDocumentSnapshot& snapshot,
+    const std::atomic_bool& cancelled,
+    QString* error
+) {
+    std::shared_ptr<NbtSearchIndex> index(new NbtSearchIndex());
+    if (snapshot.root && !index->add(snapshot.root, -1, 0, true, snapshot, cancelled, error)) return nullptr;
+    index->entries_.shrink_to_fit();
+    index->text_.squeeze();
+    return index;
+}
+
+bool NbtSearchIndex::add(
+    const NBTTag* tag,
+    int parent,
+    int row,
+    bool named,
+    const NbtDocumentSnapshot& snapshot,
+    const std::atomic_bool& cancelled,
+    QString* error
+) {
+    if (entries_.size() % kCancelCheckInterval == 0 && cancelled.load()) return false;
+
+    Entry entry{parent, row, text_.size(), 0, 0, tag->type};
+    if (named && tag->name) {
+        const QString name = QString::fromUtf8(tag->name).toCaseFolded();
+        entry.nameLength = static_cast<int>(name.size());
+        text_ += name;
+    }
+    const QString value = valueText(tag).toCaseFolded();
+    entry.valueLength = static_cast<int>(value.size());
+    text_ += value;
+    const int self = static_cast<int>(entries_.size());
+    entries_.push_back(entry);
+
+    // Collapsed containers are decoded here, one at a time, and dropped again.
+    NBTTag* decoded = nullptr;
+    const auto pending = snapshot.pending.constFind(tag);
+    if (pending != snapshot.pending.cend()) {
+        char decodeError[512]{};
+        decoded = nbt_binary_parse_payload_at(
+            snapshot.bytes.get(), snapshot.size, pending->offset, pending->type, "",
+            snapshot.format, nullptr, decodeError, sizeof(decodeError));
+        if (!decoded) {
+            if (error) {
+                *error = decodeError[0]
+                    ? QString::fromUtf8(decodeError)
+                    : QObject::tr("Could not decode a tag for searching.");
+            }
+            return false;
+        }
+        tag = decoded;
+    }
+
+    const bool list = tag->type == TAG_List;
+    const int count = list ? tag->value.list.count
+        : tag->type == TAG_Compound ? tag->value.compound.count : 0;
+    bool ok = true;
+    for (int i = 0; ok && i < count; ++i) {
+        const NBTTag* child = list ? tag->value.list.items[i] : tag->value.compound.items[i];
+        ok = add(child, self, i, !list, snapshot, cancelled, error);
+    }
+    free_nbt_tree(decoded);
+    return ok;
+}
+
+qsizetype NbtSearchIndex::search(
+    const QString& text,
+    qsizetype limit,
+    const std::atomic_bool& cancelled,
+    const MatchSink& sink
+) const {
+    const QString needle = text.toCaseFolded();
+    bool typeMatches[TAG_Long_Array + 1];
+    for (int type = TAG_End; type <= TAG_Long_Array; ++type) {
+        typeMatches[type] = QString::fromLatin1(nbt_tag_type_name(static_cast<TagType>(type)))
+            .toCaseFolded().contains(needle);
+    }
+
+    const QStringView all(text_);
+    qsizetype total = 0;
+    std::vector<int> batch;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (i % kCancelCheckInterval == 0 && cancelled.load()) return -1;
+        const Entry& entry = entries_[i];
+        const bool matches =
+            (entry.type >= TAG_End && entry.type <= TAG_Long_Array && typeMatches[entry.type]) ||
+            all.mid(entry.offset, entry.nameLength).contains(needle) ||
+            all.mid(entry.offset + entry.nameLength, entry.valueLength).contains(needle);
+        if (!matches || total++ >= limit) continue;
+        batch.push_back(static_cast<int>(i));
+        if (batch.size() >= kBatchSize) {
+            sink(std::move(batch));
+            batch = {};
+        }
+    }
+    if (!batch.empty()) sink(std::move(batch));
+    return total;
+}
+
+NbtSearchProxy::NbtSearchProxy(QObject* parent) : QSortFilterProxyModel(parent) {
+    setAutoAcceptChildRows(true);
+}
+
+void NbtSearchProxy::setFilterActive(bool active) {
+    active_ = active;
+    shown_.clear();
+    invalidateFilter();
+}
+
+bool NbtSearchProxy::showTag(const NBTTag* tag) {
+    if (shown_.contains(tag)) return false;
+    shown_.insert(tag);
+    return true;
+}
+
+void NbtSearchProxy::refresh() {
+    invalidateFilter();
+}
+
+bool NbtSearchProxy::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const {
+    if (!active_) return true;
+    const auto* model = static_cast<const NbtTreeModel*>(sourceModel());
+    return shown_.contains(model->tagForIndex(model->index(sourceRow, 0, sourceParent)));
+}
@@ -0,0 +1,88 @@
+#ifndef CNBT_SEARCH_INDEX_H
+#define CNBT_SEARCH_INDEX_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QSet>
+#include <QSortFilterProxyModel>
+#include <QString>
+
+extern "C" {
+#include "nbt_parser.h"
+}
+
+struct NbtDocumentSnapshot;
+
+/*
+ * Flat, case-folded text of every tag in a document: its name, type, and the
+ * value the tree shows for scalars and strings. Entries are in tree order and
+ * refer to their parent entry and row, so a match can be found in the model
+ * without keeping tag pointers. An index is immutable once built and can be
+ * searched from any thread.
+ */
+class NbtSearchIndex final {
+public:
+    // Batches of matching entries, in tree order.
+    using MatchSink = std::function<void(std::vector<int> entries)>;
+
+    // Returns null when cancelled or when a collapsed subtree cannot be decoded.
+    static std::shared_ptr<const NbtSearchIndex> build(const NbtDocumentSnapshot& snapshot,
+                                                       const std::atomic_bool& cancelled,
+                                                       QString* error);
+
+    /*
+     * Streams up to limit matches for text to sink and returns how many
+     * entries match in total, or -1 when cancelled.
+     */
+    qsizetype search(const QString& text, qsizetype limit, const std::atomic_bool& cancelled,
+                     const MatchSink& sink) const;
+
+    int size() const { return static_cast<int>(entries_.size()); }
+    int parent(int entry) const { return entries_[static_cast<size_t>(entry)].parent; }
+    int row(int entry) const { return entries_[static_cast<size_t>(entry)].row; }
+
+private:
+    struct Entry {
+        int parent;  // -1 for the root
+        int row;
+        qsizetype offset;  // name, then value, in text_
+        int nameLength;
+        int valueLength;
+        TagType type;
+    };
+
+    NbtSearchIndex() = default;
+    bool add(const NBTTag* tag, int parent, int row, bool named, const NbtDocumentSnapshot& snapshot,
+             const std::atomic_bool& cancelled, QString* error);
+
+    std::vector<Entry> entries_;
+    QString text_;
+};
+
+/*
+ * Shows only the rows whose tags were added with showTag (matches and their
+ * ancestors) while a filter is active, plus everything below a shown row.
+ * Each check is one set lookup, so refreshing never formats row text.
+ */
+class NbtSearchProxy final : public QSortFilterProxyModel {
+public:
+    explicit NbtSearchProxy(QObject* parent = nullptr);
+
+    void setFilterActive(bool active);
+    bool isFilterActive() const { return active_; }
+    // Returns false when the tag was already shown.
+    bool showTag(const NBTTag* tag);
+    void refresh();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+
+private:
+    bool active_ = false;
+    QSet<const NBTTag*> shown_;
+};
+
+#endif
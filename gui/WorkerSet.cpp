@@ -0,0 +1,29 @@
+#include "WorkerSet.h"
+
+#include <algorithm>
+
+#include <QObject>
+#include <QThread>
+
+std::shared_ptr<std::atomic_bool> NbtWorkerSet::run(std::function<void(const std::atomic_bool&)> work) {
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    QThread* thread = QThread::create([work = std::move(work), cancelled] { work(*cancelled); });
+    workers_.push_back({thread, cancelled});
+    QObject::connect(thread, &QThread::finished, owner_, [this, thread] {
+        workers_.erase(std::remove_if(workers_.begin(), workers_.end(), [thread](const Worker& worker) {
+            return worker.thread == thread;
+        }), workers_.end());
+        thread->deleteLater();
+    });
+    thread->start(QThread::LowPriority);
+    return cancelled;
+}
+
+void NbtWorkerSet::stop() {
+    for (const Worker& worker : workers_) worker.cancelled->store(true);
+    for (const Worker& worker : workers_) {
+        worker.thread->wait();
+        delete worker.thread;
+    }
+    workers_.clear();
+}
@@ -0,0 +1,40 @@
+#ifndef CNBT_WORKER_SET_H
+#define CNBT_WORKER_SET_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QObject;
+class QThread;
+
+/*
+ * Low-priority worker threads that belong to one GUI object. Each worker gets
+ * its own cancel flag, and a finished thread is deleted from the owner's
+ * thread. The owner calls stop() at the top of its destructor, before any of
+ * the members its workers read are destroyed.
+ */
+class NbtWorkerSet final {
+public:
+    explicit NbtWorkerSet(QObject* owner) : owner_(owner) {}
+    ~NbtWorkerSet() { stop(); }
+    NbtWorkerSet(const NbtWorkerSet&) = delete;
+    NbtWorkerSet& operator=(const NbtWorkerSet&) = delete;
+
+    // Starts work on a new thread and returns the flag that cancels it.
+    std::shared_ptr<std::atomic_bool> run(std::function<void(const std::atomic_bool&)> work);
+    // Cancels every worker and waits for all of them.
+    void stop();
+
+private:
+    struct Worker {
+        QThread* thread;
+        std::shared_ptr<std::atomic_bool> cancelled;
+    };
+
+    QObject* owner_;
+    std::vector<Worker> workers_;
+};
+
+#endif
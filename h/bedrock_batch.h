@@ -0,0 +1,96 @@
+#ifndef BEDROCK_BATCH_H
+#define BEDROCK_BATCH_H
+
+#include <stddef.h>
+
+#include "bedrock_db.h"
+
+/*
+ * Accumulates many Bedrock record writes for one bulk edit. Keys and values
+ * (NBT roots are serialized on entry) are copied into an arena and flushed
+ * through LevelDB in batches of about max_batch_bytes. Only the last batch is
+ * synchronous; its log sync also makes the earlier ones durable, so a bulk
+ * edit costs one fsync instead of one per record. Each batch is atomic, but
+ * a crash before bedrock_db_batch_finish can keep some batches and lose
+ * later ones.
+ *
+ * With a backup path, the previous value of every key is appended to one
+ * backup file before the batch that changes it is written, and the file is
+ * synced before each flush. bedrock_db_batch_restore puts those values back.
+ */
+typedef struct BedrockDBBatch BedrockDBBatch;
+
+#define BEDROCK_DB_BATCH_DEFAULT_BYTES ((size_t)4 << 20)
+
+/*
+ * max_batch_bytes 0 selects BEDROCK_DB_BATCH_DEFAULT_BYTES. backup_path may be
+ * NULL; otherwise it is created and must not exist yet.
+ */
+BedrockDBBatch* bedrock_db_batch_create(
+    BedrockDB* db,
+    size_t max_batch_bytes,
+    const char* backup_path,
+    char* err,
+    size_t err_sz
+);
+
+int bedrock_db_batch_put(
+    BedrockDBBatch* batch,
+    const unsigned char* key,
+    size_t key_size,
+    const unsigned char* value,
+    size_t value_size,
+    char* err,
+    size_t err_sz
+);
+
+/* Serializes root as one little-endian NBT root. */
+int bedrock_db_batch_put_nbt(
+    BedrockDBBatch* batch,
+    const unsigned char* key,
+    size_t key_size,
+    const NBTTag* root,
+    char* err,
+    size_t err_sz
+);
+
+/* Serializes the elements of a synthetic root list back to back. */
+int bedrock_db_batch_put_nbt_roots(
+    BedrockDBBatch* batch,
+    const unsigned char* key,
+    size_t key_size,
+    const NBTTag* list,
+    char* err,
+    size_t err_sz
+);
+
+int bedrock_db_batch_delete(
+    BedrockDBBatch* batch,
+    const unsigned char* key,
+    size_t key_size,
+    char* err,
+    size_t err_sz
+);
+
+/* Writes what is left with a synchronous batch and closes the backup file. */
+int bedrock_db_batch_finish(BedrockDBBatch* batch, char* err, size_t err_sz);
+
+/*
+ * Drops the mutations not yet flushed, syncs the batches already written,
+ * and closes the backup file, whose entries still cover every written key.
+ * Used when a bulk edit stops partway; bedrock_db_batch_written tells how
+ * many records changed.
+ */
+int bedrock_db_batch_abort(BedrockDBBatch* batch, char* err, size_t err_sz);
+
+/* Records written so far and LevelDB batches used. */
+size_t bedrock_db_batch_written(const BedrockDBBatch* batch);
+size_t bedrock_db_batch_flushes(const BedrockDBBatch* batch);
+
+/* Discards anything not yet flushed. */
+void bedrock_db_batch_free(BedrockDBBatch* batch);
+
+/* Restores every value saved in a batch backup file in one atomic, synchronous write batch. */
+int bedrock_db_batch_restore(BedrockDB* db, const char* backup_path, char* err, size_t err_sz);
+
+#endif
@@ -6,6 +6,7 @@
 #include "nbt_parser.h"
 
 typedef struct BedrockDB BedrockDB;
+typedef struct BedrockDBSnapshot BedrockDBSnapshot;
 
 typedef enum {
     BEDROCK_DB_LOGICAL_READ_ONLY = 0,
@@ -34,6 +35,38 @@ typedef int (*BedrockDBIterateFn)(
     void* user_data
 );
 
+/*
+ * Receives each key with its value's size and the first value_prefix_size
+ * bytes of the value (fewer when the value is shorter; NULL when no prefix
+ * was requested). Return nonzero to continue, or zero to stop successfully.
+ */
+typedef int (*BedrockDBScanFn)(
+    const unsigned char* key,
+    size_t key_size,
+    size_t value_size,
+    const unsigned char* value_prefix,
+    size_t value_prefix_size,
+    void* user_data
+);
+
+typedef struct {
+    const unsigned char* start;  /* first key, inclusive; NULL for the first record */
+    size_t start_size;
+    const unsigned char* end;    /* stop key, exclusive; NULL for no upper bound */
+    size_t end_size;
+    size_t value_prefix_size;    /* 0 to receive sizes only, SIZE_MAX for whole values */
+    int fill_cache;              /* keep scanned blocks in LevelDB's block cache */
+    const BedrockDBSnapshot* snapshot;  /* NULL to read the latest state */
+} BedrockDBScanOptions;
+
+/* A key range for size estimates and compaction. */
+typedef struct {
+    const unsigned char* start;  /* first key, inclusive; NULL for the first record */
+    size_t start_size;
+    const unsigned char* end;    /* stop key, exclusive; NULL for no upper bound */
+    size_t end_size;
+} BedrockDBRange;
+
 /*
  * Opens a Bedrock world's `db` directory through the Amulet-Team LevelDB fork.
  * In self-contained desktop builds, library_path is ignored because the fork
@@ -78,6 +111,81 @@ int bedrock_db_iterate(
     size_t err_sz
 );
 
+/*
+ * Visits keys in [start, end) in key order after one seek, so a bounded
+ * lookup costs O(log n) plus the records it returns. A NULL start begins at
+ * the first key and a NULL end runs to the last.
+ */
+int bedrock_db_iterate_range(
+    BedrockDB* db,
+    const unsigned char* start,
+    size_t start_size,
+    const unsigned char* end,
+    size_t end_size,
+    BedrockDBIterateFn callback,
+    void* user_data,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * Visits every key that starts with prefix, e.g. "actorprefix" or a chunk
+ * prefix from bedrock_chunk_key_prefix().
+ */
+int bedrock_db_iterate_prefix(
+    BedrockDB* db,
+    const unsigned char* prefix,
+    size_t prefix_size,
+    BedrockDBIterateFn callback,
+    void* user_data,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * A consistent point-in-time view for scans. LevelDB is safe to read from
+ * several threads, so one snapshot can back concurrent scans over disjoint
+ * ranges. Release it before closing the database.
+ */
+BedrockDBSnapshot* bedrock_db_snapshot_create(BedrockDB* db, char* err, size_t err_sz);
+void bedrock_db_snapshot_release(BedrockDB* db, BedrockDBSnapshot* snapshot);
+
+/*
+ * Lists keys in [start, end) in key order without copying values, seeking
+ * straight to start. LevelDB stores keys and values in the same data blocks,
+ * so every block in the range is still read; leave fill_cache off for large
+ * scans so they do not evict the blocks other reads are using.
+ */
+int bedrock_db_scan(
+    BedrockDB* db,
+    const BedrockDBScanOptions* options,
+    BedrockDBScanFn callback,
+    void* user_data,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * Estimates the compressed bytes each range occupies in table files, from the
+ * file index alone. Recent writes still in the log are not counted, and
+ * deleted or overwritten values count until compaction drops them.
+ */
+int bedrock_db_approximate_sizes(
+    BedrockDB* db,
+    const BedrockDBRange* ranges,
+    size_t range_count,
+    uint64_t* out_sizes,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * Compacts range (NULL for the whole database) into the last level, dropping
+ * deleted and overwritten values. The logical content does not change, but
+ * table files are rewritten, so this needs a read-write database.
+ */
+int bedrock_db_compact_range(BedrockDB* db, const BedrockDBRange* range, char* err, size_t err_sz);
+
 /* Applies all mutations in one synchronous, WAL-backed LevelDB write batch. */
 int bedrock_db_apply_mutations(
     BedrockDB* db,
@@ -87,6 +195,20 @@ int bedrock_db_apply_mutations(
     size_t err_sz
 );
 
+/*
+ * Applies mutations as one atomic LevelDB write batch. Without sync the batch
+ * reaches the log but is not fsynced, so a crash can lose it (never only part
+ * of it); the next synchronous write makes it durable. See bedrock_batch.h.
+ */
+int bedrock_db_write_mutations(
+    BedrockDB* db,
+    const BedrockDBMutation* mutations,
+    size_t mutation_count,
+    int sync,
+    char* err,
+    size_t err_sz
+);
+
 /* Convenience helpers for values that are exactly one little-endian NBT root. */
 NBTTag* bedrock_db_get_nbt(
     BedrockDB* db,
@@ -106,4 +228,26 @@ int bedrock_db_put_nbt(
     size_t err_sz
 );
 
+/*
+ * The same for values made of unnamed little-endian roots stored back to back
+ * (block entities, entities, ...), presented as a synthetic TAG_List.
+ */
+NBTTag* bedrock_db_get_nbt_roots(
+    BedrockDB* db,
+    const unsigned char* key,
+    size_t key_size,
+    int* out_found,
+    char* err,
+    size_t err_sz
+);
+
+int bedrock_db_put_nbt_roots(
+    BedrockDB* db,
+    const unsigned char* key,
+    size_t key_size,
+    const NBTTag* list,
+    char* err,
+    size_t err_sz
+);
+
 #endif
@@ -0,0 +1,75 @@
+#ifndef BEDROCK_KEYS_H
+#define BEDROCK_KEYS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Bedrock chunk records are keyed by little-endian int32 x and z, an int32
+ * dimension that is omitted for the Overworld, a one-byte record tag, and for
+ * per-subchunk records a signed subchunk index:
+ *
+ *   x z tag                  9 bytes
+ *   x z tag subchunk        10 bytes
+ *   x z dim tag             13 bytes
+ *   x z dim tag subchunk    14 bytes
+ */
+#define BEDROCK_CHUNK_KEY_MAX 14
+
+#define BEDROCK_DIMENSION_OVERWORLD 0
+#define BEDROCK_DIMENSION_NETHER 1
+#define BEDROCK_DIMENSION_END 2
+
+#define BEDROCK_TAG_DATA_3D 0x2B
+#define BEDROCK_TAG_VERSION 0x2C
+#define BEDROCK_TAG_DATA_2D 0x2D
+#define BEDROCK_TAG_SUBCHUNK_PREFIX 0x2F
+#define BEDROCK_TAG_BLOCK_ENTITY 0x31
+#define BEDROCK_TAG_ENTITY 0x32
+#define BEDROCK_TAG_PENDING_TICKS 0x33
+#define BEDROCK_TAG_LEGACY_VERSION 0x76
+
+typedef struct {
+    int32_t x;
+    int32_t z;
+    int32_t dimension;
+    unsigned char tag;
+    int has_subchunk;
+    int8_t subchunk;
+} BedrockChunkKey;
+
+/* Writes the key into out and returns its size. */
+size_t bedrock_chunk_key_build(const BedrockChunkKey* key, unsigned char out[BEDROCK_CHUNK_KEY_MAX]);
+
+/*
+ * Writes the x, z, [dimension] prefix shared by one chunk's records and
+ * returns its size. An Overworld prefix also begins the same column's keys in
+ * other dimensions, so prefix scans should check the parsed dimension.
+ */
+size_t bedrock_chunk_key_prefix(int32_t x, int32_t z, int32_t dimension,
+                                unsigned char out[BEDROCK_CHUNK_KEY_MAX]);
+
+/*
+ * Returns 1 when key has a chunk-key size and a known record tag. Other keys
+ * (player data, villages, "~local_player", ...) return 0.
+ */
+int bedrock_chunk_key_parse(const unsigned char* key, size_t key_size, BedrockChunkKey* out);
+
+/* "SubChunkPrefix", "BlockEntity", ...; NULL for an unknown tag. */
+const char* bedrock_chunk_record_name(unsigned char tag);
+
+/*
+ * A short, static record kind for grouping keys: the record name for chunk
+ * keys, the family of well-known global keys ("actorprefix", "digp",
+ * "player", "VILLAGE", "map", ...), or "Other".
+ */
+const char* bedrock_key_kind(const unsigned char* key, size_t key_size);
+
+/*
+ * Writes the smallest key greater than every key starting with prefix into
+ * out (which holds prefix_size bytes) and returns its size, or 0 when no such
+ * key exists because the prefix is empty or all 0xFF.
+ */
+size_t bedrock_key_prefix_end(const unsigned char* prefix, size_t prefix_size, unsigned char* out);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef BEDROCK_SUBCHUNK_H
+#define BEDROCK_SUBCHUNK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nbt_parser.h"
+
+/*
+ * Read-only decoder for Bedrock SubChunkPrefix (0x2F) values in the paletted
+ * formats, versions 1, 8 and 9:
+ *
+ *   version [storage count (8, 9)] [y index (9)] storage...
+ *
+ * Each block storage is a header byte (bits per block << 1, low bit set only
+ * for network runtime IDs), ceil(4096 / (32 / bits)) little-endian uint32
+ * words of packed palette indices, a uint32 palette size, and that many
+ * little-endian NBT roots stored back to back. Zero bits per block stores no
+ * words and no size: the palette has exactly one entry. Indices are in XZY
+ * order, i.e. (x << 8) | (z << 4) | y. Storage 0 holds blocks; a second one
+ * usually holds waterlogging.
+ */
+#define BEDROCK_SUBCHUNK_VOLUME 4096
+
+typedef struct {
+    NBTTag* state;     /* palette root, usually {name, states, version} */
+    const char* name;  /* the root's "name" string, or "" */
+    uint32_t count;    /* blocks in the storage using this entry */
+} BedrockPaletteEntry;
+
+typedef struct {
+    int bits_per_block;
+    uint32_t palette_size;
+    BedrockPaletteEntry* palette;
+    uint32_t invalid_count;  /* indices past the end of the palette */
+    uint16_t* indices;       /* BEDROCK_SUBCHUNK_VOLUME entries, or NULL */
+} BedrockBlockStorage;
+
+typedef struct {
+    int version;
+    int has_y;
+    int8_t y;
+    size_t storage_count;
+    BedrockBlockStorage* storages;
+    size_t bytes_consumed;
+} BedrockSubChunk;
+
+/* Keep the unpacked per-block indices, not just the palette counts. */
+#define BEDROCK_SUBCHUNK_KEEP_INDICES 1
+
+/*
+ * Decodes one SubChunkPrefix value. Palette counts always form the block
+ * histogram of each storage. Legacy versions (0, 2-7) and runtime-ID palettes
+ * are rejected with an error.
+ */
+BedrockSubChunk* bedrock_subchunk_decode(
+    const unsigned char* data,
+    size_t size,
+    int flags,
+    char* err,
+    size_t err_sz
+);
+
+void bedrock_subchunk_free(BedrockSubChunk* subchunk);
+
+/*
+ * Unpacks the index words of a storage into BEDROCK_SUBCHUNK_VOLUME entries
+ * of out. Returns 0 for an unsupported bits_per_block.
+ */
+int bedrock_unpack_block_indices(const unsigned char* words, int bits_per_block, uint16_t* out);
+
+/* The number of bytes of index words for bits_per_block, or 0 when it has none. */
+size_t bedrock_block_index_bytes(int bits_per_block);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef CNBT_CLI_BEDROCK_H
+#define CNBT_CLI_BEDROCK_H
+
+#include <stddef.h>
+
+#include "nbt_find.h"
+
+/*
+ * Bedrock world database commands. path may name a world folder or its db
+ * folder. The Amulet LevelDB library is bundled in CMake builds and is
+ * otherwise loaded from NBT_EXPLORER_LEVELDB_LIBRARY.
+ */
+
+/* Returns the LevelDB directory for a world or db folder; the caller frees it. */
+char* cli_bedrock_db_directory(const char* path, char* err, size_t err_sz);
+
+/*
+ * Writes every record whose value is one or more little-endian NBT roots to
+ * output_path as JSON Lines ({"key": hex, "kind": ..., "root": typed node},
+ * or "roots": [...] for back-to-back roots), in key order, and prints
+ * per-kind record counts and throughput. The keyspace is split into ranges
+ * that worker threads scan over one snapshot.
+ */
+int cli_bedrock_export(const char* path, const char* output_path, char* err, size_t err_sz);
+
+/*
+ * Decodes every paletted SubChunkPrefix record and prints how many blocks of
+ * each name the world holds, counting the block storage of each subchunk.
+ */
+int cli_bedrock_blocks(const char* path, char* err, size_t err_sz);
+
+/*
+ * Prints where a world's space goes in one streaming pass over key and value
+ * sizes: records and bytes by kind and by dimension, and live bytes next to
+ * LevelDB's approximate table size for sixteen key ranges. With
+ * compact_copy_path, the db folder is then copied there, the copy is fully
+ * compacted, and the table sizes are printed again.
+ */
+int cli_bedrock_stats(const char* path, const char* compact_copy_path, char* err, size_t err_sz);
+
+/*
+ * Runs a replacing find over every NBT record and writes the changed ones
+ * through a bulk batch with a single sync at the end. With backup set, the
+ * previous values go to one file under <world>/cnbt-record-backups.
+ */
+int cli_bedrock_replace(const char* path, const NBTFind* find, int backup, char* err, size_t err_sz);
+
+/* Puts back the values saved in a bulk backup file. */
+int cli_bedrock_restore(const char* path, const char* backup_path, char* err, size_t err_sz);
+
+#endif
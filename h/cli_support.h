@@ -4,8 +4,10 @@
 #include <stddef.h>
 
 #include "nbt_binary.h"
+#include "nbt_find.h"
 #include "nbt_io.h"
 #include "nbt_parser.h"
+#include "nbt_query.h"
 
 unsigned char* cli_read_file(const char* path, size_t* out_size, char* err, size_t err_sz);
 char* cli_append_suffix(const char* path, const char* suffix);
@@ -24,5 +26,22 @@ int cli_write_binary_document(
 int cli_write_snbt_document(const char* path, const NBTTag* root, char* err, size_t err_sz);
 int cli_dump_tree(const char* path, const NBTTag* root, char* err, size_t err_sz);
 int cli_list_region_chunks(const char* path, char* err, size_t err_sz);
+int cli_list_cubic_world(const char* directory, char* err, size_t err_sz);
+int cli_verify_region(const char* path, int full_rehash, char* err, size_t err_sz);
+
+/* Print matches as one cnbt-query-v1 JSON document on stdout. */
+int cli_query_regions(const char* path, const NBTQuery* query, char* err, size_t err_sz);
+int cli_query_document(const char* source, const NBTTag* root, const NBTQuery* query, char* err, size_t err_sz);
+
+/*
+ * Without a replacement, print matches as one cnbt-find-v1 JSON document.
+ * With one, rewrite each changed region in place (after copying it to
+ * <region><backup_suffix> when the suffix is not NULL) and print a summary.
+ * A region with chunks that failed to decode is left unchanged unless
+ * allow_partial is set, and any failed chunk makes the replace fail.
+ */
+int cli_find_regions(const char* path, const NBTFind* find, const char* backup_suffix, int allow_partial,
+                     char* err, size_t err_sz);
+int cli_find_document(const char* source, NBTTag* root, const NBTFind* find, char* err, size_t err_sz);
 
 #endif
@@ -0,0 +1,67 @@
+#ifndef CUBIC_WORLD_H
+#define CUBIC_WORLD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "nbt_io.h"
+#include "nbt_parser.h"
+
+/*
+ * Enumerates the legacy Cubic Chunks r2.<x>.<y>.<z> files of one world
+ * directory. Files are grouped into columns sharing (x, z) and ordered by y,
+ * so a whole column can be streamed bottom to top without one process per
+ * file.
+ */
+typedef struct {
+    char* path;
+    int region_x;
+    int cube_y;
+    int region_z;
+} CubicRegionFileRef;
+
+typedef struct {
+    int region_x;
+    int region_z;
+    size_t first_file;
+    size_t file_count;
+} CubicColumn;
+
+typedef struct {
+    CubicRegionFileRef* files;
+    size_t file_count;
+    CubicColumn* columns;
+    size_t column_count;
+} CubicWorld;
+
+typedef struct {
+    const CubicRegionFileRef* file;
+    int local_x;
+    int local_z;
+    uint32_t timestamp;
+    NBTInputFormat compression;
+    const NBTTag* root;
+} CubicCube;
+
+/* Return 0 to stop the iteration early. */
+typedef int (*CubicCubeFn)(const CubicCube* cube, void* user);
+
+CubicWorld* cubic_world_scan(const char* directory, char* err, size_t err_sz);
+void cubic_world_free(CubicWorld* world);
+
+/*
+ * Streams every cube of one column in ascending y, then local slot order.
+ * Region files are read, decompressed, and parsed on worker threads a few
+ * files ahead of the callback, which always runs on the calling thread.
+ */
+int cubic_world_iterate_column(
+    const CubicWorld* world,
+    size_t column_index,
+    CubicCubeFn fn,
+    void* user,
+    char* err,
+    size_t err_sz
+);
+
+int cubic_world_iterate(const CubicWorld* world, CubicCubeFn fn, void* user, char* err, size_t err_sz);
+
+#endif
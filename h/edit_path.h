@@ -19,6 +19,24 @@ typedef struct {
     int index;
 } PathTarget;
 
+/*
+ * A path parsed once and resolved against any number of roots. Keys are
+ * decoded and hashed at compile time, so execution does no tokenizing and
+ * only allocates the returned target array and its cursor buffers.
+ */
+typedef struct EditPathProgram EditPathProgram;
+
+EditStatus edit_path_compile(const char* path, EditPathProgram** out_program, char* err, size_t err_sz);
+EditStatus edit_path_execute(
+    const EditPathProgram* program,
+    NBTTag* root,
+    PathTarget** out_targets,
+    size_t* out_count,
+    char* err,
+    size_t err_sz
+);
+void edit_path_program_free(EditPathProgram* program);
+
 EditStatus resolve_edit_path(NBTTag* root, const char* path, PathTarget* out, char* err, size_t err_sz);
 EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_targets, size_t* out_count, char* err, size_t err_sz);
 void free_edit_paths(PathTarget* targets);
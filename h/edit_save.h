@@ -25,6 +25,14 @@ EditStatus delete_tag_by_path(NBTTag* root, const char* path, char* err, size_t
 EditStatus rename_tag_by_path(NBTTag* root, const char* path, const char* new_name, char* err, size_t err_sz);
 const char* edit_status_name(EditStatus status);
 
+/* Variants taking a path compiled with edit_path_compile and a value from
+ * edit_value_prepare, for applying one edit to many roots (for example
+ * every chunk of a region). */
+struct EditPathProgram;
+struct EditPreparedValue;
+EditStatus edit_tag_by_program(NBTTag* root, const struct EditPathProgram* program, struct EditPreparedValue* value, char* err, size_t err_sz);
+EditStatus delete_tag_by_program(NBTTag* root, const struct EditPathProgram* program, char* err, size_t err_sz);
+
 /* Backward-compat utility: returns only direct tag targets. */
 NBTTag* find_tag_by_path(NBTTag* root, const char* path);
 
@@ -10,4 +10,18 @@ EditStatus parse_json_for_list_element(NBTTag* list_tag, int index, const char*
 EditStatus parse_json_for_array_element(NBTTag* array_tag, int index, const char* value_expr, char* err, size_t err_sz);
 EditStatus create_tag_from_json_expr(const char* tag_name, const char* value_expr, NBTTag** out_tag, char* err, size_t err_sz);
 
+/*
+ * A value expression tokenized once for applying to many targets. The first
+ * target of each tag type decodes the literal into a private template; later
+ * targets of that type receive a copy of it. Compound targets are patched
+ * from the shared token array. Not safe for concurrent use.
+ */
+typedef struct EditPreparedValue EditPreparedValue;
+
+EditStatus edit_value_prepare(const char* value_expr, EditPreparedValue** out_value, char* err, size_t err_sz);
+void edit_value_free(EditPreparedValue* value);
+EditStatus edit_value_apply_to_tag(EditPreparedValue* value, NBTTag* target, char* err, size_t err_sz);
+EditStatus edit_value_apply_to_list_element(EditPreparedValue* value, NBTTag* list_tag, int index, char* err, size_t err_sz);
+EditStatus edit_value_apply_to_array_element(EditPreparedValue* value, NBTTag* array_tag, int index, char* err, size_t err_sz);
+
 #endif
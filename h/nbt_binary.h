@@ -41,6 +41,89 @@ NBTTag* nbt_binary_parse(
     size_t err_sz
 );
 
+/*
+ * Random access into a raw (unenveloped) Java or Bedrock payload stream.
+ * offset points at the payload of a tag of the given type, i.e. just past its
+ * type byte and name. Skipping follows length prefixes without allocating;
+ * both functions report the offset one past the payload through out_end.
+ */
+int nbt_binary_skip_payload(
+    const unsigned char* data,
+    size_t size,
+    size_t offset,
+    TagType type,
+    NBTBinaryFormat format,
+    size_t* out_end,
+    char* err,
+    size_t err_sz
+);
+
+NBTTag* nbt_binary_parse_payload_at(
+    const unsigned char* data,
+    size_t size,
+    size_t offset,
+    TagType type,
+    const char* name,
+    NBTBinaryFormat format,
+    size_t* out_end,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * Iterates named roots stored back to back in one raw Java or Bedrock buffer,
+ * as Bedrock does for block entities, entities, and palettes. The buffer is
+ * not copied and must outlive the iterator. Set offset after init to start
+ * past a prefix; it always holds the start of the next root.
+ */
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    size_t count;  /* roots returned so far */
+    NBTBinaryFormat format;
+} NBTBinaryRoots;
+
+void nbt_binary_roots_init(
+    NBTBinaryRoots* roots,
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format
+);
+
+/*
+ * Returns 1 with the next root in *out_root, 0 at the end of the buffer, or
+ * -1 on malformed input. A NULL out_root skips the root without allocating.
+ */
+int nbt_binary_roots_next(NBTBinaryRoots* roots, NBTTag** out_root, char* err, size_t err_sz);
+
+/*
+ * Parses a whole buffer of unnamed roots into a synthetic, unnamed TAG_List
+ * so it can be browsed and edited like one document. Fails for an empty
+ * buffer, named roots, or roots of different types.
+ */
+NBTTag* nbt_binary_parse_root_list(
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * Writes each element of a TAG_List as an unnamed root, back to back. Fails
+ * for an empty list or elements of different types, which would not parse
+ * back as a root list.
+ */
+int nbt_binary_serialize_root_list(
+    const NBTTag* list,
+    NBTBinaryFormat format,
+    unsigned char** out_data,
+    size_t* out_size,
+    char* err,
+    size_t err_sz
+);
+
 /* Serialize Java, Bedrock, or an enveloped Bedrock level.dat document. */
 int nbt_binary_serialize(
     const NBTTag* root,
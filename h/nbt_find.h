@@ -0,0 +1,82 @@
+#ifndef NBT_FIND_H
+#define NBT_FIND_H
+
+#include <stddef.h>
+#include "nbt_parser.h"
+
+/*
+ * Typed find and replace over NBT trees. Every criterion that is set must
+ * hold for a tag to match:
+ *
+ *   name_glob    '*' and '?' over the tag's own name ("" for list elements)
+ *   type         one tag type, or -1 for any
+ *   min / max    numeric tags (Byte through Double) inside the range
+ *   value_regex  string tags containing a match
+ *
+ * Regular expressions are a portable subset: literals, '.', bracket classes
+ * with ranges and '^' negation, \d \w \s (and their negations), the '*' '+'
+ * '?' quantifiers, and '^' / '$' anchors. There is no grouping or
+ * alternation. ignore_case folds ASCII letters in the glob and the regex.
+ *
+ * A replacement is applied to each match during the same walk that finds
+ * it, and the walk does not descend into a tag it has just replaced:
+ *
+ *   NBT_REPLACE_VALUE  set the match from a JSON value expression, with the
+ *                      same typing rules as --edit
+ *   NBT_REPLACE_TEXT   substitute text for every regex match inside matching
+ *                      string values (requires value_regex)
+ *
+ * A compiled finder is immutable and may be run from several threads at
+ * once, provided the trees it runs over are not shared between them.
+ */
+typedef struct NBTFind NBTFind;
+
+typedef enum {
+    NBT_REPLACE_NONE = 0,
+    NBT_REPLACE_VALUE,
+    NBT_REPLACE_TEXT
+} NBTReplaceMode;
+
+typedef struct {
+    const char* name_glob;
+    int type;
+    int has_min;
+    double min;
+    int has_max;
+    double max;
+    const char* value_regex;
+    int ignore_case;
+    NBTReplaceMode replace;
+    const char* replacement;
+} NBTFindOptions;
+
+typedef struct {
+    size_t matched;
+    size_t replaced;
+} NBTFindStats;
+
+/*
+ * Receives each match, after any replacement, with its edit path. Return 0
+ * to stop the walk early.
+ */
+typedef int (*NBTFindMatchFn)(const NBTTag* match, const char* path, void* user);
+
+NBTFind* nbt_find_compile(const NBTFindOptions* options, char* err, size_t err_sz);
+void nbt_find_free(NBTFind* find);
+int nbt_find_replaces(const NBTFind* find);
+
+/* fn may be NULL to only count and replace. stats may be NULL. */
+int nbt_find_run(
+    const NBTFind* find,
+    NBTTag* root,
+    NBTFindMatchFn fn,
+    void* user,
+    NBTFindStats* stats,
+    char* err,
+    size_t err_sz
+);
+
+/* Accepts "Int", "int_array", "Long Array", "compound", or a numeric id. */
+int nbt_find_parse_type(const char* text, TagType* out_type);
+
+#endif
@@ -27,6 +27,21 @@ int nbt_write_typed_json_file(
     size_t err_sz
 );
 
+/*
+ * Writes one node object of the typed schema (no envelope, no trailing
+ * newline) with path as its edit path; used for streaming match output.
+ */
+int nbt_write_typed_json_node(
+    FILE* out,
+    const NBTTag* node,
+    const char* path,
+    int pretty,
+    char* err,
+    size_t err_sz
+);
+
+int nbt_write_json_string(FILE* out, const char* text);
+
 const char* nbt_tag_type_name(TagType type);
 
 #endif
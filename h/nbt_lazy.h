@@ -0,0 +1,78 @@
+#ifndef NBT_LAZY_H
+#define NBT_LAZY_H
+
+#include <stddef.h>
+
+#include "nbt_binary.h"
+#include "nbt_parser.h"
+
+/*
+ * Lazy access to a binary NBT document. Opening runs one allocation-free
+ * skip scan to validate the layout; the children of a compound or list are
+ * indexed (type, name, payload offset and length) the first time they are
+ * asked for, and subtrees are decoded only when materialized.
+ *
+ * The document borrows data, which must outlive it. Entry pointers stay valid
+ * until nbt_lazy_close. A document is not safe to use from several threads.
+ */
+typedef struct NBTLazyDocument NBTLazyDocument;
+
+typedef struct {
+    TagType type;
+    const char* name;  /* points into the buffer; not NUL-terminated */
+    size_t name_len;
+    size_t offset;     /* first payload byte */
+    size_t length;     /* payload bytes */
+} NBTLazyEntry;
+
+NBTLazyDocument* nbt_lazy_open(
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format,
+    NBTBinaryInfo* info,
+    char* err,
+    size_t err_sz
+);
+void nbt_lazy_close(NBTLazyDocument* document);
+
+const NBTLazyEntry* nbt_lazy_root(const NBTLazyDocument* document);
+
+/* Returns the indexed children of a compound or list, building them once. */
+int nbt_lazy_children(
+    NBTLazyDocument* document,
+    const NBTLazyEntry* parent,
+    const NBTLazyEntry** out_children,
+    int* out_count,
+    char* err,
+    size_t err_sz
+);
+
+/* First child of a compound named name, or NULL (err is left empty when it is just absent). */
+const NBTLazyEntry* nbt_lazy_find_child(
+    NBTLazyDocument* document,
+    const NBTLazyEntry* parent,
+    const char* name,
+    char* err,
+    size_t err_sz
+);
+
+/* Decodes the whole subtree below entry. */
+NBTTag* nbt_lazy_materialize(
+    const NBTLazyDocument* document,
+    const NBTLazyEntry* entry,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * Decodes entry without its children: compounds and lists come back empty
+ * (lists keep their element type) so callers can fill them on demand.
+ */
+NBTTag* nbt_lazy_materialize_shallow(
+    const NBTLazyDocument* document,
+    const NBTLazyEntry* entry,
+    char* err,
+    size_t err_sz
+);
+
+#endif
@@ -21,10 +21,13 @@ typedef enum {
 } TagType;
 
 struct NBTTag;
+struct NBTCompoundIndex;
 
 typedef struct {
     int count;
     struct NBTTag** items;
+    /* Lazily built name lookup table owned by nbt_tree.c; may be NULL. */
+    struct NBTCompoundIndex* index;
 } Compound;
 
 typedef struct {
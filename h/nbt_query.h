@@ -0,0 +1,70 @@
+#ifndef NBT_QUERY_H
+#define NBT_QUERY_H
+
+#include <stddef.h>
+#include "nbt_binary.h"
+#include "nbt_parser.h"
+
+/*
+ * Compiled selectors over NBT trees. The syntax extends edit paths:
+ *
+ *   Level/Entities        child keys, separated by '/' or '.'
+ *   "odd key"             quoted keys (same escapes as edit paths)
+ *   *                     every child of a compound, list, or array
+ *   ..CustomName  ..*     recursive descent below the current node
+ *   [3]  [-1]  [*]        list/array elements, negative from the end
+ *   [?expr]               keep list elements (or the current node when it is
+ *                         not a list) for which expr holds
+ *   {id, hp: Health}      trailing projection into a new compound
+ *
+ * Predicates combine comparisons (== != < <= > >=) between relative paths,
+ * '@' (the candidate itself), numbers, "strings", true and false with
+ * &&, || and !; a bare relative path tests for existence. Comparisons with a
+ * missing operand are false. Projection fields that do not resolve are left
+ * out of the result. Example:
+ *
+ *   Entities[?id=="minecraft:villager" && Health<5]{id, Pos}
+ *
+ * A compiled query is immutable and may be run from several threads at once,
+ * provided the trees it runs over are not shared between them.
+ */
+typedef struct NBTQuery NBTQuery;
+
+/*
+ * Receives each match with its concrete edit path. Array elements and
+ * projections are temporaries that are only valid during the call.
+ * Return 0 to stop the query early.
+ */
+typedef int (*NBTQueryMatchFn)(const NBTTag* match, const char* path, void* user);
+
+NBTQuery* nbt_query_compile(const char* expression, char* err, size_t err_sz);
+void nbt_query_free(NBTQuery* query);
+
+int nbt_query_run(
+    const NBTQuery* query,
+    const NBTTag* root,
+    NBTQueryMatchFn fn,
+    void* user,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * Runs the query directly over a binary document without building its tree.
+ * Subtrees off the query path are skipped by their length prefixes; matches,
+ * filter candidates, and projections are decoded on demand. format must be
+ * Java, Bedrock, or an enveloped Bedrock level.dat; bytes after the root are
+ * ignored.
+ */
+int nbt_query_run_binary(
+    const NBTQuery* query,
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format,
+    NBTQueryMatchFn fn,
+    void* user,
+    char* err,
+    size_t err_sz
+);
+
+#endif
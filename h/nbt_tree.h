@@ -6,7 +6,19 @@
 NBTTag* nbt_tag_create(TagType type, const char* name);
 NBTTag* nbt_tag_clone(const NBTTag* source);
 
+/* FNV-1a over a tag name; callers resolving the same key repeatedly can
+ * hash it once and use nbt_compound_find_hashed, which probes the index of a
+ * large compound with that hash instead of rehashing the name. */
+uint32_t nbt_name_hash(const char* name, size_t len);
+
+/*
+ * Name lookups on large compounds build a hash index on first use. The
+ * functions below keep it current; code that edits compound.items or a
+ * child's name directly must call nbt_compound_invalidate_index afterwards.
+ */
 int nbt_compound_find_index(const NBTTag* compound, const char* name);
+int nbt_compound_find_hashed(const NBTTag* compound, const char* name, size_t len, uint32_t hash);
+void nbt_compound_invalidate_index(NBTTag* compound);
 int nbt_compound_insert(NBTTag* compound, int index, NBTTag* child);
 int nbt_compound_append(NBTTag* compound, NBTTag* child);
 NBTTag* nbt_compound_take(NBTTag* compound, int index);
@@ -16,5 +28,6 @@ int nbt_list_append(NBTTag* list, NBTTag* child);
 NBTTag* nbt_list_take(NBTTag* list, int index);
 
 int nbt_tag_rename(NBTTag* tag, const char* new_name);
+int nbt_compound_rename_child(NBTTag* compound, NBTTag* child, const char* new_name);
 
 #endif
@@ -2,6 +2,7 @@
 #define NBT_EXPLORER_PLATFORM_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 /* Small, explicit portability layer shared by the core, CLI, and GUI. */
@@ -28,6 +29,47 @@ int nbt_remove_file(const char* path);
 /* Replaces target_path with temp_path, including on Windows. */
 int nbt_replace_file(const char* temp_path, const char* target_path, char* err, size_t err_sz);
 
+/* 64-bit positioning for region files that outgrow a 32-bit long. */
+int nbt_fseek64(FILE* stream, uint64_t offset);
+int nbt_file_size(FILE* stream, uint64_t* out_size);
+
+/* Reads a whole file into a malloc'd buffer; the caller frees it. */
+unsigned char* nbt_read_file(const char* path, size_t* out_size, char* err, size_t err_sz);
+
+/* Flushes a written file (or, on POSIX, a directory entry) to stable storage. */
+int nbt_fsync_file(FILE* stream);
+int nbt_sync_parent_directory(const char* path);
+
+int nbt_cpu_count(void);
+
+int nbt_is_directory(const char* path);
+/* Creates one directory level; an existing directory counts as success. */
+int nbt_make_directory(const char* path);
+
+/* Calls fn with each entry name in directory (excluding "." and ".."). fn returns 0 to stop. */
+typedef int (*NBTDirectoryEntryFn)(const char* name, void* user);
+int nbt_list_directory(
+    const char* directory,
+    NBTDirectoryEntryFn fn,
+    void* user,
+    char* err,
+    size_t err_sz
+);
+
+/*
+ * Minimal background work queue used for overlapping sidecar I/O and
+ * independent decodes. Tasks start as soon as they are submitted; when no
+ * worker thread can be created they run inline inside nbt_work_queue_submit.
+ * A task reports failure by returning 0 and keeps its own error text.
+ */
+typedef int (*NBTTaskFn)(void* task);
+typedef struct NBTWorkQueue NBTWorkQueue;
+
+NBTWorkQueue* nbt_work_queue_create(int max_workers);
+void nbt_work_queue_submit(NBTWorkQueue* queue, NBTTaskFn fn, void* task);
+/* Waits for every submitted task, frees the queue, and returns 1 if all succeeded. */
+int nbt_work_queue_finish(NBTWorkQueue* queue);
+
 /* File-descriptor helpers used when redirecting CLI output. */
 int nbt_dup_fd(int fd);
 int nbt_dup2_fd(int source_fd, int destination_fd);
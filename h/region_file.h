@@ -18,6 +18,8 @@
 #define REGION_COMPRESSION_NONE 3
 #define REGION_COMPRESSION_LZ4 4
 #define REGION_EXTERNAL_STREAM_FLAG 0x80U
+/* Oversized .mcc sidecars are few but large; a handful of readers or writers saturates most disks. */
+#define REGION_SIDECAR_IO_WORKERS 4
 
 typedef enum {
     REGION_LAYOUT_STANDARD = 0,
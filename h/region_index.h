@@ -0,0 +1,73 @@
+#ifndef REGION_INDEX_H
+#define REGION_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "region_file.h"
+
+/*
+ * Optional per-region sidecar (<region>.cnbtidx) caching a fingerprint of the
+ * 8 KiB header and an XXH64 hash of every stored chunk record. Verification
+ * only re-reads chunks whose location or timestamp moved since the index was
+ * written, which keeps periodic integrity sweeps incremental.
+ */
+#define REGION_INDEX_SUFFIX ".cnbtidx"
+
+typedef struct {
+    uint32_t location;
+    uint32_t timestamp;
+    uint32_t stored_length;
+    uint32_t external;
+    uint64_t hash;
+} RegionIndexEntry;
+
+typedef struct {
+    RegionLayout layout;
+    uint64_t file_size;
+    uint64_t header_fingerprint;
+    RegionIndexEntry entries[REGION_CHUNK_COUNT];
+} RegionIndex;
+
+typedef enum {
+    REGION_VERIFY_EMPTY = 0,
+    REGION_VERIFY_REUSED,
+    REGION_VERIFY_HASHED,
+    REGION_VERIFY_MISMATCH
+} RegionVerifyStatus;
+
+typedef struct {
+    int populated;
+    int reused;
+    int hashed;
+    int mismatched;
+    int header_unchanged;
+    uint64_t bytes_hashed;
+    uint8_t status[REGION_CHUNK_COUNT];
+} RegionVerifyReport;
+
+uint64_t region_index_hash(const void* data, size_t size, uint64_t seed);
+
+char* region_index_path(const char* region_path);
+
+/* Returns 1 when loaded, 0 when no index exists, and -1 when it is unusable. */
+int region_index_load(const char* index_path, RegionIndex* out_index, char* err, size_t err_sz);
+int region_index_save(const char* index_path, const RegionIndex* index, char* err, size_t err_sz);
+
+/*
+ * Validates the region layout and hashes chunk records into out_index.
+ * Entries unchanged since previous are trusted unless full_rehash is set;
+ * a re-hashed chunk whose timestamp did not change must match its cached
+ * hash or it is reported as REGION_VERIFY_MISMATCH. previous may be NULL.
+ * Structural corruption fails the call with a message in err.
+ */
+int region_index_verify(
+    const char* region_path,
+    const RegionIndex* previous,
+    int full_rehash,
+    RegionIndex* out_index,
+    RegionVerifyReport* report,
+    char* err,
+    size_t err_sz
+);
+
+#endif
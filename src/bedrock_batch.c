@@ -0,0 +1,436 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bedrock_batch.h"
+#include "nbt_binary.h"
+#include "platform.h"
+
+#define ARENA_BLOCK_BYTES ((size_t)64 << 10)
+#define BACKUP_MAGIC "CNBTBAK1"
+#define BACKUP_MAGIC_SIZE 8
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t capacity;
+    unsigned char data[];
+} ArenaBlock;
+
+struct BedrockDBBatch {
+    BedrockDB* db;
+    size_t max_bytes;
+    ArenaBlock* arena;  /* newest block first */
+    BedrockDBMutation* mutations;
+    size_t count;
+    size_t capacity;
+    size_t pending_bytes;
+    size_t written;
+    size_t flushes;
+    int unsynced;       /* a flushed batch still waits for a log sync */
+    int failed;
+    FILE* backup;
+    char* backup_path;
+};
+
+static void set_error(char* err, size_t err_sz, const char* message) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s", message);
+}
+
+/* Returns size bytes in the arena; pointers stay valid until the next reset. */
+static unsigned char* arena_alloc(BedrockDBBatch* batch, size_t size) {
+    ArenaBlock* block = batch->arena;
+    unsigned char* bytes;
+    if (!block || block->capacity - block->used < size) {
+        size_t capacity = size > ARENA_BLOCK_BYTES ? size : ARENA_BLOCK_BYTES;
+        block = malloc(sizeof(*block) + capacity);
+        if (!block) return NULL;
+        block->next = batch->arena;
+        block->used = 0;
+        block->capacity = capacity;
+        batch->arena = block;
+    }
+    bytes = block->data + block->used;
+    block->used += size;
+    return bytes;
+}
+
+/* Keeps the newest block for the next batch and frees the rest. */
+static void arena_reset(BedrockDBBatch* batch) {
+    ArenaBlock* block;
+    if (!batch->arena) return;
+    block = batch->arena->next;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    batch->arena->next = NULL;
+    batch->arena->used = 0;
+}
+
+static int write_le(FILE* out, uint64_t value, size_t width) {
+    unsigned char bytes[8];
+    size_t i;
+    for (i = 0; i < width; i++) bytes[i] = (unsigned char)(value >> (i * 8));
+    return fwrite(bytes, 1, width, out) == width;
+}
+
+static uint64_t read_le(const unsigned char* bytes, size_t width) {
+    uint64_t value = 0;
+    size_t i;
+    for (i = width; i > 0; i--) value = (value << 8) | bytes[i - 1];
+    return value;
+}
+
+/*
+ * Backup entries are: uint32 key size, key, uint8 found, uint64 value size,
+ * value, all little-endian. A key changed twice is saved twice; restoring in
+ * reverse order leaves its oldest value in place.
+ */
+static int backup_previous(BedrockDBBatch* batch, const unsigned char* key, size_t key_size,
+                           char* err, size_t err_sz) {
+    unsigned char* value = NULL;
+    size_t value_size = 0;
+    int found = 0;
+    int ok;
+    if (key_size > UINT32_MAX) {
+        set_error(err, err_sz, "Bedrock record key is too large to back up");
+        return 0;
+    }
+    if (!bedrock_db_get(batch->db, key, key_size, &value, &value_size, &found, err, err_sz)) return 0;
+    ok = write_le(batch->backup, key_size, 4) &&
+         (key_size == 0 || fwrite(key, 1, key_size, batch->backup) == key_size) &&
+         write_le(batch->backup, found ? 1 : 0, 1) &&
+         write_le(batch->backup, found ? value_size : 0, 8) &&
+         (!found || value_size == 0 || fwrite(value, 1, value_size, batch->backup) == value_size);
+    free(value);
+    if (!ok) set_error(err, err_sz, "failed to write the Bedrock record backup");
+    return ok;
+}
+
+static int flush_batch(BedrockDBBatch* batch, int sync, char* err, size_t err_sz) {
+    /* The backup must be on disk before the values it protects change. */
+    if (batch->backup && !nbt_fsync_file(batch->backup)) {
+        set_error(err, err_sz, "failed to sync the Bedrock record backup");
+        batch->failed = 1;
+        return 0;
+    }
+    if (!bedrock_db_write_mutations(batch->db, batch->mutations, batch->count, sync, err, err_sz)) {
+        batch->failed = 1;
+        return 0;
+    }
+    if (batch->count > 0) batch->flushes++;
+    batch->written += batch->count;
+    batch->unsynced = !sync;
+    batch->count = 0;
+    batch->pending_bytes = 0;
+    arena_reset(batch);
+    return 1;
+}
+
+static int add_mutation(
+    BedrockDBBatch* batch,
+    BedrockDBMutationType type,
+    const unsigned char* key,
+    size_t key_size,
+    const unsigned char* value,
+    size_t value_size,
+    char* err,
+    size_t err_sz
+) {
+    BedrockDBMutation* mutation;
+    unsigned char* bytes;
+
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!batch || (!key && key_size > 0) || (!value && value_size > 0)) {
+        set_error(err, err_sz, "invalid Bedrock batch mutation arguments");
+        return 0;
+    }
+    if (batch->failed) {
+        set_error(err, err_sz, "an earlier Bedrock batch write failed");
+        return 0;
+    }
+    if (value_size > SIZE_MAX - key_size) {
+        set_error(err, err_sz, "Bedrock record is too large");
+        return 0;
+    }
+    if (batch->count > 0 &&
+        (batch->pending_bytes >= batch->max_bytes ||
+         key_size + value_size > batch->max_bytes - batch->pending_bytes) &&
+        !flush_batch(batch, 0, err, err_sz)) return 0;
+    if (batch->backup && !backup_previous(batch, key, key_size, err, err_sz)) {
+        batch->failed = 1;
+        return 0;
+    }
+    if (batch->count == batch->capacity) {
+        size_t capacity = batch->capacity ? batch->capacity * 2 : 256;
+        BedrockDBMutation* grown = realloc(batch->mutations, capacity * sizeof(*grown));
+        if (!grown) {
+            set_error(err, err_sz, "out of memory while batching Bedrock writes");
+            return 0;
+        }
+        batch->mutations = grown;
+        batch->capacity = capacity;
+    }
+    /* One allocation holds the key and the value; never NULL, even when empty. */
+    bytes = arena_alloc(batch, key_size + value_size + 1);
+    if (!bytes) {
+        set_error(err, err_sz, "out of memory while batching Bedrock writes");
+        return 0;
+    }
+    if (key_size > 0) memcpy(bytes, key, key_size);
+    if (value_size > 0) memcpy(bytes + key_size, value, value_size);
+    mutation = &batch->mutations[batch->count++];
+    mutation->type = type;
+    mutation->key = bytes;
+    mutation->key_size = key_size;
+    mutation->value = type == BEDROCK_DB_PUT ? bytes + key_size : NULL;
+    mutation->value_size = type == BEDROCK_DB_PUT ? value_size : 0;
+    batch->pending_bytes += key_size + value_size;
+    return 1;
+}
+
+BedrockDBBatch* bedrock_db_batch_create(
+    BedrockDB* db,
+    size_t max_batch_bytes,
+    const char* backup_path,
+    char* err,
+    size_t err_sz
+) {
+    BedrockDBBatch* batch;
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!db) {
+        set_error(err, err_sz, "invalid Bedrock batch arguments");
+        return NULL;
+    }
+    if (!bedrock_db_is_writable(db)) {
+        set_error(err, err_sz, "Bedrock LevelDB was opened in logical read-only mode");
+        return NULL;
+    }
+    batch = calloc(1, sizeof(*batch));
+    if (!batch) {
+        set_error(err, err_sz, "out of memory while creating a Bedrock batch");
+        return NULL;
+    }
+    batch->db = db;
+    batch->max_bytes = max_batch_bytes ? max_batch_bytes : BEDROCK_DB_BATCH_DEFAULT_BYTES;
+    if (backup_path) {
+        batch->backup_path = nbt_strdup(backup_path);
+        /* Exclusive, so an earlier backup is never truncated. */
+        errno = 0;
+        batch->backup = batch->backup_path ? nbt_fopen(backup_path, "wbx") : NULL;
+        if (!batch->backup || fwrite(BACKUP_MAGIC, 1, BACKUP_MAGIC_SIZE, batch->backup) != BACKUP_MAGIC_SIZE) {
+            if (err && err_sz > 0) {
+                snprintf(err, err_sz, errno == EEXIST ? "Bedrock backup %s already exists"
+                                                      : "could not create Bedrock backup %s", backup_path);
+            }
+            bedrock_db_batch_free(batch);
+            return NULL;
+        }
+    }
+    return batch;
+}
+
+int bedrock_db_batch_put(
+    BedrockDBBatch* batch,
+    const unsigned char* key,
+    size_t key_size,
+    const unsigned char* value,
+    size_t value_size,
+    char* err,
+    size_t err_sz
+) {
+    return add_mutation(batch, BEDROCK_DB_PUT, key, key_size, value, value_size, err, err_sz);
+}
+
+int bedrock_db_batch_put_nbt(
+    BedrockDBBatch* batch,
+    const unsigned char* key,
+    size_t key_size,
+    const NBTTag* root,
+    char* err,
+    size_t err_sz
+) {
+    unsigned char* value = NULL;
+    size_t value_size = 0;
+    int ok;
+    if (!nbt_binary_serialize(root, NBT_BINARY_BEDROCK, 0, &value, &value_size, err, err_sz)) return 0;
+    ok = add_mutation(batch, BEDROCK_DB_PUT, key, key_size, value, value_size, err, err_sz);
+    free(value);
+    return ok;
+}
+
+int bedrock_db_batch_put_nbt_roots(
+    BedrockDBBatch* batch,
+    const unsigned char* key,
+    size_t key_size,
+    const NBTTag* list,
+    char* err,
+    size_t err_sz
+) {
+    unsigned char* value = NULL;
+    size_t value_size = 0;
+    int ok;
+    if (!nbt_binary_serialize_root_list(list, NBT_BINARY_BEDROCK, &value, &value_size, err, err_sz)) return 0;
+    ok = add_mutation(batch, BEDROCK_DB_PUT, key, key_size, value, value_size, err, err_sz);
+    free(value);
+    return ok;
+}
+
+int bedrock_db_batch_delete(
+    BedrockDBBatch* batch,
+    const unsigned char* key,
+    size_t key_size,
+    char* err,
+    size_t err_sz
+) {
+    return add_mutation(batch, BEDROCK_DB_DELETE, key, key_size, NULL, 0, err, err_sz);
+}
+
+static int close_backup(BedrockDBBatch* batch, char* err, size_t err_sz) {
+    FILE* backup = batch->backup;
+    int synced;
+    batch->backup = NULL;
+    if (!backup) return 1;
+    synced = nbt_fsync_file(backup);
+    if (fclose(backup) != 0 || !synced || !nbt_sync_parent_directory(batch->backup_path)) {
+        set_error(err, err_sz, "failed to finish the Bedrock record backup");
+        return 0;
+    }
+    return 1;
+}
+
+int bedrock_db_batch_finish(BedrockDBBatch* batch, char* err, size_t err_sz) {
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!batch) {
+        set_error(err, err_sz, "invalid Bedrock batch arguments");
+        return 0;
+    }
+    if (batch->failed) {
+        set_error(err, err_sz, "an earlier Bedrock batch write failed");
+        return 0;
+    }
+    if ((batch->count > 0 || batch->unsynced) && !flush_batch(batch, 1, err, err_sz)) return 0;
+    return close_backup(batch, err, err_sz);
+}
+
+int bedrock_db_batch_abort(BedrockDBBatch* batch, char* err, size_t err_sz) {
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!batch) {
+        set_error(err, err_sz, "invalid Bedrock batch arguments");
+        return 0;
+    }
+    batch->count = 0;
+    batch->pending_bytes = 0;
+    arena_reset(batch);
+    /* An empty synchronous write syncs the log behind the earlier batches. */
+    if (batch->unsynced && !bedrock_db_write_mutations(batch->db, NULL, 0, 1, err, err_sz)) return 0;
+    batch->unsynced = 0;
+    return close_backup(batch, err, err_sz);
+}
+
+size_t bedrock_db_batch_written(const BedrockDBBatch* batch) {
+    return batch ? batch->written : 0;
+}
+
+size_t bedrock_db_batch_flushes(const BedrockDBBatch* batch) {
+    return batch ? batch->flushes : 0;
+}
+
+void bedrock_db_batch_free(BedrockDBBatch* batch) {
+    if (!batch) return;
+    arena_reset(batch);
+    free(batch->arena);
+    free(batch->mutations);
+    if (batch->backup) fclose(batch->backup);
+    free(batch->backup_path);
+    free(batch);
+}
+
+static unsigned char* read_backup(const char* path, size_t* out_size, char* err, size_t err_sz) {
+    FILE* file = nbt_fopen(path, "rb");
+    unsigned char* data = NULL;
+    uint64_t size = 0;
+    if (!file) {
+        if (err && err_sz > 0) snprintf(err, err_sz, "could not open Bedrock backup %s", path);
+        return NULL;
+    }
+    if (!nbt_file_size(file, &size) || size > SIZE_MAX || size < BACKUP_MAGIC_SIZE ||
+        !(data = malloc((size_t)size)) || fread(data, 1, (size_t)size, file) != (size_t)size ||
+        memcmp(data, BACKUP_MAGIC, BACKUP_MAGIC_SIZE) != 0) {
+        set_error(err, err_sz, "not a readable Bedrock record backup");
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *out_size = (size_t)size;
+    return data;
+}
+
+int bedrock_db_batch_restore(BedrockDB* db, const char* backup_path, char* err, size_t err_sz) {
+    BedrockDBMutation* entries = NULL;
+    unsigned char* data;
+    size_t size = 0;
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t pos = BACKUP_MAGIC_SIZE;
+    int ok = 0;
+
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!db || !backup_path) {
+        set_error(err, err_sz, "invalid Bedrock restore arguments");
+        return 0;
+    }
+    data = read_backup(backup_path, &size, err, err_sz);
+    if (!data) return 0;
+    while (pos < size) {
+        BedrockDBMutation entry;
+        uint64_t value_size;
+        if (size - pos < 4 || (entry.key_size = (size_t)read_le(data + pos, 4)) > size - pos - 4 ||
+            size - pos - 4 - entry.key_size < 9) {
+            set_error(err, err_sz, "Bedrock record backup is truncated");
+            goto done;
+        }
+        entry.key = data + pos + 4;
+        pos += 4 + entry.key_size;
+        entry.type = data[pos] ? BEDROCK_DB_PUT : BEDROCK_DB_DELETE;
+        value_size = read_le(data + pos + 1, 8);
+        pos += 9;
+        if (value_size > size - pos) {
+            set_error(err, err_sz, "Bedrock record backup is truncated");
+            goto done;
+        }
+        entry.value = data + pos;
+        entry.value_size = (size_t)value_size;
+        pos += entry.value_size;
+        if (count == capacity) {
+            size_t grown_capacity = capacity ? capacity * 2 : 256;
+            BedrockDBMutation* grown = realloc(entries, grown_capacity * sizeof(*grown));
+            if (!grown) {
+                set_error(err, err_sz, "out of memory while reading a Bedrock backup");
+                goto done;
+            }
+            entries = grown;
+            capacity = grown_capacity;
+        }
+        entries[count++] = entry;
+    }
+
+    /* Newest entries first, so a key saved twice ends at its oldest value. */
+    for (size_t i = 0; i < count / 2; ++i) {
+        BedrockDBMutation swap = entries[i];
+        entries[i] = entries[count - 1 - i];
+        entries[count - 1 - i] = swap;
+    }
+    /* One synchronous write batch, so a failed restore changes nothing. */
+    ok = bedrock_db_write_mutations(db, entries, count, 1, err, err_sz);
+
+done:
+    free(entries);
+    free(data);
+    return ok;
+}
@@ -1,9 +1,11 @@
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "bedrock_db.h"
+#include "bedrock_keys.h"
 #include "nbt_binary.h"
 #include "nbt_builder.h"
 
@@ -24,6 +26,7 @@ typedef void* BedrockLibrary;
 
 typedef struct leveldb_t leveldb_t;
 typedef struct leveldb_iterator_t leveldb_iterator_t;
+typedef struct leveldb_snapshot_t leveldb_snapshot_t;
 typedef struct leveldb_options_t leveldb_options_t;
 typedef struct leveldb_readoptions_t leveldb_readoptions_t;
 typedef struct leveldb_writebatch_t leveldb_writebatch_t;
@@ -42,11 +45,19 @@ typedef struct {
     void (*iter_destroy)(leveldb_iterator_t*);
     uint8_t (*iter_valid)(const leveldb_iterator_t*);
     void (*iter_seek_to_first)(leveldb_iterator_t*);
+    void (*iter_seek)(leveldb_iterator_t*, const char*, size_t);
     void (*iter_next)(leveldb_iterator_t*);
     const char* (*iter_key)(const leveldb_iterator_t*, size_t*);
     const char* (*iter_value)(const leveldb_iterator_t*, size_t*);
     void (*iter_get_error)(const leveldb_iterator_t*, char**);
 
+    void (*approximate_sizes)(leveldb_t*, int, const char* const*, const size_t*,
+                              const char* const*, const size_t*, uint64_t*);
+    void (*compact_range)(leveldb_t*, const char*, size_t, const char*, size_t);
+
+    const leveldb_snapshot_t* (*create_snapshot)(leveldb_t*);
+    void (*release_snapshot)(leveldb_t*, const leveldb_snapshot_t*);
+
     leveldb_options_t* (*options_create)(void);
     void (*options_destroy)(leveldb_options_t*);
     void (*options_set_create_if_missing)(leveldb_options_t*, uint8_t);
@@ -59,6 +70,7 @@ typedef struct {
     void (*readoptions_destroy)(leveldb_readoptions_t*);
     void (*readoptions_set_verify_checksums)(leveldb_readoptions_t*, uint8_t);
     void (*readoptions_set_fill_cache)(leveldb_readoptions_t*, uint8_t);
+    void (*readoptions_set_snapshot)(leveldb_readoptions_t*, const leveldb_snapshot_t*);
 
     leveldb_writeoptions_t* (*writeoptions_create)(void);
     void (*writeoptions_destroy)(leveldb_writeoptions_t*);
@@ -79,9 +91,14 @@ struct BedrockDB {
     leveldb_options_t* options;
     leveldb_readoptions_t* read_options;
     leveldb_writeoptions_t* write_options;
+    leveldb_writeoptions_t* unsynced_write_options;
     BedrockDBOpenMode mode;
 };
 
+struct BedrockDBSnapshot {
+    const leveldb_snapshot_t* snapshot;
+};
+
 static void set_error(char* err, size_t err_sz, const char* message) {
     if (err && err_sz > 0) snprintf(err, err_sz, "%s", message);
 }
@@ -202,10 +219,15 @@ static int load_leveldb_api(
     api->iter_destroy = leveldb_iter_destroy;
     api->iter_valid = leveldb_iter_valid;
     api->iter_seek_to_first = leveldb_iter_seek_to_first;
+    api->iter_seek = leveldb_iter_seek;
     api->iter_next = leveldb_iter_next;
     api->iter_key = leveldb_iter_key;
     api->iter_value = leveldb_iter_value;
     api->iter_get_error = leveldb_iter_get_error;
+    api->approximate_sizes = leveldb_approximate_sizes;
+    api->compact_range = leveldb_compact_range;
+    api->create_snapshot = leveldb_create_snapshot;
+    api->release_snapshot = leveldb_release_snapshot;
     api->options_create = leveldb_options_create;
     api->options_destroy = leveldb_options_destroy;
     api->options_set_create_if_missing = leveldb_options_set_create_if_missing;
@@ -218,6 +240,7 @@ static int load_leveldb_api(
     api->readoptions_destroy = leveldb_readoptions_destroy;
     api->readoptions_set_verify_checksums = leveldb_readoptions_set_verify_checksums;
     api->readoptions_set_fill_cache = leveldb_readoptions_set_fill_cache;
+    api->readoptions_set_snapshot = leveldb_readoptions_set_snapshot;
     api->writeoptions_create = leveldb_writeoptions_create;
     api->writeoptions_destroy = leveldb_writeoptions_destroy;
     api->writeoptions_set_sync = leveldb_writeoptions_set_sync;
@@ -246,10 +269,15 @@ static int load_leveldb_api(
     REQUIRED(iter_destroy, "leveldb_iter_destroy");
     REQUIRED(iter_valid, "leveldb_iter_valid");
     REQUIRED(iter_seek_to_first, "leveldb_iter_seek_to_first");
+    REQUIRED(iter_seek, "leveldb_iter_seek");
     REQUIRED(iter_next, "leveldb_iter_next");
     REQUIRED(iter_key, "leveldb_iter_key");
     REQUIRED(iter_value, "leveldb_iter_value");
     REQUIRED(iter_get_error, "leveldb_iter_get_error");
+    REQUIRED(approximate_sizes, "leveldb_approximate_sizes");
+    REQUIRED(compact_range, "leveldb_compact_range");
+    REQUIRED(create_snapshot, "leveldb_create_snapshot");
+    REQUIRED(release_snapshot, "leveldb_release_snapshot");
     REQUIRED(options_create, "leveldb_options_create");
     REQUIRED(options_destroy, "leveldb_options_destroy");
     REQUIRED(options_set_create_if_missing, "leveldb_options_set_create_if_missing");
@@ -260,6 +288,7 @@ static int load_leveldb_api(
     REQUIRED(readoptions_destroy, "leveldb_readoptions_destroy");
     REQUIRED(readoptions_set_verify_checksums, "leveldb_readoptions_set_verify_checksums");
     REQUIRED(readoptions_set_fill_cache, "leveldb_readoptions_set_fill_cache");
+    REQUIRED(readoptions_set_snapshot, "leveldb_readoptions_set_snapshot");
     REQUIRED(writeoptions_create, "leveldb_writeoptions_create");
     REQUIRED(writeoptions_destroy, "leveldb_writeoptions_destroy");
     REQUIRED(writeoptions_set_sync, "leveldb_writeoptions_set_sync");
@@ -317,7 +346,8 @@ BedrockDB* bedrock_db_open(
     db->options = db->api.options_create();
     db->read_options = db->api.readoptions_create();
     db->write_options = db->api.writeoptions_create();
-    if (!db->options || !db->read_options || !db->write_options) {
+    db->unsynced_write_options = db->api.writeoptions_create();
+    if (!db->options || !db->read_options || !db->write_options || !db->unsynced_write_options) {
         set_error(err, err_sz, "Bedrock LevelDB library failed to allocate options");
         goto fail;
     }
@@ -330,6 +360,7 @@ BedrockDB* bedrock_db_open(
     db->api.readoptions_set_verify_checksums(db->read_options, 1);
     db->api.readoptions_set_fill_cache(db->read_options, 1);
     db->api.writeoptions_set_sync(db->write_options, 1);
+    db->api.writeoptions_set_sync(db->unsynced_write_options, 0);
 
     db->database = db->api.open(db->options, db_directory, &backend_error);
     if (backend_error || !db->database) {
@@ -353,6 +384,8 @@ void bedrock_db_close(BedrockDB* db) {
         db->api.readoptions_destroy(db->read_options);
     if (db->write_options && db->api.writeoptions_destroy)
         db->api.writeoptions_destroy(db->write_options);
+    if (db->unsynced_write_options && db->api.writeoptions_destroy)
+        db->api.writeoptions_destroy(db->unsynced_write_options);
     if (db->options && db->api.options_destroy) db->api.options_destroy(db->options);
     memset(db, 0, sizeof(*db));
     free(db);
@@ -409,17 +442,65 @@ int bedrock_db_get(
     return 1;
 }
 
+BedrockDBSnapshot* bedrock_db_snapshot_create(BedrockDB* db, char* err, size_t err_sz) {
+    BedrockDBSnapshot* snapshot;
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!db || !db->database) {
+        set_error(err, err_sz, "invalid Bedrock LevelDB snapshot arguments");
+        return NULL;
+    }
+    snapshot = calloc(1, sizeof(*snapshot));
+    if (!snapshot) {
+        set_error(err, err_sz, "out of memory while creating a Bedrock LevelDB snapshot");
+        return NULL;
+    }
+    snapshot->snapshot = db->api.create_snapshot(db->database);
+    if (!snapshot->snapshot) {
+        free(snapshot);
+        set_error(err, err_sz, "Bedrock LevelDB failed to create a snapshot");
+        return NULL;
+    }
+    return snapshot;
+}
+
+void bedrock_db_snapshot_release(BedrockDB* db, BedrockDBSnapshot* snapshot) {
+    if (!snapshot) return;
+    if (db && db->database) db->api.release_snapshot(db->database, snapshot->snapshot);
+    free(snapshot);
+}
+
+/* Bedrock worlds use LevelDB's default bytewise comparator. */
+static int key_before(const char* key, size_t key_size, const unsigned char* bound, size_t bound_size) {
+    size_t common = key_size < bound_size ? key_size : bound_size;
+    int compared = common ? memcmp(key, bound, common) : 0;
+    return compared < 0 || (compared == 0 && key_size < bound_size);
+}
+
 int bedrock_db_iterate(
     BedrockDB* db,
     BedrockDBIterateFn callback,
     void* user_data,
     char* err,
     size_t err_sz
+) {
+    return bedrock_db_iterate_range(db, NULL, 0, NULL, 0, callback, user_data, err, err_sz);
+}
+
+int bedrock_db_iterate_range(
+    BedrockDB* db,
+    const unsigned char* start,
+    size_t start_size,
+    const unsigned char* end,
+    size_t end_size,
+    BedrockDBIterateFn callback,
+    void* user_data,
+    char* err,
+    size_t err_sz
 ) {
     leveldb_iterator_t* iterator;
     char* backend_error = NULL;
     if (err && err_sz > 0) err[0] = '\0';
-    if (!db || !db->database || !callback) {
+    if (!db || !db->database || !callback || (start_size > 0 && !start) || (end_size > 0 && !end)) {
         set_error(err, err_sz, "invalid Bedrock LevelDB iteration arguments");
         return 0;
     }
@@ -428,12 +509,18 @@ int bedrock_db_iterate(
         set_error(err, err_sz, "Bedrock LevelDB failed to create an iterator");
         return 0;
     }
-    db->api.iter_seek_to_first(iterator);
+    if (start) {
+        db->api.iter_seek(iterator, (const char*)start, start_size);
+    } else {
+        db->api.iter_seek_to_first(iterator);
+    }
     while (db->api.iter_valid(iterator)) {
         size_t key_size = 0;
         size_t value_size = 0;
         const char* key = db->api.iter_key(iterator, &key_size);
-        const char* value = db->api.iter_value(iterator, &value_size);
+        const char* value;
+        if (end && !key_before(key, key_size, end, end_size)) break;
+        value = db->api.iter_value(iterator, &value_size);
         if (!callback((const unsigned char*)key, key_size,
                       (const unsigned char*)value, value_size, user_data)) break;
         db->api.iter_next(iterator);
@@ -447,12 +534,189 @@ int bedrock_db_iterate(
     return 1;
 }
 
+int bedrock_db_iterate_prefix(
+    BedrockDB* db,
+    const unsigned char* prefix,
+    size_t prefix_size,
+    BedrockDBIterateFn callback,
+    void* user_data,
+    char* err,
+    size_t err_sz
+) {
+    unsigned char bound[64];
+    unsigned char* end = bound;
+    size_t end_size;
+    int result;
+    if (prefix_size > 0 && !prefix) {
+        set_error(err, err_sz, "invalid Bedrock LevelDB iteration arguments");
+        return 0;
+    }
+    if (prefix_size > sizeof(bound) && !(end = malloc(prefix_size))) {
+        set_error(err, err_sz, "out of memory while bounding a Bedrock LevelDB prefix");
+        return 0;
+    }
+    end_size = bedrock_key_prefix_end(prefix, prefix_size, end);
+    result = bedrock_db_iterate_range(db, prefix_size ? prefix : NULL, prefix_size,
+                                      end_size ? end : NULL, end_size, callback, user_data, err, err_sz);
+    if (end != bound) free(end);
+    return result;
+}
+
+int bedrock_db_scan(
+    BedrockDB* db,
+    const BedrockDBScanOptions* options,
+    BedrockDBScanFn callback,
+    void* user_data,
+    char* err,
+    size_t err_sz
+) {
+    leveldb_readoptions_t* read_options;
+    leveldb_iterator_t* iterator;
+    char* backend_error = NULL;
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!db || !db->database || !options || !callback ||
+        (options->start_size > 0 && !options->start) || (options->end_size > 0 && !options->end)) {
+        set_error(err, err_sz, "invalid Bedrock LevelDB scan arguments");
+        return 0;
+    }
+    /* A scan gets its own read options so it can bypass the block cache. */
+    read_options = db->api.readoptions_create();
+    if (!read_options) {
+        set_error(err, err_sz, "Bedrock LevelDB library failed to allocate options");
+        return 0;
+    }
+    db->api.readoptions_set_verify_checksums(read_options, 1);
+    db->api.readoptions_set_fill_cache(read_options, options->fill_cache ? 1 : 0);
+    if (options->snapshot) db->api.readoptions_set_snapshot(read_options, options->snapshot->snapshot);
+    iterator = db->api.create_iterator(db->database, read_options);
+    if (!iterator) {
+        db->api.readoptions_destroy(read_options);
+        set_error(err, err_sz, "Bedrock LevelDB failed to create an iterator");
+        return 0;
+    }
+    if (options->start) {
+        db->api.iter_seek(iterator, (const char*)options->start, options->start_size);
+    } else {
+        db->api.iter_seek_to_first(iterator);
+    }
+    while (db->api.iter_valid(iterator)) {
+        size_t key_size = 0;
+        size_t value_size = 0;
+        const char* key = db->api.iter_key(iterator, &key_size);
+        const char* value;
+        if (options->end && !key_before(key, key_size, options->end, options->end_size)) break;
+        /* The value stays in the iterator's block; nothing is copied. */
+        value = db->api.iter_value(iterator, &value_size);
+        if (!callback((const unsigned char*)key, key_size, value_size,
+                      options->value_prefix_size ? (const unsigned char*)value : NULL,
+                      value_size < options->value_prefix_size ? value_size : options->value_prefix_size,
+                      user_data)) break;
+        db->api.iter_next(iterator);
+    }
+    db->api.iter_get_error(iterator, &backend_error);
+    db->api.iter_destroy(iterator);
+    db->api.readoptions_destroy(read_options);
+    if (backend_error) {
+        set_backend_error(db, err, err_sz, "Bedrock LevelDB scan failed", backend_error);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * approximate_sizes needs a limit key for every range. No Bedrock key begins
+ * with this many 0xFF bytes, so it stands in for the end of the keyspace.
+ */
+static const unsigned char open_range_end[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+int bedrock_db_approximate_sizes(
+    BedrockDB* db,
+    const BedrockDBRange* ranges,
+    size_t range_count,
+    uint64_t* out_sizes,
+    char* err,
+    size_t err_sz
+) {
+    const char** starts;
+    const char** ends;
+    size_t* start_sizes;
+    size_t* end_sizes;
+    size_t i;
+    int ok = 0;
+
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!db || !db->database || (range_count > 0 && (!ranges || !out_sizes)) || range_count > INT_MAX) {
+        set_error(err, err_sz, "invalid Bedrock LevelDB size arguments");
+        return 0;
+    }
+    if (range_count == 0) return 1;
+    starts = calloc(range_count, sizeof(*starts));
+    ends = calloc(range_count, sizeof(*ends));
+    start_sizes = calloc(range_count, sizeof(*start_sizes));
+    end_sizes = calloc(range_count, sizeof(*end_sizes));
+    if (!starts || !ends || !start_sizes || !end_sizes) {
+        set_error(err, err_sz, "out of memory while estimating Bedrock LevelDB sizes");
+        goto done;
+    }
+    for (i = 0; i < range_count; i++) {
+        /* An empty start key sorts before every key. */
+        starts[i] = ranges[i].start ? (const char*)ranges[i].start : "";
+        start_sizes[i] = ranges[i].start ? ranges[i].start_size : 0;
+        ends[i] = ranges[i].end ? (const char*)ranges[i].end : (const char*)open_range_end;
+        end_sizes[i] = ranges[i].end ? ranges[i].end_size : sizeof(open_range_end);
+    }
+    db->api.approximate_sizes(db->database, (int)range_count, starts, start_sizes,
+                              ends, end_sizes, out_sizes);
+    ok = 1;
+
+done:
+    free(starts);
+    free(ends);
+    free(start_sizes);
+    free(end_sizes);
+    return ok;
+}
+
+int bedrock_db_compact_range(BedrockDB* db, const BedrockDBRange* range, char* err, size_t err_sz) {
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!db || !db->database) {
+        set_error(err, err_sz, "invalid Bedrock LevelDB compaction arguments");
+        return 0;
+    }
+    if (db->mode != BEDROCK_DB_READ_WRITE) {
+        set_error(err, err_sz, "Bedrock LevelDB was opened in logical read-only mode");
+        return 0;
+    }
+    /* NULL bounds reach the first and last keys. */
+    db->api.compact_range(db->database,
+                          range && range->start ? (const char*)range->start : NULL,
+                          range && range->start ? range->start_size : 0,
+                          range && range->end ? (const char*)range->end : NULL,
+                          range && range->end ? range->end_size : 0);
+    return 1;
+}
+
 int bedrock_db_apply_mutations(
     BedrockDB* db,
     const BedrockDBMutation* mutations,
     size_t mutation_count,
     char* err,
     size_t err_sz
+) {
+    /* Nothing to write is still validated, but does not sync the log. */
+    return bedrock_db_write_mutations(db, mutations, mutation_count, mutation_count > 0, err, err_sz);
+}
+
+int bedrock_db_write_mutations(
+    BedrockDB* db,
+    const BedrockDBMutation* mutations,
+    size_t mutation_count,
+    int sync,
+    char* err,
+    size_t err_sz
 ) {
     leveldb_writebatch_t* batch;
     char* backend_error = NULL;
@@ -465,7 +729,9 @@ int bedrock_db_apply_mutations(
         set_error(err, err_sz, "Bedrock LevelDB was opened in logical read-only mode");
         return 0;
     }
-    if (mutation_count == 0) return 1;
+    /* An empty synchronous batch still syncs the log, which makes earlier
+       unsynced batches durable. */
+    if (mutation_count == 0 && !sync) return 1;
     batch = db->api.writebatch_create();
     if (!batch) {
         set_error(err, err_sz, "Bedrock LevelDB failed to allocate a write batch");
@@ -494,7 +760,8 @@ int bedrock_db_apply_mutations(
             return 0;
         }
     }
-    db->api.write(db->database, db->write_options, batch, &backend_error);
+    db->api.write(db->database, sync ? db->write_options : db->unsynced_write_options,
+                  batch, &backend_error);
     db->api.writebatch_destroy(batch);
     if (backend_error) {
         set_backend_error(db, err, err_sz, "Bedrock LevelDB write batch failed", backend_error);
@@ -565,3 +832,57 @@ int bedrock_db_put_nbt(
     free(value);
     return result;
 }
+
+NBTTag* bedrock_db_get_nbt_roots(
+    BedrockDB* db,
+    const unsigned char* key,
+    size_t key_size,
+    int* out_found,
+    char* err,
+    size_t err_sz
+) {
+    unsigned char* value = NULL;
+    size_t value_size = 0;
+    int found = 0;
+    NBTTag* list;
+    if (out_found) *out_found = 0;
+    if (!out_found) {
+        set_error(err, err_sz, "invalid Bedrock NBT get arguments");
+        return NULL;
+    }
+    if (!bedrock_db_get(db, key, key_size, &value, &value_size, &found,
+                        err, err_sz)) return NULL;
+    *out_found = found;
+    if (!found) return NULL;
+    list = nbt_binary_parse_root_list(value, value_size, NBT_BINARY_BEDROCK, err, err_sz);
+    free(value);
+    return list;
+}
+
+int bedrock_db_put_nbt_roots(
+    BedrockDB* db,
+    const unsigned char* key,
+    size_t key_size,
+    const NBTTag* list,
+    char* err,
+    size_t err_sz
+) {
+    unsigned char* value = NULL;
+    size_t value_size = 0;
+    BedrockDBMutation mutation;
+    int result;
+    if (!list) {
+        set_error(err, err_sz, "Bedrock NBT root list is null");
+        return 0;
+    }
+    if (!nbt_binary_serialize_root_list(list, NBT_BINARY_BEDROCK,
+                                        &value, &value_size, err, err_sz)) return 0;
+    mutation.type = BEDROCK_DB_PUT;
+    mutation.key = key;
+    mutation.key_size = key_size;
+    mutation.value = value;
+    mutation.value_size = value_size;
+    result = bedrock_db_apply_mutations(db, &mutation, 1, err, err_sz);
+    free(value);
+    return result;
+}
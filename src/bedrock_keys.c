@@ -0,0 +1,134 @@
+#include <string.h>
+
+#include "bedrock_keys.h"
+
+static void write_i32(unsigned char* out, int32_t value) {
+    uint32_t bits = (uint32_t)value;
+    out[0] = (unsigned char)(bits & 0xFFU);
+    out[1] = (unsigned char)((bits >> 8) & 0xFFU);
+    out[2] = (unsigned char)((bits >> 16) & 0xFFU);
+    out[3] = (unsigned char)((bits >> 24) & 0xFFU);
+}
+
+static int32_t read_i32(const unsigned char* bytes) {
+    uint32_t bits = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+        ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return (int32_t)bits;
+}
+
+size_t bedrock_chunk_key_prefix(int32_t x, int32_t z, int32_t dimension,
+                                unsigned char out[BEDROCK_CHUNK_KEY_MAX]) {
+    write_i32(out, x);
+    write_i32(out + 4, z);
+    if (dimension == BEDROCK_DIMENSION_OVERWORLD) return 8;
+    write_i32(out + 8, dimension);
+    return 12;
+}
+
+size_t bedrock_chunk_key_build(const BedrockChunkKey* key, unsigned char out[BEDROCK_CHUNK_KEY_MAX]) {
+    size_t size = bedrock_chunk_key_prefix(key->x, key->z, key->dimension, out);
+    out[size++] = key->tag;
+    if (key->has_subchunk) out[size++] = (unsigned char)key->subchunk;
+    return size;
+}
+
+int bedrock_chunk_key_parse(const unsigned char* key, size_t key_size, BedrockChunkKey* out) {
+    BedrockChunkKey parsed;
+    size_t tag_offset;
+
+    if (!key || (key_size != 9 && key_size != 10 && key_size != 13 && key_size != 14)) return 0;
+    tag_offset = key_size >= 13 ? 12 : 8;
+    if (!bedrock_chunk_record_name(key[tag_offset])) return 0;
+
+    memset(&parsed, 0, sizeof(parsed));
+    parsed.x = read_i32(key);
+    parsed.z = read_i32(key + 4);
+    parsed.dimension = key_size >= 13 ? read_i32(key + 8) : BEDROCK_DIMENSION_OVERWORLD;
+    parsed.tag = key[tag_offset];
+    parsed.has_subchunk = key_size == tag_offset + 2;
+    if (parsed.has_subchunk) parsed.subchunk = (int8_t)key[tag_offset + 1];
+    if (out) *out = parsed;
+    return 1;
+}
+
+const char* bedrock_chunk_record_name(unsigned char tag) {
+    switch (tag) {
+        case 0x2B: return "Data3D";
+        case 0x2C: return "Version";
+        case 0x2D: return "Data2D";
+        case 0x2E: return "Data2DLegacy";
+        case 0x2F: return "SubChunkPrefix";
+        case 0x30: return "LegacyTerrain";
+        case 0x31: return "BlockEntity";
+        case 0x32: return "Entity";
+        case 0x33: return "PendingTicks";
+        case 0x34: return "LegacyBlockExtraData";
+        case 0x35: return "BiomeState";
+        case 0x36: return "FinalizedState";
+        case 0x37: return "ConversionData";
+        case 0x38: return "BorderBlocks";
+        case 0x39: return "HardcodedSpawners";
+        case 0x3A: return "RandomTicks";
+        case 0x3B: return "Checksums";
+        case 0x3C: return "GenerationSeed";
+        case 0x3D: return "GeneratedPreCavesAndCliffsBlending";
+        case 0x3E: return "BlendingBiomeHeight";
+        case 0x3F: return "MetaDataHash";
+        case 0x40: return "BlendingData";
+        case 0x41: return "ActorDigestVersion";
+        case 0x76: return "LegacyVersion";
+        default: return NULL;
+    }
+}
+
+/* Well-known global keys, grouped into families by prefix. */
+static const struct {
+    const char* prefix;
+    const char* kind;
+} known_key_prefixes[] = {
+    {"actorprefix", "actorprefix"},
+    {"digp", "digp"},
+    {"~local_player", "player"},
+    {"player_", "player"},
+    {"VILLAGE_", "VILLAGE"},
+    {"map_", "map"},
+    {"portals", "portals"},
+    {"BiomeData", "BiomeData"},
+    {"AutonomousEntities", "AutonomousEntities"},
+    {"scoreboard", "scoreboard"},
+    {"mobevents", "mobevents"},
+    {"Overworld", "dimension"},
+    {"Nether", "dimension"},
+    {"TheEnd", "dimension"},
+    {"schedulerWT", "schedulerWT"},
+    {"structuretemplate", "structuretemplate"},
+    {"tickingarea", "tickingarea"},
+    {"LevelChunkMetaDataDictionary", "LevelChunkMetaDataDictionary"},
+    {"game_flatworldlayers", "game_flatworldlayers"},
+    {"dimension", "dimension"},
+    {"realmsStoriesData", "realmsStoriesData"},
+};
+
+const char* bedrock_key_kind(const unsigned char* key, size_t key_size) {
+    BedrockChunkKey chunk;
+    size_t i;
+
+    if (bedrock_chunk_key_parse(key, key_size, &chunk)) return bedrock_chunk_record_name(chunk.tag);
+    for (i = 0; i < sizeof(known_key_prefixes) / sizeof(known_key_prefixes[0]); i++) {
+        size_t length = strlen(known_key_prefixes[i].prefix);
+        if (key_size >= length && memcmp(key, known_key_prefixes[i].prefix, length) == 0) {
+            return known_key_prefixes[i].kind;
+        }
+    }
+    return "Other";
+}
+
+size_t bedrock_key_prefix_end(const unsigned char* prefix, size_t prefix_size, unsigned char* out) {
+    size_t size = prefix_size;
+    /* Drop trailing 0xFF bytes, then bump the last remaining byte. */
+    while (size > 0 && prefix[size - 1] == 0xFF) size--;
+    if (size == 0) return 0;
+    memcpy(out, prefix, size);
+    out[size - 1]++;
+    return size;
+}
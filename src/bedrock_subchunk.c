@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bedrock_subchunk.h"
+#include "nbt_binary.h"
+#include "nbt_builder.h"
+#include "nbt_tree.h"
+
+static void set_error(char* err, size_t err_sz, const char* message) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s", message);
+}
+
+static uint32_t read_le_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * One unpacker per width. The block count per word and the mask are
+ * compile-time constants, so the inner loop unrolls into fixed shifts and
+ * compilers vectorize the word loop. Widths that do not divide 32 leave
+ * padding bits at the top of each word, and a partial last word.
+ */
+#define DEFINE_UNPACK(BITS) \
+    static void unpack_##BITS(const unsigned char* words, uint16_t* out) { \
+        enum { PER_WORD = 32 / (BITS), \
+               FULL_WORDS = BEDROCK_SUBCHUNK_VOLUME / PER_WORD, \
+               TAIL = BEDROCK_SUBCHUNK_VOLUME % PER_WORD }; \
+        const uint32_t mask = (uint32_t)((1ul << (BITS)) - 1ul); \
+        size_t w; \
+        int j; \
+        for (w = 0; w < FULL_WORDS; w++) { \
+            uint32_t word = read_le_u32(words + w * 4); \
+            uint16_t* block = out + w * PER_WORD; \
+            for (j = 0; j < PER_WORD; j++) block[j] = (uint16_t)((word >> (j * (BITS))) & mask); \
+        } \
+        if (TAIL) { \
+            uint32_t word = read_le_u32(words + FULL_WORDS * 4); \
+            uint16_t* block = out + FULL_WORDS * PER_WORD; \
+            for (j = 0; j < TAIL; j++) block[j] = (uint16_t)((word >> (j * (BITS))) & mask); \
+        } \
+    }
+
+DEFINE_UNPACK(1)
+DEFINE_UNPACK(2)
+DEFINE_UNPACK(3)
+DEFINE_UNPACK(4)
+DEFINE_UNPACK(5)
+DEFINE_UNPACK(6)
+DEFINE_UNPACK(8)
+DEFINE_UNPACK(16)
+
+#undef DEFINE_UNPACK
+
+size_t bedrock_block_index_bytes(int bits_per_block) {
+    size_t per_word;
+    switch (bits_per_block) {
+        case 1: case 2: case 3: case 4: case 5: case 6: case 8: case 16: break;
+        default: return 0;
+    }
+    per_word = 32u / (unsigned)bits_per_block;
+    return (BEDROCK_SUBCHUNK_VOLUME + per_word - 1) / per_word * 4;
+}
+
+int bedrock_unpack_block_indices(const unsigned char* words, int bits_per_block, uint16_t* out) {
+    if (!words || !out) return 0;
+    switch (bits_per_block) {
+        case 1: unpack_1(words, out); return 1;
+        case 2: unpack_2(words, out); return 1;
+        case 3: unpack_3(words, out); return 1;
+        case 4: unpack_4(words, out); return 1;
+        case 5: unpack_5(words, out); return 1;
+        case 6: unpack_6(words, out); return 1;
+        case 8: unpack_8(words, out); return 1;
+        case 16: unpack_16(words, out); return 1;
+        default: return 0;
+    }
+}
+
+static int all_zero(const unsigned char* data, size_t size) {
+    size_t i;
+    for (i = 0; i < size; i++) {
+        if (data[i]) return 0;
+    }
+    return 1;
+}
+
+static const char* palette_name(const NBTTag* state) {
+    int index;
+    if (!state || state->type != TAG_Compound) return "";
+    index = nbt_compound_find_index(state, "name");
+    if (index < 0) return "";
+    state = state->value.compound.items[index];
+    return state->type == TAG_String && state->value.string_val ? state->value.string_val : "";
+}
+
+static void free_storage(BedrockBlockStorage* storage) {
+    uint32_t i;
+    if (storage->palette) {
+        for (i = 0; i < storage->palette_size; i++) free_nbt_tree(storage->palette[i].state);
+    }
+    free(storage->palette);
+    free(storage->indices);
+}
+
+void bedrock_subchunk_free(BedrockSubChunk* subchunk) {
+    size_t i;
+    if (!subchunk) return;
+    for (i = 0; i < subchunk->storage_count; i++) free_storage(&subchunk->storages[i]);
+    free(subchunk->storages);
+    free(subchunk);
+}
+
+/* Tallies each index into the palette counts; indices past the palette are invalid. */
+static void count_blocks(BedrockBlockStorage* storage, const uint16_t* indices) {
+    size_t i;
+    for (i = 0; i < BEDROCK_SUBCHUNK_VOLUME; i++) {
+        if (indices[i] < storage->palette_size) storage->palette[indices[i]].count++;
+        else storage->invalid_count++;
+    }
+}
+
+static int decode_storage(
+    const unsigned char* data,
+    size_t size,
+    size_t* offset,
+    int flags,
+    BedrockBlockStorage* storage,
+    char* err,
+    size_t err_sz
+) {
+    const unsigned char* words = NULL;
+    NBTBinaryRoots roots;
+    size_t word_bytes = 0;
+    size_t pos = *offset;
+    uint32_t i;
+    unsigned header;
+
+    if (pos >= size) {
+        set_error(err, err_sz, "SubChunkPrefix ends before a block storage");
+        return 0;
+    }
+    header = data[pos++];
+    if (header & 1u) {
+        set_error(err, err_sz, "SubChunkPrefix storage uses runtime IDs, which are not stored on disk");
+        return 0;
+    }
+    storage->bits_per_block = (int)(header >> 1);
+    if (storage->bits_per_block == 0) {
+        storage->palette_size = 1;
+    } else {
+        word_bytes = bedrock_block_index_bytes(storage->bits_per_block);
+        if (word_bytes == 0) {
+            if (err && err_sz > 0) {
+                snprintf(err, err_sz, "SubChunkPrefix storage has unsupported %d bits per block",
+                         storage->bits_per_block);
+            }
+            return 0;
+        }
+        if (size - pos < word_bytes + 4) {
+            set_error(err, err_sz, "SubChunkPrefix block indices are truncated");
+            return 0;
+        }
+        words = data + pos;
+        pos += word_bytes;
+        storage->palette_size = read_le_u32(data + pos);
+        pos += 4;
+        /* Every palette root needs at least a type byte, a name length, and an end tag. */
+        if (storage->palette_size == 0 || storage->palette_size > (size - pos) / 4) {
+            set_error(err, err_sz, "SubChunkPrefix palette size is invalid");
+            return 0;
+        }
+    }
+
+    storage->palette = calloc(storage->palette_size, sizeof(*storage->palette));
+    if (!storage->palette) {
+        storage->palette_size = 0;
+        set_error(err, err_sz, "out of memory while decoding a SubChunkPrefix palette");
+        return 0;
+    }
+    nbt_binary_roots_init(&roots, data, size, NBT_BINARY_BEDROCK);
+    roots.offset = pos;
+    for (i = 0; i < storage->palette_size; i++) {
+        NBTTag* state = NULL;
+        int result = nbt_binary_roots_next(&roots, &state, err, err_sz);
+        if (result <= 0) {
+            if (result == 0) set_error(err, err_sz, "SubChunkPrefix palette is truncated");
+            storage->palette_size = i;
+            return 0;
+        }
+        storage->palette[i].state = state;
+        storage->palette[i].name = palette_name(state);
+    }
+    pos = roots.offset;
+
+    if (flags & BEDROCK_SUBCHUNK_KEEP_INDICES) {
+        storage->indices = calloc(BEDROCK_SUBCHUNK_VOLUME, sizeof(*storage->indices));
+        if (!storage->indices) {
+            set_error(err, err_sz, "out of memory while decoding SubChunkPrefix indices");
+            return 0;
+        }
+    }
+    /* Uniform storages need no unpacking: one entry with all-zero words. */
+    if (!words || (storage->palette_size == 1 && all_zero(words, word_bytes))) {
+        storage->palette[0].count = BEDROCK_SUBCHUNK_VOLUME;
+    } else if (storage->indices) {
+        bedrock_unpack_block_indices(words, storage->bits_per_block, storage->indices);
+        count_blocks(storage, storage->indices);
+    } else {
+        uint16_t indices[BEDROCK_SUBCHUNK_VOLUME];
+        bedrock_unpack_block_indices(words, storage->bits_per_block, indices);
+        count_blocks(storage, indices);
+    }
+    *offset = pos;
+    return 1;
+}
+
+BedrockSubChunk* bedrock_subchunk_decode(
+    const unsigned char* data,
+    size_t size,
+    int flags,
+    char* err,
+    size_t err_sz
+) {
+    BedrockSubChunk* subchunk;
+    size_t storage_count = 1;
+    size_t pos = 0;
+    size_t i;
+
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!data || size == 0) {
+        set_error(err, err_sz, "SubChunkPrefix value is empty");
+        return NULL;
+    }
+    subchunk = calloc(1, sizeof(*subchunk));
+    if (!subchunk) {
+        set_error(err, err_sz, "out of memory while decoding a SubChunkPrefix");
+        return NULL;
+    }
+    subchunk->version = data[pos++];
+    if (subchunk->version != 1 && subchunk->version != 8 && subchunk->version != 9) {
+        if (err && err_sz > 0) {
+            snprintf(err, err_sz, "SubChunkPrefix version %d is not a paletted format", subchunk->version);
+        }
+        goto fail;
+    }
+    if (subchunk->version != 1) {
+        if (pos >= size) {
+            set_error(err, err_sz, "SubChunkPrefix ends before its storage count");
+            goto fail;
+        }
+        storage_count = data[pos++];
+    }
+    if (subchunk->version == 9) {
+        if (pos >= size) {
+            set_error(err, err_sz, "SubChunkPrefix ends before its y index");
+            goto fail;
+        }
+        subchunk->has_y = 1;
+        subchunk->y = (int8_t)data[pos++];
+    }
+    if (storage_count > 0) {
+        subchunk->storages = calloc(storage_count, sizeof(*subchunk->storages));
+        if (!subchunk->storages) {
+            set_error(err, err_sz, "out of memory while decoding a SubChunkPrefix");
+            goto fail;
+        }
+    }
+    for (i = 0; i < storage_count; i++) {
+        /* Count the storage first so a partial one is freed with the rest. */
+        subchunk->storage_count = i + 1;
+        if (!decode_storage(data, size, &pos, flags, &subchunk->storages[i], err, err_sz)) goto fail;
+    }
+    subchunk->bytes_consumed = pos;
+    return subchunk;
+
+fail:
+    bedrock_subchunk_free(subchunk);
+    return NULL;
+}
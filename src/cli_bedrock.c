@@ -0,0 +1,1093 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bedrock_batch.h"
+#include "bedrock_db.h"
+#include "bedrock_keys.h"
+#include "bedrock_subchunk.h"
+#include "cli_bedrock.h"
+#include "nbt_find.h"
+#include "nbt_binary.h"
+#include "nbt_builder.h"
+#include "nbt_json.h"
+#include "nbt_tree.h"
+#include "platform.h"
+
+/* Key ranges per worker; several per worker keep the workers evenly loaded. */
+#define SCAN_RANGES_PER_WORKER 4
+#define SCAN_MAX_WORKERS 8
+#define EXPORT_MAX_KINDS 64
+
+static void set_err(char* err, size_t err_sz, const char* message) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s", message ? message : "unknown error");
+}
+
+static double wall_seconds(void) {
+    struct timespec now;
+    if (timespec_get(&now, TIME_UTC) != TIME_UTC) return (double)clock() / CLOCKS_PER_SEC;
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int is_file(const char* path) {
+    FILE* file = nbt_fopen(path, "rb");
+    if (!file) return 0;
+    fclose(file);
+    return 1;
+}
+
+static char* join_path(const char* directory, const char* name) {
+    size_t length = strlen(directory);
+    int separator = length > 0 && directory[length - 1] != '/' && directory[length - 1] != '\\';
+    char* path = malloc(length + (size_t)separator + strlen(name) + 1);
+    if (!path) return NULL;
+    memcpy(path, directory, length);
+    if (separator) path[length++] = '/';
+    strcpy(path + length, name);
+    return path;
+}
+
+char* cli_bedrock_db_directory(const char* path, char* err, size_t err_sz) {
+    char* current = join_path(path, "CURRENT");
+    char* database;
+    if (!current) {
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+    if (is_file(current)) {
+        free(current);
+        database = nbt_strdup(path);
+        if (!database) set_err(err, err_sz, "out of memory");
+        return database;
+    }
+    free(current);
+    database = join_path(path, "db");
+    current = database ? join_path(database, "CURRENT") : NULL;
+    if (!current) {
+        free(database);
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+    if (!is_file(current)) {
+        free(database);
+        database = NULL;
+        set_err(err, err_sz, "not a Bedrock world database: expected CURRENT or db/CURRENT");
+    }
+    free(current);
+    return database;
+}
+
+typedef struct {
+    const char* kind;  /* static, from bedrock_key_kind() */
+    size_t records;
+    size_t nbt_records;
+    uint64_t key_bytes;
+    uint64_t value_bytes;
+} KindStats;
+
+typedef struct {
+    KindStats items[EXPORT_MAX_KINDS];
+    size_t count;
+} KindTable;
+
+/* Kinds are static strings, so they are compared by address. */
+static KindStats* kind_stats(KindTable* table, const char* kind) {
+    size_t i;
+    for (i = 0; i < table->count; i++) {
+        if (table->items[i].kind == kind) return &table->items[i];
+    }
+    if (table->count == EXPORT_MAX_KINDS) return &table->items[EXPORT_MAX_KINDS - 1];
+    table->items[table->count].kind = kind;
+    return &table->items[table->count++];
+}
+
+static void merge_kinds(KindTable* total, const KindTable* part) {
+    size_t i;
+    for (i = 0; i < part->count; i++) {
+        KindStats* stats = kind_stats(total, part->items[i].kind);
+        stats->records += part->items[i].records;
+        stats->nbt_records += part->items[i].nbt_records;
+        stats->key_bytes += part->items[i].key_bytes;
+        stats->value_bytes += part->items[i].value_bytes;
+    }
+}
+
+static int compare_kinds(const void* left, const void* right) {
+    const KindStats* a = left;
+    const KindStats* b = right;
+    if (a->records != b->records) return a->records < b->records ? 1 : -1;
+    return strcmp(a->kind, b->kind);
+}
+
+static void print_kinds(KindTable* table) {
+    size_t i;
+    qsort(table->items, table->count, sizeof(table->items[0]), compare_kinds);
+    printf("Records by kind:\n");
+    for (i = 0; i < table->count; i++) {
+        const KindStats* stats = &table->items[i];
+        printf("  %-28s %10zu records %10zu NBT %12.1f KiB\n", stats->kind, stats->records,
+               stats->nbt_records, (double)stats->value_bytes / 1024.0);
+    }
+}
+
+/* One slice of the keyspace, scanned by a worker over the shared snapshot. */
+typedef struct {
+    BedrockDB* db;
+    const BedrockDBSnapshot* snapshot;
+    unsigned char start;
+    int has_start;
+    unsigned char end;
+    int has_end;
+    size_t value_prefix_size;
+    BedrockDBScanFn callback;
+    void* user;
+    int ok;
+    char err[256];
+} ScanRange;
+
+typedef struct {
+    BedrockDB* db;
+    BedrockDBSnapshot* snapshot;
+    int workers;
+    int range_count;
+} WorldScan;
+
+static int world_scan_open(const char* path, WorldScan* scan, char* err, size_t err_sz) {
+    char* directory = cli_bedrock_db_directory(path, err, err_sz);
+    memset(scan, 0, sizeof(*scan));
+    if (!directory) return 0;
+    scan->db = bedrock_db_open(directory, BEDROCK_DB_LOGICAL_READ_ONLY, NULL, err, err_sz);
+    free(directory);
+    if (!scan->db) return 0;
+    scan->snapshot = bedrock_db_snapshot_create(scan->db, err, err_sz);
+    if (!scan->snapshot) {
+        bedrock_db_close(scan->db);
+        scan->db = NULL;
+        return 0;
+    }
+    scan->workers = nbt_cpu_count();
+    if (scan->workers > SCAN_MAX_WORKERS) scan->workers = SCAN_MAX_WORKERS;
+    if (scan->workers < 1) scan->workers = 1;
+    scan->range_count = scan->workers * SCAN_RANGES_PER_WORKER;
+    return 1;
+}
+
+static void world_scan_close(WorldScan* scan) {
+    bedrock_db_snapshot_release(scan->db, scan->snapshot);
+    bedrock_db_close(scan->db);
+    memset(scan, 0, sizeof(*scan));
+}
+
+/* Split on the first key byte: chunk keys lead with the low byte of x, which
+   spreads terrain evenly, and the named keys fall in a few ranges. */
+static void world_scan_range(const WorldScan* scan, int index, BedrockDBScanFn callback, void* user,
+                             ScanRange* range) {
+    range->db = scan->db;
+    range->snapshot = scan->snapshot;
+    range->has_start = index > 0;
+    range->start = (unsigned char)(index * 256 / scan->range_count);
+    range->has_end = index + 1 < scan->range_count;
+    range->end = (unsigned char)((index + 1) * 256 / scan->range_count);
+    range->value_prefix_size = SIZE_MAX;
+    range->callback = callback;
+    range->user = user;
+}
+
+static int scan_range(void* argument) {
+    ScanRange* range = argument;
+    BedrockDBScanOptions options;
+    char scan_err[256] = {0};
+
+    memset(&options, 0, sizeof(options));
+    options.start = range->has_start ? &range->start : NULL;
+    options.start_size = range->has_start ? 1 : 0;
+    options.end = range->has_end ? &range->end : NULL;
+    options.end_size = range->has_end ? 1 : 0;
+    options.value_prefix_size = range->value_prefix_size;
+    options.snapshot = range->snapshot;
+    range->ok = 1;
+    if (!bedrock_db_scan(range->db, &options, range->callback, range->user, scan_err, sizeof(scan_err))) {
+        range->ok = 0;
+        if (!range->err[0]) set_err(range->err, sizeof(range->err), scan_err);
+    }
+    return range->ok;
+}
+
+/* Runs every range on the work queue and returns the elapsed wall time. */
+static double world_scan_run(const WorldScan* scan, ScanRange* const* ranges) {
+    double started = wall_seconds();
+    NBTWorkQueue* queue = scan->workers > 1 ? nbt_work_queue_create(scan->workers) : NULL;
+    double elapsed;
+    int i;
+    for (i = 0; i < scan->range_count; i++) nbt_work_queue_submit(queue, scan_range, ranges[i]);
+    nbt_work_queue_finish(queue);
+    elapsed = wall_seconds() - started;
+    return elapsed > 0.0 ? elapsed : 1e-9;
+}
+
+typedef struct {
+    ScanRange range;
+    char* part_path;
+    FILE* part;
+    KindTable kinds;
+} ExportTask;
+
+/*
+ * Streams one record as {"key", "kind", "root"} or, for several back-to-back
+ * roots, {"key", "kind", "roots": [...]}; each root is freed once written.
+ */
+static int write_export_line(FILE* out, const unsigned char* key, size_t key_size, const char* kind,
+                             const unsigned char* value, size_t value_size, size_t root_count,
+                             char* err, size_t err_sz) {
+    static const char hex[] = "0123456789abcdef";
+    NBTBinaryRoots roots;
+    NBTTag* root = NULL;
+    size_t i;
+    if (fputs("{\"key\":\"", out) == EOF) return 0;
+    for (i = 0; i < key_size; i++) {
+        if (fputc(hex[key[i] >> 4], out) == EOF || fputc(hex[key[i] & 0x0F], out) == EOF) return 0;
+    }
+    if (fputs("\",\"kind\":", out) == EOF || !nbt_write_json_string(out, kind)) return 0;
+    if (fputs(root_count == 1 ? ",\"root\":" : ",\"roots\":[", out) == EOF) return 0;
+    nbt_binary_roots_init(&roots, value, value_size, NBT_BINARY_BEDROCK);
+    for (i = 0; i < root_count; i++) {
+        int written;
+        if (nbt_binary_roots_next(&roots, &root, err, err_sz) != 1) return 0;
+        written = (i == 0 || fputc(',', out) != EOF) &&
+                  nbt_write_typed_json_node(out, root, "", 0, err, err_sz);
+        free_nbt_tree(root);
+        if (!written) return 0;
+    }
+    return fputs(root_count == 1 ? "}\n" : "]}\n", out) != EOF;
+}
+
+static int export_record(
+    const unsigned char* key,
+    size_t key_size,
+    size_t value_size,
+    const unsigned char* value,
+    size_t value_prefix_size,
+    void* user
+) {
+    ExportTask* task = user;
+    const char* kind = bedrock_key_kind(key, key_size);
+    KindStats* stats = kind_stats(&task->kinds, kind);
+    NBTBinaryRoots roots;
+    char parse_err[128];
+    int result;
+
+    stats->records++;
+    stats->value_bytes += value_size;
+    /* Terrain and other custom encodings never start with a compound tag. */
+    if (value_prefix_size == 0 || value[0] != TAG_Compound) return 1;
+    /* Skip through the roots first so nothing is written for a value that is
+       only partly NBT. */
+    nbt_binary_roots_init(&roots, value, value_prefix_size, NBT_BINARY_BEDROCK);
+    while ((result = nbt_binary_roots_next(&roots, NULL, parse_err, sizeof(parse_err))) > 0) {}
+    if (result < 0) return 1;
+    if (!write_export_line(task->part, key, key_size, kind, value, value_prefix_size, roots.count,
+                           task->range.err, sizeof(task->range.err))) {
+        if (!task->range.err[0]) {
+            set_err(task->range.err, sizeof(task->range.err), "failed to write export output");
+        }
+        task->range.ok = 0;
+        return 0;
+    }
+    stats->nbt_records++;
+    return 1;
+}
+
+static FILE* open_temp_output(const char* target_path, const char* prefix, char** out_path,
+                              const char* mode, char* err, size_t err_sz) {
+    FILE* file;
+    int descriptor = nbt_open_temp_file(target_path, prefix, out_path, err, err_sz);
+    if (descriptor < 0) return NULL;
+    if (nbt_close_fd(descriptor) != 0) {
+        nbt_remove_file(*out_path);
+        free(*out_path);
+        *out_path = NULL;
+        set_err(err, err_sz, "failed to close temporary file descriptor");
+        return NULL;
+    }
+    file = nbt_fopen(*out_path, mode);
+    if (!file) {
+        if (err && err_sz > 0) snprintf(err, err_sz, "fopen(%s): %s", *out_path, strerror(errno));
+        nbt_remove_file(*out_path);
+        free(*out_path);
+        *out_path = NULL;
+    }
+    return file;
+}
+
+/* Joins the per-range parts, already in key order, into the output file. */
+static int assemble_export(const char* output_path, ExportTask* tasks, int task_count, char* err, size_t err_sz) {
+    char* temporary_path = NULL;
+    FILE* output = open_temp_output(output_path, "nbt", &temporary_path, "wb", err, err_sz);
+    unsigned char buffer[65536];
+    int ok = output != NULL;
+    int i;
+
+    for (i = 0; ok && i < task_count; i++) {
+        size_t count;
+        if (fflush(tasks[i].part) != 0 || fseek(tasks[i].part, 0, SEEK_SET) != 0) {
+            set_err(err, err_sz, "failed to read back an export part");
+            ok = 0;
+            break;
+        }
+        while ((count = fread(buffer, 1, sizeof(buffer), tasks[i].part)) > 0) {
+            if (fwrite(buffer, 1, count, output) != count) {
+                set_err(err, err_sz, "failed to write export output");
+                ok = 0;
+                break;
+            }
+        }
+        if (ok && ferror(tasks[i].part)) {
+            set_err(err, err_sz, "failed to read back an export part");
+            ok = 0;
+        }
+    }
+    if (output && fclose(output) != 0 && ok) {
+        set_err(err, err_sz, "failed to finish export output");
+        ok = 0;
+    }
+    if (ok) ok = nbt_replace_file(temporary_path, output_path, err, err_sz);
+    if (!ok && temporary_path) nbt_remove_file(temporary_path);
+    free(temporary_path);
+    return ok;
+}
+
+int cli_bedrock_export(const char* path, const char* output_path, char* err, size_t err_sz) {
+    WorldScan scan;
+    ExportTask* tasks = NULL;
+    ScanRange** ranges = NULL;
+    KindTable totals;
+    size_t records = 0;
+    size_t nbt_records = 0;
+    uint64_t value_bytes = 0;
+    double elapsed;
+    int ok = 0;
+    int i;
+
+    if (!world_scan_open(path, &scan, err, err_sz)) return 0;
+    tasks = calloc((size_t)scan.range_count, sizeof(*tasks));
+    ranges = calloc((size_t)scan.range_count, sizeof(*ranges));
+    if (!tasks || !ranges) {
+        set_err(err, err_sz, "out of memory");
+        goto done;
+    }
+    for (i = 0; i < scan.range_count; i++) {
+        world_scan_range(&scan, i, export_record, &tasks[i], &tasks[i].range);
+        ranges[i] = &tasks[i].range;
+        tasks[i].part = open_temp_output(output_path, "part", &tasks[i].part_path, "w+b", err, err_sz);
+        if (!tasks[i].part) goto done;
+    }
+
+    elapsed = world_scan_run(&scan, ranges);
+    memset(&totals, 0, sizeof(totals));
+    for (i = 0; i < scan.range_count; i++) {
+        size_t k;
+        if (!tasks[i].range.ok) {
+            set_err(err, err_sz, tasks[i].range.err);
+            goto done;
+        }
+        for (k = 0; k < tasks[i].kinds.count; k++) {
+            records += tasks[i].kinds.items[k].records;
+            nbt_records += tasks[i].kinds.items[k].nbt_records;
+            value_bytes += tasks[i].kinds.items[k].value_bytes;
+        }
+        merge_kinds(&totals, &tasks[i].kinds);
+    }
+    if (!assemble_export(output_path, tasks, scan.range_count, err, err_sz)) goto done;
+
+    printf("Exported %zu NBT records of %zu to %s\n", nbt_records, records, output_path);
+    printf("Scanned %.1f MiB of values in %.2f s with %d workers: %.0f records/s, %.1f MiB/s\n",
+           (double)value_bytes / (1024.0 * 1024.0), elapsed, scan.workers,
+           (double)records / elapsed, (double)value_bytes / (1024.0 * 1024.0) / elapsed);
+    print_kinds(&totals);
+    ok = 1;
+
+done:
+    if (tasks) {
+        for (i = 0; i < scan.range_count; i++) {
+            if (tasks[i].part) fclose(tasks[i].part);
+            if (tasks[i].part_path) nbt_remove_file(tasks[i].part_path);
+            free(tasks[i].part_path);
+        }
+        free(tasks);
+    }
+    free(ranges);
+    world_scan_close(&scan);
+    return ok;
+}
+
+typedef struct {
+    const NBTFind* find;
+    BedrockDBBatch* batch;
+    NBTFindStats totals;
+    size_t records;
+    size_t changed;
+    size_t skipped;
+    int failed;
+    char err[256];
+} ReplaceScan;
+
+/* Parses one NBT record, applies the replacement, and queues it if it changed. */
+static int replace_record(
+    const unsigned char* key,
+    size_t key_size,
+    size_t value_size,
+    const unsigned char* value,
+    size_t value_prefix_size,
+    void* user
+) {
+    ReplaceScan* state = user;
+    NBTBinaryRoots roots;
+    NBTFindStats stats = {0, 0};
+    NBTTag* root;
+    char parse_err[128];
+    int result;
+    int ok;
+
+    (void)value_size;
+    if (value_prefix_size == 0 || value[0] != TAG_Compound) return 1;
+    nbt_binary_roots_init(&roots, value, value_prefix_size, NBT_BINARY_BEDROCK);
+    while ((result = nbt_binary_roots_next(&roots, NULL, parse_err, sizeof(parse_err))) > 0) {}
+    if (result < 0) return 1;
+    /* A lone root keeps its name; several become a synthetic list. Roots that
+       cannot form one (named, or of mixed types) are left alone, as export
+       leaves values that are only partly NBT. */
+    root = roots.count == 1
+        ? nbt_binary_parse(value, value_prefix_size, NBT_BINARY_BEDROCK, NULL, parse_err, sizeof(parse_err))
+        : nbt_binary_parse_root_list(value, value_prefix_size, NBT_BINARY_BEDROCK, parse_err, sizeof(parse_err));
+    if (!root) {
+        state->skipped++;
+        return 1;
+    }
+    state->records++;
+    ok = nbt_find_run(state->find, root, NULL, NULL, &stats, state->err, sizeof(state->err));
+    if (ok && stats.replaced > 0) {
+        ok = roots.count == 1
+            ? bedrock_db_batch_put_nbt(state->batch, key, key_size, root, state->err, sizeof(state->err))
+            : bedrock_db_batch_put_nbt_roots(state->batch, key, key_size, root, state->err, sizeof(state->err));
+        if (ok) state->changed++;
+    }
+    state->totals.matched += stats.matched;
+    state->totals.replaced += stats.replaced;
+    free_nbt_tree(root);
+    if (!ok) state->failed = 1;
+    return ok;
+}
+
+/*
+ * <world>/cnbt-record-backups/bulk-<UTC time>.cnbtbak, next to the db folder,
+ * with a -2, -3, ... suffix when an earlier edit in the same second left one.
+ */
+static char* bulk_backup_path(const char* database, char* err, size_t err_sz) {
+    char stamp[48];
+    char name[64];
+    time_t now = time(NULL);
+    struct tm* utc = gmtime(&now);
+    char* directory = join_path(database, "../cnbt-record-backups");
+    char* path = NULL;
+    int attempt;
+    if (!directory) {
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+    if (!nbt_make_directory(directory)) {
+        if (err && err_sz > 0) snprintf(err, err_sz, "could not create backup directory %s", directory);
+        free(directory);
+        return NULL;
+    }
+    if (!utc || strftime(stamp, sizeof(stamp), "bulk-%Y%m%d-%H%M%S", utc) == 0) {
+        snprintf(stamp, sizeof(stamp), "bulk-%lld", (long long)now);
+    }
+    /* The batch still creates the file exclusively, so a concurrent edit that
+       picks the same name fails instead of truncating this backup. */
+    for (attempt = 1; attempt <= 1000; attempt++) {
+        FILE* existing;
+        if (attempt == 1) snprintf(name, sizeof(name), "%s.cnbtbak", stamp);
+        else snprintf(name, sizeof(name), "%s-%d.cnbtbak", stamp, attempt);
+        free(path);
+        path = join_path(directory, name);
+        if (!path) {
+            set_err(err, err_sz, "out of memory");
+            break;
+        }
+        existing = nbt_fopen(path, "rb");
+        if (!existing) break;
+        fclose(existing);
+    }
+    if (path && attempt > 1000) {
+        if (err && err_sz > 0) snprintf(err, err_sz, "too many backups named %s in %s", stamp, directory);
+        free(path);
+        path = NULL;
+    }
+    free(directory);
+    return path;
+}
+
+int cli_bedrock_replace(const char* path, const NBTFind* find, int backup, char* err, size_t err_sz) {
+    BedrockDBScanOptions options;
+    BedrockDBSnapshot* snapshot = NULL;
+    BedrockDB* db = NULL;
+    ReplaceScan state;
+    char* database = cli_bedrock_db_directory(path, err, err_sz);
+    char* backup_path = NULL;
+    double started = wall_seconds();
+    double elapsed;
+    int ok = 0;
+
+    memset(&state, 0, sizeof(state));
+    state.find = find;
+    if (!database) return 0;
+    if (backup && !(backup_path = bulk_backup_path(database, err, err_sz))) goto done;
+    db = bedrock_db_open(database, BEDROCK_DB_READ_WRITE, NULL, err, err_sz);
+    if (!db) goto done;
+    /* Scan a snapshot so records the batch rewrites are not visited again. */
+    snapshot = bedrock_db_snapshot_create(db, err, err_sz);
+    if (!snapshot) goto done;
+    state.batch = bedrock_db_batch_create(db, 0, backup_path, err, err_sz);
+    if (!state.batch) goto done;
+    memset(&options, 0, sizeof(options));
+    options.value_prefix_size = SIZE_MAX;
+    options.snapshot = snapshot;
+    /* A callback that stops the scan ends it successfully; check for a failure. */
+    if (!bedrock_db_scan(db, &options, replace_record, &state, err, err_sz)) {
+        set_err(state.err, sizeof(state.err), err);
+        state.failed = 1;
+    }
+    if (state.failed) {
+        /* Earlier batches are already in the database; make them durable and
+           say how to undo them. */
+        char sync_err[256] = {0};
+        int synced = bedrock_db_batch_abort(state.batch, sync_err, sizeof(sync_err));
+        if (err && err_sz > 0) {
+            snprintf(err, err_sz, "%s; %zu records were already written%s%s%s%s", state.err,
+                     bedrock_db_batch_written(state.batch), synced ? "" : " but not synced: ", sync_err,
+                     backup_path ? ", previous values saved to " : "", backup_path ? backup_path : "");
+        }
+        goto done;
+    }
+    if (!bedrock_db_batch_finish(state.batch, err, err_sz)) goto done;
+
+    elapsed = wall_seconds() - started;
+    printf("Replaced %zu of %zu matching tags in %zu of %zu Bedrock NBT records\n",
+           state.totals.replaced, state.totals.matched, state.changed, state.records);
+    printf("Wrote %zu records in %zu LevelDB batches in %.2f s\n", bedrock_db_batch_written(state.batch),
+           bedrock_db_batch_flushes(state.batch), elapsed);
+    if (state.skipped) printf("Skipped %zu records whose roots do not form one list\n", state.skipped);
+    if (backup_path) printf("Previous values saved to %s\n", backup_path);
+    ok = 1;
+
+done:
+    bedrock_db_batch_free(state.batch);
+    if (snapshot) bedrock_db_snapshot_release(db, snapshot);
+    bedrock_db_close(db);
+    free(backup_path);
+    free(database);
+    return ok;
+}
+
+int cli_bedrock_restore(const char* path, const char* backup_path, char* err, size_t err_sz) {
+    char* database = cli_bedrock_db_directory(path, err, err_sz);
+    BedrockDB* db;
+    int ok;
+    if (!database) return 0;
+    db = bedrock_db_open(database, BEDROCK_DB_READ_WRITE, NULL, err, err_sz);
+    free(database);
+    if (!db) return 0;
+    ok = bedrock_db_batch_restore(db, backup_path, err, err_sz);
+    bedrock_db_close(db);
+    if (ok) printf("Restored Bedrock records from %s\n", backup_path);
+    return ok;
+}
+
+/* Block totals by palette name in an open-addressing table. */
+typedef struct {
+    char* name;
+    uint32_t hash;
+    uint64_t count;
+} BlockCount;
+
+typedef struct {
+    BlockCount* items;
+    size_t capacity;  /* zero or a power of two */
+    size_t count;
+} BlockTable;
+
+static void block_table_free(BlockTable* table) {
+    size_t i;
+    for (i = 0; i < table->capacity; i++) free(table->items[i].name);
+    free(table->items);
+    memset(table, 0, sizeof(*table));
+}
+
+static BlockCount* block_slot(BlockCount* items, size_t capacity, const char* name, uint32_t hash) {
+    size_t i = hash & (capacity - 1);
+    while (items[i].name && (items[i].hash != hash || strcmp(items[i].name, name) != 0)) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &items[i];
+}
+
+static int block_table_add(BlockTable* table, const char* name, uint32_t hash, uint64_t count) {
+    BlockCount* slot;
+    if ((table->count + 1) * 4 > table->capacity * 3) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 256;
+        BlockCount* items = calloc(capacity, sizeof(*items));
+        size_t i;
+        if (!items) return 0;
+        for (i = 0; i < table->capacity; i++) {
+            const BlockCount* item = &table->items[i];
+            if (item->name) *block_slot(items, capacity, item->name, item->hash) = *item;
+        }
+        free(table->items);
+        table->items = items;
+        table->capacity = capacity;
+    }
+    slot = block_slot(table->items, table->capacity, name, hash);
+    if (!slot->name) {
+        slot->name = nbt_strdup(name);
+        if (!slot->name) return 0;
+        slot->hash = hash;
+        table->count++;
+    }
+    slot->count += count;
+    return 1;
+}
+
+static int compare_blocks(const void* left, const void* right) {
+    const BlockCount* a = left;
+    const BlockCount* b = right;
+    if (a->count != b->count) return a->count < b->count ? 1 : -1;
+    return strcmp(a->name, b->name);
+}
+
+typedef struct {
+    ScanRange range;
+    BlockTable blocks;
+    size_t subchunks;
+    size_t skipped;
+    uint64_t invalid;
+} BlocksTask;
+
+static int count_subchunk_blocks(
+    const unsigned char* key,
+    size_t key_size,
+    size_t value_size,
+    const unsigned char* value,
+    size_t value_prefix_size,
+    void* user
+) {
+    BlocksTask* task = user;
+    BedrockChunkKey chunk;
+    BedrockSubChunk* subchunk;
+    char decode_err[128];
+    int ok = 1;
+
+    (void)value_size;
+    if (!bedrock_chunk_key_parse(key, key_size, &chunk) || chunk.tag != BEDROCK_TAG_SUBCHUNK_PREFIX) return 1;
+    subchunk = bedrock_subchunk_decode(value, value_prefix_size, 0, decode_err, sizeof(decode_err));
+    if (!subchunk) {
+        task->skipped++;
+        return 1;
+    }
+    task->subchunks++;
+    /* Storage 0 holds the blocks; later storages only add waterlogging. */
+    if (subchunk->storage_count > 0) {
+        const BedrockBlockStorage* storage = &subchunk->storages[0];
+        uint32_t i;
+        for (i = 0; ok && i < storage->palette_size; i++) {
+            const char* name = storage->palette[i].name;
+            if (storage->palette[i].count == 0) continue;
+            ok = block_table_add(&task->blocks, name, nbt_name_hash(name, strlen(name)),
+                                 storage->palette[i].count);
+        }
+        task->invalid += storage->invalid_count;
+    }
+    bedrock_subchunk_free(subchunk);
+    if (!ok) {
+        set_err(task->range.err, sizeof(task->range.err), "out of memory while counting blocks");
+        task->range.ok = 0;
+    }
+    return ok;
+}
+
+int cli_bedrock_blocks(const char* path, char* err, size_t err_sz) {
+    WorldScan scan;
+    BlocksTask* tasks = NULL;
+    ScanRange** ranges = NULL;
+    BlockTable totals;
+    BlockCount* sorted = NULL;
+    size_t subchunks = 0;
+    size_t skipped = 0;
+    uint64_t invalid = 0;
+    size_t sorted_count = 0;
+    size_t k;
+    double elapsed;
+    int ok = 0;
+    int i;
+
+    memset(&totals, 0, sizeof(totals));
+    if (!world_scan_open(path, &scan, err, err_sz)) return 0;
+    tasks = calloc((size_t)scan.range_count, sizeof(*tasks));
+    ranges = calloc((size_t)scan.range_count, sizeof(*ranges));
+    if (!tasks || !ranges) {
+        set_err(err, err_sz, "out of memory");
+        goto done;
+    }
+    for (i = 0; i < scan.range_count; i++) {
+        world_scan_range(&scan, i, count_subchunk_blocks, &tasks[i], &tasks[i].range);
+        ranges[i] = &tasks[i].range;
+    }
+
+    elapsed = world_scan_run(&scan, ranges);
+    for (i = 0; i < scan.range_count; i++) {
+        if (!tasks[i].range.ok) {
+            set_err(err, err_sz, tasks[i].range.err);
+            goto done;
+        }
+        subchunks += tasks[i].subchunks;
+        skipped += tasks[i].skipped;
+        invalid += tasks[i].invalid;
+        for (k = 0; k < tasks[i].blocks.capacity; k++) {
+            const BlockCount* item = &tasks[i].blocks.items[k];
+            if (item->name && !block_table_add(&totals, item->name, item->hash, item->count)) {
+                set_err(err, err_sz, "out of memory while counting blocks");
+                goto done;
+            }
+        }
+    }
+    if (totals.count > 0) {
+        sorted = malloc(totals.count * sizeof(*sorted));
+        if (!sorted) {
+            set_err(err, err_sz, "out of memory");
+            goto done;
+        }
+        for (k = 0; k < totals.capacity; k++) {
+            if (totals.items[k].name) sorted[sorted_count++] = totals.items[k];
+        }
+        qsort(sorted, sorted_count, sizeof(*sorted), compare_blocks);
+    }
+
+    printf("Decoded %zu subchunks in %.2f s with %d workers: %.0f subchunks/s\n",
+           subchunks, elapsed, scan.workers, (double)subchunks / elapsed);
+    if (skipped) printf("Skipped %zu legacy or damaged SubChunkPrefix records\n", skipped);
+    if (invalid) printf("%llu block indices pointed past their palette\n", (unsigned long long)invalid);
+    printf("Blocks by name (%zu):\n", sorted_count);
+    for (k = 0; k < sorted_count; k++) {
+        printf("  %14llu  %s\n", (unsigned long long)sorted[k].count,
+               sorted[k].name[0] ? sorted[k].name : "(unnamed)");
+    }
+    ok = 1;
+
+done:
+    free(sorted);
+    block_table_free(&totals);
+    if (tasks) {
+        for (i = 0; i < scan.range_count; i++) block_table_free(&tasks[i].blocks);
+        free(tasks);
+    }
+    free(ranges);
+    world_scan_close(&scan);
+    return ok;
+}
+
+/* Size report buckets: the high nibble of the first key byte. */
+#define STATS_KEY_RANGES 16
+/* Non-chunk keys, the three known dimensions, and any other dimension. */
+#define STATS_DIMENSIONS 5
+
+typedef struct {
+    size_t records;
+    uint64_t key_bytes;
+    uint64_t value_bytes;
+} SizeStats;
+
+typedef struct {
+    ScanRange range;
+    KindTable kinds;
+    SizeStats dimensions[STATS_DIMENSIONS];
+    size_t chunks[STATS_DIMENSIONS];
+    SizeStats key_ranges[STATS_KEY_RANGES];
+} StatsTask;
+
+static const char* const dimension_names[STATS_DIMENSIONS] = {
+    "Global (not chunk keys)", "Overworld", "Nether", "The End", "Other dimensions"
+};
+
+static void add_size(SizeStats* stats, size_t key_size, size_t value_size) {
+    stats->records++;
+    stats->key_bytes += key_size;
+    stats->value_bytes += value_size;
+}
+
+static void merge_size(SizeStats* total, const SizeStats* part) {
+    total->records += part->records;
+    total->key_bytes += part->key_bytes;
+    total->value_bytes += part->value_bytes;
+}
+
+static int stats_record(
+    const unsigned char* key,
+    size_t key_size,
+    size_t value_size,
+    const unsigned char* value,
+    size_t value_prefix_size,
+    void* user
+) {
+    StatsTask* task = user;
+    KindStats* kind = kind_stats(&task->kinds, bedrock_key_kind(key, key_size));
+    BedrockChunkKey chunk;
+    int dimension = 0;
+
+    (void)value;
+    (void)value_prefix_size;
+    kind->records++;
+    kind->key_bytes += key_size;
+    kind->value_bytes += value_size;
+    if (bedrock_chunk_key_parse(key, key_size, &chunk)) {
+        dimension = chunk.dimension >= BEDROCK_DIMENSION_OVERWORLD && chunk.dimension <= BEDROCK_DIMENSION_END
+            ? chunk.dimension + 1 : STATS_DIMENSIONS - 1;
+        /* Every chunk has exactly one version record. */
+        if (chunk.tag == BEDROCK_TAG_VERSION || chunk.tag == BEDROCK_TAG_LEGACY_VERSION) {
+            task->chunks[dimension]++;
+        }
+    }
+    add_size(&task->dimensions[dimension], key_size, value_size);
+    add_size(&task->key_ranges[key_size > 0 ? key[0] >> 4 : 0], key_size, value_size);
+    return 1;
+}
+
+static double mebibytes(uint64_t bytes) {
+    return (double)bytes / (1024.0 * 1024.0);
+}
+
+static void key_range_bounds(int index, unsigned char bounds[2], BedrockDBRange* range) {
+    bounds[0] = (unsigned char)(index * (256 / STATS_KEY_RANGES));
+    bounds[1] = (unsigned char)((index + 1) * (256 / STATS_KEY_RANGES));
+    memset(range, 0, sizeof(*range));
+    if (index > 0) {
+        range->start = &bounds[0];
+        range->start_size = 1;
+    }
+    if (index + 1 < STATS_KEY_RANGES) {
+        range->end = &bounds[1];
+        range->end_size = 1;
+    }
+}
+
+static int key_range_sizes(BedrockDB* db, uint64_t sizes[STATS_KEY_RANGES], char* err, size_t err_sz) {
+    unsigned char bounds[STATS_KEY_RANGES][2];
+    BedrockDBRange ranges[STATS_KEY_RANGES];
+    int i;
+    for (i = 0; i < STATS_KEY_RANGES; i++) key_range_bounds(i, bounds[i], &ranges[i]);
+    return bedrock_db_approximate_sizes(db, ranges, STATS_KEY_RANGES, sizes, err, err_sz);
+}
+
+typedef struct {
+    const char* source;
+    const char* target;
+    size_t files;
+    uint64_t bytes;
+    int failed;
+    char err[256];
+} DatabaseCopy;
+
+static int copy_file(const char* source_path, const char* target_path, uint64_t* bytes) {
+    unsigned char buffer[65536];
+    FILE* source = nbt_fopen(source_path, "rb");
+    FILE* target = source ? nbt_fopen(target_path, "wb") : NULL;
+    size_t count;
+    int ok = target != NULL;
+    while (ok && (count = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+        ok = fwrite(buffer, 1, count, target) == count;
+        *bytes += count;
+    }
+    if (ok && ferror(source)) ok = 0;
+    if (target && fclose(target) != 0) ok = 0;
+    if (source) fclose(source);
+    return ok;
+}
+
+/* Copies each database file; LOCK belongs to whoever has the source open. */
+static int copy_database_entry(const char* name, void* user) {
+    DatabaseCopy* copy = user;
+    char* source_path;
+    char* target_path;
+    int ok;
+    if (!strcmp(name, "LOCK")) return 1;
+    source_path = join_path(copy->source, name);
+    target_path = join_path(copy->target, name);
+    ok = source_path && target_path;
+    if (ok && !nbt_is_directory(source_path)) {
+        ok = copy_file(source_path, target_path, &copy->bytes);
+        if (ok) copy->files++;
+        else snprintf(copy->err, sizeof(copy->err), "could not copy %s", source_path);
+    } else if (!ok) {
+        set_err(copy->err, sizeof(copy->err), "out of memory");
+    }
+    free(source_path);
+    free(target_path);
+    if (!ok) copy->failed = 1;
+    return ok;
+}
+
+static int copy_database(DatabaseCopy* copy, char* err, size_t err_sz) {
+    char* current = join_path(copy->target, "CURRENT");
+    int exists = current && is_file(current);
+    free(current);
+    if (exists) {
+        if (err && err_sz > 0) snprintf(err, err_sz, "%s already holds a LevelDB database", copy->target);
+        return 0;
+    }
+    if (!nbt_make_directory(copy->target)) {
+        if (err && err_sz > 0) snprintf(err, err_sz, "could not create directory %s", copy->target);
+        return 0;
+    }
+    if (!nbt_list_directory(copy->source, copy_database_entry, copy, err, err_sz)) {
+        if (copy->failed) set_err(err, err_sz, copy->err);
+        return 0;
+    }
+    if (copy->failed) {
+        set_err(err, err_sz, copy->err);
+        return 0;
+    }
+    return 1;
+}
+
+/* Copies the database, compacts the copy, and prints the size per key range before and after. */
+static int compact_copy(const char* database, const char* target, const uint64_t before[STATS_KEY_RANGES],
+                        char* err, size_t err_sz) {
+    DatabaseCopy copy;
+    uint64_t after[STATS_KEY_RANGES];
+    uint64_t before_total = 0;
+    uint64_t after_total = 0;
+    BedrockDB* db;
+    double started;
+    int ok;
+    int i;
+
+    memset(&copy, 0, sizeof(copy));
+    copy.source = database;
+    copy.target = target;
+    if (!copy_database(&copy, err, err_sz)) return 0;
+    printf("Copied %zu database files (%.1f MiB) to %s\n", copy.files, mebibytes(copy.bytes), target);
+    db = bedrock_db_open(target, BEDROCK_DB_READ_WRITE, NULL, err, err_sz);
+    if (!db) return 0;
+    started = wall_seconds();
+    ok = bedrock_db_compact_range(db, NULL, err, err_sz) && key_range_sizes(db, after, err, err_sz);
+    bedrock_db_close(db);
+    if (!ok) return 0;
+    printf("Compacted the copy in %.2f s\n", wall_seconds() - started);
+    printf("Table size per key range after compaction:\n");
+    for (i = 0; i < STATS_KEY_RANGES; i++) {
+        before_total += before[i];
+        after_total += after[i];
+        printf("  %02x-%02x  %12.1f MiB -> %12.1f MiB\n", i * (256 / STATS_KEY_RANGES),
+               (i + 1) * (256 / STATS_KEY_RANGES) - 1, mebibytes(before[i]), mebibytes(after[i]));
+    }
+    printf("  total  %12.1f MiB -> %12.1f MiB\n", mebibytes(before_total), mebibytes(after_total));
+    return 1;
+}
+
+int cli_bedrock_stats(const char* path, const char* compact_copy_path, char* err, size_t err_sz) {
+    WorldScan scan;
+    StatsTask* tasks = NULL;
+    ScanRange** ranges = NULL;
+    KindTable kinds;
+    SizeStats dimensions[STATS_DIMENSIONS];
+    SizeStats key_ranges[STATS_KEY_RANGES];
+    SizeStats total;
+    size_t chunks[STATS_DIMENSIONS];
+    uint64_t disk[STATS_KEY_RANGES];
+    uint64_t disk_total = 0;
+    char* database = NULL;
+    double elapsed;
+    int ok = 0;
+    int i;
+    int k;
+
+    if (compact_copy_path && !(database = cli_bedrock_db_directory(path, err, err_sz))) return 0;
+    if (!world_scan_open(path, &scan, err, err_sz)) {
+        free(database);
+        return 0;
+    }
+    tasks = calloc((size_t)scan.range_count, sizeof(*tasks));
+    ranges = calloc((size_t)scan.range_count, sizeof(*ranges));
+    if (!tasks || !ranges) {
+        set_err(err, err_sz, "out of memory");
+        goto done;
+    }
+    for (i = 0; i < scan.range_count; i++) {
+        world_scan_range(&scan, i, stats_record, &tasks[i], &tasks[i].range);
+        /* Sizes only: values are never copied out of LevelDB. */
+        tasks[i].range.value_prefix_size = 0;
+        ranges[i] = &tasks[i].range;
+    }
+
+    elapsed = world_scan_run(&scan, ranges);
+    memset(&kinds, 0, sizeof(kinds));
+    memset(dimensions, 0, sizeof(dimensions));
+    memset(key_ranges, 0, sizeof(key_ranges));
+    memset(&total, 0, sizeof(total));
+    memset(chunks, 0, sizeof(chunks));
+    for (i = 0; i < scan.range_count; i++) {
+        if (!tasks[i].range.ok) {
+            set_err(err, err_sz, tasks[i].range.err);
+            goto done;
+        }
+        merge_kinds(&kinds, &tasks[i].kinds);
+        for (k = 0; k < STATS_DIMENSIONS; k++) {
+            merge_size(&dimensions[k], &tasks[i].dimensions[k]);
+            chunks[k] += tasks[i].chunks[k];
+        }
+        for (k = 0; k < STATS_KEY_RANGES; k++) merge_size(&key_ranges[k], &tasks[i].key_ranges[k]);
+    }
+    for (k = 0; k < STATS_KEY_RANGES; k++) merge_size(&total, &key_ranges[k]);
+    if (!key_range_sizes(scan.db, disk, err, err_sz)) goto done;
+
+    printf("Scanned %zu records in %.2f s with %d workers: %.1f MiB of keys, %.1f MiB of values\n",
+           total.records, elapsed, scan.workers, mebibytes(total.key_bytes), mebibytes(total.value_bytes));
+    qsort(kinds.items, kinds.count, sizeof(kinds.items[0]), compare_kinds);
+    printf("Records by kind:\n");
+    for (k = 0; k < (int)kinds.count; k++) {
+        const KindStats* stats = &kinds.items[k];
+        uint64_t bytes = stats->key_bytes + stats->value_bytes;
+        printf("  %-28s %10zu records %12.1f KiB keys %12.1f KiB values %5.1f%%\n", stats->kind,
+               stats->records, (double)stats->key_bytes / 1024.0, (double)stats->value_bytes / 1024.0,
+               total.key_bytes + total.value_bytes
+                   ? 100.0 * (double)bytes / (double)(total.key_bytes + total.value_bytes) : 0.0);
+    }
+    printf("Records by dimension:\n");
+    for (k = 0; k < STATS_DIMENSIONS; k++) {
+        if (dimensions[k].records == 0) continue;
+        printf("  %-28s %10zu chunks %10zu records %12.1f MiB\n", dimension_names[k], chunks[k],
+               dimensions[k].records, mebibytes(dimensions[k].key_bytes + dimensions[k].value_bytes));
+    }
+    /* Live bytes are uncompressed; table bytes are compressed but still hold
+       deleted and overwritten values until compaction drops them. */
+    printf("Key ranges by first byte (live bytes, approximate table bytes):\n");
+    for (k = 0; k < STATS_KEY_RANGES; k++) {
+        disk_total += disk[k];
+        printf("  %02x-%02x  %10zu records %12.1f MiB live %12.1f MiB in tables\n",
+               k * (256 / STATS_KEY_RANGES), (k + 1) * (256 / STATS_KEY_RANGES) - 1, key_ranges[k].records,
+               mebibytes(key_ranges[k].key_bytes + key_ranges[k].value_bytes), mebibytes(disk[k]));
+    }
+    printf("  total  %10zu records %12.1f MiB live %12.1f MiB in tables\n", total.records,
+           mebibytes(total.key_bytes + total.value_bytes), mebibytes(disk_total));
+    ok = 1;
+
+done:
+    free(tasks);
+    free(ranges);
+    world_scan_close(&scan);
+    /* The source is closed first, so no compaction of ours changes its files mid-copy. */
+    if (ok && compact_copy_path) ok = compact_copy(database, compact_copy_path, disk, err, err_sz);
+    free(database);
+    return ok;
+}
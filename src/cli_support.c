@@ -8,10 +8,16 @@
 #include <zlib.h>
 
 #include "cli_support.h"
+#include "cubic_world.h"
 #include "nbt_binary.h"
+#include "nbt_builder.h"
+#include "nbt_json.h"
+#include "nbt_tree.h"
 #include "platform.h"
 #include "region_file.h"
+#include "region_index.h"
 #include "region_read.h"
+#include "region_write.h"
 #include "snbt.h"
 
 static void set_err(char* err, size_t err_sz, const char* message) {
@@ -344,3 +350,656 @@ int cli_list_region_chunks(const char* path, char* err, size_t err_sz) {
     region_file_free(region);
     return 1;
 }
+
+static int print_cube(const CubicCube* cube, void* user) {
+    size_t* count = user;
+    printf("%d\t%d\t%d\t%d\t%d\t%s\t%u\n", cube->file->region_x, cube->file->region_z,
+           cube->file->cube_y, cube->local_x, cube->local_z,
+           nbt_input_format_name(cube->compression), cube->timestamp);
+    (*count)++;
+    return 1;
+}
+
+int cli_list_cubic_world(const char* directory, char* err, size_t err_sz) {
+    CubicWorld* world = cubic_world_scan(directory, err, err_sz);
+    size_t count = 0;
+    int ok;
+
+    if (!world) return 0;
+    printf("region_x\tregion_z\tcube_y\tlocal_x\tlocal_z\tcompression\ttimestamp\n");
+    ok = cubic_world_iterate(world, print_cube, &count, err, err_sz);
+    if (ok) {
+        printf("%zu cube%s in %zu column%s (%zu region file%s)\n",
+               count, count == 1 ? "" : "s",
+               world->column_count, world->column_count == 1 ? "" : "s",
+               world->file_count, world->file_count == 1 ? "" : "s");
+    }
+    cubic_world_free(world);
+    return ok;
+}
+
+int cli_verify_region(const char* path, int full_rehash, char* err, size_t err_sz) {
+    RegionIndex* previous;
+    RegionIndex* current;
+    RegionVerifyReport report;
+    char* index_path = region_index_path(path);
+    int loaded;
+    int ok = 0;
+    int index;
+
+    previous = malloc(sizeof(*previous));
+    current = malloc(sizeof(*current));
+    if (!index_path || !previous || !current) {
+        set_err(err, err_sz, "out of memory");
+        goto done;
+    }
+
+    loaded = region_index_load(index_path, previous, err, err_sz);
+    if (loaded < 0) {
+        fprintf(stderr, "Ignoring unusable index %s: %s\n", index_path, err);
+        if (err && err_sz > 0) err[0] = '\0';
+    }
+    if (!region_index_verify(path, loaded > 0 ? previous : NULL, full_rehash,
+                             current, &report, err, err_sz)) goto done;
+
+    for (index = 0; index < REGION_CHUNK_COUNT; index++) {
+        int x;
+        int z;
+        if (report.status[index] != REGION_VERIFY_MISMATCH) continue;
+        region_chunk_coords(index, &x, &z);
+        printf("Chunk (%d, %d) changed without a timestamp update\n", x, z);
+    }
+    printf("%d populated chunk%s: %d hashed, %d reused from index (%llu bytes hashed)\n",
+           report.populated, report.populated == 1 ? "" : "s", report.hashed + report.mismatched,
+           report.reused, (unsigned long long)report.bytes_hashed);
+    if (report.header_unchanged) printf("Region header unchanged since the last index\n");
+
+    if (report.mismatched > 0) {
+        /* Keep the old index so the damage stays visible on the next sweep. */
+        if (err && err_sz > 0) {
+            snprintf(err, err_sz, "%d chunk%s failed hash verification",
+                     report.mismatched, report.mismatched == 1 ? "" : "s");
+        }
+        goto done;
+    }
+    if (loaded <= 0 || !report.header_unchanged) {
+        if (!region_index_save(index_path, current, err, err_sz)) goto done;
+        printf("Updated index: %s\n", index_path);
+    }
+    ok = 1;
+
+done:
+    free(index_path);
+    free(previous);
+    free(current);
+    return ok;
+}
+
+/* Chunks per query task; small enough to balance, large enough to amortize. */
+#define QUERY_CHUNKS_PER_TASK 32
+#define QUERY_MAX_WORKERS 8
+
+typedef struct {
+    int chunk_x;
+    int chunk_z;
+    char* path;
+    NBTTag* node;
+} QueryMatch;
+
+typedef struct {
+    QueryMatch* items;
+    size_t count;
+    size_t capacity;
+    int chunk_x;
+    int chunk_z;
+    int failed;
+} QueryMatchList;
+
+typedef struct {
+    const RegionFile* region;
+    const NBTQuery* query;
+    int first_chunk;
+    int end_chunk;
+    QueryMatchList matches;
+    char warnings[512];
+    int error_count;
+} QueryChunkTask;
+
+typedef struct {
+    char** paths;
+    size_t count;
+    size_t capacity;
+    const char* directory;
+    int failed;
+} QueryRegionList;
+
+static int collect_query_match(const NBTTag* match, const char* path, void* user) {
+    QueryMatchList* list = user;
+    QueryMatch* item;
+
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        QueryMatch* grown = realloc(list->items, capacity * sizeof(*grown));
+        if (!grown) {
+            list->failed = 1;
+            return 0;
+        }
+        list->items = grown;
+        list->capacity = capacity;
+    }
+    item = &list->items[list->count];
+    item->chunk_x = list->chunk_x;
+    item->chunk_z = list->chunk_z;
+    item->path = nbt_strdup(path);
+    item->node = nbt_tag_clone(match);
+    if (!item->path || !item->node) {
+        free(item->path);
+        free_nbt_tree(item->node);
+        list->failed = 1;
+        return 0;
+    }
+    list->count++;
+    return 1;
+}
+
+static void free_query_matches(QueryMatchList* list) {
+    size_t i;
+    for (i = 0; i < list->count; i++) {
+        free(list->items[i].path);
+        free_nbt_tree(list->items[i].node);
+    }
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+static int query_chunk_task(void* task) {
+    QueryChunkTask* chunk_task = task;
+    int index;
+
+    for (index = chunk_task->first_chunk; index < chunk_task->end_chunk; index++) {
+        const RegionChunkSlot* slot = &chunk_task->region->chunks[index];
+        unsigned char* nbt;
+        size_t nbt_size = 0;
+        size_t first_match = chunk_task->matches.count;
+        int queried = 0;
+        char chunk_err[256] = {0};
+
+        if (!slot->present) continue;
+        region_chunk_coords(index, &chunk_task->matches.chunk_x, &chunk_task->matches.chunk_z);
+        nbt = region_file_extract_chunk_nbt(
+            chunk_task->region, chunk_task->matches.chunk_x, chunk_task->matches.chunk_z,
+            &nbt_size, NULL, chunk_err, sizeof(chunk_err));
+        if (nbt) {
+            /* Walk the decompressed bytes; only matching subtrees are decoded. */
+            queried = nbt_query_run_binary(chunk_task->query, nbt, nbt_size, NBT_BINARY_JAVA,
+                                           collect_query_match, &chunk_task->matches,
+                                           chunk_err, sizeof(chunk_err));
+            free(nbt);
+        }
+        if (chunk_task->matches.failed) return 0;
+        if (queried) continue;
+        /* Drop partial matches from a chunk that turned out to be malformed. */
+        while (chunk_task->matches.count > first_match) {
+            QueryMatch* match = &chunk_task->matches.items[--chunk_task->matches.count];
+            free(match->path);
+            free_nbt_tree(match->node);
+        }
+        /* Keep the first warning per task; the rest are only counted. */
+        if (chunk_task->error_count++ == 0) {
+            snprintf(chunk_task->warnings, sizeof(chunk_task->warnings), "chunk (%d, %d): %s",
+                     chunk_task->matches.chunk_x, chunk_task->matches.chunk_z, chunk_err);
+        }
+    }
+    return 1;
+}
+
+static int write_query_match(FILE* out, const char* source, const QueryMatch* match, int has_chunk, size_t ordinal) {
+    if (fputs(ordinal ? ",\n{\"source\":" : "\n{\"source\":", out) == EOF) return 0;
+    if (!nbt_write_json_string(out, source)) return 0;
+    if (has_chunk && fprintf(out, ",\"chunk\":[%d,%d]", match->chunk_x, match->chunk_z) < 0) return 0;
+    if (fputs(",\"match\":", out) == EOF) return 0;
+    if (!nbt_write_typed_json_node(out, match->node, match->path, 0, NULL, 0)) return 0;
+    return fputc('}', out) != EOF;
+}
+
+static int query_region_file(
+    const char* path,
+    const NBTQuery* query,
+    size_t* match_count,
+    size_t* error_count,
+    char* err,
+    size_t err_sz
+) {
+    char region_err[256] = {0};
+    RegionFile* region = region_file_read(path, region_err, sizeof(region_err));
+    QueryChunkTask tasks[REGION_CHUNK_COUNT / QUERY_CHUNKS_PER_TASK];
+    NBTWorkQueue* queue;
+    int workers = nbt_cpu_count();
+    int task_count = REGION_CHUNK_COUNT / QUERY_CHUNKS_PER_TASK;
+    int ok = 1;
+    int i;
+
+    if (!region) {
+        /* Unreadable region files are reported and skipped. */
+        fprintf(stderr, "Warning: %s: %s\n", path, region_err);
+        (*error_count)++;
+        return 1;
+    }
+    if (workers > QUERY_MAX_WORKERS) workers = QUERY_MAX_WORKERS;
+    queue = workers > 1 ? nbt_work_queue_create(workers) : NULL;
+
+    memset(tasks, 0, sizeof(tasks));
+    for (i = 0; i < task_count; i++) {
+        tasks[i].region = region;
+        tasks[i].query = query;
+        tasks[i].first_chunk = i * QUERY_CHUNKS_PER_TASK;
+        tasks[i].end_chunk = tasks[i].first_chunk + QUERY_CHUNKS_PER_TASK;
+        nbt_work_queue_submit(queue, query_chunk_task, &tasks[i]);
+    }
+    /* Inline tasks (no queue) report failure only through their own state. */
+    ok = nbt_work_queue_finish(queue);
+    for (i = 0; i < task_count; i++) {
+        if (tasks[i].matches.failed) ok = 0;
+    }
+    if (!ok) set_err(err, err_sz, "out of memory while collecting query matches");
+
+    /* Emit in chunk order so output does not depend on scheduling. */
+    for (i = 0; i < task_count; i++) {
+        size_t j;
+        if (tasks[i].error_count) {
+            fprintf(stderr, "Warning: %s: %s", path, tasks[i].warnings);
+            if (tasks[i].error_count > 1) fprintf(stderr, " (+%d more)", tasks[i].error_count - 1);
+            fputc('\n', stderr);
+            *error_count += (size_t)tasks[i].error_count;
+        }
+        for (j = 0; ok && j < tasks[i].matches.count; j++) {
+            if (!write_query_match(stdout, path, &tasks[i].matches.items[j], 1, *match_count)) {
+                set_err(err, err_sz, "failed to write query output");
+                ok = 0;
+            }
+            (*match_count)++;
+        }
+        free_query_matches(&tasks[i].matches);
+    }
+    region_file_free(region);
+    return ok;
+}
+
+static int collect_query_region(const char* name, void* user) {
+    QueryRegionList* list = user;
+    size_t dir_len;
+    size_t name_len;
+    char* path;
+
+    if (!region_path_has_extension(name)) return 1;
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 32;
+        char** grown = realloc(list->paths, capacity * sizeof(*grown));
+        if (!grown) {
+            list->failed = 1;
+            return 0;
+        }
+        list->paths = grown;
+        list->capacity = capacity;
+    }
+    dir_len = strlen(list->directory);
+    name_len = strlen(name);
+    path = malloc(dir_len + name_len + 2);
+    if (!path) {
+        list->failed = 1;
+        return 0;
+    }
+    memcpy(path, list->directory, dir_len);
+    path[dir_len] = '/';
+    memcpy(path + dir_len + 1, name, name_len + 1);
+    list->paths[list->count++] = path;
+    return 1;
+}
+
+static int compare_query_paths(const void* left, const void* right) {
+    return strcmp(*(char* const*)left, *(char* const*)right);
+}
+
+static void free_query_regions(QueryRegionList* list) {
+    size_t i;
+    for (i = 0; i < list->count; i++) free(list->paths[i]);
+    free(list->paths);
+    memset(list, 0, sizeof(*list));
+}
+
+/* Region files in directory, or in directory/region for a world folder. */
+static int scan_query_regions(const char* directory, QueryRegionList* list, char* err, size_t err_sz) {
+    char* nested;
+
+    memset(list, 0, sizeof(*list));
+    list->directory = directory;
+    if (!nbt_list_directory(directory, collect_query_region, list, err, err_sz)) return 0;
+    if (!list->failed && list->count == 0) {
+        nested = malloc(strlen(directory) + sizeof("/region"));
+        if (!nested) {
+            set_err(err, err_sz, "out of memory");
+            return 0;
+        }
+        sprintf(nested, "%s/region", directory);
+        if (nbt_is_directory(nested)) {
+            list->directory = nested;
+            if (!nbt_list_directory(nested, collect_query_region, list, err, err_sz)) {
+                free(nested);
+                free_query_regions(list);
+                return 0;
+            }
+        }
+        free(nested);
+        list->directory = NULL;
+    }
+    if (list->failed) {
+        set_err(err, err_sz, "out of memory");
+        free_query_regions(list);
+        return 0;
+    }
+    qsort(list->paths, list->count, sizeof(*list->paths), compare_query_paths);
+    return 1;
+}
+
+static int finish_query_output(size_t match_count, size_t error_count, int ok) {
+    printf("%s],\"count\":%zu,\"errors\":%zu}\n", match_count ? "\n" : "", match_count, error_count);
+    return ok && !ferror(stdout);
+}
+
+/* A single region file, or every region of a world folder. */
+static int collect_region_paths(const char* path, QueryRegionList* regions, char* err, size_t err_sz) {
+    memset(regions, 0, sizeof(*regions));
+    if (nbt_is_directory(path)) return scan_query_regions(path, regions, err, err_sz);
+    regions->paths = malloc(sizeof(*regions->paths));
+    if (regions->paths) regions->paths[0] = nbt_strdup(path);
+    if (!regions->paths || !regions->paths[0]) {
+        free(regions->paths);
+        regions->paths = NULL;
+        set_err(err, err_sz, "out of memory");
+        return 0;
+    }
+    regions->count = 1;
+    return 1;
+}
+
+int cli_query_regions(const char* path, const NBTQuery* query, char* err, size_t err_sz) {
+    QueryRegionList regions;
+    size_t match_count = 0;
+    size_t error_count = 0;
+    size_t i;
+    int ok = 1;
+
+    if (!collect_region_paths(path, &regions, err, err_sz)) return 0;
+
+    printf("{\"schema\":\"cnbt-query-v1\",\"matches\":[");
+    for (i = 0; ok && i < regions.count; i++) {
+        ok = query_region_file(regions.paths[i], query, &match_count, &error_count, err, err_sz);
+    }
+    if (!finish_query_output(match_count, error_count, ok) && ok) {
+        set_err(err, err_sz, "failed to write query output");
+        ok = 0;
+    }
+    free_query_regions(&regions);
+    return ok;
+}
+
+int cli_query_document(const char* source, const NBTTag* root, const NBTQuery* query, char* err, size_t err_sz) {
+    QueryMatchList matches;
+    size_t i;
+    int ok;
+
+    memset(&matches, 0, sizeof(matches));
+    ok = nbt_query_run(query, root, collect_query_match, &matches, err, err_sz);
+    if (matches.failed) {
+        set_err(err, err_sz, "out of memory while collecting query matches");
+        ok = 0;
+    }
+    if (ok) {
+        printf("{\"schema\":\"cnbt-query-v1\",\"matches\":[");
+        for (i = 0; ok && i < matches.count; i++) {
+            ok = write_query_match(stdout, source, &matches.items[i], 0, i);
+        }
+        if (!finish_query_output(matches.count, 0, ok)) {
+            set_err(err, err_sz, "failed to write query output");
+            ok = 0;
+        }
+    }
+    free_query_matches(&matches);
+    return ok;
+}
+
+typedef struct {
+    RegionFile* region;
+    const NBTFind* find;
+    int first_chunk;
+    int end_chunk;
+    QueryMatchList matches;
+    size_t matched;
+    size_t replaced;
+    int changed_chunks;
+    char warnings[512];
+    int error_count;
+} FindChunkTask;
+
+/*
+ * Finds (and replaces) in one range of chunks. Each task only updates the
+ * slots of its own chunks, so tasks can share the region.
+ */
+static int find_chunk_task(void* task) {
+    FindChunkTask* chunk_task = task;
+    int replacing = nbt_find_replaces(chunk_task->find);
+    int index;
+
+    for (index = chunk_task->first_chunk; index < chunk_task->end_chunk; index++) {
+        const RegionChunkSlot* slot = &chunk_task->region->chunks[index];
+        NBTFindStats stats = {0};
+        NBTTag* root = NULL;
+        unsigned char* nbt;
+        size_t nbt_size = 0;
+        size_t first_match = chunk_task->matches.count;
+        int found = 0;
+        char chunk_err[256] = {0};
+
+        if (!slot->present) continue;
+        region_chunk_coords(index, &chunk_task->matches.chunk_x, &chunk_task->matches.chunk_z);
+        nbt = region_file_extract_chunk_nbt(
+            chunk_task->region, chunk_task->matches.chunk_x, chunk_task->matches.chunk_z,
+            &nbt_size, NULL, chunk_err, sizeof(chunk_err));
+        if (nbt) {
+            root = nbt_binary_parse(nbt, nbt_size, NBT_BINARY_JAVA, NULL, chunk_err, sizeof(chunk_err));
+            free(nbt);
+        }
+        if (root) {
+            found = nbt_find_run(chunk_task->find, root, replacing ? NULL : collect_query_match,
+                                 &chunk_task->matches, &stats, chunk_err, sizeof(chunk_err));
+        }
+        if (found && stats.replaced) {
+            found = region_file_update_chunk_from_nbt(
+                chunk_task->region, chunk_task->matches.chunk_x, chunk_task->matches.chunk_z,
+                root, -1, chunk_err, sizeof(chunk_err));
+        }
+        free_nbt_tree(root);
+        if (chunk_task->matches.failed) return 0;
+        if (found) {
+            chunk_task->matched += stats.matched;
+            chunk_task->replaced += stats.replaced;
+            if (stats.replaced) chunk_task->changed_chunks++;
+            continue;
+        }
+        while (chunk_task->matches.count > first_match) {
+            QueryMatch* match = &chunk_task->matches.items[--chunk_task->matches.count];
+            free(match->path);
+            free_nbt_tree(match->node);
+        }
+        if (chunk_task->error_count++ == 0) {
+            snprintf(chunk_task->warnings, sizeof(chunk_task->warnings), "chunk (%d, %d): %s",
+                     chunk_task->matches.chunk_x, chunk_task->matches.chunk_z, chunk_err);
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    size_t matched;
+    size_t replaced;
+    size_t errors;
+    size_t regions_written;
+    size_t regions_skipped;
+} FindTotals;
+
+static int find_region_file(
+    const char* path,
+    const NBTFind* find,
+    const char* backup_suffix,
+    int allow_partial,
+    FindTotals* totals,
+    char* err,
+    size_t err_sz
+) {
+    char region_err[256] = {0};
+    RegionFile* region = region_file_read(path, region_err, sizeof(region_err));
+    FindChunkTask tasks[REGION_CHUNK_COUNT / QUERY_CHUNKS_PER_TASK];
+    NBTWorkQueue* queue;
+    int workers = nbt_cpu_count();
+    int task_count = REGION_CHUNK_COUNT / QUERY_CHUNKS_PER_TASK;
+    int changed_chunks = 0;
+    int failed_chunks = 0;
+    size_t replaced = 0;
+    int ok = 1;
+    int i;
+
+    if (!region) {
+        fprintf(stderr, "Warning: %s: %s\n", path, region_err);
+        totals->errors++;
+        return 1;
+    }
+    if (workers > QUERY_MAX_WORKERS) workers = QUERY_MAX_WORKERS;
+    queue = workers > 1 ? nbt_work_queue_create(workers) : NULL;
+
+    memset(tasks, 0, sizeof(tasks));
+    for (i = 0; i < task_count; i++) {
+        tasks[i].region = region;
+        tasks[i].find = find;
+        tasks[i].first_chunk = i * QUERY_CHUNKS_PER_TASK;
+        tasks[i].end_chunk = tasks[i].first_chunk + QUERY_CHUNKS_PER_TASK;
+        nbt_work_queue_submit(queue, find_chunk_task, &tasks[i]);
+    }
+    /* Inline tasks (no queue) report failure only through their own state. */
+    ok = nbt_work_queue_finish(queue);
+    for (i = 0; i < task_count; i++) {
+        if (tasks[i].matches.failed) ok = 0;
+    }
+    if (!ok) set_err(err, err_sz, "out of memory while collecting find matches");
+
+    for (i = 0; i < task_count; i++) {
+        size_t j;
+        if (tasks[i].error_count) {
+            fprintf(stderr, "Warning: %s: %s", path, tasks[i].warnings);
+            if (tasks[i].error_count > 1) fprintf(stderr, " (+%d more)", tasks[i].error_count - 1);
+            fputc('\n', stderr);
+            totals->errors += (size_t)tasks[i].error_count;
+            failed_chunks += tasks[i].error_count;
+        }
+        for (j = 0; ok && j < tasks[i].matches.count; j++) {
+            if (!write_query_match(stdout, path, &tasks[i].matches.items[j], 1, totals->matched + j)) {
+                set_err(err, err_sz, "failed to write find output");
+                ok = 0;
+            }
+        }
+        totals->matched += tasks[i].matched;
+        replaced += tasks[i].replaced;
+        changed_chunks += tasks[i].changed_chunks;
+        free_query_matches(&tasks[i].matches);
+    }
+
+    /* A chunk that failed to decode was not searched; rewriting would leave
+       the region half edited. */
+    if (ok && changed_chunks && failed_chunks && !allow_partial) {
+        fprintf(stderr, "Skipped %s: %d chunks failed, so none of its %d changed chunks were written\n",
+                path, failed_chunks, changed_chunks);
+        totals->regions_skipped++;
+    } else if (ok && changed_chunks) {
+        if (backup_suffix) {
+            char* backup_path = cli_append_suffix(path, backup_suffix);
+            ok = backup_path && cli_copy_file(path, backup_path, err, err_sz) &&
+                cli_backup_region_sidecars(path, backup_suffix, err, err_sz);
+            if (!backup_path) set_err(err, err_sz, "out of memory");
+            free(backup_path);
+        }
+        if (ok) ok = region_file_write_atomic(region, path, err, err_sz);
+        if (ok) {
+            printf("Updated %s: %zu tags in %d chunks\n", path, replaced, changed_chunks);
+            totals->replaced += replaced;
+            totals->regions_written++;
+        }
+    }
+    region_file_free(region);
+    return ok;
+}
+
+int cli_find_regions(
+    const char* path,
+    const NBTFind* find,
+    const char* backup_suffix,
+    int allow_partial,
+    char* err,
+    size_t err_sz
+) {
+    QueryRegionList regions;
+    FindTotals totals = {0};
+    int replacing = nbt_find_replaces(find);
+    size_t i;
+    int ok = 1;
+
+    if (!collect_region_paths(path, &regions, err, err_sz)) return 0;
+
+    if (!replacing) printf("{\"schema\":\"cnbt-find-v1\",\"matches\":[");
+    for (i = 0; ok && i < regions.count; i++) {
+        ok = find_region_file(regions.paths[i], find, backup_suffix, allow_partial, &totals, err, err_sz);
+    }
+    if (!replacing) {
+        if (!finish_query_output(totals.matched, totals.errors, ok) && ok) {
+            set_err(err, err_sz, "failed to write find output");
+            ok = 0;
+        }
+    } else {
+        printf("Replaced %zu of %zu matching tags in %zu region files (%zu errors)\n",
+               totals.replaced, totals.matched, totals.regions_written, totals.errors);
+        /* A replace that could not reach every chunk is a failure, even when
+           the remaining regions were written. */
+        if (ok && totals.errors) {
+            if (err && err_sz > 0) {
+                snprintf(err, err_sz, "%zu chunks or regions could not be searched; %zu regions were left "
+                         "unchanged (--allow-partial writes them anyway)", totals.errors, totals.regions_skipped);
+            }
+            ok = 0;
+        }
+    }
+    free_query_regions(&regions);
+    return ok;
+}
+
+int cli_find_document(const char* source, NBTTag* root, const NBTFind* find, char* err, size_t err_sz) {
+    QueryMatchList matches;
+    size_t i;
+    int ok;
+
+    memset(&matches, 0, sizeof(matches));
+    ok = nbt_find_run(find, root, collect_query_match, &matches, NULL, err, err_sz);
+    if (matches.failed) {
+        set_err(err, err_sz, "out of memory while collecting find matches");
+        ok = 0;
+    }
+    if (ok) {
+        printf("{\"schema\":\"cnbt-find-v1\",\"matches\":[");
+        for (i = 0; ok && i < matches.count; i++) {
+            ok = write_query_match(stdout, source, &matches.items[i], 0, i);
+        }
+        if (!finish_query_output(matches.count, 0, ok)) {
+            set_err(err, err_sz, "failed to write find output");
+            ok = 0;
+        }
+    }
+    free_query_matches(&matches);
+    return ok;
+}
@@ -0,0 +1,366 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cubic_world.h"
+#include "nbt_binary.h"
+#include "nbt_builder.h"
+#include "platform.h"
+#include "region_file.h"
+#include "region_read.h"
+
+/* Keep a bounded number of decoded files in memory ahead of the callback. */
+#define CUBIC_DECODE_MAX_WORKERS 8
+
+typedef struct {
+    int local_x;
+    int local_z;
+    uint32_t timestamp;
+    NBTInputFormat compression;
+    NBTTag* root;
+} DecodedCube;
+
+typedef struct {
+    const CubicRegionFileRef* file;
+    DecodedCube* cubes;
+    int cube_count;
+    int ok;
+    char err[256];
+} DecodedFile;
+
+typedef struct {
+    DecodedFile* files;
+    size_t count;
+    NBTWorkQueue* queue;
+} DecodeBatch;
+
+typedef struct {
+    const char* directory;
+    CubicWorld* world;
+    size_t capacity;
+    int failed;
+} ScanContext;
+
+static void set_err(char* err, size_t err_sz, const char* msg) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s", msg);
+}
+
+static char* join_path(const char* directory, const char* name) {
+    size_t dir_len = strlen(directory);
+    size_t name_len = strlen(name);
+    int needs_separator = dir_len > 0 && directory[dir_len - 1] != '/' && directory[dir_len - 1] != '\\';
+    char* path = malloc(dir_len + (size_t)needs_separator + name_len + 1);
+
+    if (!path) return NULL;
+    memcpy(path, directory, dir_len);
+    if (needs_separator) path[dir_len] = '/';
+    memcpy(path + dir_len + (size_t)needs_separator, name, name_len + 1);
+    return path;
+}
+
+static int collect_region_file(const char* name, void* user) {
+    ScanContext* context = user;
+    CubicWorld* world = context->world;
+    CubicRegionFileRef* ref;
+    int region_x;
+    int cube_y;
+    int region_z;
+
+    if (!region_path_parse_cubic_r2_coords(name, &region_x, &cube_y, &region_z)) return 1;
+    if (world->file_count == context->capacity) {
+        size_t capacity = context->capacity ? context->capacity * 2 : 64;
+        CubicRegionFileRef* grown = realloc(world->files, capacity * sizeof(*grown));
+        if (!grown) {
+            context->failed = 1;
+            return 0;
+        }
+        world->files = grown;
+        context->capacity = capacity;
+    }
+
+    ref = &world->files[world->file_count];
+    ref->path = join_path(context->directory, name);
+    if (!ref->path) {
+        context->failed = 1;
+        return 0;
+    }
+    ref->region_x = region_x;
+    ref->cube_y = cube_y;
+    ref->region_z = region_z;
+    world->file_count++;
+    return 1;
+}
+
+static int compare_int(int a, int b) {
+    return (a > b) - (a < b);
+}
+
+static int compare_region_files(const void* left, const void* right) {
+    const CubicRegionFileRef* a = left;
+    const CubicRegionFileRef* b = right;
+    int order = compare_int(a->region_x, b->region_x);
+
+    if (!order) order = compare_int(a->region_z, b->region_z);
+    if (!order) order = compare_int(a->cube_y, b->cube_y);
+    if (!order) order = strcmp(a->path, b->path);
+    return order;
+}
+
+CubicWorld* cubic_world_scan(const char* directory, char* err, size_t err_sz) {
+    ScanContext context;
+    CubicWorld* world;
+    size_t i;
+
+    if (!directory) {
+        set_err(err, err_sz, "missing world directory");
+        return NULL;
+    }
+    world = calloc(1, sizeof(*world));
+    if (!world) {
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+
+    memset(&context, 0, sizeof(context));
+    context.directory = directory;
+    context.world = world;
+    if (!nbt_list_directory(directory, collect_region_file, &context, err, err_sz)) {
+        cubic_world_free(world);
+        return NULL;
+    }
+    if (context.failed) {
+        set_err(err, err_sz, "out of memory");
+        cubic_world_free(world);
+        return NULL;
+    }
+    if (world->file_count == 0) return world;
+
+    qsort(world->files, world->file_count, sizeof(*world->files), compare_region_files);
+
+    world->columns = malloc(world->file_count * sizeof(*world->columns));
+    if (!world->columns) {
+        set_err(err, err_sz, "out of memory");
+        cubic_world_free(world);
+        return NULL;
+    }
+    for (i = 0; i < world->file_count; i++) {
+        const CubicRegionFileRef* ref = &world->files[i];
+        CubicColumn* column = world->column_count > 0 ? &world->columns[world->column_count - 1] : NULL;
+
+        if (column && column->region_x == ref->region_x && column->region_z == ref->region_z) {
+            column->file_count++;
+            continue;
+        }
+        column = &world->columns[world->column_count++];
+        column->region_x = ref->region_x;
+        column->region_z = ref->region_z;
+        column->first_file = i;
+        column->file_count = 1;
+    }
+
+    return world;
+}
+
+void cubic_world_free(CubicWorld* world) {
+    size_t i;
+
+    if (!world) return;
+    for (i = 0; i < world->file_count; i++) free(world->files[i].path);
+    free(world->files);
+    free(world->columns);
+    free(world);
+}
+
+static int decode_file_task(void* task) {
+    DecodedFile* decoded = task;
+    RegionFile* region;
+    int index;
+
+    region = region_file_read(decoded->file->path, decoded->err, sizeof(decoded->err));
+    if (!region) return 0;
+
+    decoded->cubes = calloc(REGION_CHUNK_COUNT, sizeof(*decoded->cubes));
+    if (!decoded->cubes) {
+        set_err(decoded->err, sizeof(decoded->err), "out of memory");
+        region_file_free(region);
+        return 0;
+    }
+
+    for (index = 0; index < REGION_CHUNK_COUNT; index++) {
+        const RegionChunkSlot* slot = &region->chunks[index];
+        DecodedCube* cube;
+        unsigned char* nbt;
+        size_t nbt_size = 0;
+        char cube_err[192] = {0};
+
+        if (!slot->present) continue;
+        cube = &decoded->cubes[decoded->cube_count];
+        region_chunk_coords(index, &cube->local_x, &cube->local_z);
+        cube->timestamp = slot->timestamp;
+
+        nbt = region_file_extract_chunk_nbt(
+            region, cube->local_x, cube->local_z, &nbt_size, &cube->compression,
+            cube_err, sizeof(cube_err));
+        if (nbt) {
+            cube->root = nbt_binary_parse(nbt, nbt_size, NBT_BINARY_JAVA, NULL, cube_err, sizeof(cube_err));
+            free(nbt);
+        }
+        if (!cube->root) {
+            snprintf(decoded->err, sizeof(decoded->err), "cube (%d, %d): %s",
+                     cube->local_x, cube->local_z, cube_err);
+            region_file_free(region);
+            return 0;
+        }
+        decoded->cube_count++;
+    }
+
+    region_file_free(region);
+    decoded->ok = 1;
+    return 1;
+}
+
+static void free_batch(DecodeBatch* batch) {
+    size_t i;
+    int j;
+
+    if (!batch->files) return;
+    nbt_work_queue_finish(batch->queue);
+    batch->queue = NULL;
+    for (i = 0; i < batch->count; i++) {
+        DecodedFile* decoded = &batch->files[i];
+        for (j = 0; j < decoded->cube_count; j++) free_nbt_tree(decoded->cubes[j].root);
+        free(decoded->cubes);
+    }
+    free(batch->files);
+    batch->files = NULL;
+    batch->count = 0;
+}
+
+static int start_batch(
+    const CubicWorld* world,
+    size_t first_file,
+    size_t count,
+    DecodeBatch* batch
+) {
+    size_t i;
+
+    memset(batch, 0, sizeof(*batch));
+    if (count == 0) return 1;
+    batch->files = calloc(count, sizeof(*batch->files));
+    if (!batch->files) return 0;
+    batch->count = count;
+    batch->queue = count > 1 ? nbt_work_queue_create((int)count) : NULL;
+    for (i = 0; i < count; i++) {
+        batch->files[i].file = &world->files[first_file + i];
+        nbt_work_queue_submit(batch->queue, decode_file_task, &batch->files[i]);
+    }
+    return 1;
+}
+
+static int iterate_column(
+    const CubicWorld* world,
+    size_t column_index,
+    CubicCubeFn fn,
+    void* user,
+    int* stopped,
+    char* err,
+    size_t err_sz
+) {
+    const CubicColumn* column;
+    DecodeBatch current;
+    DecodeBatch next;
+    size_t window;
+    size_t position;
+    size_t end;
+    int workers;
+    int ok = 1;
+
+    if (!world || !fn || column_index >= world->column_count) {
+        set_err(err, err_sz, "invalid cubic column iteration arguments");
+        return 0;
+    }
+    column = &world->columns[column_index];
+    workers = nbt_cpu_count();
+    if (workers > CUBIC_DECODE_MAX_WORKERS) workers = CUBIC_DECODE_MAX_WORKERS;
+    window = (size_t)workers;
+    position = column->first_file;
+    end = column->first_file + column->file_count;
+
+    if (!start_batch(world, position, end - position < window ? end - position : window, &current)) {
+        set_err(err, err_sz, "out of memory");
+        return 0;
+    }
+    position += current.count;
+
+    while (current.count > 0) {
+        size_t i;
+
+        nbt_work_queue_finish(current.queue);
+        current.queue = NULL;
+        /* Decode the next files while the callback consumes this window. */
+        if (!start_batch(world, position, end - position < window ? end - position : window, &next)) {
+            set_err(err, err_sz, "out of memory");
+            ok = 0;
+            break;
+        }
+        position += next.count;
+
+        for (i = 0; ok && i < current.count; i++) {
+            DecodedFile* decoded = &current.files[i];
+            int j;
+
+            if (!decoded->ok) {
+                if (err && err_sz > 0) snprintf(err, err_sz, "%s: %s", decoded->file->path, decoded->err);
+                ok = 0;
+                break;
+            }
+            for (j = 0; j < decoded->cube_count; j++) {
+                CubicCube cube;
+                cube.file = decoded->file;
+                cube.local_x = decoded->cubes[j].local_x;
+                cube.local_z = decoded->cubes[j].local_z;
+                cube.timestamp = decoded->cubes[j].timestamp;
+                cube.compression = decoded->cubes[j].compression;
+                cube.root = decoded->cubes[j].root;
+                if (!fn(&cube, user)) {
+                    *stopped = 1;
+                    free_batch(&current);
+                    free_batch(&next);
+                    return 1;
+                }
+            }
+        }
+
+        free_batch(&current);
+        current = next;
+        if (!ok) break;
+    }
+
+    free_batch(&current);
+    return ok;
+}
+
+int cubic_world_iterate_column(
+    const CubicWorld* world,
+    size_t column_index,
+    CubicCubeFn fn,
+    void* user,
+    char* err,
+    size_t err_sz
+) {
+    int stopped = 0;
+    return iterate_column(world, column_index, fn, user, &stopped, err, err_sz);
+}
+
+int cubic_world_iterate(const CubicWorld* world, CubicCubeFn fn, void* user, char* err, size_t err_sz) {
+    size_t column;
+    int stopped = 0;
+
+    if (!world || !fn) {
+        set_err(err, err_sz, "invalid cubic world iteration arguments");
+        return 0;
+    }
+    for (column = 0; column < world->column_count && !stopped; column++) {
+        if (!iterate_column(world, column, fn, user, &stopped, err, err_sz)) return 0;
+    }
+    return 1;
+}
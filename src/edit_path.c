@@ -1,10 +1,12 @@
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "edit_path.h"
+#include "nbt_tree.h"
 #include "platform.h"
 
 typedef enum {
@@ -15,10 +17,17 @@ typedef enum {
 
 typedef struct {
     char* key;
+    size_t key_len;
+    uint32_t key_hash;
     IndexMode index_mode;
     int index;
 } ParsedSegment;
 
+struct EditPathProgram {
+    ParsedSegment* segs;
+    int count;
+};
+
 typedef struct {
     NBTTag* tag;
     NBTTag* parent;
@@ -330,17 +339,11 @@ static int is_root_name_segment(NBTTag* root, const ParsedSegment* seg) {
     return strcmp(seg->key, root->name) == 0;
 }
 
-static NBTTag* find_child_by_name(NBTTag* compound, const char* name, int* out_index) {
-    if (!compound || compound->type != TAG_Compound || !name) return NULL;
-
-    for (int i = 0; i < compound->value.compound.count; i++) {
-        NBTTag* child = compound->value.compound.items[i];
-        if (child && child->name && strcmp(child->name, name) == 0) {
-            if (out_index) *out_index = i;
-            return child;
-        }
-    }
-    return NULL;
+static NBTTag* find_segment_child(NBTTag* compound, const ParsedSegment* seg, int* out_index) {
+    int index = nbt_compound_find_hashed(compound, seg->key, seg->key_len, seg->key_hash);
+    if (index < 0) return NULL;
+    if (out_index) *out_index = index;
+    return compound->value.compound.items[index];
 }
 
 static int push_cursor(Cursor** arr, size_t* count, size_t* cap, Cursor value) {
@@ -367,21 +370,71 @@ static int push_target(PathTarget** arr, size_t* count, size_t* cap, PathTarget
     return 1;
 }
 
-EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_targets, size_t* out_count, char* err, size_t err_sz) {
-    ParsedSegment* segs = NULL;
-    int seg_count = 0;
-    int start = 0;
+EditStatus edit_path_compile(const char* path, EditPathProgram** out_program, char* err, size_t err_sz) {
+    EditPathProgram* program;
     EditStatus st;
+
+    if (!path || !out_program) {
+        set_err(err, err_sz, "invalid argument");
+        return EDIT_ERR_PATH_SYNTAX;
+    }
+    *out_program = NULL;
+
+    program = calloc(1, sizeof(*program));
+    if (!program) {
+        set_err(err, err_sz, "out of memory");
+        return EDIT_ERR_MEMORY;
+    }
+
+    st = parse_path_segments(path, &program->segs, &program->count, err, err_sz);
+    if (st != EDIT_OK) {
+        free(program);
+        return st;
+    }
+
+    if (program->count > 0) {
+        /* parse_path_segments reserves the maximum; keep only what is used. */
+        ParsedSegment* fitted = realloc(program->segs, (size_t)program->count * sizeof(ParsedSegment));
+        if (fitted) program->segs = fitted;
+    }
+    for (int i = 0; i < program->count; i++) {
+        ParsedSegment* seg = &program->segs[i];
+        seg->key_len = strlen(seg->key);
+        seg->key_hash = nbt_name_hash(seg->key, seg->key_len);
+    }
+
+    *out_program = program;
+    return EDIT_OK;
+}
+
+void edit_path_program_free(EditPathProgram* program) {
+    if (!program) return;
+    free_parsed_segments(program->segs, program->count);
+    free(program);
+}
+
+EditStatus edit_path_execute(
+    const EditPathProgram* program,
+    NBTTag* root,
+    PathTarget** out_targets,
+    size_t* out_count,
+    char* err,
+    size_t err_sz
+) {
+    int start = 0;
     Cursor* cursors = NULL;
     size_t cur_count = 0;
     size_t cur_cap = 0;
+    Cursor* next = NULL;
+    size_t next_count = 0;
+    size_t next_cap = 0;
     PathTarget* targets = NULL;
     size_t target_count = 0;
     size_t target_cap = 0;
     int saw_type_mismatch = 0;
     int saw_index_bounds = 0;
 
-    if (!root || !path || !out_targets || !out_count) {
+    if (!program || !root || !out_targets || !out_count) {
         set_err(err, err_sz, "invalid argument");
         return EDIT_ERR_PATH_SYNTAX;
     }
@@ -389,61 +442,37 @@ EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_t
     *out_targets = NULL;
     *out_count = 0;
 
-    st = parse_path_segments(path, &segs, &seg_count, err, err_sz);
-    if (st != EDIT_OK) return st;
-
-    if (!push_cursor(&cursors, &cur_count, &cur_cap, (Cursor){ .tag = root, .parent = NULL, .parent_index = -1 })) {
-        free_parsed_segments(segs, seg_count);
-        set_err(err, err_sz, "out of memory");
-        return EDIT_ERR_MEMORY;
+    if (program->count > 0 && is_root_name_segment(root, &program->segs[0])) {
+        start = 1;
     }
 
-    if (seg_count == 0) {
+    if (start >= program->count) {
         if (!push_target(&targets, &target_count, &target_cap, (PathTarget){ .kind = PATH_TARGET_TAG, .tag = root, .parent = NULL, .index = -1 })) {
-            free(cursors);
-            free_parsed_segments(segs, seg_count);
-            set_err(err, err_sz, "out of memory");
-            return EDIT_ERR_MEMORY;
+            goto oom;
         }
-        free(cursors);
-        free_parsed_segments(segs, seg_count);
         *out_targets = targets;
         *out_count = target_count;
         return EDIT_OK;
     }
 
-    if (is_root_name_segment(root, &segs[0])) {
-        start = 1;
-    }
-
-    if (start >= seg_count) {
-        if (!push_target(&targets, &target_count, &target_cap, (PathTarget){ .kind = PATH_TARGET_TAG, .tag = root, .parent = NULL, .index = -1 })) {
-            free(cursors);
-            free_parsed_segments(segs, seg_count);
-            set_err(err, err_sz, "out of memory");
-            return EDIT_ERR_MEMORY;
-        }
-        free(cursors);
-        free_parsed_segments(segs, seg_count);
-        *out_targets = targets;
-        *out_count = target_count;
-        return EDIT_OK;
+    if (!push_cursor(&cursors, &cur_count, &cur_cap, (Cursor){ .tag = root, .parent = NULL, .parent_index = -1 })) {
+        goto oom;
     }
 
-    for (int si = start; si < seg_count; si++) {
-        int is_last = (si == seg_count - 1);
-        ParsedSegment* seg = &segs[si];
-        Cursor* next = NULL;
-        size_t next_count = 0;
-        size_t next_cap = 0;
+    /* Two cursor buffers are swapped between segments, so the walk only
+     * allocates when a level is wider than any level before it. */
+    for (int si = start; si < program->count && cur_count > 0; si++) {
+        int is_last = (si == program->count - 1);
+        const ParsedSegment* seg = &program->segs[si];
 
+        next_count = 0;
         for (size_t ci = 0; ci < cur_count; ci++) {
             Cursor cur = cursors[ci];
             NBTTag* node = cur.tag;
             NBTTag* node_parent = cur.parent;
             int node_parent_index = cur.parent_index;
 
-            if (seg->key && seg->key[0] != '\0') {
+            if (seg->key_len > 0) {
                 int child_index = -1;
                 NBTTag* child;
 
@@ -452,7 +481,7 @@ EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_t
                     continue;
                 }
 
-                child = find_child_by_name(node, seg->key, &child_index);
+                child = find_segment_child(node, seg, &child_index);
                 if (!child) continue;
                 node_parent = node;
                 node_parent_index = child_index;
@@ -461,57 +490,25 @@ EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_t
 
             if (seg->index_mode != INDEX_NONE) {
                 if (node->type == TAG_List) {
+                    int first = 0;
+                    int end = node->value.list.count;
+
                     if (seg->index_mode == INDEX_EXACT) {
-                        int idx = seg->index;
-                        if (idx < 0 || idx >= node->value.list.count) {
+                        if (seg->index < 0 || seg->index >= node->value.list.count) {
                             saw_index_bounds = 1;
                             continue;
                         }
+                        first = seg->index;
+                        end = seg->index + 1;
+                    }
 
+                    for (int idx = first; idx < end; idx++) {
                         if (is_last) {
                             PathTarget t = { .kind = PATH_TARGET_LIST_ELEMENT, .tag = node, .parent = NULL, .index = idx };
-                            if (!push_target(&targets, &target_count, &target_cap, t)) {
-                                free(next);
-                                free(cursors);
-                                free_parsed_segments(segs, seg_count);
-                                free(targets);
-                                set_err(err, err_sz, "out of memory");
-                                return EDIT_ERR_MEMORY;
-                            }
+                            if (!push_target(&targets, &target_count, &target_cap, t)) goto oom;
                         } else if (node->value.list.items[idx]) {
                             Cursor nx = { .tag = node->value.list.items[idx], .parent = node, .parent_index = idx };
-                            if (!push_cursor(&next, &next_count, &next_cap, nx)) {
-                                free(next);
-                                free(cursors);
-                                free_parsed_segments(segs, seg_count);
-                                free(targets);
-                                set_err(err, err_sz, "out of memory");
-                                return EDIT_ERR_MEMORY;
-                            }
-                        }
-                    } else {
-                        for (int idx = 0; idx < node->value.list.count; idx++) {
-                            if (is_last) {
-                                PathTarget t = { .kind = PATH_TARGET_LIST_ELEMENT, .tag = node, .parent = NULL, .index = idx };
-                                if (!push_target(&targets, &target_count, &target_cap, t)) {
-                                    free(next);
-                                    free(cursors);
-                                    free_parsed_segments(segs, seg_count);
-                                    free(targets);
-                                    set_err(err, err_sz, "out of memory");
-                                    return EDIT_ERR_MEMORY;
-                                }
-                            } else if (node->value.list.items[idx]) {
-                                Cursor nx = { .tag = node->value.list.items[idx], .parent = node, .parent_index = idx };
-                                if (!push_cursor(&next, &next_count, &next_cap, nx)) {
-                                    free(next);
-                                    free(cursors);
-                                    free_parsed_segments(segs, seg_count);
-                                    free(targets);
-                                    set_err(err, err_sz, "out of memory");
-                                    return EDIT_ERR_MEMORY;
-                                }
-                            }
+                            if (!push_cursor(&next, &next_count, &next_cap, nx)) goto oom;
                         }
                     }
                     continue;
@@ -524,6 +521,8 @@ EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_t
 
                 if (node->type == TAG_Byte_Array || node->type == TAG_Int_Array || node->type == TAG_Long_Array) {
                     int len = 0;
+                    int first = 0;
+                    int end;
                     PathTargetKind kind = PATH_TARGET_BYTE_ARRAY_ELEMENT;
                     if (node->type == TAG_Byte_Array) {
                         len = node->value.byte_array.length;
@@ -536,35 +535,19 @@ EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_t
                         kind = PATH_TARGET_LONG_ARRAY_ELEMENT;
                     }
 
+                    end = len;
                     if (seg->index_mode == INDEX_EXACT) {
-                        int idx = seg->index;
-                        if (idx < 0 || idx >= len) {
+                        if (seg->index < 0 || seg->index >= len) {
                             saw_index_bounds = 1;
                             continue;
                         }
-                        {
-                            PathTarget t = { .kind = kind, .tag = node, .parent = NULL, .index = idx };
-                            if (!push_target(&targets, &target_count, &target_cap, t)) {
-                                free(next);
-                                free(cursors);
-                                free_parsed_segments(segs, seg_count);
-                                free(targets);
-                                set_err(err, err_sz, "out of memory");
-                                return EDIT_ERR_MEMORY;
-                            }
-                        }
-                    } else {
-                        for (int idx = 0; idx < len; idx++) {
-                            PathTarget t = { .kind = kind, .tag = node, .parent = NULL, .index = idx };
-                            if (!push_target(&targets, &target_count, &target_cap, t)) {
-                                free(next);
-                                free(cursors);
-                                free_parsed_segments(segs, seg_count);
-                                free(targets);
-                                set_err(err, err_sz, "out of memory");
-                                return EDIT_ERR_MEMORY;
-                            }
-                        }
+                        first = seg->index;
+                        end = seg->index + 1;
+                    }
+
+                    for (int idx = first; idx < end; idx++) {
+                        PathTarget t = { .kind = kind, .tag = node, .parent = NULL, .index = idx };
+                        if (!push_target(&targets, &target_count, &target_cap, t)) goto oom;
                     }
                     continue;
                 }
@@ -575,35 +558,26 @@ EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_t
 
             if (is_last) {
                 PathTarget t = { .kind = PATH_TARGET_TAG, .tag = node, .parent = node_parent, .index = node_parent_index };
-                if (!push_target(&targets, &target_count, &target_cap, t)) {
-                    free(next);
-                    free(cursors);
-                    free_parsed_segments(segs, seg_count);
-                    free(targets);
-                    set_err(err, err_sz, "out of memory");
-                    return EDIT_ERR_MEMORY;
-                }
+                if (!push_target(&targets, &target_count, &target_cap, t)) goto oom;
             } else {
                 Cursor nx = { .tag = node, .parent = node_parent, .parent_index = node_parent_index };
-                if (!push_cursor(&next, &next_count, &next_cap, nx)) {
-                    free(next);
-                    free(cursors);
-                    free_parsed_segments(segs, seg_count);
-                    free(targets);
-                    set_err(err, err_sz, "out of memory");
-                    return EDIT_ERR_MEMORY;
-                }
+                if (!push_cursor(&next, &next_count, &next_cap, nx)) goto oom;
             }
         }
 
-        free(cursors);
-        cursors = next;
-        cur_count = next_count;
-        cur_cap = next_cap;
+        {
+            Cursor* swap = cursors;
+            size_t swap_cap = cur_cap;
+            cursors = next;
+            cur_cap = next_cap;
+            cur_count = next_count;
+            next = swap;
+            next_cap = swap_cap;
+        }
     }
 
     free(cursors);
-    free_parsed_segments(segs, seg_count);
+    free(next);
 
     if (target_count == 0) {
         free(targets);
@@ -622,6 +596,30 @@ EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_t
     *out_targets = targets;
     *out_count = target_count;
     return EDIT_OK;
+
+oom:
+    free(cursors);
+    free(next);
+    free(targets);
+    set_err(err, err_sz, "out of memory");
+    return EDIT_ERR_MEMORY;
+}
+
+EditStatus resolve_edit_paths(NBTTag* root, const char* path, PathTarget** out_targets, size_t* out_count, char* err, size_t err_sz) {
+    EditPathProgram* program = NULL;
+    EditStatus st;
+
+    if (!root || !path || !out_targets || !out_count) {
+        set_err(err, err_sz, "invalid argument");
+        return EDIT_ERR_PATH_SYNTAX;
+    }
+
+    st = edit_path_compile(path, &program, err, err_sz);
+    if (st != EDIT_OK) return st;
+
+    st = edit_path_execute(program, root, out_targets, out_count, err, err_sz);
+    edit_path_program_free(program);
+    return st;
 }
 
 void free_edit_paths(PathTarget* targets) {
@@ -653,8 +651,9 @@ EditStatus resolve_edit_path(NBTTag* root, const char* path, PathTarget* out, ch
 }
 
 EditStatus resolve_set_parent_and_key(NBTTag* root, const char* path, NBTTag** out_parent, char** out_key, char* err, size_t err_sz) {
-    ParsedSegment* segs = NULL;
-    int seg_count = 0;
+    EditPathProgram* program = NULL;
+    const ParsedSegment* segs;
+    int seg_count;
     int start = 0;
     EditStatus st;
     NBTTag* current;
@@ -667,70 +666,72 @@ EditStatus resolve_set_parent_and_key(NBTTag* root, const char* path, NBTTag** o
     *out_parent = NULL;
     *out_key = NULL;
 
-    st = parse_path_segments(path, &segs, &seg_count, err, err_sz);
+    st = edit_path_compile(path, &program, err, err_sz);
     if (st != EDIT_OK) return st;
+    segs = program->segs;
+    seg_count = program->count;
 
     if (seg_count == 0) {
-        free_parsed_segments(segs, seg_count);
         set_err(err, err_sz, "invalid path syntax");
-        return EDIT_ERR_PATH_SYNTAX;
+        st = EDIT_ERR_PATH_SYNTAX;
+        goto done;
     }
 
     if (is_root_name_segment(root, &segs[0])) start = 1;
     if (start >= seg_count) {
-        free_parsed_segments(segs, seg_count);
         set_err(err, err_sz, "unsupported operation: cannot target root path");
-        return EDIT_ERR_UNSUPPORTED;
+        st = EDIT_ERR_UNSUPPORTED;
+        goto done;
     }
 
     if (segs[seg_count - 1].index_mode != INDEX_NONE) {
-        free_parsed_segments(segs, seg_count);
         set_err(err, err_sz, "unsupported operation: set-create path must end with a key");
-        return EDIT_ERR_UNSUPPORTED;
+        st = EDIT_ERR_UNSUPPORTED;
+        goto done;
     }
 
     current = root;
     for (int i = start; i < seg_count - 1; i++) {
-        ParsedSegment* seg = &segs[i];
+        const ParsedSegment* seg = &segs[i];
         NBTTag* node = current;
 
         if (seg->index_mode == INDEX_WILDCARD) {
-            free_parsed_segments(segs, seg_count);
             set_err(err, err_sz, "unsupported operation: wildcard is not allowed in set-create path");
-            return EDIT_ERR_UNSUPPORTED;
+            st = EDIT_ERR_UNSUPPORTED;
+            goto done;
         }
 
-        if (seg->key && seg->key[0] != '\0') {
+        if (seg->key_len > 0) {
             if (!node || node->type != TAG_Compound) {
-                free_parsed_segments(segs, seg_count);
                 set_err(err, err_sz, "type mismatch: parent path is not a compound");
-                return EDIT_ERR_TYPE_MISMATCH;
+                st = EDIT_ERR_TYPE_MISMATCH;
+                goto done;
             }
-            node = find_child_by_name(node, seg->key, NULL);
+            node = find_segment_child(node, seg, NULL);
             if (!node) {
-                free_parsed_segments(segs, seg_count);
                 set_err(err, err_sz, "path not found");
-                return EDIT_ERR_PATH_NOT_FOUND;
+                st = EDIT_ERR_PATH_NOT_FOUND;
+                goto done;
             }
         }
 
         if (seg->index_mode == INDEX_EXACT) {
             int idx = seg->index;
             if (node->type != TAG_List) {
-                free_parsed_segments(segs, seg_count);
                 set_err(err, err_sz, "type mismatch: indexing is only supported for list/array tags");
-                return EDIT_ERR_TYPE_MISMATCH;
+                st = EDIT_ERR_TYPE_MISMATCH;
+                goto done;
             }
             if (idx < 0 || idx >= node->value.list.count) {
-                free_parsed_segments(segs, seg_count);
                 set_err(err, err_sz, "index out of bounds");
-                return EDIT_ERR_INDEX_BOUNDS;
+                st = EDIT_ERR_INDEX_BOUNDS;
+                goto done;
             }
             node = node->value.list.items[idx];
             if (!node) {
-                free_parsed_segments(segs, seg_count);
                 set_err(err, err_sz, "path not found");
-                return EDIT_ERR_PATH_NOT_FOUND;
+                st = EDIT_ERR_PATH_NOT_FOUND;
+                goto done;
             }
         }
 
@@ -738,19 +739,22 @@ EditStatus resolve_set_parent_and_key(NBTTag* root, const char* path, NBTTag** o
     }
 
     if (!current || current->type != TAG_Compound) {
-        free_parsed_segments(segs, seg_count);
         set_err(err, err_sz, "type mismatch: parent path is not a compound");
-        return EDIT_ERR_TYPE_MISMATCH;
+        st = EDIT_ERR_TYPE_MISMATCH;
+        goto done;
     }
 
     *out_parent = current;
-    *out_key = nbt_strdup(segs[seg_count - 1].key ? segs[seg_count - 1].key : "");
+    *out_key = nbt_strdup(segs[seg_count - 1].key);
     if (!*out_key) {
-        free_parsed_segments(segs, seg_count);
+        *out_parent = NULL;
         set_err(err, err_sz, "out of memory");
-        return EDIT_ERR_MEMORY;
+        st = EDIT_ERR_MEMORY;
+        goto done;
     }
+    st = EDIT_OK;
 
-    free_parsed_segments(segs, seg_count);
-    return EDIT_OK;
+done:
+    edit_path_program_free(program);
+    return st;
 }
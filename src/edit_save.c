@@ -542,293 +542,213 @@ static void set_err(char* err, size_t err_sz, const char* msg) {
     }
 }
 
-static NBTTag* find_child_by_name(NBTTag* compound, const char* name, int* out_index) {
-    if (!compound || compound->type != TAG_Compound || !name) return NULL;
-
-    for (int i = 0; i < compound->value.compound.count; i++) {
-        NBTTag* child = compound->value.compound.items[i];
-        if (child && child->name && strcmp(child->name, name) == 0) {
-            if (out_index) *out_index = i;
-            return child;
-        }
-    }
-
-    return NULL;
-}
+static EditStatus edit_single_target(const PathTarget* target, EditPreparedValue* value, char* err, size_t err_sz) {
+    switch (target->kind) {
+        case PATH_TARGET_TAG:
+            return edit_value_apply_to_tag(value, target->tag, err, err_sz);
 
-static int append_compound_child(NBTTag* compound, NBTTag* child) {
-    int new_count;
-    NBTTag** new_items;
+        case PATH_TARGET_LIST_ELEMENT:
+            return edit_value_apply_to_list_element(value, target->tag, target->index, err, err_sz);
 
-    if (!compound || compound->type != TAG_Compound || !child) return 0;
+        case PATH_TARGET_BYTE_ARRAY_ELEMENT:
+        case PATH_TARGET_INT_ARRAY_ELEMENT:
+        case PATH_TARGET_LONG_ARRAY_ELEMENT:
+            return edit_value_apply_to_array_element(value, target->tag, target->index, err, err_sz);
 
-    new_count = compound->value.compound.count + 1;
-    new_items = realloc(compound->value.compound.items, (size_t)new_count * sizeof(NBTTag*));
-    if (!new_items) return 0;
+        default:
+            set_err(err, err_sz, "unsupported path target kind");
+            return EDIT_ERR_UNSUPPORTED;
+    }
+}
 
-    compound->value.compound.items = new_items;
-    compound->value.compound.items[new_count - 1] = child;
-    compound->value.compound.count = new_count;
-    return 1;
+/* The tag whose storage loses an element when target is deleted. */
+static NBTTag* delete_container(const PathTarget* target) {
+    return target->kind == PATH_TARGET_TAG ? target->parent : target->tag;
 }
 
-static void remove_compound_child_at(NBTTag* compound, int index) {
-    int count;
-    NBTTag** new_items;
+static int compare_delete_targets(const void* a, const void* b) {
+    const PathTarget* ta = (const PathTarget*)a;
+    const PathTarget* tb = (const PathTarget*)b;
+    uintptr_t ca = (uintptr_t)delete_container(ta);
+    uintptr_t cb = (uintptr_t)delete_container(tb);
 
-    if (!compound || compound->type != TAG_Compound) return;
+    if (ca < cb) return -1;
+    if (ca > cb) return 1;
+    if (ta->index < tb->index) return -1;
+    if (ta->index > tb->index) return 1;
+    return 0;
+}
 
-    count = compound->value.compound.count;
-    if (index < 0 || index >= count) return;
+static EditStatus check_delete_target(const PathTarget* target, NBTTag* root, char* err, size_t err_sz) {
+    NBTTag* container = delete_container(target);
+    int length;
 
-    free_nbt_tree(compound->value.compound.items[index]);
-    if (index < count - 1) {
-        memmove(
-            &compound->value.compound.items[index],
-            &compound->value.compound.items[index + 1],
-            (size_t)(count - index - 1) * sizeof(NBTTag*)
-        );
+    if (target->kind == PATH_TARGET_TAG && (target->tag == root || !target->parent)) {
+        set_err(err, err_sz, "unsupported operation: cannot delete root tag");
+        return EDIT_ERR_UNSUPPORTED;
     }
 
-    count--;
-    compound->value.compound.count = count;
+    switch (container ? container->type : TAG_End) {
+        case TAG_Compound:
+            if (target->kind != PATH_TARGET_TAG) break;
+            if (target->index < 0 || target->index >= container->value.compound.count) {
+                set_err(err, err_sz, "path not found");
+                return EDIT_ERR_PATH_NOT_FOUND;
+            }
+            return EDIT_OK;
 
-    if (count == 0) {
-        free(compound->value.compound.items);
-        compound->value.compound.items = NULL;
-        return;
-    }
+        case TAG_List:
+            if (target->kind != PATH_TARGET_TAG && target->kind != PATH_TARGET_LIST_ELEMENT) break;
+            length = container->value.list.count;
+            goto check_bounds;
 
-    new_items = realloc(compound->value.compound.items, (size_t)count * sizeof(NBTTag*));
-    if (new_items) {
-        compound->value.compound.items = new_items;
-    }
-}
+        case TAG_Byte_Array:
+            if (target->kind != PATH_TARGET_BYTE_ARRAY_ELEMENT) break;
+            length = container->value.byte_array.length;
+            goto check_bounds;
 
-static EditStatus delete_list_element(NBTTag* list_tag, int index, char* err, size_t err_sz) {
-    int new_count;
-    NBTTag** new_items;
+        case TAG_Int_Array:
+            if (target->kind != PATH_TARGET_INT_ARRAY_ELEMENT) break;
+            length = container->value.int_array.length;
+            goto check_bounds;
 
-    if (!list_tag || list_tag->type != TAG_List) {
-        set_err(err, err_sz, "type mismatch: target is not a list");
-        return EDIT_ERR_TYPE_MISMATCH;
-    }
-
-    if (index < 0 || index >= list_tag->value.list.count) {
-        set_err(err, err_sz, "index out of bounds");
-        return EDIT_ERR_INDEX_BOUNDS;
-    }
+        case TAG_Long_Array:
+            if (target->kind != PATH_TARGET_LONG_ARRAY_ELEMENT) break;
+            length = container->value.long_array.length;
+            goto check_bounds;
 
-    free_nbt_tree(list_tag->value.list.items[index]);
-    if (index < list_tag->value.list.count - 1) {
-        memmove(
-            &list_tag->value.list.items[index],
-            &list_tag->value.list.items[index + 1],
-            (size_t)(list_tag->value.list.count - index - 1) * sizeof(NBTTag*)
-        );
+        default:
+            break;
     }
 
-    new_count = list_tag->value.list.count - 1;
-    list_tag->value.list.count = new_count;
-
-    if (new_count == 0) {
-        free(list_tag->value.list.items);
-        list_tag->value.list.items = NULL;
-        return EDIT_OK;
-    }
+    set_err(err, err_sz, "unsupported operation");
+    return EDIT_ERR_UNSUPPORTED;
 
-    new_items = realloc(list_tag->value.list.items, (size_t)new_count * sizeof(NBTTag*));
-    if (new_items) {
-        list_tag->value.list.items = new_items;
+check_bounds:
+    if (target->index < 0 || target->index >= length) {
+        set_err(err, err_sz, "index out of bounds");
+        return EDIT_ERR_INDEX_BOUNDS;
     }
-
     return EDIT_OK;
 }
 
-static EditStatus delete_array_element(NBTTag* array_tag, int index, char* err, size_t err_sz) {
-    if (!array_tag) {
-        set_err(err, err_sz, "invalid array target");
-        return EDIT_ERR_TYPE_MISMATCH;
+/*
+ * Removes the ascending, distinct positions in removed from an array of
+ * count elements, moving every surviving run exactly once. Returns the new
+ * element count.
+ */
+static int compact_elements(void* data, int count, size_t elem_size, const int* removed, size_t removed_count) {
+    unsigned char* bytes = data;
+    int write = removed[0];
+
+    for (size_t r = 0; r < removed_count; r++) {
+        int run_start = removed[r] + 1;
+        int run_end = (r + 1 < removed_count) ? removed[r + 1] : count;
+        if (run_end > run_start) {
+            memmove(
+                bytes + (size_t)write * elem_size,
+                bytes + (size_t)run_start * elem_size,
+                (size_t)(run_end - run_start) * elem_size
+            );
+            write += run_end - run_start;
+        }
     }
+    return write;
+}
 
-    switch (array_tag->type) {
-        case TAG_Byte_Array: {
-            int len = array_tag->value.byte_array.length;
-            uint8_t* new_data;
+/* One resize after compaction; a failed shrink keeps the larger block. */
+static void* shrink_elements(void* data, int count, size_t elem_size) {
+    void* resized;
 
-            if (index < 0 || index >= len) {
-                set_err(err, err_sz, "index out of bounds");
-                return EDIT_ERR_INDEX_BOUNDS;
-            }
+    if (count == 0) {
+        free(data);
+        return NULL;
+    }
+    resized = realloc(data, (size_t)count * elem_size);
+    return resized ? resized : data;
+}
 
-            if (index < len - 1) {
-                memmove(
-                    &array_tag->value.byte_array.data[index],
-                    &array_tag->value.byte_array.data[index + 1],
-                    (size_t)(len - index - 1)
-                );
-            }
-            len--;
-            array_tag->value.byte_array.length = len;
+static void delete_from_container(NBTTag* container, const int* removed, size_t removed_count) {
+    switch (container->type) {
+        case TAG_Compound: {
+            Compound* compound = &container->value.compound;
+            for (size_t i = 0; i < removed_count; i++) free_nbt_tree(compound->items[removed[i]]);
+            compound->count = compact_elements(compound->items, compound->count, sizeof(NBTTag*), removed, removed_count);
+            compound->items = shrink_elements(compound->items, compound->count, sizeof(NBTTag*));
+            nbt_compound_invalidate_index(container);
+            break;
+        }
 
-            if (len == 0) {
-                free(array_tag->value.byte_array.data);
-                array_tag->value.byte_array.data = NULL;
-                return EDIT_OK;
-            }
+        case TAG_List: {
+            List* list = &container->value.list;
+            for (size_t i = 0; i < removed_count; i++) free_nbt_tree(list->items[removed[i]]);
+            list->count = compact_elements(list->items, list->count, sizeof(NBTTag*), removed, removed_count);
+            list->items = shrink_elements(list->items, list->count, sizeof(NBTTag*));
+            break;
+        }
 
-            new_data = realloc(array_tag->value.byte_array.data, (size_t)len);
-            if (new_data) array_tag->value.byte_array.data = new_data;
-            return EDIT_OK;
+        case TAG_Byte_Array: {
+            ByteArray* array = &container->value.byte_array;
+            array->length = compact_elements(array->data, array->length, sizeof(uint8_t), removed, removed_count);
+            array->data = shrink_elements(array->data, array->length, sizeof(uint8_t));
+            break;
         }
 
         case TAG_Int_Array: {
-            int len = array_tag->value.int_array.length;
-            int32_t* new_data;
-
-            if (index < 0 || index >= len) {
-                set_err(err, err_sz, "index out of bounds");
-                return EDIT_ERR_INDEX_BOUNDS;
-            }
-
-            if (index < len - 1) {
-                memmove(
-                    &array_tag->value.int_array.data[index],
-                    &array_tag->value.int_array.data[index + 1],
-                    (size_t)(len - index - 1) * sizeof(int32_t)
-                );
-            }
-            len--;
-            array_tag->value.int_array.length = len;
-
-            if (len == 0) {
-                free(array_tag->value.int_array.data);
-                array_tag->value.int_array.data = NULL;
-                return EDIT_OK;
-            }
-
-            new_data = realloc(array_tag->value.int_array.data, (size_t)len * sizeof(int32_t));
-            if (new_data) array_tag->value.int_array.data = new_data;
-            return EDIT_OK;
+            IntArray* array = &container->value.int_array;
+            array->length = compact_elements(array->data, array->length, sizeof(int32_t), removed, removed_count);
+            array->data = shrink_elements(array->data, array->length, sizeof(int32_t));
+            break;
         }
 
         case TAG_Long_Array: {
-            int len = array_tag->value.long_array.length;
-            int64_t* new_data;
-
-            if (index < 0 || index >= len) {
-                set_err(err, err_sz, "index out of bounds");
-                return EDIT_ERR_INDEX_BOUNDS;
-            }
-
-            if (index < len - 1) {
-                memmove(
-                    &array_tag->value.long_array.data[index],
-                    &array_tag->value.long_array.data[index + 1],
-                    (size_t)(len - index - 1) * sizeof(int64_t)
-                );
-            }
-            len--;
-            array_tag->value.long_array.length = len;
-
-            if (len == 0) {
-                free(array_tag->value.long_array.data);
-                array_tag->value.long_array.data = NULL;
-                return EDIT_OK;
-            }
-
-            new_data = realloc(array_tag->value.long_array.data, (size_t)len * sizeof(int64_t));
-            if (new_data) array_tag->value.long_array.data = new_data;
-            return EDIT_OK;
+            LongArray* array = &container->value.long_array;
+            array->length = compact_elements(array->data, array->length, sizeof(int64_t), removed, removed_count);
+            array->data = shrink_elements(array->data, array->length, sizeof(int64_t));
+            break;
         }
 
         default:
-            set_err(err, err_sz, "type mismatch: target is not an editable array");
-            return EDIT_ERR_TYPE_MISMATCH;
+            break;
     }
 }
 
-static EditStatus edit_single_target(const PathTarget* target, const char* value_expr, char* err, size_t err_sz) {
-    switch (target->kind) {
-        case PATH_TARGET_TAG:
-            if (target->tag->type == TAG_Compound) {
-                return apply_json_patch_to_compound(target->tag, value_expr, err, err_sz);
-            }
-            return parse_json_for_tag_type(target->tag, value_expr, err, err_sz);
-
-        case PATH_TARGET_LIST_ELEMENT:
-            return parse_json_for_list_element(target->tag, target->index, value_expr, err, err_sz);
+/*
+ * Deletes every target with one compaction pass per container. All targets
+ * are validated first, so a failing path leaves the tree untouched.
+ */
+static EditStatus delete_targets(PathTarget* targets, size_t count, NBTTag* root, char* err, size_t err_sz) {
+    int* removed;
+    size_t group_start = 0;
 
-        case PATH_TARGET_BYTE_ARRAY_ELEMENT:
-        case PATH_TARGET_INT_ARRAY_ELEMENT:
-        case PATH_TARGET_LONG_ARRAY_ELEMENT:
-            return parse_json_for_array_element(target->tag, target->index, value_expr, err, err_sz);
-
-        default:
-            set_err(err, err_sz, "unsupported path target kind");
-            return EDIT_ERR_UNSUPPORTED;
+    for (size_t i = 0; i < count; i++) {
+        EditStatus st = check_delete_target(&targets[i], root, err, err_sz);
+        if (st != EDIT_OK) return st;
     }
-}
-
-static uintptr_t delete_container_key(const PathTarget* t) {
-    if (!t) return 0;
-    if (t->kind == PATH_TARGET_TAG) return (uintptr_t)t->parent;
-    return (uintptr_t)t->tag;
-}
-
-static int compare_delete_targets(const void* a, const void* b) {
-    const PathTarget* ta = (const PathTarget*)a;
-    const PathTarget* tb = (const PathTarget*)b;
-    uintptr_t ca = delete_container_key(ta);
-    uintptr_t cb = delete_container_key(tb);
-
-    if (ca < cb) return -1;
-    if (ca > cb) return 1;
-
-    if ((int)ta->kind < (int)tb->kind) return -1;
-    if ((int)ta->kind > (int)tb->kind) return 1;
-
-    if (ta->index > tb->index) return -1;
-    if (ta->index < tb->index) return 1;
-    return 0;
-}
 
-static EditStatus delete_single_target(const PathTarget* target, NBTTag* root, char* err, size_t err_sz) {
-    switch (target->kind) {
-        case PATH_TARGET_LIST_ELEMENT:
-            return delete_list_element(target->tag, target->index, err, err_sz);
-
-        case PATH_TARGET_BYTE_ARRAY_ELEMENT:
-        case PATH_TARGET_INT_ARRAY_ELEMENT:
-        case PATH_TARGET_LONG_ARRAY_ELEMENT:
-            return delete_array_element(target->tag, target->index, err, err_sz);
-
-        case PATH_TARGET_TAG:
-            if (target->tag == root || !target->parent) {
-                set_err(err, err_sz, "unsupported operation: cannot delete root tag");
-                return EDIT_ERR_UNSUPPORTED;
-            }
+    removed = malloc(count * sizeof(*removed));
+    if (!removed) {
+        set_err(err, err_sz, "out of memory");
+        return EDIT_ERR_MEMORY;
+    }
 
-            if (target->parent->type == TAG_Compound) {
-                if (target->index < 0 || target->index >= target->parent->value.compound.count) {
-                    set_err(err, err_sz, "path not found");
-                    return EDIT_ERR_PATH_NOT_FOUND;
-                }
-                remove_compound_child_at(target->parent, target->index);
-                return EDIT_OK;
-            }
+    qsort(targets, count, sizeof(PathTarget), compare_delete_targets);
+    while (group_start < count) {
+        NBTTag* container = delete_container(&targets[group_start]);
+        size_t removed_count = 0;
+        size_t i = group_start;
 
-            if (target->parent->type == TAG_List) {
-                return delete_list_element(target->parent, target->index, err, err_sz);
+        for (; i < count && delete_container(&targets[i]) == container; i++) {
+            if (removed_count == 0 || removed[removed_count - 1] != targets[i].index) {
+                removed[removed_count++] = targets[i].index;
             }
-
-            set_err(err, err_sz, "unsupported operation");
-            return EDIT_ERR_UNSUPPORTED;
-
-        default:
-            set_err(err, err_sz, "unsupported operation");
-            return EDIT_ERR_UNSUPPORTED;
+        }
+        delete_from_container(container, removed, removed_count);
+        group_start = i;
     }
+
+    free(removed);
+    return EDIT_OK;
 }
 
 NBTTag* find_tag_by_path(NBTTag* root, const char* path) {
@@ -852,16 +772,16 @@ NBTTag* find_tag_by_path(NBTTag* root, const char* path) {
     return NULL;
 }
 
-EditStatus edit_tag_by_path(NBTTag* root, const char* path, const char* value_expr, char* err, size_t err_sz) {
+EditStatus edit_tag_by_program(NBTTag* root, const EditPathProgram* program, EditPreparedValue* value, char* err, size_t err_sz) {
     PathTarget* targets = NULL;
     size_t count = 0;
     EditStatus st;
 
-    st = resolve_edit_paths(root, path, &targets, &count, err, err_sz);
+    st = edit_path_execute(program, root, &targets, &count, err, err_sz);
     if (st != EDIT_OK) return st;
 
     for (size_t i = 0; i < count; i++) {
-        st = edit_single_target(&targets[i], value_expr, err, err_sz);
+        st = edit_single_target(&targets[i], value, err, err_sz);
         if (st != EDIT_OK) {
             free_edit_paths(targets);
             return st;
@@ -872,12 +792,32 @@ EditStatus edit_tag_by_path(NBTTag* root, const char* path, const char* value_ex
     return EDIT_OK;
 }
 
+EditStatus edit_tag_by_path(NBTTag* root, const char* path, const char* value_expr, char* err, size_t err_sz) {
+    EditPathProgram* program = NULL;
+    EditPreparedValue* value = NULL;
+    EditStatus st;
+
+    if (!root || !path) {
+        set_err(err, err_sz, "invalid argument");
+        return EDIT_ERR_PATH_SYNTAX;
+    }
+
+    st = edit_path_compile(path, &program, err, err_sz);
+    if (st != EDIT_OK) return st;
+    st = edit_value_prepare(value_expr, &value, err, err_sz);
+    if (st == EDIT_OK) st = edit_tag_by_program(root, program, value, err, err_sz);
+    edit_value_free(value);
+    edit_path_program_free(program);
+    return st;
+}
+
 EditStatus set_tag_by_path(NBTTag* root, const char* path, const char* value_expr, char* err, size_t err_sz) {
     EditStatus st;
     char* key = NULL;
     NBTTag* parent = NULL;
     NBTTag* existing = NULL;
     NBTTag* new_tag = NULL;
+    int existing_index;
 
     st = edit_tag_by_path(root, path, value_expr, err, err_sz);
     if (st == EDIT_OK) return EDIT_OK;
@@ -886,8 +826,9 @@ EditStatus set_tag_by_path(NBTTag* root, const char* path, const char* value_exp
     st = resolve_set_parent_and_key(root, path, &parent, &key, err, err_sz);
     if (st != EDIT_OK) goto done;
 
-    existing = find_child_by_name(parent, key, NULL);
-    if (existing) {
+    existing_index = nbt_compound_find_index(parent, key);
+    if (existing_index >= 0) {
+        existing = parent->value.compound.items[existing_index];
         st = parse_json_for_tag_type(existing, value_expr, err, err_sz);
         goto done;
     }
@@ -895,7 +836,7 @@ EditStatus set_tag_by_path(NBTTag* root, const char* path, const char* value_exp
     st = create_tag_from_json_expr(key, value_expr, &new_tag, err, err_sz);
     if (st != EDIT_OK) goto done;
 
-    if (!append_compound_child(parent, new_tag)) {
+    if (!nbt_compound_append(parent, new_tag)) {
         free_nbt_tree(new_tag);
         set_err(err, err_sz, "out of memory");
         st = EDIT_ERR_MEMORY;
@@ -909,30 +850,38 @@ done:
     return st;
 }
 
-EditStatus delete_tag_by_path(NBTTag* root, const char* path, char* err, size_t err_sz) {
+EditStatus delete_tag_by_program(NBTTag* root, const EditPathProgram* program, char* err, size_t err_sz) {
     PathTarget* targets = NULL;
     size_t count = 0;
     EditStatus st;
 
-    if (!root || !path) {
+    if (!root || !program) {
         set_err(err, err_sz, "invalid delete arguments");
         return EDIT_ERR_PATH_SYNTAX;
     }
 
-    st = resolve_edit_paths(root, path, &targets, &count, err, err_sz);
+    st = edit_path_execute(program, root, &targets, &count, err, err_sz);
     if (st != EDIT_OK) return st;
 
-    qsort(targets, count, sizeof(PathTarget), compare_delete_targets);
-    for (size_t i = 0; i < count; i++) {
-        st = delete_single_target(&targets[i], root, err, err_sz);
-        if (st != EDIT_OK) {
-            free_edit_paths(targets);
-            return st;
-        }
+    st = delete_targets(targets, count, root, err, err_sz);
+    free_edit_paths(targets);
+    return st;
+}
+
+EditStatus delete_tag_by_path(NBTTag* root, const char* path, char* err, size_t err_sz) {
+    EditPathProgram* program = NULL;
+    EditStatus st;
+
+    if (!root || !path) {
+        set_err(err, err_sz, "invalid delete arguments");
+        return EDIT_ERR_PATH_SYNTAX;
     }
 
-    free_edit_paths(targets);
-    return EDIT_OK;
+    st = edit_path_compile(path, &program, err, err_sz);
+    if (st != EDIT_OK) return st;
+    st = delete_tag_by_program(root, program, err, err_sz);
+    edit_path_program_free(program);
+    return st;
 }
 
 EditStatus rename_tag_by_path(
@@ -980,7 +929,7 @@ EditStatus rename_tag_by_path(
         return EDIT_ERR_TYPE_MISMATCH;
     }
 
-    if (!nbt_tag_rename(target->tag, new_name)) {
+    if (!nbt_compound_rename_child(target->parent, target->tag, new_name)) {
         free_edit_paths(targets);
         set_err(err, err_sz, "out of memory");
         return EDIT_ERR_MEMORY;
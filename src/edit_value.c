@@ -10,6 +10,7 @@
 #include "edit_value.h"
 #include "jsmn.h"
 #include "nbt_builder.h"
+#include "nbt_tree.h"
 #include "platform.h"
 
 typedef struct {
@@ -841,6 +842,7 @@ static int append_compound_item(NBTTag* compound, NBTTag* child) {
     compound->value.compound.items = new_items;
     compound->value.compound.items[new_count - 1] = child;
     compound->value.compound.count = new_count;
+    nbt_compound_invalidate_index(compound);
     return 1;
 }
 
@@ -1153,9 +1155,195 @@ EditStatus apply_json_patch_to_compound(NBTTag* compound, const char* json_objec
     return st;
 }
 
+/* The single-use entry points prepare the value once and share the prepared path. */
 EditStatus parse_json_for_list_element(NBTTag* list_tag, int index, const char* value_expr, char* err, size_t err_sz) {
+    EditPreparedValue* value = NULL;
+    EditStatus st = edit_value_prepare(value_expr, &value, err, err_sz);
+    if (st != EDIT_OK) return st;
+    st = edit_value_apply_to_list_element(value, list_tag, index, err, err_sz);
+    edit_value_free(value);
+    return st;
+}
+
+EditStatus parse_json_for_array_element(NBTTag* array_tag, int index, const char* value_expr, char* err, size_t err_sz) {
+    EditPreparedValue* value = NULL;
+    EditStatus st = edit_value_prepare(value_expr, &value, err, err_sz);
+    if (st != EDIT_OK) return st;
+    st = edit_value_apply_to_array_element(value, array_tag, index, err, err_sz);
+    edit_value_free(value);
+    return st;
+}
+
+EditStatus create_tag_from_json_expr(const char* tag_name, const char* value_expr, NBTTag** out_tag, char* err, size_t err_sz) {
+    JsonDoc doc;
     EditStatus st;
+
+    if (!tag_name || !value_expr || !out_tag) {
+        set_err(err, err_sz, "invalid create tag arguments");
+        return EDIT_ERR_PATH_SYNTAX;
+    }
+
+    *out_tag = NULL;
+
+    st = parse_json_doc(value_expr, &doc, err, err_sz);
+    if (st != EDIT_OK) return st;
+
+    st = create_tag_from_token(tag_name, &doc, 0, out_tag, err, err_sz);
+    free_json_doc(&doc);
+    return st;
+}
+
+struct EditPreparedValue {
+    char* text;
     JsonDoc doc;
+    int json_ok;
+    EditStatus parse_status;
+    char parse_err[256];
+    /* Decoded values keyed by target type, and by element type for lists.
+     * Built on first use and never modified afterwards. */
+    NBTTag* templates[TAG_Long_Array + 1];
+    NBTTag* list_templates[TAG_Long_Array + 1];
+};
+
+EditStatus edit_value_prepare(const char* value_expr, EditPreparedValue** out_value, char* err, size_t err_sz) {
+    EditPreparedValue* value;
+
+    if (!value_expr || !out_value) {
+        set_err(err, err_sz, "invalid edit arguments");
+        return EDIT_ERR_PATH_SYNTAX;
+    }
+    *out_value = NULL;
+
+    value = calloc(1, sizeof(*value));
+    if (!value) {
+        set_err(err, err_sz, "out of memory");
+        return EDIT_ERR_MEMORY;
+    }
+    value->text = nbt_strdup(value_expr);
+    if (!value->text) {
+        free(value);
+        set_err(err, err_sz, "out of memory");
+        return EDIT_ERR_MEMORY;
+    }
+
+    /* A non-JSON expression is not an error yet: numeric targets still
+     * accept the legacy scalar syntax, so the failure is kept for later. */
+    value->parse_status = parse_json_doc(value->text, &value->doc, value->parse_err, sizeof(value->parse_err));
+    value->json_ok = value->parse_status == EDIT_OK;
+
+    *out_value = value;
+    return EDIT_OK;
+}
+
+void edit_value_free(EditPreparedValue* value) {
+    if (!value) return;
+    for (int i = 0; i <= TAG_Long_Array; i++) {
+        free_nbt_tree(value->templates[i]);
+        free_nbt_tree(value->list_templates[i]);
+    }
+    if (value->json_ok) free_json_doc(&value->doc);
+    free(value->text);
+    free(value);
+}
+
+static EditStatus prepared_template(
+    EditPreparedValue* value,
+    TagType type,
+    TagType element_type,
+    const NBTTag** out_template,
+    char* err,
+    size_t err_sz
+) {
+    NBTTag** slot;
+    NBTTag* tmpl;
+    EditStatus st;
+
+    if (type <= TAG_End || type > TAG_Long_Array || type == TAG_Compound ||
+        element_type < TAG_End || element_type > TAG_Long_Array) {
+        set_err(err, err_sz, "editing not supported for this tag type");
+        return EDIT_ERR_UNSUPPORTED;
+    }
+
+    slot = type == TAG_List ? &value->list_templates[element_type] : &value->templates[type];
+    if (*slot) {
+        *out_template = *slot;
+        return EDIT_OK;
+    }
+
+    tmpl = create_named_tag(type, "");
+    if (!tmpl) {
+        set_err(err, err_sz, "out of memory");
+        return EDIT_ERR_MEMORY;
+    }
+    if (type == TAG_List) tmpl->value.list.element_type = element_type;
+
+    if (value->json_ok) {
+        st = parse_token_into_tag(tmpl, &value->doc, 0, err, err_sz);
+    } else if (is_numeric_scalar_type(type)) {
+        st = apply_legacy_scalar_edit(tmpl, value->text, err, err_sz);
+    } else {
+        set_err(err, err_sz, value->parse_err);
+        st = value->parse_status;
+    }
+    if (st != EDIT_OK) {
+        free_nbt_tree(tmpl);
+        return st;
+    }
+
+    *slot = tmpl;
+    *out_template = tmpl;
+    return EDIT_OK;
+}
+
+/* Copies the template's value into target, whose type the caller matched. */
+static EditStatus stamp_template(NBTTag* target, const NBTTag* tmpl, char* err, size_t err_sz) {
+    NBTTag* copy;
+    TagValue old_value;
+
+    if (is_numeric_scalar_type(tmpl->type)) {
+        target->value = tmpl->value;
+        return EDIT_OK;
+    }
+
+    copy = nbt_tag_clone(tmpl);
+    if (!copy) {
+        set_err(err, err_sz, "out of memory");
+        return EDIT_ERR_MEMORY;
+    }
+    /* Hand the old payload to the clone so free_nbt_tree releases it. */
+    old_value = target->value;
+    target->value = copy->value;
+    copy->value = old_value;
+    free_nbt_tree(copy);
+    return EDIT_OK;
+}
+
+EditStatus edit_value_apply_to_tag(EditPreparedValue* value, NBTTag* target, char* err, size_t err_sz) {
+    const NBTTag* tmpl = NULL;
+    EditStatus st;
+
+    if (!value || !target) {
+        set_err(err, err_sz, "invalid edit arguments");
+        return EDIT_ERR_PATH_SYNTAX;
+    }
+
+    if (target->type == TAG_Compound) {
+        if (!value->json_ok) {
+            set_err(err, err_sz, value->parse_err);
+            return value->parse_status;
+        }
+        return apply_object_patch_token(target, &value->doc, 0, err, err_sz);
+    }
+
+    st = prepared_template(
+        value, target->type,
+        target->type == TAG_List ? target->value.list.element_type : TAG_End,
+        &tmpl, err, err_sz);
+    if (st != EDIT_OK) return st;
+    return stamp_template(target, tmpl, err, err_sz);
+}
+
+EditStatus edit_value_apply_to_list_element(EditPreparedValue* value, NBTTag* list_tag, int index, char* err, size_t err_sz) {
     NBTTag* item;
 
     if (!list_tag || list_tag->type != TAG_List) {
@@ -1184,40 +1372,27 @@ EditStatus parse_json_for_list_element(NBTTag* list_tag, int index, const char*
         list_tag->value.list.items[index] = item;
     }
 
-    st = parse_json_doc(value_expr, &doc, err, err_sz);
-    if (st != EDIT_OK) {
-        if (is_numeric_scalar_type(item->type)) {
-            return apply_legacy_scalar_edit(item, value_expr, err, err_sz);
-        }
-        return st;
-    }
-
-    st = parse_token_into_tag(item, &doc, 0, err, err_sz);
-    free_json_doc(&doc);
-    return st;
+    return edit_value_apply_to_tag(value, item, err, err_sz);
 }
 
-EditStatus parse_json_for_array_element(NBTTag* array_tag, int index, const char* value_expr, char* err, size_t err_sz) {
-    NBTTag temp;
+EditStatus edit_value_apply_to_array_element(EditPreparedValue* value, NBTTag* array_tag, int index, char* err, size_t err_sz) {
+    const NBTTag* tmpl = NULL;
     EditStatus st;
 
-    if (!array_tag) {
+    if (!value || !array_tag) {
         set_err(err, err_sz, "invalid array target");
         return EDIT_ERR_TYPE_MISMATCH;
     }
 
-    memset(&temp, 0, sizeof(temp));
-
     switch (array_tag->type) {
         case TAG_Byte_Array:
             if (index < 0 || index >= array_tag->value.byte_array.length) {
                 set_err(err, err_sz, "index out of bounds");
                 return EDIT_ERR_INDEX_BOUNDS;
             }
-            temp.type = TAG_Byte;
-            st = parse_json_for_tag_type(&temp, value_expr, err, err_sz);
+            st = prepared_template(value, TAG_Byte, TAG_End, &tmpl, err, err_sz);
             if (st != EDIT_OK) return st;
-            array_tag->value.byte_array.data[index] = (uint8_t)temp.value.byte_val;
+            array_tag->value.byte_array.data[index] = (uint8_t)tmpl->value.byte_val;
             return EDIT_OK;
 
         case TAG_Int_Array:
@@ -1225,10 +1400,9 @@ EditStatus parse_json_for_array_element(NBTTag* array_tag, int index, const char
                 set_err(err, err_sz, "index out of bounds");
                 return EDIT_ERR_INDEX_BOUNDS;
             }
-            temp.type = TAG_Int;
-            st = parse_json_for_tag_type(&temp, value_expr, err, err_sz);
+            st = prepared_template(value, TAG_Int, TAG_End, &tmpl, err, err_sz);
             if (st != EDIT_OK) return st;
-            array_tag->value.int_array.data[index] = temp.value.int_val;
+            array_tag->value.int_array.data[index] = tmpl->value.int_val;
             return EDIT_OK;
 
         case TAG_Long_Array:
@@ -1236,10 +1410,9 @@ EditStatus parse_json_for_array_element(NBTTag* array_tag, int index, const char
                 set_err(err, err_sz, "index out of bounds");
                 return EDIT_ERR_INDEX_BOUNDS;
             }
-            temp.type = TAG_Long;
-            st = parse_json_for_tag_type(&temp, value_expr, err, err_sz);
+            st = prepared_template(value, TAG_Long, TAG_End, &tmpl, err, err_sz);
             if (st != EDIT_OK) return st;
-            array_tag->value.long_array.data[index] = temp.value.long_val;
+            array_tag->value.long_array.data[index] = tmpl->value.long_val;
             return EDIT_OK;
 
         default:
@@ -1247,22 +1420,3 @@ EditStatus parse_json_for_array_element(NBTTag* array_tag, int index, const char
             return EDIT_ERR_TYPE_MISMATCH;
     }
 }
-
-EditStatus create_tag_from_json_expr(const char* tag_name, const char* value_expr, NBTTag** out_tag, char* err, size_t err_sz) {
-    JsonDoc doc;
-    EditStatus st;
-
-    if (!tag_name || !value_expr || !out_tag) {
-        set_err(err, err_sz, "invalid create tag arguments");
-        return EDIT_ERR_PATH_SYNTAX;
-    }
-
-    *out_tag = NULL;
-
-    st = parse_json_doc(value_expr, &doc, err, err_sz);
-    if (st != EDIT_OK) return st;
-
-    st = create_tag_from_token(tag_name, &doc, 0, out_tag, err, err_sz);
-    free_json_doc(&doc);
-    return st;
-}
@@ -3,7 +3,6 @@
 #include <stdint.h>
 #include <string.h>
 #include <limits.h>
-#include <errno.h>
 #include <zlib.h>
 #include "nbt_io.h"
 #include "platform.h"
@@ -17,69 +16,6 @@ static void set_err(char* err, size_t err_sz, const char* msg) {
     }
 }
 
-static unsigned char* read_file_bytes(const char* filename, size_t* out_size, char* err, size_t err_sz) {
-    FILE* file = nbt_fopen(filename, "rb");
-    unsigned char* buffer = NULL;
-    size_t size = 0;
-    size_t capacity = 0;
-
-    if (out_size) *out_size = 0;
-    if (!file) {
-        if (err && err_sz > 0) {
-            snprintf(err, err_sz, "fopen(%s) failed: %s", filename, strerror(errno));
-        }
-        return NULL;
-    }
-
-    capacity = CHUNK;
-    buffer = malloc(capacity);
-    if (!buffer) {
-        fclose(file);
-        set_err(err, err_sz, "out of memory");
-        return NULL;
-    }
-
-    while (1) {
-        size_t bytes_read;
-
-        if (size > SIZE_MAX - CHUNK) {
-            set_err(err, err_sz, "input too large");
-            free(buffer);
-            fclose(file);
-            return NULL;
-        }
-        if (size + CHUNK > capacity) {
-            size_t new_capacity = size + CHUNK;
-            unsigned char* grown = realloc(buffer, new_capacity);
-            if (!grown) {
-                set_err(err, err_sz, "out of memory");
-                free(buffer);
-                fclose(file);
-                return NULL;
-            }
-            buffer = grown;
-            capacity = new_capacity;
-        }
-
-        bytes_read = fread(buffer + size, 1, CHUNK, file);
-        if (bytes_read == 0) {
-            if (ferror(file)) {
-                set_err(err, err_sz, "failed to read input file");
-                free(buffer);
-                fclose(file);
-                return NULL;
-            }
-            break;
-        }
-
-        size += bytes_read;
-    }
-
-    if (out_size) *out_size = size;
-    fclose(file);
-    return buffer;
-}
-
 static int looks_like_gzip(const unsigned char* data, size_t size) {
     return data && size >= 2 && data[0] == 0x1f && data[1] == 0x8b;
 }
@@ -311,7 +247,7 @@ unsigned char* load_nbt_data(const char* filename, size_t* out_size, const NBTLo
         return NULL;
     }
 
-    input = read_file_bytes(filename, &input_size, err, err_sz);
+    input = nbt_read_file(filename, &input_size, err, err_sz);
     if (!input) {
         return NULL;
     }
@@ -5,6 +5,7 @@
 #include <string.h>
 #include <time.h>
 
+#include "cli_bedrock.h"
 #include "cli_support.h"
 #include "edit_save.h"
 #include "nbt_binary.h"
@@ -12,6 +13,9 @@
 #include "nbt_io.h"
 #include "nbt_json.h"
 #include "nbt_parser.h"
+#include "nbt_find.h"
+#include "nbt_query.h"
+#include "platform.h"
 #include "region_file.h"
 #include "region_read.h"
 #include "region_write.h"
@@ -31,7 +35,16 @@ typedef enum {
     MODE_JSON,
     MODE_SNBT,
     MODE_LIST_CHUNKS,
-    MODE_VALIDATE
+    MODE_LIST_CUBES,
+    MODE_BEDROCK_EXPORT,
+    MODE_BEDROCK_BLOCKS,
+    MODE_BEDROCK_RESTORE,
+    MODE_BEDROCK_STATS,
+    MODE_VERIFY,
+    MODE_VALIDATE,
+    MODE_QUERY,
+    MODE_FIND,
+    MODE_REPLACE
 } CliMode;
 
 typedef enum {
@@ -50,7 +63,17 @@ static void print_usage(const char* program) {
     printf("  %s <file> [--chunk x z] --json output.json\n", program);
     printf("  %s <file> [--chunk x z] --snbt output.snbt\n", program);
     printf("  %s <region.mca|region.mcr> --list-chunks\n", program);
+    printf("  %s <region.mca|region.mcr> --verify[=full]\n", program);
+    printf("  %s <cubic-world-region-dir> --list-cubes\n", program);
+    printf("  %s <bedrock-world|db> --bedrock-export output.jsonl\n", program);
+    printf("  %s <bedrock-world|db> --bedrock-blocks\n", program);
+    printf("  %s <bedrock-world|db> --bedrock-restore backup.cnbtbak\n", program);
+    printf("  %s <bedrock-world|db> --bedrock-stats [--compact-copy new-db-dir]\n", program);
     printf("  %s <file> --validate\n", program);
+    printf("  %s <file|region.mca|world-dir> [--chunk x z] --query expression\n", program);
+    printf("  %s <file|region.mca|world-dir> [--chunk x z] --find [criteria]\n", program);
+    printf("  %s <file|region.mca|world-dir> [--chunk x z] --find [criteria] --replace-value jsonValue [save options]\n", program);
+    printf("  %s <file|region.mca|world-dir> [--chunk x z] --find [criteria] --replace-text text [save options]\n", program);
     printf("  %s <file> [--chunk x z] --edit path jsonValue [save options]\n", program);
     printf("  %s <file> [--chunk x z] --set path jsonValue [save options]\n", program);
     printf("  %s <file> [--chunk x z] --delete path [save options]\n", program);
@@ -59,7 +82,18 @@ static void print_usage(const char* program) {
     printf("  --output path       Write a new file.\n");
     printf("  --in-place         Atomically replace the input.\n");
     printf("  --backup[=suffix]  Back up an in-place edit (default: .bak).\n");
+    printf("  --allow-partial    Rewrite regions even when some of their chunks fail to replace.\n");
+    printf("\nFind criteria (all must hold):\n");
+    printf("  --name glob        Tag name, with * and ?.\n");
+    printf("  --type type        Tag type, e.g. int, string, long_array.\n");
+    printf("  --min n / --max n  Numeric value range.\n");
+    printf("  --regex pattern    String value contains a match.\n");
+    printf("  --ignore-case      Fold case in --name and --regex.\n");
     printf("\nRegion coordinates are local (0..31). Input encoding and compression are preserved.\n");
+    printf("Queries print cnbt-query-v1 JSON, e.g. --query 'Level.Entities[?id==\"minecraft:cow\"]{id, Pos}'.\n");
+    printf("Finds print cnbt-find-v1 JSON; replacing across regions or worlds requires --in-place.\n");
+    printf("Bedrock exports write one typed JSON line per NBT record, in key order.\n");
+    printf("Bedrock replaces write in bulk; --backup saves one .cnbtbak file for --bedrock-restore.\n");
 }
 
 static int parse_int_arg(const char* text, int* output) {
@@ -98,7 +132,19 @@ static int parse_input_mode(const char* text, CliInputMode* mode) {
 }
 
 static int is_mutation(CliMode mode) {
-    return mode == MODE_EDIT || mode == MODE_SET || mode == MODE_DELETE || mode == MODE_RENAME;
+    return mode == MODE_EDIT || mode == MODE_SET || mode == MODE_DELETE || mode == MODE_RENAME ||
+        mode == MODE_REPLACE;
+}
+
+static int parse_double_arg(const char* text, double* output) {
+    char* end = NULL;
+    double value;
+    if (!text || !output) return 0;
+    errno = 0;
+    value = strtod(text, &end);
+    if (errno || end == text || *end) return 0;
+    *output = value;
+    return 1;
 }
 
 int main(int argc, char* argv[]) {
@@ -107,18 +153,26 @@ int main(int argc, char* argv[]) {
     const char* input_path;
     const char* operation_path = NULL;
     const char* operation_value = NULL;
+    const char* query_text = NULL;
     const char* result_path = NULL;
     const char* output_path = NULL;
+    const char* compact_copy_path = NULL;
     const char* backup_suffix = ".bak";
     int operation_seen = 0;
+    int full_verify = 0;
     int in_place = 0;
     int backup_enabled = 0;
+    int allow_partial = 0;
     NBTLoadOptions load_options = {0};
     NBTLoadInfo load_info = {0};
     NBTBinaryInfo binary_info = {0};
     unsigned char* data = NULL;
     size_t data_size = 0;
     NBTTag* root = NULL;
+    NBTQuery* query = NULL;
+    NBTFindOptions find_options = {0};
+    NBTFind* find = NULL;
+    int find_criteria = 0;
     char error[512] = {0};
     clock_t started;
     double elapsed_ms = 0.0;
@@ -139,6 +193,7 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     input_path = argv[1];
+    find_options.type = -1;
 
 #define CHOOSE_MODE(value) \
     do { \
@@ -166,13 +221,71 @@ int main(int argc, char* argv[]) {
             result_path = argv[++index];
         } else if (!strcmp(argument, "--list-chunks")) {
             CHOOSE_MODE(MODE_LIST_CHUNKS);
+        } else if (!strcmp(argument, "--list-cubes")) {
+            CHOOSE_MODE(MODE_LIST_CUBES);
+        } else if (!strcmp(argument, "--bedrock-export")) {
+            if (index + 1 >= argc) { print_usage(argv[0]); return 1; }
+            CHOOSE_MODE(MODE_BEDROCK_EXPORT);
+            result_path = argv[++index];
+        } else if (!strcmp(argument, "--bedrock-blocks")) {
+            CHOOSE_MODE(MODE_BEDROCK_BLOCKS);
+        } else if (!strcmp(argument, "--bedrock-stats")) {
+            CHOOSE_MODE(MODE_BEDROCK_STATS);
+        } else if (!strcmp(argument, "--compact-copy")) {
+            if (index + 1 >= argc) { print_usage(argv[0]); return 1; }
+            compact_copy_path = argv[++index];
+        } else if (!strcmp(argument, "--bedrock-restore")) {
+            if (index + 1 >= argc) { print_usage(argv[0]); return 1; }
+            CHOOSE_MODE(MODE_BEDROCK_RESTORE);
+            result_path = argv[++index];
+        } else if (!strcmp(argument, "--verify") || !strcmp(argument, "--verify=full")) {
+            CHOOSE_MODE(MODE_VERIFY);
+            full_verify = argument[8] == '=';
         } else if (!strcmp(argument, "--validate")) {
             CHOOSE_MODE(MODE_VALIDATE);
+        } else if (!strcmp(argument, "--query")) {
+            if (index + 1 >= argc) { print_usage(argv[0]); return 1; }
+            CHOOSE_MODE(MODE_QUERY);
+            query_text = argv[++index];
+        } else if (!strcmp(argument, "--find")) {
+            CHOOSE_MODE(MODE_FIND);
+        } else if (!strcmp(argument, "--name") || !strcmp(argument, "--regex")) {
+            if (index + 1 >= argc) { print_usage(argv[0]); return 1; }
+            if (argument[2] == 'n') find_options.name_glob = argv[++index];
+            else find_options.value_regex = argv[++index];
+            find_criteria = 1;
+        } else if (!strcmp(argument, "--type")) {
+            TagType type;
+            if (index + 1 >= argc || !nbt_find_parse_type(argv[++index], &type)) {
+                fprintf(stderr, "Unknown --type\n");
+                return 1;
+            }
+            find_options.type = (int)type;
+            find_criteria = 1;
+        } else if (!strcmp(argument, "--min") || !strcmp(argument, "--max")) {
+            int is_min = argument[3] == 'i';
+            if (index + 1 >= argc ||
+                !parse_double_arg(argv[++index], is_min ? &find_options.min : &find_options.max)) {
+                fprintf(stderr, "%s expects a number\n", argument);
+                return 1;
+            }
+            if (is_min) find_options.has_min = 1;
+            else find_options.has_max = 1;
+            find_criteria = 1;
+        } else if (!strcmp(argument, "--ignore-case")) {
+            find_options.ignore_case = 1;
+            find_criteria = 1;
+        } else if (!strcmp(argument, "--replace-value") || !strcmp(argument, "--replace-text")) {
+            if (index + 1 >= argc || find_options.replace != NBT_REPLACE_NONE) { print_usage(argv[0]); return 1; }
+            find_options.replace = argument[10] == 'v' ? NBT_REPLACE_VALUE : NBT_REPLACE_TEXT;
+            find_options.replacement = argv[++index];
         } else if (!strcmp(argument, "--output")) {
             if (index + 1 >= argc) { print_usage(argv[0]); return 1; }
             output_path = argv[++index];
         } else if (!strcmp(argument, "--in-place")) {
             in_place = 1;
+        } else if (!strcmp(argument, "--allow-partial")) {
+            allow_partial = 1;
         } else if (!strcmp(argument, "--backup")) {
             backup_enabled = 1;
             if (index + 1 < argc && argv[index + 1][0] != '-') backup_suffix = argv[++index];
@@ -207,12 +320,58 @@ int main(int argc, char* argv[]) {
     }
 #undef CHOOSE_MODE
 
+    if (mode != MODE_FIND && (find_criteria || find_options.replace != NBT_REPLACE_NONE)) {
+        fprintf(stderr, "Find criteria and replacements require --find\n");
+        return 1;
+    }
+    if (mode == MODE_FIND && find_options.replace != NBT_REPLACE_NONE) mode = MODE_REPLACE;
+    if (allow_partial && mode != MODE_REPLACE) {
+        fprintf(stderr, "--allow-partial requires a find replacement\n");
+        return 1;
+    }
     if (!is_mutation(mode) && (output_path || in_place || backup_enabled)) {
         fprintf(stderr, "Save options require an edit operation\n");
         return 1;
     }
+    if (compact_copy_path && mode != MODE_BEDROCK_STATS) {
+        fprintf(stderr, "--compact-copy requires --bedrock-stats\n");
+        return 1;
+    }
     if (output_path && in_place) { fprintf(stderr, "Use --output or --in-place, not both\n"); return 1; }
     if (backup_enabled && !in_place) { fprintf(stderr, "--backup requires --in-place\n"); return 1; }
+    if (mode == MODE_FIND || mode == MODE_REPLACE) {
+        find = nbt_find_compile(&find_options, error, sizeof(error));
+        if (!find) {
+            fprintf(stderr, "Invalid find: %s\n", error);
+            return 1;
+        }
+        /* Bedrock worlds are rewritten record by record in bulk batches. */
+        if (mode == MODE_REPLACE && in_place && nbt_is_directory(input_path)) {
+            char* database = cli_bedrock_db_directory(input_path, NULL, 0);
+            if (database) {
+                free(database);
+                exit_code = cli_bedrock_replace(input_path, find, backup_enabled,
+                                                error, sizeof(error)) ? 0 : 1;
+                if (exit_code) fprintf(stderr, "Bedrock replace failed: %s\n", error);
+                nbt_find_free(find);
+                return exit_code;
+            }
+        }
+        /* Whole regions and world folders are searched chunk by chunk in parallel. */
+        if (nbt_is_directory(input_path) ||
+            (region_path_has_extension(input_path) && !load_options.has_chunk_coords)) {
+            if (mode == MODE_REPLACE && !in_place) {
+                fprintf(stderr, "Replacing across regions requires --in-place\n");
+                exit_code = 1;
+            } else {
+                exit_code = cli_find_regions(input_path, find, backup_enabled ? backup_suffix : NULL,
+                                             allow_partial, error, sizeof(error)) ? 0 : 1;
+                if (exit_code) fprintf(stderr, "Find failed: %s\n", error);
+            }
+            nbt_find_free(find);
+            return exit_code;
+        }
+    }
     if (mode == MODE_LIST_CHUNKS) {
         if (!region_path_has_extension(input_path)) {
             fprintf(stderr, "--list-chunks requires a .mca or .mcr file\n");
@@ -224,6 +383,67 @@ int main(int argc, char* argv[]) {
         }
         return 0;
     }
+    if (mode == MODE_LIST_CUBES) {
+        if (!cli_list_cubic_world(input_path, error, sizeof(error))) {
+            fprintf(stderr, "Failed to list cubes: %s\n", error);
+            return 1;
+        }
+        return 0;
+    }
+    if (mode == MODE_BEDROCK_EXPORT) {
+        if (!cli_bedrock_export(input_path, result_path, error, sizeof(error))) {
+            fprintf(stderr, "Bedrock export failed: %s\n", error);
+            return 1;
+        }
+        return 0;
+    }
+    if (mode == MODE_BEDROCK_BLOCKS) {
+        if (!cli_bedrock_blocks(input_path, error, sizeof(error))) {
+            fprintf(stderr, "Bedrock block count failed: %s\n", error);
+            return 1;
+        }
+        return 0;
+    }
+    if (mode == MODE_BEDROCK_STATS) {
+        if (!cli_bedrock_stats(input_path, compact_copy_path, error, sizeof(error))) {
+            fprintf(stderr, "Bedrock statistics failed: %s\n", error);
+            return 1;
+        }
+        return 0;
+    }
+    if (mode == MODE_BEDROCK_RESTORE) {
+        if (!cli_bedrock_restore(input_path, result_path, error, sizeof(error))) {
+            fprintf(stderr, "Bedrock restore failed: %s\n", error);
+            return 1;
+        }
+        return 0;
+    }
+    if (mode == MODE_VERIFY) {
+        if (!region_path_has_extension(input_path)) {
+            fprintf(stderr, "--verify requires a .mca or .mcr file\n");
+            return 1;
+        }
+        if (!cli_verify_region(input_path, full_verify, error, sizeof(error))) {
+            fprintf(stderr, "Verification failed: %s\n", error);
+            return 1;
+        }
+        return 0;
+    }
+    if (mode == MODE_QUERY) {
+        query = nbt_query_compile(query_text, error, sizeof(error));
+        if (!query) {
+            fprintf(stderr, "Invalid query: %s\n", error);
+            return 1;
+        }
+        /* Whole regions and world folders are queried chunk by chunk in parallel. */
+        if (nbt_is_directory(input_path) ||
+            (region_path_has_extension(input_path) && !load_options.has_chunk_coords)) {
+            exit_code = cli_query_regions(input_path, query, error, sizeof(error)) ? 0 : 1;
+            if (exit_code) fprintf(stderr, "Query failed: %s\n", error);
+            nbt_query_free(query);
+            return exit_code;
+        }
+    }
 
     source_is_snbt = input_mode == INPUT_SNBT ||
         (input_mode == INPUT_AUTO && has_extension(input_path, ".snbt"));
@@ -257,6 +477,17 @@ int main(int argc, char* argv[]) {
         goto done;
     }
 
+    if (mode == MODE_QUERY) {
+        exit_code = cli_query_document(input_path, root, query, error, sizeof(error)) ? 0 : 1;
+        if (exit_code) fprintf(stderr, "Query failed: %s\n", error);
+        goto done;
+    }
+    if (mode == MODE_FIND) {
+        exit_code = cli_find_document(input_path, root, find, error, sizeof(error)) ? 0 : 1;
+        if (exit_code) fprintf(stderr, "Find failed: %s\n", error);
+        goto done;
+    }
+
     printf("Detected source: %s\n", nbt_source_type_name(load_info.source_type));
     printf("Detected input format: %s\n", source_is_snbt ? "snbt" : nbt_input_format_name(load_info.input_format));
     printf("Detected NBT encoding: %s\n", source_is_snbt ? "snbt" : nbt_binary_format_name(binary_info.format));
@@ -300,7 +531,16 @@ int main(int argc, char* argv[]) {
             fprintf(stderr, "A region output requires a region input\n");
             goto done;
         }
-        if (mode == MODE_EDIT) {
+        if (mode == MODE_REPLACE) {
+            NBTFindStats stats = {0};
+            if (!nbt_find_run(find, root, NULL, NULL, &stats, error, sizeof(error))) {
+                fprintf(stderr, "Failed to replace: %s\n", *error ? error : "unknown error");
+                goto done;
+            }
+            printf("Replaced %zu of %zu matching tags\n", stats.replaced, stats.matched);
+            operation_name = "replace";
+            status = EDIT_OK;
+        } else if (mode == MODE_EDIT) {
             operation_name = "edit";
             status = edit_tag_by_path(root, operation_path, operation_value, error, sizeof(error));
         } else if (mode == MODE_SET) {
@@ -377,5 +617,7 @@ save_error:
 done:
     free(data);
     free_nbt_tree(root);
+    nbt_query_free(query);
+    nbt_find_free(find);
     return exit_code;
 }
@@ -391,6 +391,164 @@ static NBTTag* parse_payload_document(
     return root;
 }
 
+static size_t fixed_payload_width(TagType type) {
+    switch (type) {
+        case TAG_Byte: return 1;
+        case TAG_Short: return 2;
+        case TAG_Int:
+        case TAG_Float: return 4;
+        case TAG_Long:
+        case TAG_Double: return 8;
+        default: return 0;
+    }
+}
+
+/* Advances past one payload using only length prefixes; nothing is allocated. */
+static int skip_payload(BinaryReader* r, TagType type) {
+    size_t width = fixed_payload_width(type);
+    int32_t length;
+    int ok = 1;
+
+    if (width > 0) return reader_take(r, NULL, width);
+    if (++r->depth > NBT_MAX_DEPTH) {
+        --r->depth;
+        return reader_error(r, "binary NBT nesting depth limit exceeded");
+    }
+
+    switch (type) {
+        case TAG_Byte_Array:
+        case TAG_Int_Array:
+        case TAG_Long_Array:
+            width = type == TAG_Byte_Array ? 1 : type == TAG_Int_Array ? 4 : 8;
+            ok = parse_array_length(r, &length, width,
+                                    type == TAG_Byte_Array ? "TAG_Byte_Array" :
+                                    type == TAG_Int_Array ? "TAG_Int_Array" : "TAG_Long_Array") &&
+                 reader_take(r, NULL, (size_t)length * width);
+            break;
+        case TAG_String: {
+            uint16_t string_length;
+            ok = read_u16(r, &string_length) && reader_take(r, NULL, string_length);
+            break;
+        }
+        case TAG_List: {
+            uint8_t element_type;
+            uint32_t raw_count;
+            if (!read_u8(r, &element_type) || !valid_type(element_type) || !read_u32(r, &raw_count)) {
+                ok = r->failed ? 0 : reader_error(r, "invalid TAG_List header");
+                break;
+            }
+            length = (int32_t)raw_count;
+            if (length < 0 || (length > 0 && element_type == TAG_End)) {
+                ok = reader_error(r, "invalid TAG_List length or element type");
+                break;
+            }
+            width = fixed_payload_width((TagType)element_type);
+            if (width > 0) {
+                if ((size_t)length > (r->size - r->pos) / width) {
+                    ok = reader_error(r, "TAG_List length exceeds remaining input");
+                } else {
+                    ok = reader_take(r, NULL, (size_t)length * width);
+                }
+                break;
+            }
+            for (int32_t i = 0; ok && i < length; ++i) ok = skip_payload(r, (TagType)element_type);
+            break;
+        }
+        case TAG_Compound:
+            while (ok) {
+                uint8_t next;
+                uint16_t name_length;
+                if (!read_u8(r, &next)) {
+                    ok = 0;
+                    break;
+                }
+                if (next == TAG_End) break;
+                if (!valid_type(next)) {
+                    ok = reader_error(r, "invalid NBT tag type");
+                    break;
+                }
+                ok = read_u16(r, &name_length) && reader_take(r, NULL, name_length) &&
+                     skip_payload(r, (TagType)next);
+            }
+            break;
+        default:
+            ok = reader_error(r, "TAG_End cannot be used as a payload");
+            break;
+    }
+
+    --r->depth;
+    return ok;
+}
+
+static void init_reader_at(
+    BinaryReader* reader,
+    const unsigned char* data,
+    size_t size,
+    size_t offset,
+    NBTBinaryFormat format,
+    char* err,
+    size_t err_sz
+) {
+    memset(reader, 0, sizeof(*reader));
+    reader->data = data;
+    reader->size = size;
+    reader->pos = offset;
+    reader->little_endian = format != NBT_BINARY_JAVA;
+    reader->err = err;
+    reader->err_sz = err_sz;
+}
+
+int nbt_binary_skip_payload(
+    const unsigned char* data,
+    size_t size,
+    size_t offset,
+    TagType type,
+    NBTBinaryFormat format,
+    size_t* out_end,
+    char* err,
+    size_t err_sz
+) {
+    BinaryReader reader;
+
+    if (!data || offset > size || !valid_type((uint8_t)type)) {
+        set_error(err, err_sz, "invalid binary NBT skip arguments");
+        return 0;
+    }
+    init_reader_at(&reader, data, size, offset, format, err, err_sz);
+    if (!skip_payload(&reader, type)) return 0;
+    if (out_end) *out_end = reader.pos;
+    return 1;
+}
+
+NBTTag* nbt_binary_parse_payload_at(
+    const unsigned char* data,
+    size_t size,
+    size_t offset,
+    TagType type,
+    const char* name,
+    NBTBinaryFormat format,
+    size_t* out_end,
+    char* err,
+    size_t err_sz
+) {
+    BinaryReader reader;
+    NBTTag* tag;
+
+    if (!data || offset > size || !valid_type((uint8_t)type) || type == TAG_End) {
+        set_error(err, err_sz, "invalid binary NBT subtree arguments");
+        return NULL;
+    }
+    init_reader_at(&reader, data, size, offset, format, err, err_sz);
+    tag = allocate_tag(type, name ? name : "", &reader);
+    if (!tag) return NULL;
+    if (!parse_payload(&reader, tag)) {
+        free_nbt_tree(tag);
+        return NULL;
+    }
+    if (out_end) *out_end = reader.pos;
+    return tag;
+}
+
 static uint32_t load_le32(const unsigned char* data) {
     return (uint32_t)data[0] |
            ((uint32_t)data[1] << 8) |
@@ -766,6 +924,158 @@ fail:
     return 0;
 }
 
+void nbt_binary_roots_init(
+    NBTBinaryRoots* roots,
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format
+) {
+    if (!roots) return;
+    memset(roots, 0, sizeof(*roots));
+    roots->data = data;
+    roots->size = data ? size : 0;
+    roots->format = format;
+}
+
+int nbt_binary_roots_next(NBTBinaryRoots* roots, NBTTag** out_root, char* err, size_t err_sz) {
+    BinaryReader reader;
+
+    if (out_root) *out_root = NULL;
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!roots || (roots->format != NBT_BINARY_JAVA && roots->format != NBT_BINARY_BEDROCK) ||
+        roots->offset > roots->size) {
+        set_error(err, err_sz, "invalid binary NBT root iterator");
+        return -1;
+    }
+    if (roots->offset == roots->size) return 0;
+    /* One reader over the whole buffer keeps error offsets absolute. */
+    init_reader_at(&reader, roots->data, roots->size, roots->offset, roots->format, err, err_sz);
+    if (out_root) {
+        *out_root = parse_named_tag(&reader);
+        if (!*out_root) return -1;
+    } else {
+        uint8_t type = TAG_End;
+        uint16_t name_length;
+        if (!read_u8(&reader, &type)) return -1;
+        if (!valid_type(type) || type == TAG_End) {
+            reader_error(&reader, type == TAG_End ? "unexpected TAG_End" : "invalid NBT tag type");
+            return -1;
+        }
+        if (!read_u16(&reader, &name_length) || !reader_take(&reader, NULL, name_length) ||
+            !skip_payload(&reader, (TagType)type)) return -1;
+    }
+    roots->offset = reader.pos;
+    roots->count++;
+    return 1;
+}
+
+NBTTag* nbt_binary_parse_root_list(
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format,
+    char* err,
+    size_t err_sz
+) {
+    NBTBinaryRoots roots;
+    NBTTag* list;
+    NBTTag* root = NULL;
+    int result;
+
+    if (!data || size == 0) {
+        set_error(err, err_sz, "binary NBT input is empty");
+        return NULL;
+    }
+    list = calloc(1, sizeof(*list));
+    if (!list || !(list->name = duplicate_string(""))) {
+        free(list);
+        set_error(err, err_sz, "out of memory while reading NBT roots");
+        return NULL;
+    }
+    list->type = TAG_List;
+    list->value.list.element_type = TAG_End;
+    nbt_binary_roots_init(&roots, data, size, format);
+    while ((result = nbt_binary_roots_next(&roots, &root, err, err_sz)) > 0) {
+        NBTTag** grown;
+        if (root->name && root->name[0]) {
+            set_error(err, err_sz, "named concatenated roots cannot be listed");
+            break;
+        }
+        if (list->value.list.count > 0 && root->type != list->value.list.element_type) {
+            set_error(err, err_sz, "concatenated roots have different types");
+            break;
+        }
+        if (list->value.list.count == INT_MAX) {
+            set_error(err, err_sz, "too many concatenated NBT roots");
+            break;
+        }
+        grown = realloc(list->value.list.items, (size_t)(list->value.list.count + 1) * sizeof(NBTTag*));
+        if (!grown) {
+            set_error(err, err_sz, "out of memory while reading NBT roots");
+            break;
+        }
+        list->value.list.items = grown;
+        list->value.list.element_type = root->type;
+        list->value.list.items[list->value.list.count++] = root;
+        root = NULL;
+    }
+    if (result != 0) {
+        free_nbt_tree(root);
+        free_nbt_tree(list);
+        return NULL;
+    }
+    return list;
+}
+
+int nbt_binary_serialize_root_list(
+    const NBTTag* list,
+    NBTBinaryFormat format,
+    unsigned char** out_data,
+    size_t* out_size,
+    char* err,
+    size_t err_sz
+) {
+    BinaryWriter writer;
+    int i;
+    if (out_data) *out_data = NULL;
+    if (out_size) *out_size = 0;
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!list || list->type != TAG_List || !out_data || !out_size ||
+        (format != NBT_BINARY_JAVA && format != NBT_BINARY_BEDROCK)) {
+        set_error(err, err_sz, "invalid binary NBT root list arguments");
+        return 0;
+    }
+    /* An empty value would not parse back as a root list. */
+    if (list->value.list.count == 0) {
+        set_error(err, err_sz, "an NBT root list needs at least one root");
+        return 0;
+    }
+    memset(&writer, 0, sizeof(writer));
+    writer.little_endian = format != NBT_BINARY_JAVA;
+    writer.err = err;
+    writer.err_sz = err_sz;
+    for (i = 0; i < list->value.list.count; ++i) {
+        const NBTTag* root = list->value.list.items[i];
+        if (!root || root->type <= TAG_End || root->type > TAG_Long_Array) {
+            writer_error(&writer, "invalid NBT root in list");
+            goto fail;
+        }
+        if (root->type != list->value.list.items[0]->type) {
+            writer_error(&writer, "NBT roots in a list must all have the same type");
+            goto fail;
+        }
+        /* List elements carry no names; each root is written unnamed. */
+        if (!write_u8(&writer, (uint8_t)root->type) || !write_string(&writer, "") ||
+            !write_payload(&writer, root)) goto fail;
+    }
+    *out_data = writer.data;
+    *out_size = writer.size;
+    return 1;
+
+fail:
+    free(writer.data);
+    return 0;
+}
+
 const char* nbt_binary_format_name(NBTBinaryFormat format) {
     switch (format) {
         case NBT_BINARY_AUTO: return "auto";
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "nbt_builder.h"
+#include "nbt_tree.h"
 #include "nbt_utils.h"
 #include "platform.h"
 
@@ -409,6 +410,7 @@ void free_nbt_tree(NBTTag* tag) {
                 free_nbt_tree(tag->value.compound.items[i]);
             }
             free(tag->value.compound.items);
+            nbt_compound_invalidate_index(tag);
             break;
 
         default:
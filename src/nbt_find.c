@@ -0,0 +1,725 @@
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "edit_value.h"
+#include "nbt_find.h"
+#include "platform.h"
+
+typedef enum {
+    RX_CHAR = 0,
+    RX_ANY,
+    RX_CLASS,
+    RX_BEGIN,
+    RX_END
+} RegexKind;
+
+typedef struct {
+    RegexKind kind;
+    unsigned char ch;
+    unsigned char set[32];  /* RX_CLASS membership by byte */
+    char repeat;            /* 0, '*', '+' or '?' */
+} RegexNode;
+
+typedef struct {
+    RegexNode* nodes;
+    int count;
+} FindRegex;
+
+struct NBTFind {
+    char* name_glob;
+    int type;
+    int has_min;
+    double min;
+    int has_max;
+    double max;
+    FindRegex regex;
+    int has_regex;
+    int ignore_case;
+    NBTReplaceMode replace;
+    char* replacement;
+};
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} FindPath;  /* also used as a plain text buffer */
+
+typedef struct {
+    const NBTFind* find;
+    NBTFindMatchFn fn;
+    void* user;
+    FindPath path;
+    EditPreparedValue* value;
+    NBTFindStats stats;
+    int stopped;
+    char* err;
+    size_t err_sz;
+} FindWalk;
+
+static void set_err(char* err, size_t err_sz, const char* msg) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s", msg);
+}
+
+static unsigned char fold(unsigned char c, int ignore_case) {
+    return ignore_case ? (unsigned char)tolower(c) : c;
+}
+
+/* ---- regular expressions ---- */
+
+static void set_add(unsigned char* set, unsigned char c) {
+    set[c >> 3] |= (unsigned char)(1U << (c & 7));
+}
+
+static int set_has(const unsigned char* set, unsigned char c) {
+    return (set[c >> 3] >> (c & 7)) & 1;
+}
+
+/* Adds \d \w \s (or their negations) to set; returns 0 for any other escape. */
+static int add_class_escape(unsigned char* set, char escape) {
+    unsigned char members[32];
+    int negate = isupper((unsigned char)escape);
+    int c;
+
+    memset(members, 0, sizeof(members));
+    switch (tolower((unsigned char)escape)) {
+        case 'd':
+            for (c = '0'; c <= '9'; c++) set_add(members, (unsigned char)c);
+            break;
+        case 'w':
+            for (c = 0; c < 256; c++) {
+                if (isalnum(c) || c == '_') set_add(members, (unsigned char)c);
+            }
+            break;
+        case 's':
+            for (c = 0; c < 256; c++) {
+                if (isspace(c)) set_add(members, (unsigned char)c);
+            }
+            break;
+        default:
+            return 0;
+    }
+    for (c = 0; c < 32; c++) set[c] |= negate ? (unsigned char)~members[c] : members[c];
+    return 1;
+}
+
+static unsigned char literal_escape(char escape) {
+    switch (escape) {
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 't': return '\t';
+        default: return (unsigned char)escape;
+    }
+}
+
+/* Case-insensitive matching lowercases the subject, so a set needs the lowercase of each letter it has. */
+static void fold_set(unsigned char* set) {
+    int c;
+    for (c = 'a'; c <= 'z'; c++) {
+        if (set_has(set, (unsigned char)toupper(c))) set_add(set, (unsigned char)c);
+    }
+}
+
+static const char* parse_class(const char* p, RegexNode* node, int ignore_case, char* err, size_t err_sz) {
+    int negate = 0;
+    int first = 1;
+
+    node->kind = RX_CLASS;
+    if (*p == '^') {
+        negate = 1;
+        p++;
+    }
+    while (*p && (*p != ']' || first)) {
+        unsigned char low;
+        first = 0;
+        if (*p == '\\' && p[1]) {
+            if (add_class_escape(node->set, p[1])) {
+                p += 2;
+                continue;
+            }
+            low = literal_escape(p[1]);
+            p += 2;
+        } else {
+            low = (unsigned char)*p++;
+        }
+        if (*p == '-' && p[1] && p[1] != ']') {
+            unsigned char high = p[1] == '\\' && p[2] ? literal_escape(p[2]) : (unsigned char)p[1];
+            int c;
+            p += p[1] == '\\' && p[2] ? 3 : 2;
+            if (high < low) {
+                set_err(err, err_sz, "invalid range in regex character class");
+                return NULL;
+            }
+            for (c = low; c <= high; c++) set_add(node->set, (unsigned char)c);
+        } else {
+            set_add(node->set, low);
+        }
+    }
+    if (*p != ']') {
+        set_err(err, err_sz, "unterminated regex character class");
+        return NULL;
+    }
+    /* Fold before negating, or [^a] would let a folded 'A' back in. */
+    if (ignore_case) fold_set(node->set);
+    if (negate) {
+        int i;
+        for (i = 0; i < 32; i++) node->set[i] = (unsigned char)~node->set[i];
+    }
+    return p + 1;
+}
+
+static int compile_regex(const char* pattern, int ignore_case, FindRegex* out, char* err, size_t err_sz) {
+    size_t capacity = strlen(pattern) + 1;
+    const char* p = pattern;
+
+    out->nodes = calloc(capacity, sizeof(*out->nodes));
+    out->count = 0;
+    if (!out->nodes) {
+        set_err(err, err_sz, "out of memory");
+        return 0;
+    }
+    while (*p) {
+        RegexNode* node = &out->nodes[out->count];
+        if (*p == '*' || *p == '+' || *p == '?') {
+            RegexNode* previous = out->count ? &out->nodes[out->count - 1] : NULL;
+            if (!previous || previous->repeat || previous->kind == RX_BEGIN || previous->kind == RX_END) {
+                set_err(err, err_sz, "regex quantifier has nothing to repeat");
+                return 0;
+            }
+            previous->repeat = *p++;
+            continue;
+        }
+        if (*p == '^' && out->count == 0) {
+            node->kind = RX_BEGIN;
+            p++;
+        } else if (*p == '$' && !p[1]) {
+            node->kind = RX_END;
+            p++;
+        } else if (*p == '.') {
+            node->kind = RX_ANY;
+            p++;
+        } else if (*p == '[') {
+            p = parse_class(p + 1, node, ignore_case, err, err_sz);
+            if (!p) return 0;
+            out->count++;
+            continue;
+        } else if (*p == '\\') {
+            if (!p[1]) {
+                set_err(err, err_sz, "regex ends with a backslash");
+                return 0;
+            }
+            if (add_class_escape(node->set, p[1])) node->kind = RX_CLASS;
+            else {
+                node->kind = RX_CHAR;
+                node->ch = literal_escape(p[1]);
+            }
+            p += 2;
+        } else if (*p == '(' || *p == ')' || *p == '|' || *p == '{') {
+            set_err(err, err_sz, "regex groups, alternation, and counted repeats are not supported");
+            return 0;
+        } else {
+            node->kind = RX_CHAR;
+            node->ch = (unsigned char)*p++;
+        }
+        if (ignore_case && node->kind == RX_CHAR) node->ch = fold(node->ch, 1);
+        if (ignore_case && node->kind == RX_CLASS) fold_set(node->set);
+        out->count++;
+    }
+    return 1;
+}
+
+static int node_accepts(const RegexNode* node, unsigned char c, int ignore_case) {
+    switch (node->kind) {
+        case RX_CHAR: return fold(c, ignore_case) == node->ch;
+        case RX_ANY: return c != '\n';
+        case RX_CLASS: return set_has(node->set, fold(c, ignore_case));
+        default: return 0;
+    }
+}
+
+/*
+ * Failed (node, pos) states. Without groups or backreferences a state fails
+ * the same way whichever start position or path reached it, so each is
+ * explored at most once and a search costs O(nodes * len^2) instead of
+ * exponential time for patterns like a*a*a*b.
+ */
+typedef struct {
+    unsigned char* failed;
+    size_t stride;  /* len + 1 */
+} RegexMemo;
+
+#define REGEX_MEMO_STACK_BYTES 512
+
+static int memo_failed(const RegexMemo* memo, int node, size_t pos) {
+    size_t state = (size_t)node * memo->stride + pos;
+    return (memo->failed[state >> 3] >> (state & 7)) & 1;
+}
+
+static void memo_mark(RegexMemo* memo, int node, size_t pos) {
+    size_t state = (size_t)node * memo->stride + pos;
+    memo->failed[state >> 3] |= (unsigned char)(1u << (state & 7));
+}
+
+/* Backtracking match of nodes[node..] at text[pos]; greedy quantifiers. */
+static int match_here(
+    const FindRegex* regex,
+    RegexMemo* memo,
+    int node,
+    const unsigned char* text,
+    size_t len,
+    size_t pos,
+    int ignore_case,
+    size_t* out_end
+) {
+    const int entry_node = node;
+    const size_t entry_pos = pos;
+
+    if (memo_failed(memo, entry_node, entry_pos)) return 0;
+    while (node < regex->count) {
+        const RegexNode* current = &regex->nodes[node];
+        size_t least;
+        size_t most;
+        size_t count = 0;
+
+        if (current->kind == RX_BEGIN) {
+            if (pos != 0) goto fail;
+            node++;
+            continue;
+        }
+        if (current->kind == RX_END) {
+            if (pos != len) goto fail;
+            node++;
+            continue;
+        }
+        if (!current->repeat) {
+            if (pos >= len || !node_accepts(current, text[pos], ignore_case)) goto fail;
+            pos++;
+            node++;
+            continue;
+        }
+        least = current->repeat == '+' ? 1 : 0;
+        most = pos < len ? (current->repeat == '?' ? 1 : len - pos) : 0;
+        while (count < most && node_accepts(current, text[pos + count], ignore_case)) count++;
+        if (count < least) goto fail;
+        for (;;) {
+            if (match_here(regex, memo, node + 1, text, len, pos + count, ignore_case, out_end)) return 1;
+            if (count == least) goto fail;
+            count--;
+        }
+    }
+    *out_end = pos;
+    return 1;
+
+fail:
+    memo_mark(memo, entry_node, entry_pos);
+    return 0;
+}
+
+/* Uses stack_bytes of stack when the states fit; returns 0 when out of memory. */
+static int regex_memo_init(RegexMemo* memo, unsigned char* stack, size_t stack_bytes,
+                           const FindRegex* regex, size_t len) {
+    size_t bytes;
+    memo->failed = NULL;
+    memo->stride = len + 1;
+    if (len == SIZE_MAX || (size_t)(regex->count + 1) > SIZE_MAX / 8 / (len + 1)) return 0;
+    bytes = ((size_t)(regex->count + 1) * (len + 1) + 7) / 8;
+    if (bytes <= stack_bytes) {
+        memset(stack, 0, bytes);
+        memo->failed = stack;
+    } else {
+        memo->failed = calloc(bytes, 1);
+    }
+    return memo->failed != NULL;
+}
+
+static void regex_memo_free(RegexMemo* memo, const unsigned char* stack) {
+    if (memo->failed != stack) free(memo->failed);
+    memo->failed = NULL;
+}
+
+/* memo must have been set up for this text; it stays valid between searches. */
+static int regex_search(
+    const FindRegex* regex,
+    RegexMemo* memo,
+    const unsigned char* text,
+    size_t len,
+    size_t from,
+    int ignore_case,
+    size_t* out_start,
+    size_t* out_end
+) {
+    size_t start;
+    int anchored = regex->count > 0 && regex->nodes[0].kind == RX_BEGIN;
+
+    for (start = from; start <= len; start++) {
+        if (match_here(regex, memo, 0, text, len, start, ignore_case, out_end)) {
+            *out_start = start;
+            return 1;
+        }
+        if (anchored) break;
+    }
+    return 0;
+}
+
+/* ---- criteria ---- */
+
+static int glob_match(const char* pattern, const char* text, int ignore_case) {
+    const char* star = NULL;
+    const char* resume = NULL;
+
+    while (*text) {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = text;
+        } else if (*pattern == '?' ||
+                   (*pattern && fold((unsigned char)*pattern, ignore_case) == fold((unsigned char)*text, ignore_case))) {
+            pattern++;
+            text++;
+        } else if (star) {
+            pattern = star + 1;
+            text = ++resume;
+        } else {
+            return 0;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return !*pattern;
+}
+
+static int numeric_value(const NBTTag* tag, double* out) {
+    switch (tag->type) {
+        case TAG_Byte: *out = tag->value.byte_val; return 1;
+        case TAG_Short: *out = tag->value.short_val; return 1;
+        case TAG_Int: *out = tag->value.int_val; return 1;
+        case TAG_Long: *out = (double)tag->value.long_val; return 1;
+        case TAG_Float: *out = tag->value.float_val; return 1;
+        case TAG_Double: *out = tag->value.double_val; return 1;
+        default: return 0;
+    }
+}
+
+/* Returns -1 when a regex search runs out of memory. */
+static int tag_matches(const NBTFind* find, const NBTTag* tag, const char* name) {
+    if (find->type >= 0 && (int)tag->type != find->type) return 0;
+    if (find->name_glob && !glob_match(find->name_glob, name, find->ignore_case)) return 0;
+    if (find->has_min || find->has_max) {
+        double value;
+        if (!numeric_value(tag, &value)) return 0;
+        if (find->has_min && value < find->min) return 0;
+        if (find->has_max && value > find->max) return 0;
+    }
+    if (find->has_regex) {
+        unsigned char stack_memo[REGEX_MEMO_STACK_BYTES];
+        RegexMemo memo;
+        const char* text;
+        size_t len;
+        size_t start;
+        size_t end;
+        int found;
+        if (tag->type != TAG_String) return 0;
+        text = tag->value.string_val ? tag->value.string_val : "";
+        len = strlen(text);
+        if (!regex_memo_init(&memo, stack_memo, sizeof(stack_memo), &find->regex, len)) return -1;
+        found = regex_search(&find->regex, &memo, (const unsigned char*)text, len, 0,
+                             find->ignore_case, &start, &end);
+        regex_memo_free(&memo, stack_memo);
+        if (!found) return 0;
+    }
+    return 1;
+}
+
+NBTFind* nbt_find_compile(const NBTFindOptions* options, char* err, size_t err_sz) {
+    NBTFind* find;
+
+    if (!options) {
+        set_err(err, err_sz, "invalid find arguments");
+        return NULL;
+    }
+    if (options->type < -1 || options->type > TAG_Long_Array) {
+        set_err(err, err_sz, "invalid tag type");
+        return NULL;
+    }
+    if (options->has_min && options->has_max && options->min > options->max) {
+        set_err(err, err_sz, "the minimum is greater than the maximum");
+        return NULL;
+    }
+    if (options->replace != NBT_REPLACE_NONE && !options->replacement) {
+        set_err(err, err_sz, "a replacement needs a value");
+        return NULL;
+    }
+    if (options->replace == NBT_REPLACE_TEXT && !options->value_regex) {
+        set_err(err, err_sz, "text replacement needs a value regex");
+        return NULL;
+    }
+
+    find = calloc(1, sizeof(*find));
+    if (!find) {
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+    find->type = options->type;
+    find->has_min = options->has_min;
+    find->min = options->min;
+    find->has_max = options->has_max;
+    find->max = options->max;
+    find->ignore_case = options->ignore_case;
+    find->replace = options->replace;
+    if ((options->name_glob && !(find->name_glob = nbt_strdup(options->name_glob))) ||
+        (options->replacement && !(find->replacement = nbt_strdup(options->replacement)))) {
+        set_err(err, err_sz, "out of memory");
+        goto fail;
+    }
+    if (options->value_regex) {
+        if (!compile_regex(options->value_regex, options->ignore_case, &find->regex, err, err_sz)) goto fail;
+        find->has_regex = 1;
+    }
+    if (find->replace == NBT_REPLACE_VALUE) {
+        /* Validate the expression up front; each run prepares its own copy. */
+        EditPreparedValue* value = NULL;
+        if (edit_value_prepare(find->replacement, &value, err, err_sz) != EDIT_OK) goto fail;
+        edit_value_free(value);
+    }
+    return find;
+
+fail:
+    nbt_find_free(find);
+    return NULL;
+}
+
+void nbt_find_free(NBTFind* find) {
+    if (!find) return;
+    free(find->name_glob);
+    free(find->regex.nodes);
+    free(find->replacement);
+    free(find);
+}
+
+int nbt_find_replaces(const NBTFind* find) {
+    return find && find->replace != NBT_REPLACE_NONE;
+}
+
+int nbt_find_parse_type(const char* text, TagType* out_type) {
+    static const char* const names[] = {
+        "end", "byte", "short", "int", "long", "float", "double", "bytearray",
+        "string", "list", "compound", "intarray", "longarray"
+    };
+    char compact[16];
+    size_t len = 0;
+    char* end = NULL;
+    long number;
+    int i;
+
+    if (!text || !*text || !out_type) return 0;
+    number = strtol(text, &end, 10);
+    if (end && !*end) {
+        if (number < TAG_End || number > TAG_Long_Array) return 0;
+        *out_type = (TagType)number;
+        return 1;
+    }
+    for (; *text; text++) {
+        if (*text == '_' || *text == ' ' || *text == '-') continue;
+        if (len + 1 >= sizeof(compact)) return 0;
+        compact[len++] = (char)tolower((unsigned char)*text);
+    }
+    compact[len] = '\0';
+    if (!strncmp(compact, "tag", 3)) memmove(compact, compact + 3, len - 2);
+    for (i = 0; i <= TAG_Long_Array; i++) {
+        if (!strcmp(compact, names[i])) {
+            *out_type = (TagType)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ---- walking ---- */
+
+static int path_reserve(FindWalk* walk, size_t extra) {
+    FindPath* path = &walk->path;
+    char* grown;
+    size_t cap;
+
+    if (path->len + extra + 1 <= path->cap) return 1;
+    cap = path->cap ? path->cap : 128;
+    while (cap < path->len + extra + 1) cap *= 2;
+    grown = realloc(path->data, cap);
+    if (!grown) {
+        set_err(walk->err, walk->err_sz, "out of memory");
+        return 0;
+    }
+    path->data = grown;
+    path->cap = cap;
+    return 1;
+}
+
+/* Appends one segment in edit-path syntax, quoting keys that need it. */
+static int path_push_key(FindWalk* walk, const char* key) {
+    FindPath* path = &walk->path;
+    size_t len = strlen(key);
+    int quote = len == 0 || strpbrk(key, "/[]\"\\\n\r\t") != NULL;
+    size_t i;
+
+    if (!path_reserve(walk, len * 2 + 3)) return 0;
+    if (path->len) path->data[path->len++] = '/';
+    if (quote) path->data[path->len++] = '"';
+    for (i = 0; i < len; i++) {
+        char c = key[i];
+        if (quote && (c == '"' || c == '\\')) path->data[path->len++] = '\\';
+        else if (quote && (c == '\n' || c == '\r' || c == '\t')) {
+            path->data[path->len++] = '\\';
+            c = c == '\n' ? 'n' : c == '\r' ? 'r' : 't';
+        }
+        path->data[path->len++] = c;
+    }
+    if (quote) path->data[path->len++] = '"';
+    path->data[path->len] = '\0';
+    return 1;
+}
+
+static int path_push_index(FindWalk* walk, int index) {
+    FindPath* path = &walk->path;
+    if (!path_reserve(walk, 16)) return 0;
+    path->len += (size_t)snprintf(path->data + path->len, path->cap - path->len, "[%d]", index);
+    return 1;
+}
+
+static int buffer_append(FindWalk* walk, FindPath* buffer, const char* bytes, size_t len) {
+    if (buffer->len + len + 1 > buffer->cap) {
+        size_t cap = buffer->cap ? buffer->cap : 64;
+        char* grown;
+        while (cap < buffer->len + len + 1) cap *= 2;
+        grown = realloc(buffer->data, cap);
+        if (!grown) {
+            set_err(walk->err, walk->err_sz, "out of memory");
+            return 0;
+        }
+        buffer->data = grown;
+        buffer->cap = cap;
+    }
+    memcpy(buffer->data + buffer->len, bytes, len);
+    buffer->len += len;
+    buffer->data[buffer->len] = '\0';
+    return 1;
+}
+
+static int replace_text(FindWalk* walk, NBTTag* tag) {
+    const NBTFind* find = walk->find;
+    const char* text = tag->value.string_val ? tag->value.string_val : "";
+    size_t len = strlen(text);
+    size_t insert_len = strlen(find->replacement);
+    unsigned char stack_memo[REGEX_MEMO_STACK_BYTES];
+    RegexMemo memo;
+    FindPath result = {0};
+    size_t pos = 0;
+    size_t start;
+    size_t end;
+
+    if (!regex_memo_init(&memo, stack_memo, sizeof(stack_memo), &find->regex, len)) {
+        set_err(walk->err, walk->err_sz, "out of memory while matching a regex");
+        return 0;
+    }
+    while (pos <= len &&
+           regex_search(&find->regex, &memo, (const unsigned char*)text, len, pos, find->ignore_case,
+                        &start, &end)) {
+        if (!buffer_append(walk, &result, text + pos, start - pos) ||
+            !buffer_append(walk, &result, find->replacement, insert_len)) goto fail;
+        if (end > start) {
+            pos = end;
+            continue;
+        }
+        /* An empty match keeps the byte after it and moves the scan on. */
+        if (start < len && !buffer_append(walk, &result, text + start, 1)) goto fail;
+        pos = start + 1;
+    }
+    if (pos < len && !buffer_append(walk, &result, text + pos, len - pos)) goto fail;
+    if (!result.data && !buffer_append(walk, &result, "", 0)) goto fail;
+    regex_memo_free(&memo, stack_memo);
+    free(tag->value.string_val);
+    tag->value.string_val = result.data;
+    return 1;
+
+fail:
+    regex_memo_free(&memo, stack_memo);
+    free(result.data);
+    return 0;
+}
+
+static int apply_replacement(FindWalk* walk, NBTTag* tag) {
+    if (walk->find->replace == NBT_REPLACE_TEXT) return replace_text(walk, tag);
+    if (!walk->value &&
+        edit_value_prepare(walk->find->replacement, &walk->value, walk->err, walk->err_sz) != EDIT_OK) {
+        return 0;
+    }
+    return edit_value_apply_to_tag(walk->value, tag, walk->err, walk->err_sz) == EDIT_OK;
+}
+
+static int walk_tag(FindWalk* walk, NBTTag* tag, const char* name) {
+    size_t mark = walk->path.len;
+    int count;
+    int matched;
+    int i;
+
+    matched = tag_matches(walk->find, tag, name);
+    if (matched < 0) {
+        set_err(walk->err, walk->err_sz, "out of memory while matching a regex");
+        return 0;
+    }
+    if (matched) {
+        walk->stats.matched++;
+        if (walk->find->replace != NBT_REPLACE_NONE) {
+            if (!apply_replacement(walk, tag)) return 0;
+            walk->stats.replaced++;
+        }
+        if (walk->fn && !walk->fn(tag, walk->path.data ? walk->path.data : "", walk->user)) {
+            walk->stopped = 1;
+            return 1;
+        }
+        if (walk->find->replace != NBT_REPLACE_NONE) return 1;
+    }
+
+    count = tag->type == TAG_Compound ? tag->value.compound.count
+        : tag->type == TAG_List ? tag->value.list.count : 0;
+    for (i = 0; i < count && !walk->stopped; i++) {
+        NBTTag* child = tag->type == TAG_Compound ? tag->value.compound.items[i] : tag->value.list.items[i];
+        const char* child_name = tag->type == TAG_Compound && child->name ? child->name : "";
+        int pushed = !walk->fn ? 1
+            : tag->type == TAG_Compound ? path_push_key(walk, child_name) : path_push_index(walk, i);
+        if (!pushed || !walk_tag(walk, child, child_name)) return 0;
+        if (walk->path.data) {
+            walk->path.len = mark;
+            walk->path.data[mark] = '\0';
+        }
+    }
+    return 1;
+}
+
+int nbt_find_run(
+    const NBTFind* find,
+    NBTTag* root,
+    NBTFindMatchFn fn,
+    void* user,
+    NBTFindStats* stats,
+    char* err,
+    size_t err_sz
+) {
+    FindWalk walk;
+    int ok;
+
+    if (!find || !root) {
+        set_err(err, err_sz, "invalid find arguments");
+        return 0;
+    }
+    memset(&walk, 0, sizeof(walk));
+    walk.find = find;
+    walk.fn = fn;
+    walk.user = user;
+    walk.err = err;
+    walk.err_sz = err_sz;
+    ok = walk_tag(&walk, root, root->name ? root->name : "");
+    free(walk.path.data);
+    edit_value_free(walk.value);
+    if (stats) *stats = walk.stats;
+    return ok;
+}
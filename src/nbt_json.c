@@ -374,6 +374,43 @@ int nbt_write_typed_json(FILE* out, const NBTTag* root, int pretty, char* err, s
     return 1;
 }
 
+int nbt_write_typed_json_node(
+    FILE* out,
+    const NBTTag* node,
+    const char* path,
+    int pretty,
+    char* err,
+    size_t err_sz
+) {
+    JsonWriter writer;
+
+    if (!out || !node) {
+        set_err(err, err_sz, "invalid JSON export arguments");
+        return 0;
+    }
+
+    writer.out = out;
+    writer.pretty = pretty != 0;
+    writer.failed = 0;
+    if (!write_tag(&writer, node, path ? path : "", 0)) writer.failed = 1;
+
+    if (writer.failed || ferror(out)) {
+        set_err(err, err_sz, "failed to write JSON output");
+        return 0;
+    }
+    return 1;
+}
+
+int nbt_write_json_string(FILE* out, const char* text) {
+    JsonWriter writer;
+
+    writer.out = out;
+    writer.pretty = 0;
+    writer.failed = 0;
+    jw_string(&writer, text);
+    return !writer.failed;
+}
+
 int nbt_write_typed_json_file(const char* path, const NBTTag* root, int pretty, char* err, size_t err_sz) {
     FILE* out;
     int ok;
@@ -0,0 +1,465 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nbt_lazy.h"
+#include "nbt_tree.h"
+
+typedef struct {
+    size_t key;  /* parent payload offset + 1; 0 marks an empty slot */
+    NBTLazyEntry* children;
+    int count;
+} LazyChildSlot;
+
+struct NBTLazyDocument {
+    const unsigned char* data;
+    size_t limit;                /* end of the NBT payload inside data */
+    NBTBinaryFormat format;      /* JAVA or BEDROCK once opened */
+    NBTLazyEntry root;
+    LazyChildSlot* slots;
+    size_t capacity;
+    size_t used;
+};
+
+static void set_err(char* err, size_t err_sz, const char* msg) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s", msg);
+}
+
+static void set_offset_err(char* err, size_t err_sz, const char* msg, size_t offset) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s at byte offset %zu", msg, offset);
+}
+
+static int read_uint(
+    const unsigned char* data,
+    size_t limit,
+    size_t offset,
+    size_t width,
+    NBTBinaryFormat format,
+    uint32_t* value
+) {
+    uint32_t result = 0;
+
+    if (offset > limit || width > limit - offset) return 0;
+    if (format == NBT_BINARY_JAVA) {
+        for (size_t i = 0; i < width; i++) result = (result << 8) | data[offset + i];
+    } else {
+        for (size_t i = width; i > 0; i--) result = (result << 8) | data[offset + i - 1];
+    }
+    *value = result;
+    return 1;
+}
+
+static uint32_t load_le32(const unsigned char* data) {
+    return (uint32_t)data[0] |
+           ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) |
+           ((uint32_t)data[3] << 24);
+}
+
+/* Reads a named tag header at offset and sizes its payload with a skip scan. */
+static int read_entry(
+    const unsigned char* data,
+    size_t limit,
+    size_t offset,
+    NBTBinaryFormat format,
+    NBTLazyEntry* entry,
+    size_t* out_end,
+    char* err,
+    size_t err_sz
+) {
+    uint32_t type;
+    uint32_t name_len;
+    size_t end;
+
+    memset(entry, 0, sizeof(*entry));
+    if (!read_uint(data, limit, offset, 1, format, &type) ||
+        !read_uint(data, limit, offset + 1, 2, format, &name_len) ||
+        name_len > limit - offset - 3) {
+        set_offset_err(err, err_sz, "unexpected end of binary NBT", offset);
+        return 0;
+    }
+    if (type == TAG_End || type > TAG_Long_Array) {
+        set_offset_err(err, err_sz, "invalid NBT tag type", offset);
+        return 0;
+    }
+    entry->type = (TagType)type;
+    entry->name = (const char*)data + offset + 3;
+    entry->name_len = name_len;
+    entry->offset = offset + 3 + name_len;
+    if (!nbt_binary_skip_payload(data, limit, entry->offset, entry->type, format, &end, err, err_sz)) {
+        return 0;
+    }
+    entry->length = end - entry->offset;
+    if (out_end) *out_end = end;
+    return 1;
+}
+
+static NBTLazyDocument* open_explicit(
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format,
+    NBTBinaryInfo* info,
+    int require_exact,
+    char* err,
+    size_t err_sz
+) {
+    NBTLazyDocument* document;
+    size_t payload_offset = 0;
+    size_t limit = size;
+    size_t end = 0;
+    uint32_t version = 0;
+    uint32_t declared = 0;
+    NBTBinaryFormat stream_format = format == NBT_BINARY_JAVA ? NBT_BINARY_JAVA : NBT_BINARY_BEDROCK;
+    NBTLazyEntry root;
+
+    if (format == NBT_BINARY_BEDROCK_LEVEL_DAT) {
+        if (size < 8) {
+            set_err(err, err_sz, "Bedrock level.dat is shorter than its eight-byte header");
+            return NULL;
+        }
+        version = load_le32(data);
+        declared = load_le32(data + 4);
+        if ((size_t)declared > size - 8) {
+            set_err(err, err_sz, "Bedrock level.dat payload length exceeds the file size");
+            return NULL;
+        }
+        payload_offset = 8;
+        limit = 8 + (size_t)declared;
+        require_exact = 1;
+    }
+
+    if (!read_entry(data, limit, payload_offset, stream_format, &root, &end, err, err_sz)) return NULL;
+    if (require_exact && end != limit) {
+        set_err(err, err_sz, format == NBT_BINARY_BEDROCK_LEVEL_DAT
+            ? "Bedrock level.dat payload contains trailing bytes"
+            : "binary NBT document contains trailing bytes");
+        return NULL;
+    }
+
+    document = calloc(1, sizeof(*document));
+    if (!document) {
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+    document->data = data;
+    document->limit = limit;
+    document->format = stream_format;
+    document->root = root;
+    if (info) {
+        memset(info, 0, sizeof(*info));
+        info->format = format;
+        info->payload_offset = payload_offset;
+        info->payload_size = limit - payload_offset;
+        info->bytes_consumed = end;
+        info->bedrock_storage_version = version;
+        info->bedrock_declared_payload_size = declared;
+    }
+    return document;
+}
+
+NBTLazyDocument* nbt_lazy_open(
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format,
+    NBTBinaryInfo* info,
+    char* err,
+    size_t err_sz
+) {
+    NBTLazyDocument* document;
+    char candidate_err[256] = {0};
+
+    if (err && err_sz > 0) err[0] = '\0';
+    if (!data || size == 0) {
+        set_err(err, err_sz, "binary NBT input is empty");
+        return NULL;
+    }
+    if (format == NBT_BINARY_JAVA || format == NBT_BINARY_BEDROCK || format == NBT_BINARY_BEDROCK_LEVEL_DAT) {
+        return open_explicit(data, size, format, info, 0, err, err_sz);
+    }
+    if (format != NBT_BINARY_AUTO) {
+        set_err(err, err_sz, "invalid binary NBT format");
+        return NULL;
+    }
+
+    /* Same detection order as nbt_binary_parse, using skip scans only. */
+    if (size >= 8 && (size_t)load_le32(data + 4) == size - 8) {
+        document = open_explicit(data, size, NBT_BINARY_BEDROCK_LEVEL_DAT, info, 1,
+                                 candidate_err, sizeof(candidate_err));
+        if (document) return document;
+    }
+    candidate_err[0] = '\0';
+    document = open_explicit(data, size, NBT_BINARY_JAVA, info, 1, candidate_err, sizeof(candidate_err));
+    if (document) return document;
+    candidate_err[0] = '\0';
+    document = open_explicit(data, size, NBT_BINARY_BEDROCK, info, 1, candidate_err, sizeof(candidate_err));
+    if (document) return document;
+
+    if (candidate_err[0]) set_err(err, err_sz, candidate_err);
+    else set_err(err, err_sz, "input is not a complete Java or Bedrock NBT document");
+    return NULL;
+}
+
+void nbt_lazy_close(NBTLazyDocument* document) {
+    if (!document) return;
+    for (size_t i = 0; i < document->capacity; i++) free(document->slots[i].children);
+    free(document->slots);
+    free(document);
+}
+
+const NBTLazyEntry* nbt_lazy_root(const NBTLazyDocument* document) {
+    return document ? &document->root : NULL;
+}
+
+static LazyChildSlot* find_slot(const NBTLazyDocument* document, size_t key) {
+    size_t mask;
+    size_t position;
+
+    if (!document->capacity) return NULL;
+    mask = document->capacity - 1;
+    position = (key * 0x9E3779B97F4A7C15ull) & mask;
+    while (document->slots[position].key) {
+        if (document->slots[position].key == key) return &document->slots[position];
+        position = (position + 1) & mask;
+    }
+    return &document->slots[position];
+}
+
+static int reserve_slot(NBTLazyDocument* document) {
+    LazyChildSlot* old_slots = document->slots;
+    size_t old_capacity = document->capacity;
+    size_t capacity;
+
+    if ((document->used + 1) * 2 <= document->capacity) return 1;
+    capacity = old_capacity ? old_capacity * 2 : 64;
+    document->slots = calloc(capacity, sizeof(*document->slots));
+    if (!document->slots) {
+        document->slots = old_slots;
+        return 0;
+    }
+    document->capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].key) *find_slot(document, old_slots[i].key) = old_slots[i];
+    }
+    free(old_slots);
+    return 1;
+}
+
+static int build_children(
+    const NBTLazyDocument* document,
+    const NBTLazyEntry* parent,
+    NBTLazyEntry** out_children,
+    int* out_count,
+    char* err,
+    size_t err_sz
+) {
+    NBTLazyEntry* children = NULL;
+    size_t capacity = 0;
+    size_t count = 0;
+    size_t offset = parent->offset;
+    size_t end = parent->offset + parent->length;
+    uint32_t element_type = TAG_End;
+    uint32_t list_count = 0;
+
+    if (parent->type == TAG_List) {
+        if (!read_uint(document->data, end, offset, 1, document->format, &element_type) ||
+            !read_uint(document->data, end, offset + 1, 4, document->format, &list_count)) {
+            set_offset_err(err, err_sz, "invalid TAG_List header", offset);
+            return 0;
+        }
+        offset += 5;
+        /* The opening scan already validated this list, so count fits the payload. */
+        capacity = list_count;
+        if (capacity) {
+            children = malloc(capacity * sizeof(*children));
+            if (!children) goto oom;
+        }
+    }
+
+    while (parent->type == TAG_List ? count < list_count : 1) {
+        NBTLazyEntry entry;
+        size_t entry_end;
+
+        if (parent->type == TAG_Compound) {
+            if (offset < end && document->data[offset] == TAG_End) break;
+            if (!read_entry(document->data, end, offset, document->format, &entry, &entry_end, err, err_sz)) {
+                free(children);
+                return 0;
+            }
+            if (count == capacity) {
+                size_t grown_capacity = capacity ? capacity * 2 : 16;
+                NBTLazyEntry* grown = realloc(children, grown_capacity * sizeof(*grown));
+                if (!grown) goto oom;
+                children = grown;
+                capacity = grown_capacity;
+            }
+        } else {
+            memset(&entry, 0, sizeof(entry));
+            entry.type = (TagType)element_type;
+            entry.name = "";
+            entry.offset = offset;
+            if (!nbt_binary_skip_payload(document->data, end, offset, entry.type, document->format,
+                                         &entry_end, err, err_sz)) {
+                free(children);
+                return 0;
+            }
+            entry.length = entry_end - offset;
+        }
+        if (count >= (size_t)INT32_MAX) {
+            free(children);
+            set_err(err, err_sz, "container has too many children");
+            return 0;
+        }
+        children[count++] = entry;
+        offset = entry_end;
+    }
+
+    if (count && count < capacity) {
+        NBTLazyEntry* shrunk = realloc(children, count * sizeof(*shrunk));
+        if (shrunk) children = shrunk;
+    }
+    *out_children = children;
+    *out_count = (int)count;
+    return 1;
+
+oom:
+    free(children);
+    set_err(err, err_sz, "out of memory while indexing NBT children");
+    return 0;
+}
+
+int nbt_lazy_children(
+    NBTLazyDocument* document,
+    const NBTLazyEntry* parent,
+    const NBTLazyEntry** out_children,
+    int* out_count,
+    char* err,
+    size_t err_sz
+) {
+    LazyChildSlot* slot;
+    NBTLazyEntry* children = NULL;
+    int count = 0;
+
+    if (!document || !parent || !out_children || !out_count) {
+        set_err(err, err_sz, "invalid lazy NBT arguments");
+        return 0;
+    }
+    *out_children = NULL;
+    *out_count = 0;
+    if (parent->type != TAG_Compound && parent->type != TAG_List) {
+        set_err(err, err_sz, "only compounds and lists have children");
+        return 0;
+    }
+
+    slot = find_slot(document, parent->offset + 1);
+    if (slot && slot->key) {
+        *out_children = slot->children;
+        *out_count = slot->count;
+        return 1;
+    }
+    if (!reserve_slot(document)) {
+        set_err(err, err_sz, "out of memory while indexing NBT children");
+        return 0;
+    }
+    if (!build_children(document, parent, &children, &count, err, err_sz)) return 0;
+
+    slot = find_slot(document, parent->offset + 1);
+    slot->key = parent->offset + 1;
+    slot->children = children;
+    slot->count = count;
+    document->used++;
+    *out_children = children;
+    *out_count = count;
+    return 1;
+}
+
+const NBTLazyEntry* nbt_lazy_find_child(
+    NBTLazyDocument* document,
+    const NBTLazyEntry* parent,
+    const char* name,
+    char* err,
+    size_t err_sz
+) {
+    const NBTLazyEntry* children;
+    size_t name_len = name ? strlen(name) : 0;
+    int count = 0;
+
+    if (!parent || parent->type != TAG_Compound || !name) {
+        set_err(err, err_sz, "lookup by name requires a compound");
+        return NULL;
+    }
+    if (!nbt_lazy_children(document, parent, &children, &count, err, err_sz)) return NULL;
+    for (int i = 0; i < count; i++) {
+        if (children[i].name_len == name_len && memcmp(children[i].name, name, name_len) == 0) {
+            return &children[i];
+        }
+    }
+    if (err && err_sz > 0) err[0] = '\0';
+    return NULL;
+}
+
+static char* entry_name(const NBTLazyEntry* entry) {
+    char* name = malloc(entry->name_len + 1);
+    if (!name) return NULL;
+    if (entry->name_len) memcpy(name, entry->name, entry->name_len);
+    name[entry->name_len] = '\0';
+    return name;
+}
+
+NBTTag* nbt_lazy_materialize(
+    const NBTLazyDocument* document,
+    const NBTLazyEntry* entry,
+    char* err,
+    size_t err_sz
+) {
+    char* name;
+    NBTTag* tag;
+
+    if (!document || !entry) {
+        set_err(err, err_sz, "invalid lazy NBT arguments");
+        return NULL;
+    }
+    name = entry_name(entry);
+    if (!name) {
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+    tag = nbt_binary_parse_payload_at(document->data, document->limit, entry->offset, entry->type,
+                                      name, document->format, NULL, err, err_sz);
+    free(name);
+    return tag;
+}
+
+NBTTag* nbt_lazy_materialize_shallow(
+    const NBTLazyDocument* document,
+    const NBTLazyEntry* entry,
+    char* err,
+    size_t err_sz
+) {
+    uint32_t element_type = TAG_End;
+    char* name;
+    NBTTag* tag;
+
+    if (!document || !entry) {
+        set_err(err, err_sz, "invalid lazy NBT arguments");
+        return NULL;
+    }
+    if (entry->type != TAG_Compound && entry->type != TAG_List) {
+        return nbt_lazy_materialize(document, entry, err, err_sz);
+    }
+    if (entry->type == TAG_List &&
+        !read_uint(document->data, document->limit, entry->offset, 1, document->format, &element_type)) {
+        set_offset_err(err, err_sz, "invalid TAG_List header", entry->offset);
+        return NULL;
+    }
+
+    name = entry_name(entry);
+    tag = name ? nbt_tag_create(entry->type, name) : NULL;
+    free(name);
+    if (!tag) {
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+    if (entry->type == TAG_List) tag->value.list.element_type = (TagType)element_type;
+    return tag;
+}
@@ -0,0 +1,1453 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nbt_binary.h"
+#include "nbt_builder.h"
+#include "nbt_query.h"
+#include "nbt_tree.h"
+#include "platform.h"
+
+typedef enum {
+    STEP_CHILD = 0,
+    STEP_ANY_CHILD,
+    STEP_DESCENDANT,
+    STEP_ANY_DESCENDANT,
+    STEP_INDEX,
+    STEP_ALL_ELEMENTS,
+    STEP_FILTER
+} QueryStepKind;
+
+typedef struct QueryExpr QueryExpr;
+
+typedef struct {
+    QueryStepKind kind;
+    char* key;
+    size_t key_len;
+    uint32_t key_hash;
+    int index;
+    QueryExpr* filter;
+} QueryStep;
+
+typedef struct {
+    QueryStep* steps;
+    int count;
+} QueryPath;
+
+typedef enum {
+    OPERAND_PATH = 0,
+    OPERAND_NUMBER,
+    OPERAND_STRING
+} QueryOperandKind;
+
+typedef struct {
+    QueryOperandKind kind;
+    QueryPath path;
+    int is_integer;
+    int64_t integer;
+    double number;
+    char* text;
+} QueryOperand;
+
+typedef enum {
+    EXPR_OR = 0,
+    EXPR_AND,
+    EXPR_NOT,
+    EXPR_EXISTS,
+    EXPR_COMPARE
+} QueryExprKind;
+
+typedef enum {
+    CMP_EQ = 0,
+    CMP_NE,
+    CMP_LT,
+    CMP_LE,
+    CMP_GT,
+    CMP_GE
+} QueryCompareOp;
+
+struct QueryExpr {
+    QueryExprKind kind;
+    QueryExpr* left;
+    QueryExpr* right;
+    QueryCompareOp op;
+    QueryOperand a;
+    QueryOperand b;
+};
+
+typedef struct {
+    char* alias;
+    QueryPath path;
+} QueryField;
+
+struct NBTQuery {
+    QueryPath path;
+    QueryField* fields;
+    int field_count;
+    int has_projection;
+};
+
+typedef struct {
+    const char* text;
+    size_t pos;
+    char* err;
+    size_t err_sz;
+    int failed;
+} QueryParser;
+
+static void set_err(char* err, size_t err_sz, const char* msg) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s", msg);
+}
+
+static void syntax_error(QueryParser* p, const char* msg) {
+    if (p->failed) return;
+    p->failed = 1;
+    if (p->err && p->err_sz > 0) {
+        snprintf(p->err, p->err_sz, "query syntax error at offset %zu: %s", p->pos, msg);
+    }
+}
+
+static void free_expr(QueryExpr* expr);
+
+static void free_path(QueryPath* path) {
+    for (int i = 0; i < path->count; i++) {
+        free(path->steps[i].key);
+        free_expr(path->steps[i].filter);
+    }
+    free(path->steps);
+    path->steps = NULL;
+    path->count = 0;
+}
+
+static void free_operand(QueryOperand* operand) {
+    free_path(&operand->path);
+    free(operand->text);
+}
+
+static void free_expr(QueryExpr* expr) {
+    if (!expr) return;
+    free_expr(expr->left);
+    free_expr(expr->right);
+    free_operand(&expr->a);
+    free_operand(&expr->b);
+    free(expr);
+}
+
+void nbt_query_free(NBTQuery* query) {
+    if (!query) return;
+    free_path(&query->path);
+    for (int i = 0; i < query->field_count; i++) {
+        free(query->fields[i].alias);
+        free_path(&query->fields[i].path);
+    }
+    free(query->fields);
+    free(query);
+}
+
+/* ---- parsing ---- */
+
+static char peek(const QueryParser* p) {
+    return p->text[p->pos];
+}
+
+static void skip_space(QueryParser* p) {
+    while (peek(p) == ' ' || peek(p) == '\t' || peek(p) == '\n' || peek(p) == '\r') p->pos++;
+}
+
+static int accept(QueryParser* p, const char* token) {
+    size_t len = strlen(token);
+    skip_space(p);
+    if (strncmp(p->text + p->pos, token, len) != 0) return 0;
+    p->pos += len;
+    return 1;
+}
+
+static int is_key_char(char c, int allow_colon) {
+    unsigned char u = (unsigned char)c;
+    if (u >= 0x80) return 1;
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return 1;
+    if (c == '_' || c == '-' || c == '+') return 1;
+    return allow_colon && c == ':';
+}
+
+static char* parse_quoted(QueryParser* p) {
+    char quote = peek(p);
+    size_t start = ++p->pos;
+    size_t out_len = 0;
+    char* out;
+
+    while (peek(p) && peek(p) != quote) {
+        if (peek(p) == '\\' && p->text[p->pos + 1]) p->pos++;
+        p->pos++;
+    }
+    if (peek(p) != quote) {
+        syntax_error(p, "unterminated quoted string");
+        return NULL;
+    }
+
+    out = malloc(p->pos - start + 1);
+    if (!out) {
+        syntax_error(p, "out of memory");
+        return NULL;
+    }
+    for (size_t i = start; i < p->pos; i++) {
+        char c = p->text[i];
+        if (c == '\\') {
+            c = p->text[++i];
+            if (c == 'n') c = '\n';
+            else if (c == 't') c = '\t';
+            else if (c == 'r') c = '\r';
+            else if (c != '"' && c != '\'' && c != '\\' && c != '/') {
+                free(out);
+                syntax_error(p, "unsupported escape in quoted string");
+                return NULL;
+            }
+        }
+        out[out_len++] = c;
+    }
+    out[out_len] = '\0';
+    p->pos++;
+    return out;
+}
+
+static char* parse_key(QueryParser* p, int allow_colon) {
+    size_t start = p->pos;
+    char* key;
+
+    if (peek(p) == '"' || peek(p) == '\'') return parse_quoted(p);
+    while (is_key_char(peek(p), allow_colon)) p->pos++;
+    if (p->pos == start) {
+        syntax_error(p, "expected a key");
+        return NULL;
+    }
+    key = malloc(p->pos - start + 1);
+    if (!key) {
+        syntax_error(p, "out of memory");
+        return NULL;
+    }
+    memcpy(key, p->text + start, p->pos - start);
+    key[p->pos - start] = '\0';
+    return key;
+}
+
+static int push_step(QueryParser* p, QueryPath* path, QueryStep step) {
+    QueryStep* grown = realloc(path->steps, (size_t)(path->count + 1) * sizeof(*grown));
+    if (!grown) {
+        free(step.key);
+        free_expr(step.filter);
+        syntax_error(p, "out of memory");
+        return 0;
+    }
+    if (step.key) {
+        step.key_len = strlen(step.key);
+        step.key_hash = nbt_name_hash(step.key, step.key_len);
+    }
+    path->steps = grown;
+    path->steps[path->count++] = step;
+    return 1;
+}
+
+static QueryExpr* parse_or(QueryParser* p);
+
+static int parse_bracket(QueryParser* p, QueryPath* path) {
+    QueryStep step;
+    memset(&step, 0, sizeof(step));
+
+    skip_space(p);
+    if (peek(p) == '*') {
+        p->pos++;
+        step.kind = STEP_ALL_ELEMENTS;
+    } else if (peek(p) == '?') {
+        p->pos++;
+        step.kind = STEP_FILTER;
+        step.filter = parse_or(p);
+        if (!step.filter) return 0;
+    } else {
+        char* end = NULL;
+        long value;
+        errno = 0;
+        value = strtol(p->text + p->pos, &end, 10);
+        if (end == p->text + p->pos || errno || value < -2147483647L || value > 2147483647L) {
+            syntax_error(p, "expected an index, '*' or '?'");
+            return 0;
+        }
+        p->pos = (size_t)(end - p->text);
+        step.kind = STEP_INDEX;
+        step.index = (int)value;
+    }
+    if (!accept(p, "]")) {
+        free_expr(step.filter);
+        syntax_error(p, "expected ']'");
+        return 0;
+    }
+    return push_step(p, path, step);
+}
+
+/*
+ * Parses steps until a character that cannot continue a path. relative
+ * paths (predicates and projections) may start with '@' for the candidate.
+ */
+static int parse_path(QueryParser* p, QueryPath* path, int relative) {
+    int first = 1;
+
+    skip_space(p);
+    if (relative && peek(p) == '@') {
+        p->pos++;
+        first = 0;
+    } else if (!relative && peek(p) == '$') {
+        p->pos++;
+        first = 0;
+    }
+
+    while (!p->failed) {
+        QueryStep step;
+        char c;
+
+        if (!relative) skip_space(p);
+        c = peek(p);
+        memset(&step, 0, sizeof(step));
+
+        if (c == '.' && p->text[p->pos + 1] == '.') {
+            p->pos += 2;
+            if (peek(p) == '*') {
+                p->pos++;
+                step.kind = STEP_ANY_DESCENDANT;
+            } else {
+                step.kind = STEP_DESCENDANT;
+                if (!(step.key = parse_key(p, 1))) return 0;
+            }
+        } else if (c == '.' || c == '/' || (first && (c == '*' || c == '"' || c == '\'' || is_key_char(c, 1)))) {
+            if (c == '.' || c == '/') p->pos++;
+            if (peek(p) == '*') {
+                p->pos++;
+                step.kind = STEP_ANY_CHILD;
+            } else {
+                step.kind = STEP_CHILD;
+                if (!(step.key = parse_key(p, 1))) return 0;
+            }
+        } else if (c == '[') {
+            p->pos++;
+            if (!parse_bracket(p, path)) return 0;
+            first = 0;
+            continue;
+        } else {
+            break;
+        }
+
+        if (!push_step(p, path, step)) return 0;
+        first = 0;
+    }
+    if (relative && first) {
+        syntax_error(p, "expected a relative path or '@'");
+        return 0;
+    }
+    return !p->failed;
+}
+
+static int parse_operand(QueryParser* p, QueryOperand* out) {
+    char c;
+
+    memset(out, 0, sizeof(*out));
+    skip_space(p);
+    c = peek(p);
+
+    if (c == '"' || c == '\'') {
+        out->kind = OPERAND_STRING;
+        out->text = parse_quoted(p);
+        return out->text != NULL;
+    }
+    if (!strncmp(p->text + p->pos, "true", 4) && !is_key_char(p->text[p->pos + 4], 1)) {
+        p->pos += 4;
+        out->kind = OPERAND_NUMBER;
+        out->is_integer = 1;
+        out->integer = 1;
+        out->number = 1.0;
+        return 1;
+    }
+    if (!strncmp(p->text + p->pos, "false", 5) && !is_key_char(p->text[p->pos + 5], 1)) {
+        p->pos += 5;
+        out->kind = OPERAND_NUMBER;
+        out->is_integer = 1;
+        return 1;
+    }
+    if ((c >= '0' && c <= '9') || ((c == '-' || c == '+' || c == '.') &&
+        p->text[p->pos + 1] >= '0' && p->text[p->pos + 1] <= '9')) {
+        const char* start = p->text + p->pos;
+        char* end = NULL;
+        size_t len = strspn(start, "+-0123456789");
+
+        out->kind = OPERAND_NUMBER;
+        if (start[len] == '.' || start[len] == 'e' || start[len] == 'E') {
+            errno = 0;
+            out->number = strtod(start, &end);
+        } else {
+            errno = 0;
+            out->integer = strtoll(start, &end, 10);
+            out->number = (double)out->integer;
+            out->is_integer = 1;
+        }
+        if (errno || end == start) {
+            syntax_error(p, "number out of range");
+            return 0;
+        }
+        p->pos += (size_t)(end - start);
+        /* Accept SNBT type suffixes such as 5b or 2.5f. */
+        if (peek(p) && strchr("bBsSlLfFdD", peek(p)) && !is_key_char(p->text[p->pos + 1], 1)) p->pos++;
+        return 1;
+    }
+
+    out->kind = OPERAND_PATH;
+    return parse_path(p, &out->path, 1);
+}
+
+static QueryExpr* new_expr(QueryParser* p, QueryExprKind kind) {
+    QueryExpr* expr = calloc(1, sizeof(*expr));
+    if (!expr) syntax_error(p, "out of memory");
+    else expr->kind = kind;
+    return expr;
+}
+
+static QueryExpr* parse_unary(QueryParser* p) {
+    QueryExpr* expr;
+    static const struct {
+        const char* token;
+        QueryCompareOp op;
+    } ops[] = {
+        { "==", CMP_EQ }, { "!=", CMP_NE }, { "<=", CMP_LE },
+        { ">=", CMP_GE }, { "<", CMP_LT }, { ">", CMP_GT }
+    };
+
+    skip_space(p);
+    if (peek(p) == '!' && p->text[p->pos + 1] != '=') {
+        p->pos++;
+        expr = new_expr(p, EXPR_NOT);
+        if (!expr) return NULL;
+        expr->left = parse_unary(p);
+        if (!expr->left) {
+            free_expr(expr);
+            return NULL;
+        }
+        return expr;
+    }
+    if (peek(p) == '(') {
+        p->pos++;
+        expr = parse_or(p);
+        if (!expr) return NULL;
+        if (!accept(p, ")")) {
+            free_expr(expr);
+            syntax_error(p, "expected ')'");
+            return NULL;
+        }
+        return expr;
+    }
+
+    expr = new_expr(p, EXPR_EXISTS);
+    if (!expr) return NULL;
+    if (!parse_operand(p, &expr->a)) {
+        free_expr(expr);
+        return NULL;
+    }
+    skip_space(p);
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (accept(p, ops[i].token)) {
+            expr->kind = EXPR_COMPARE;
+            expr->op = ops[i].op;
+            if (!parse_operand(p, &expr->b)) {
+                free_expr(expr);
+                return NULL;
+            }
+            return expr;
+        }
+    }
+    if (expr->a.kind != OPERAND_PATH) {
+        free_expr(expr);
+        syntax_error(p, "a literal needs a comparison");
+        return NULL;
+    }
+    return expr;
+}
+
+static QueryExpr* parse_binary(QueryParser* p, const char* token, QueryExprKind kind, QueryExpr* (*operand)(QueryParser*)) {
+    QueryExpr* left = operand(p);
+    while (left && accept(p, token)) {
+        QueryExpr* joined = new_expr(p, kind);
+        if (!joined) {
+            free_expr(left);
+            return NULL;
+        }
+        joined->left = left;
+        joined->right = operand(p);
+        if (!joined->right) {
+            free_expr(joined);
+            return NULL;
+        }
+        left = joined;
+    }
+    return left;
+}
+
+static QueryExpr* parse_and(QueryParser* p) {
+    return parse_binary(p, "&&", EXPR_AND, parse_unary);
+}
+
+static QueryExpr* parse_or(QueryParser* p) {
+    return parse_binary(p, "||", EXPR_OR, parse_and);
+}
+
+static const char* default_alias(const QueryPath* path) {
+    for (int i = path->count - 1; i >= 0; i--) {
+        if (path->steps[i].key) return path->steps[i].key;
+    }
+    return "value";
+}
+
+static int parse_projection(QueryParser* p, NBTQuery* query) {
+    query->has_projection = 1;
+    if (accept(p, "}")) return 1;
+
+    do {
+        QueryField field;
+        QueryField* grown;
+        size_t rewind;
+
+        memset(&field, 0, sizeof(field));
+        skip_space(p);
+        rewind = p->pos;
+        if (peek(p) == '"' || peek(p) == '\'' || is_key_char(peek(p), 0)) {
+            field.alias = parse_key(p, 0);
+            if (!field.alias) return 0;
+            if (accept(p, ":")) {
+                rewind = p->pos;
+            } else {
+                free(field.alias);
+                field.alias = NULL;
+            }
+        }
+        p->pos = rewind;
+        if (!parse_path(p, &field.path, 1)) {
+            free(field.alias);
+            free_path(&field.path);
+            return 0;
+        }
+        if (!field.alias) field.alias = nbt_strdup(default_alias(&field.path));
+        grown = field.alias ? realloc(query->fields, (size_t)(query->field_count + 1) * sizeof(*grown)) : NULL;
+        if (!grown) {
+            free(field.alias);
+            free_path(&field.path);
+            syntax_error(p, "out of memory");
+            return 0;
+        }
+        query->fields = grown;
+        query->fields[query->field_count++] = field;
+    } while (accept(p, ","));
+
+    if (!accept(p, "}")) {
+        syntax_error(p, "expected ',' or '}' in projection");
+        return 0;
+    }
+    return 1;
+}
+
+NBTQuery* nbt_query_compile(const char* expression, char* err, size_t err_sz) {
+    QueryParser parser;
+    NBTQuery* query;
+
+    if (!expression) {
+        set_err(err, err_sz, "missing query expression");
+        return NULL;
+    }
+    query = calloc(1, sizeof(*query));
+    if (!query) {
+        set_err(err, err_sz, "out of memory");
+        return NULL;
+    }
+
+    memset(&parser, 0, sizeof(parser));
+    parser.text = expression;
+    parser.err = err;
+    parser.err_sz = err_sz;
+
+    if (parse_path(&parser, &query->path, 0) && accept(&parser, "{")) {
+        parse_projection(&parser, query);
+    }
+    skip_space(&parser);
+    if (!parser.failed && peek(&parser) != '\0') syntax_error(&parser, "unexpected character");
+    if (parser.failed) {
+        nbt_query_free(query);
+        return NULL;
+    }
+    return query;
+}
+
+/* ---- evaluation ---- */
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} PathBuffer;
+
+typedef struct QueryWalk QueryWalk;
+typedef int (*QueryVisitFn)(QueryWalk* walk, const NBTTag* node);
+
+struct QueryWalk {
+    QueryVisitFn visit;
+    PathBuffer* path;
+    int failed;
+    /* Main query state. */
+    const NBTQuery* query;
+    NBTQueryMatchFn fn;
+    void* user;
+    /* First-match state for predicate operands. */
+    const NBTTag* found;
+    NBTTag found_element;
+    /* Binary stream state for nbt_query_run_binary. */
+    const unsigned char* data;
+    size_t size;
+    NBTBinaryFormat format;
+    size_t depth;
+    int decode_failed;
+    char* err;
+    size_t err_sz;
+};
+
+typedef enum {
+    VALUE_MISSING = 0,
+    VALUE_NUMBER,
+    VALUE_STRING,
+    VALUE_OTHER
+} QueryValueKind;
+
+typedef struct {
+    QueryValueKind kind;
+    int is_integer;
+    int64_t integer;
+    double number;
+    const char* text;
+} QueryValue;
+
+static int path_reserve(QueryWalk* walk, size_t extra) {
+    PathBuffer* path = walk->path;
+    char* grown;
+    size_t cap;
+
+    if (path->len + extra + 1 <= path->cap) return 1;
+    cap = path->cap ? path->cap : 128;
+    while (cap < path->len + extra + 1) cap *= 2;
+    grown = realloc(path->data, cap);
+    if (!grown) {
+        walk->failed = 1;
+        return 0;
+    }
+    path->data = grown;
+    path->cap = cap;
+    return 1;
+}
+
+static int key_needs_quotes(const char* key, size_t len) {
+    if (len == 0) return 1;
+    for (size_t i = 0; i < len; i++) {
+        char c = key[i];
+        if (c == '/' || c == '[' || c == ']' || c == '"' || c == '\\' ||
+            c == '\n' || c == '\r' || c == '\t') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Appends one segment in edit-path syntax; returns the length to restore. */
+static size_t path_push_key_len(QueryWalk* walk, const char* key, size_t len) {
+    size_t mark;
+    PathBuffer* path = walk->path;
+
+    if (!path) return 0;
+    mark = path->len;
+    if (!path_reserve(walk, len * 2 + 3)) return mark;
+    if (path->len) path->data[path->len++] = '/';
+    if (!key_needs_quotes(key, len)) {
+        memcpy(path->data + path->len, key, len);
+        path->len += len;
+    } else {
+        path->data[path->len++] = '"';
+        for (size_t i = 0; i < len; i++) {
+            char c = key[i];
+            if (c == '"' || c == '\\') path->data[path->len++] = '\\';
+            else if (c == '\n' || c == '\r' || c == '\t') {
+                path->data[path->len++] = '\\';
+                c = c == '\n' ? 'n' : c == '\r' ? 'r' : 't';
+            }
+            path->data[path->len++] = c;
+        }
+        path->data[path->len++] = '"';
+    }
+    path->data[path->len] = '\0';
+    return mark;
+}
+
+static size_t path_push_key(QueryWalk* walk, const char* key) {
+    key = key ? key : "";
+    return path_push_key_len(walk, key, strlen(key));
+}
+
+static size_t path_push_index(QueryWalk* walk, int index) {
+    size_t mark;
+    PathBuffer* path = walk->path;
+
+    if (!path) return 0;
+    mark = path->len;
+    if (!path_reserve(walk, 16)) return mark;
+    path->len += (size_t)snprintf(path->data + path->len, path->cap - path->len, "[%d]", index);
+    return mark;
+}
+
+static void path_pop(QueryWalk* walk, size_t mark) {
+    if (!walk->path || !walk->path->data) return;
+    walk->path->len = mark;
+    walk->path->data[mark] = '\0';
+}
+
+static int array_length(const NBTTag* tag) {
+    switch (tag->type) {
+        case TAG_Byte_Array: return tag->value.byte_array.length;
+        case TAG_Int_Array: return tag->value.int_array.length;
+        case TAG_Long_Array: return tag->value.long_array.length;
+        default: return -1;
+    }
+}
+
+/* Presents one primitive array element as a temporary scalar tag. */
+static void array_element(const NBTTag* array, int index, NBTTag* out) {
+    memset(out, 0, sizeof(*out));
+    out->name = (char*)"";
+    if (array->type == TAG_Byte_Array) {
+        out->type = TAG_Byte;
+        out->value.byte_val = (int8_t)array->value.byte_array.data[index];
+    } else if (array->type == TAG_Int_Array) {
+        out->type = TAG_Int;
+        out->value.int_val = array->value.int_array.data[index];
+    } else {
+        out->type = TAG_Long;
+        out->value.long_val = array->value.long_array.data[index];
+    }
+}
+
+static int walk_steps(QueryWalk* walk, const QueryPath* path, int step, const NBTTag* node);
+static int eval_expr(const QueryExpr* expr, const NBTTag* node, int* failed);
+
+static int walk_child(QueryWalk* walk, const QueryPath* path, int step, const NBTTag* parent, int index) {
+    size_t mark;
+    int keep_going;
+
+    if (parent->type == TAG_Compound) {
+        const NBTTag* child = parent->value.compound.items[index];
+        if (!child) return 1;
+        mark = path_push_key(walk, child->name);
+        keep_going = walk_steps(walk, path, step, child);
+    } else if (parent->type == TAG_List) {
+        const NBTTag* child = parent->value.list.items[index];
+        if (!child) return 1;
+        mark = path_push_index(walk, index);
+        keep_going = walk_steps(walk, path, step, child);
+    } else {
+        NBTTag element;
+        array_element(parent, index, &element);
+        mark = path_push_index(walk, index);
+        keep_going = walk_steps(walk, path, step, &element);
+    }
+    path_pop(walk, mark);
+    return keep_going && !walk->failed;
+}
+
+static int child_count(const NBTTag* node) {
+    if (node->type == TAG_Compound) return node->value.compound.count;
+    if (node->type == TAG_List) return node->value.list.count;
+    return array_length(node);
+}
+
+/* Pre-order walk of every compound and list below node. */
+static int walk_descendants(QueryWalk* walk, const QueryPath* path, int step, const NBTTag* node) {
+    const QueryStep* s = &path->steps[step];
+    int count;
+
+    if (node->type != TAG_Compound && node->type != TAG_List) return 1;
+    count = child_count(node);
+    for (int i = 0; i < count; i++) {
+        const NBTTag* child = node->type == TAG_Compound ? node->value.compound.items[i] : node->value.list.items[i];
+        size_t mark;
+        int keep_going = 1;
+
+        if (!child) continue;
+        mark = node->type == TAG_Compound ? path_push_key(walk, child->name) : path_push_index(walk, i);
+        if (s->kind == STEP_ANY_DESCENDANT ||
+            (node->type == TAG_Compound && child->name && strcmp(child->name, s->key) == 0)) {
+            keep_going = walk_steps(walk, path, step + 1, child);
+        }
+        if (keep_going && !walk->failed) keep_going = walk_descendants(walk, path, step, child);
+        path_pop(walk, mark);
+        if (!keep_going || walk->failed) return 0;
+    }
+    return 1;
+}
+
+static int walk_steps(QueryWalk* walk, const QueryPath* path, int step, const NBTTag* node) {
+    const QueryStep* s;
+    int count;
+
+    if (walk->failed) return 0;
+    if (step == path->count) return walk->visit(walk, node);
+    s = &path->steps[step];
+
+    switch (s->kind) {
+        case STEP_CHILD: {
+            int index;
+            if (node->type != TAG_Compound) return 1;
+            index = nbt_compound_find_hashed(node, s->key, s->key_len, s->key_hash);
+            if (index < 0) return 1;
+            return walk_child(walk, path, step + 1, node, index);
+        }
+
+        case STEP_ANY_CHILD:
+        case STEP_ALL_ELEMENTS:
+            if (s->kind == STEP_ALL_ELEMENTS && node->type == TAG_Compound) return 1;
+            count = child_count(node);
+            for (int i = 0; i < count; i++) {
+                if (!walk_child(walk, path, step + 1, node, i)) return 0;
+            }
+            return 1;
+
+        case STEP_DESCENDANT:
+        case STEP_ANY_DESCENDANT:
+            return walk_descendants(walk, path, step, node);
+
+        case STEP_INDEX: {
+            int index = s->index;
+            if (node->type != TAG_List && array_length(node) < 0) return 1;
+            count = child_count(node);
+            if (index < 0) index += count;
+            if (index < 0 || index >= count) return 1;
+            return walk_child(walk, path, step + 1, node, index);
+        }
+
+        case STEP_FILTER:
+            if (node->type == TAG_List || array_length(node) >= 0) {
+                count = child_count(node);
+                for (int i = 0; i < count; i++) {
+                    NBTTag element;
+                    const NBTTag* candidate = node->type == TAG_List ? node->value.list.items[i] : &element;
+                    if (node->type != TAG_List) array_element(node, i, &element);
+                    if (!candidate || !eval_expr(s->filter, candidate, &walk->failed)) continue;
+                    if (!walk_child(walk, path, step + 1, node, i)) return 0;
+                }
+                return !walk->failed;
+            }
+            if (!eval_expr(s->filter, node, &walk->failed)) return !walk->failed;
+            return walk_steps(walk, path, step + 1, node);
+    }
+    return 1;
+}
+
+static int capture_first(QueryWalk* walk, const NBTTag* node) {
+    /* Array elements are stack temporaries; keep a shallow copy instead. */
+    walk->found_element = *node;
+    walk->found = &walk->found_element;
+    return 0;
+}
+
+static const NBTTag* first_match(const QueryPath* path, const NBTTag* node, NBTTag* storage, int* failed) {
+    QueryWalk walk;
+
+    if (path->count == 0) return node;
+    memset(&walk, 0, sizeof(walk));
+    walk.visit = capture_first;
+    walk_steps(&walk, path, 0, node);
+    if (walk.failed) *failed = 1;
+    if (!walk.found) return NULL;
+    *storage = walk.found_element;
+    return storage;
+}
+
+static QueryValue operand_value(const QueryOperand* operand, const NBTTag* node, int* failed) {
+    QueryValue value;
+    NBTTag storage;
+    const NBTTag* tag;
+
+    memset(&value, 0, sizeof(value));
+    if (operand->kind == OPERAND_NUMBER) {
+        value.kind = VALUE_NUMBER;
+        value.is_integer = operand->is_integer;
+        value.integer = operand->integer;
+        value.number = operand->number;
+        return value;
+    }
+    if (operand->kind == OPERAND_STRING) {
+        value.kind = VALUE_STRING;
+        value.text = operand->text;
+        return value;
+    }
+
+    tag = first_match(&operand->path, node, &storage, failed);
+    if (!tag) return value;
+    value.kind = VALUE_NUMBER;
+    value.is_integer = 1;
+    switch (tag->type) {
+        case TAG_Byte: value.integer = tag->value.byte_val; break;
+        case TAG_Short: value.integer = tag->value.short_val; break;
+        case TAG_Int: value.integer = tag->value.int_val; break;
+        case TAG_Long: value.integer = tag->value.long_val; break;
+        case TAG_Float:
+            value.is_integer = 0;
+            value.number = tag->value.float_val;
+            return value;
+        case TAG_Double:
+            value.is_integer = 0;
+            value.number = tag->value.double_val;
+            return value;
+        case TAG_String:
+            value.kind = VALUE_STRING;
+            value.text = tag->value.string_val ? tag->value.string_val : "";
+            return value;
+        default:
+            value.kind = VALUE_OTHER;
+            return value;
+    }
+    value.number = (double)value.integer;
+    return value;
+}
+
+static int compare_result(int order, QueryCompareOp op) {
+    switch (op) {
+        case CMP_EQ: return order == 0;
+        case CMP_NE: return order != 0;
+        case CMP_LT: return order < 0;
+        case CMP_LE: return order <= 0;
+        case CMP_GT: return order > 0;
+        case CMP_GE: return order >= 0;
+    }
+    return 0;
+}
+
+static int compare_values(const QueryValue* a, const QueryValue* b, QueryCompareOp op) {
+    int order;
+
+    if (a->kind == VALUE_MISSING || b->kind == VALUE_MISSING) return 0;
+    if (a->kind != b->kind || a->kind == VALUE_OTHER) return op == CMP_NE;
+    if (a->kind == VALUE_STRING) {
+        order = strcmp(a->text, b->text);
+    } else if (a->is_integer && b->is_integer) {
+        order = (a->integer > b->integer) - (a->integer < b->integer);
+    } else {
+        if (a->number != a->number || b->number != b->number) return op == CMP_NE;
+        order = (a->number > b->number) - (a->number < b->number);
+    }
+    return compare_result(order, op);
+}
+
+static int eval_expr(const QueryExpr* expr, const NBTTag* node, int* failed) {
+    switch (expr->kind) {
+        case EXPR_OR:
+            return eval_expr(expr->left, node, failed) || eval_expr(expr->right, node, failed);
+        case EXPR_AND:
+            return eval_expr(expr->left, node, failed) && eval_expr(expr->right, node, failed);
+        case EXPR_NOT:
+            return !eval_expr(expr->left, node, failed);
+        case EXPR_EXISTS: {
+            NBTTag storage;
+            return first_match(&expr->a.path, node, &storage, failed) != NULL;
+        }
+        case EXPR_COMPARE: {
+            QueryValue a = operand_value(&expr->a, node, failed);
+            QueryValue b = operand_value(&expr->b, node, failed);
+            return compare_values(&a, &b, expr->op);
+        }
+    }
+    return 0;
+}
+
+static NBTTag* project(const NBTQuery* query, const NBTTag* node, int* failed) {
+    NBTTag* result = nbt_tag_create(TAG_Compound, "");
+
+    if (!result) {
+        *failed = 1;
+        return NULL;
+    }
+    for (int i = 0; i < query->field_count; i++) {
+        const QueryField* field = &query->fields[i];
+        QueryWalk walk;
+        NBTTag* copy;
+
+        memset(&walk, 0, sizeof(walk));
+        walk.visit = capture_first;
+        if (field->path.count == 0) walk.found = node;
+        else walk_steps(&walk, &field->path, 0, node);
+        if (walk.failed) {
+            *failed = 1;
+            break;
+        }
+        if (!walk.found || nbt_compound_find_index(result, field->alias) >= 0) continue;
+
+        /* found may be a shallow copy of an array element; clone reads through it. */
+        copy = nbt_tag_clone(walk.found);
+        if (!copy || !nbt_tag_rename(copy, field->alias) || !nbt_compound_append(result, copy)) {
+            free_nbt_tree(copy);
+            walk.failed = 1;
+        }
+        if (walk.failed) {
+            *failed = 1;
+            break;
+        }
+    }
+    return result;
+}
+
+static int visit_match(QueryWalk* walk, const NBTTag* node) {
+    const char* path = walk->path && walk->path->data ? walk->path->data : "";
+    NBTTag* projected;
+    int keep_going;
+
+    if (!walk->query->has_projection) return walk->fn(node, path, walk->user);
+
+    projected = project(walk->query, node, &walk->failed);
+    if (!projected || walk->failed) {
+        free_nbt_tree(projected);
+        walk->failed = 1;
+        return 0;
+    }
+    keep_going = walk->fn(projected, path, walk->user);
+    free_nbt_tree(projected);
+    return keep_going;
+}
+
+int nbt_query_run(
+    const NBTQuery* query,
+    const NBTTag* root,
+    NBTQueryMatchFn fn,
+    void* user,
+    char* err,
+    size_t err_sz
+) {
+    QueryWalk walk;
+    PathBuffer path;
+
+    if (!query || !root || !fn) {
+        set_err(err, err_sz, "invalid query arguments");
+        return 0;
+    }
+
+    memset(&walk, 0, sizeof(walk));
+    memset(&path, 0, sizeof(path));
+    walk.visit = visit_match;
+    walk.path = &path;
+    walk.query = query;
+    walk.fn = fn;
+    walk.user = user;
+    if (path_reserve(&walk, 0)) path.data[0] = '\0';
+
+    walk_steps(&walk, &query->path, 0, root);
+    free(path.data);
+    if (walk.failed) {
+        set_err(err, err_sz, "out of memory while running query");
+        return 0;
+    }
+    return 1;
+}
+
+/* ---- streaming evaluation over binary NBT ---- */
+
+/* Same bound as the binary parser; the stream walk recurses per level. */
+#define QUERY_MAX_STREAM_DEPTH 512u
+
+typedef struct {
+    TagType type;
+    const char* name;
+    size_t name_len;
+    size_t payload;
+} StreamNode;
+
+static int stream_error(QueryWalk* walk, size_t offset, const char* message) {
+    if (!walk->failed && walk->err && walk->err_sz > 0) {
+        snprintf(walk->err, walk->err_sz, "%s at byte offset %zu", message, offset);
+    }
+    walk->failed = 1;
+    walk->decode_failed = 1;
+    return 0;
+}
+
+static int stream_read(QueryWalk* walk, size_t offset, size_t width, uint64_t* value) {
+    const unsigned char* bytes;
+    uint64_t result = 0;
+
+    if (offset > walk->size || width > walk->size - offset) {
+        return stream_error(walk, offset, "unexpected end of binary NBT");
+    }
+    bytes = walk->data + offset;
+    if (walk->format == NBT_BINARY_JAVA) {
+        for (size_t i = 0; i < width; i++) result = (result << 8) | bytes[i];
+    } else {
+        for (size_t i = width; i > 0; i--) result = (result << 8) | bytes[i - 1];
+    }
+    *value = result;
+    return 1;
+}
+
+/* Reads a compound entry header at offset; a TAG_End entry sets type to TAG_End. */
+static int stream_entry(QueryWalk* walk, size_t offset, StreamNode* node) {
+    uint64_t type;
+    uint64_t name_len;
+
+    memset(node, 0, sizeof(*node));
+    if (!stream_read(walk, offset, 1, &type)) return 0;
+    node->type = (TagType)type;
+    node->payload = offset + 1;
+    if (type == TAG_End) return 1;
+    if (type > TAG_Long_Array) return stream_error(walk, offset, "invalid NBT tag type");
+    if (!stream_read(walk, offset + 1, 2, &name_len)) return 0;
+    if (name_len > walk->size - (offset + 3)) return stream_error(walk, offset + 3, "unexpected end of binary NBT");
+    node->name = (const char*)walk->data + offset + 3;
+    node->name_len = (size_t)name_len;
+    node->payload = offset + 3 + (size_t)name_len;
+    return 1;
+}
+
+static int stream_skip(QueryWalk* walk, const StreamNode* node, size_t* end) {
+    if (!nbt_binary_skip_payload(walk->data, walk->size, node->payload, node->type, walk->format,
+                                 end, walk->err, walk->err_sz)) {
+        walk->failed = 1;
+        walk->decode_failed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+static NBTTag* stream_materialize(QueryWalk* walk, const StreamNode* node, size_t* end) {
+    char* name = malloc(node->name_len + 1);
+    NBTTag* tag;
+
+    if (!name) {
+        walk->failed = 1;
+        return NULL;
+    }
+    if (node->name_len) memcpy(name, node->name, node->name_len);
+    name[node->name_len] = '\0';
+    tag = nbt_binary_parse_payload_at(walk->data, walk->size, node->payload, node->type, name,
+                                      walk->format, end, walk->err, walk->err_sz);
+    free(name);
+    if (!tag) {
+        walk->failed = 1;
+        walk->decode_failed = 1;
+    }
+    return tag;
+}
+
+/* Element count and first element offset of a list or primitive array. */
+static int stream_sequence(QueryWalk* walk, const StreamNode* node, TagType* element_type, int32_t* count, size_t* first) {
+    uint64_t raw;
+    size_t header = node->type == TAG_List ? 5 : 4;
+
+    *element_type = node->type == TAG_Byte_Array ? TAG_Byte :
+                    node->type == TAG_Int_Array ? TAG_Int : TAG_Long;
+    if (node->type == TAG_List) {
+        if (!stream_read(walk, node->payload, 1, &raw)) return 0;
+        *element_type = (TagType)raw;
+        if (!stream_read(walk, node->payload + 1, 4, &raw)) return 0;
+    } else if (!stream_read(walk, node->payload, 4, &raw)) {
+        return 0;
+    }
+    *count = (int32_t)(uint32_t)raw;
+    if (*count < 0 || *element_type > TAG_Long_Array || (*count > 0 && *element_type == TAG_End)) {
+        return stream_error(walk, node->payload, "invalid list or array header");
+    }
+    *first = node->payload + header;
+    return 1;
+}
+
+static void stream_array_element(QueryWalk* walk, TagType element_type, size_t offset, NBTTag* out) {
+    uint64_t raw = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->name = (char*)"";
+    out->type = element_type;
+    if (element_type == TAG_Byte) {
+        stream_read(walk, offset, 1, &raw);
+        out->value.byte_val = (int8_t)(uint8_t)raw;
+    } else if (element_type == TAG_Int) {
+        stream_read(walk, offset, 4, &raw);
+        out->value.int_val = (int32_t)(uint32_t)raw;
+    } else {
+        stream_read(walk, offset, 8, &raw);
+        out->value.long_val = (int64_t)raw;
+    }
+}
+
+static int stream_walk(QueryWalk* walk, const QueryPath* path, int step, const StreamNode* node, size_t* end);
+
+static int stream_visit(QueryWalk* walk, const StreamNode* node, size_t* end) {
+    NBTTag* tag = stream_materialize(walk, node, end);
+    int keep_going;
+
+    if (!tag) return 0;
+    keep_going = walk->visit(walk, tag);
+    free_nbt_tree(tag);
+    return keep_going && !walk->failed;
+}
+
+/* Continues the remaining steps on a materialized candidate (filters). */
+static int stream_continue_tree(QueryWalk* walk, const QueryPath* path, int step, const StreamNode* node, size_t* end) {
+    NBTTag* tag = stream_materialize(walk, node, end);
+    int keep_going = 1;
+
+    if (!tag) return 0;
+    if (eval_expr(path->steps[step].filter, tag, &walk->failed) && !walk->failed) {
+        keep_going = walk_steps(walk, path, step + 1, tag);
+    }
+    free_nbt_tree(tag);
+    return keep_going && !walk->failed;
+}
+
+static int stream_compound_children(QueryWalk* walk, const QueryPath* path, int step, const StreamNode* node, size_t* end) {
+    const QueryStep* s = &path->steps[step];
+    size_t offset = node->payload;
+    int matched = 0;
+
+    while (1) {
+        StreamNode child;
+        size_t child_end;
+
+        if (!stream_entry(walk, offset, &child)) return 0;
+        if (child.type == TAG_End) {
+            *end = child.payload;
+            return 1;
+        }
+        if (s->kind == STEP_ANY_CHILD ||
+            (!matched && child.name_len == s->key_len && memcmp(child.name, s->key, s->key_len) == 0)) {
+            size_t mark = path_push_key_len(walk, child.name, child.name_len);
+            int keep_going = stream_walk(walk, path, step + 1, &child, &child_end);
+            path_pop(walk, mark);
+            if (!keep_going) return 0;
+            /* Compound lookups resolve to the first child with a name. */
+            matched = 1;
+        } else if (!stream_skip(walk, &child, &child_end)) {
+            return 0;
+        }
+        offset = child_end;
+    }
+}
+
+static int stream_sequence_children(QueryWalk* walk, const QueryPath* path, int step, const StreamNode* node, size_t* end) {
+    const QueryStep* s = &path->steps[step];
+    TagType element_type;
+    int32_t count;
+    size_t offset;
+    int selected = -1;
+
+    if (!stream_sequence(walk, node, &element_type, &count, &offset)) return 0;
+    if (s->kind == STEP_INDEX) {
+        selected = s->index < 0 ? s->index + count : s->index;
+        if (selected < 0 || selected >= count) selected = -2;
+    }
+
+    if (node->type != TAG_List) {
+        size_t width = element_type == TAG_Byte ? 1 : element_type == TAG_Int ? 4 : 8;
+        if ((size_t)count > (walk->size - offset) / width) {
+            return stream_error(walk, node->payload, "array exceeds remaining input");
+        }
+        *end = offset + (size_t)count * width;
+        for (int32_t i = 0; i < count; i++) {
+            NBTTag element;
+            size_t mark;
+            int keep_going = 1;
+
+            if (selected != -1 && i != selected) continue;
+            stream_array_element(walk, element_type, offset + (size_t)i * width, &element);
+            if (s->kind == STEP_FILTER && !eval_expr(s->filter, &element, &walk->failed)) continue;
+            mark = path_push_index(walk, i);
+            keep_going = walk_steps(walk, path, step + 1, &element);
+            path_pop(walk, mark);
+            if (!keep_going || walk->failed) return 0;
+        }
+        return 1;
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        StreamNode child;
+        size_t child_end;
+        size_t mark;
+        int keep_going;
+
+        memset(&child, 0, sizeof(child));
+        child.type = element_type;
+        child.name = "";
+        child.payload = offset;
+        if (selected != -1 && i != selected) {
+            if (!stream_skip(walk, &child, &child_end)) return 0;
+            offset = child_end;
+            continue;
+        }
+        mark = path_push_index(walk, i);
+        keep_going = s->kind == STEP_FILTER
+            ? stream_continue_tree(walk, path, step, &child, &child_end)
+            : stream_walk(walk, path, step + 1, &child, &child_end);
+        path_pop(walk, mark);
+        if (!keep_going) return 0;
+        offset = child_end;
+    }
+    *end = offset;
+    return 1;
+}
+
+/* Pre-order scan below node; every container is read exactly once unless a match re-enters it. */
+static int stream_descendants(QueryWalk* walk, const QueryPath* path, int step, const StreamNode* node, size_t* end) {
+    const QueryStep* s = &path->steps[step];
+    int ok = 1;
+
+    if (node->type != TAG_Compound && node->type != TAG_List) return stream_skip(walk, node, end);
+    if (++walk->depth > QUERY_MAX_STREAM_DEPTH) {
+        --walk->depth;
+        return stream_error(walk, node->payload, "binary NBT nesting depth limit exceeded");
+    }
+
+    if (node->type == TAG_Compound) {
+        size_t offset = node->payload;
+        while (ok) {
+            StreamNode child;
+            size_t child_end;
+            size_t mark;
+
+            if (!stream_entry(walk, offset, &child)) {
+                ok = 0;
+                break;
+            }
+            if (child.type == TAG_End) {
+                *end = child.payload;
+                break;
+            }
+            mark = path_push_key_len(walk, child.name, child.name_len);
+            if (s->kind == STEP_ANY_DESCENDANT ||
+                (child.name_len == s->key_len && memcmp(child.name, s->key, s->key_len) == 0)) {
+                ok = stream_walk(walk, path, step + 1, &child, &child_end);
+            }
+            if (ok) ok = stream_descendants(walk, path, step, &child, &child_end);
+            path_pop(walk, mark);
+            offset = child_end;
+        }
+    } else {
+        TagType element_type;
+        int32_t count;
+        size_t offset;
+
+        ok = stream_sequence(walk, node, &element_type, &count, &offset);
+        for (int32_t i = 0; ok && i < count; i++) {
+            StreamNode child;
+            size_t child_end;
+            size_t mark;
+
+            memset(&child, 0, sizeof(child));
+            child.type = element_type;
+            child.name = "";
+            child.payload = offset;
+            mark = path_push_index(walk, i);
+            if (s->kind == STEP_ANY_DESCENDANT) ok = stream_walk(walk, path, step + 1, &child, &child_end);
+            if (ok) ok = stream_descendants(walk, path, step, &child, &child_end);
+            path_pop(walk, mark);
+            offset = child_end;
+        }
+        if (ok) *end = offset;
+    }
+
+    --walk->depth;
+    return ok && !walk->failed;
+}
+
+static int stream_walk(QueryWalk* walk, const QueryPath* path, int step, const StreamNode* node, size_t* end) {
+    const QueryStep* s;
+
+    if (walk->failed) return 0;
+    if (step == path->count) return stream_visit(walk, node, end);
+    s = &path->steps[step];
+
+    switch (s->kind) {
+        case STEP_CHILD:
+        case STEP_ANY_CHILD:
+            if (node->type == TAG_Compound) return stream_compound_children(walk, path, step, node, end);
+            if (s->kind == STEP_ANY_CHILD && (node->type == TAG_List || node->type == TAG_Byte_Array ||
+                node->type == TAG_Int_Array || node->type == TAG_Long_Array)) {
+                return stream_sequence_children(walk, path, step, node, end);
+            }
+            return stream_skip(walk, node, end);
+
+        case STEP_INDEX:
+        case STEP_ALL_ELEMENTS:
+            if (node->type == TAG_List || node->type == TAG_Byte_Array ||
+                node->type == TAG_Int_Array || node->type == TAG_Long_Array) {
+                return stream_sequence_children(walk, path, step, node, end);
+            }
+            return stream_skip(walk, node, end);
+
+        case STEP_FILTER:
+            if (node->type == TAG_List || node->type == TAG_Byte_Array ||
+                node->type == TAG_Int_Array || node->type == TAG_Long_Array) {
+                return stream_sequence_children(walk, path, step, node, end);
+            }
+            return stream_continue_tree(walk, path, step, node, end);
+
+        case STEP_DESCENDANT:
+        case STEP_ANY_DESCENDANT:
+            return stream_descendants(walk, path, step, node, end);
+    }
+    return stream_skip(walk, node, end);
+}
+
+int nbt_query_run_binary(
+    const NBTQuery* query,
+    const unsigned char* data,
+    size_t size,
+    NBTBinaryFormat format,
+    NBTQueryMatchFn fn,
+    void* user,
+    char* err,
+    size_t err_sz
+) {
+    QueryWalk walk;
+    PathBuffer path;
+    StreamNode root;
+    size_t offset = 0;
+    size_t end = 0;
+
+    if (!query || !data || !fn ||
+        (format != NBT_BINARY_JAVA && format != NBT_BINARY_BEDROCK && format != NBT_BINARY_BEDROCK_LEVEL_DAT)) {
+        set_err(err, err_sz, "invalid query arguments");
+        return 0;
+    }
+    if (err && err_sz > 0) err[0] = '\0';
+
+    memset(&walk, 0, sizeof(walk));
+    memset(&path, 0, sizeof(path));
+    walk.visit = visit_match;
+    walk.path = &path;
+    walk.query = query;
+    walk.fn = fn;
+    walk.user = user;
+    walk.data = data;
+    walk.size = size;
+    walk.format = format;
+    walk.err = err;
+    walk.err_sz = err_sz;
+    if (format == NBT_BINARY_BEDROCK_LEVEL_DAT) {
+        /* Skip the storage version and payload length envelope. */
+        offset = 8;
+        walk.format = NBT_BINARY_BEDROCK;
+    }
+    if (path_reserve(&walk, 0)) path.data[0] = '\0';
+
+    if (stream_entry(&walk, offset, &root) && root.type == TAG_End) {
+        stream_error(&walk, offset, "unexpected TAG_End");
+    }
+    if (!walk.failed) stream_walk(&walk, &query->path, 0, &root, &end);
+    free(path.data);
+    if (walk.failed) {
+        if (!walk.decode_failed) set_err(err, err_sz, "out of memory while running query");
+        return 0;
+    }
+    return 1;
+}
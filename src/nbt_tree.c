@@ -144,16 +144,151 @@ fail:
     return NULL;
 }
 
-int nbt_compound_find_index(const NBTTag* compound, const char* name) {
+/* Compounds smaller than this are scanned linearly; a table does not pay
+ * for itself on the handful of keys most compounds carry. */
+#define COMPOUND_INDEX_MIN_COUNT 16
+
+typedef struct {
+    uint32_t hash;
+    int position;
+} CompoundIndexSlot;
+
+/*
+ * Open-addressed name table for one compound. It remembers the items array
+ * and count it describes, so a compound resized behind its back is detected
+ * and reindexed instead of answering from stale positions.
+ */
+struct NBTCompoundIndex {
+    NBTTag** items;
+    int count;
+    uint32_t mask;
+    CompoundIndexSlot* slots;
+};
+
+uint32_t nbt_name_hash(const char* name, size_t len) {
+    uint32_t hash = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int name_matches(const NBTTag* child, const char* name, size_t len) {
+    return child && child->name && child->name[0] == name[0] &&
+        strncmp(child->name, name, len) == 0 && child->name[len] == '\0';
+}
+
+void nbt_compound_invalidate_index(NBTTag* compound) {
+    struct NBTCompoundIndex* index;
+    if (!compound || compound->type != TAG_Compound) return;
+    index = compound->value.compound.index;
+    if (!index) return;
+    free(index->slots);
+    free(index);
+    compound->value.compound.index = NULL;
+}
+
+/* Position is the child's slot in items + 1 so that zero marks an empty slot.
+ * Duplicate names keep their first occurrence, like the linear scan. */
+static void index_add(struct NBTCompoundIndex* index, const char* name, uint32_t hash, int item) {
+    size_t len = strlen(name);
+    uint32_t slot = hash & index->mask;
+
+    while (index->slots[slot].position) {
+        const CompoundIndexSlot* used = &index->slots[slot];
+        if (used->hash == hash && name_matches(index->items[used->position - 1], name, len)) return;
+        slot = (slot + 1) & index->mask;
+    }
+    index->slots[slot].hash = hash;
+    index->slots[slot].position = item + 1;
+}
+
+static struct NBTCompoundIndex* build_index(NBTTag* compound) {
+    struct NBTCompoundIndex* index;
+    int count = compound->value.compound.count;
+    uint32_t capacity = 32;
+    int i;
+
+    while (capacity < (uint32_t)count * 2u) capacity *= 2u;
+    index = malloc(sizeof(*index));
+    if (!index) return NULL;
+    index->slots = calloc(capacity, sizeof(*index->slots));
+    if (!index->slots) {
+        free(index);
+        return NULL;
+    }
+    index->items = compound->value.compound.items;
+    index->count = count;
+    index->mask = capacity - 1u;
+    for (i = 0; i < count; i++) {
+        const NBTTag* child = index->items[i];
+        if (!child || !child->name) continue;
+        index_add(index, child->name, nbt_name_hash(child->name, strlen(child->name)), i);
+    }
+    return index;
+}
+
+/*
+ * The index is a cache, so building it from a const lookup is allowed; it
+ * means concurrent lookups on one shared tree need external locking.
+ */
+static const struct NBTCompoundIndex* compound_index(const NBTTag* compound) {
+    NBTTag* cache_owner = (NBTTag*)compound;
+    struct NBTCompoundIndex* index = compound->value.compound.index;
+
+    if (compound->value.compound.count < COMPOUND_INDEX_MIN_COUNT) {
+        if (index) nbt_compound_invalidate_index(cache_owner);
+        return NULL;
+    }
+    if (index && index->items == compound->value.compound.items &&
+        index->count == compound->value.compound.count) {
+        return index;
+    }
+    nbt_compound_invalidate_index(cache_owner);
+    cache_owner->value.compound.index = build_index(cache_owner);
+    return cache_owner->value.compound.index;
+}
+
+/* hash must be nbt_name_hash(name, len); it selects the index slot. */
+static int find_in_index(const struct NBTCompoundIndex* index, const char* name, size_t len, uint32_t hash) {
+    uint32_t slot = hash & index->mask;
+    while (index->slots[slot].position) {
+        const CompoundIndexSlot* used = &index->slots[slot];
+        if (used->hash == hash && name_matches(index->items[used->position - 1], name, len)) {
+            return used->position - 1;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    return -1;
+}
+
+static int find_linear(const NBTTag* compound, const char* name, size_t len) {
     int i;
-    if (!compound || compound->type != TAG_Compound || !name) return -1;
     for (i = 0; i < compound->value.compound.count; i++) {
-        const NBTTag* child = compound->value.compound.items[i];
-        if (child && child->name && strcmp(child->name, name) == 0) return i;
+        if (name_matches(compound->value.compound.items[i], name, len)) return i;
     }
     return -1;
 }
 
+int nbt_compound_find_hashed(const NBTTag* compound, const char* name, size_t len, uint32_t hash) {
+    const struct NBTCompoundIndex* index;
+    if (!compound || compound->type != TAG_Compound || !name) return -1;
+    index = compound_index(compound);
+    return index ? find_in_index(index, name, len, hash) : find_linear(compound, name, len);
+}
+
+/* Small compounds have no index, so their names are never hashed. */
+int nbt_compound_find_index(const NBTTag* compound, const char* name) {
+    const struct NBTCompoundIndex* index;
+    size_t len;
+    if (!compound || compound->type != TAG_Compound || !name) return -1;
+    len = strlen(name);
+    index = compound_index(compound);
+    return index ? find_in_index(index, name, len, nbt_name_hash(name, len)) : find_linear(compound, name, len);
+}
+
 int nbt_compound_insert(NBTTag* compound, int index, NBTTag* child) {
     int count;
     NBTTag** items;
@@ -170,6 +305,20 @@ int nbt_compound_insert(NBTTag* compound, int index, NBTTag* child) {
     }
     items[index] = child;
     compound->value.compound.count = count + 1;
+
+    if (compound->value.compound.index) {
+        struct NBTCompoundIndex* name_index = compound->value.compound.index;
+        /* Appends keep the table in place until it is half full; anything
+         * that shifts positions rebuilds it on the next lookup. */
+        if (index == count && name_index->count == count &&
+            (uint32_t)(count + 1) * 2u <= name_index->mask + 1u) {
+            name_index->items = items;
+            name_index->count = count + 1;
+            if (child->name) index_add(name_index, child->name, nbt_name_hash(child->name, strlen(child->name)), index);
+        } else {
+            nbt_compound_invalidate_index(compound);
+        }
+    }
     return 1;
 }
 
@@ -185,6 +334,7 @@ NBTTag* nbt_compound_take(NBTTag* compound, int index) {
     count = compound->value.compound.count;
     if (index < 0 || index >= count) return NULL;
     child = compound->value.compound.items[index];
+    nbt_compound_invalidate_index(compound);
     if (index < count - 1) {
         memmove(
             &compound->value.compound.items[index],
@@ -258,3 +408,10 @@ int nbt_tag_rename(NBTTag* tag, const char* new_name) {
     tag->name = replacement;
     return 1;
 }
+
+int nbt_compound_rename_child(NBTTag* compound, NBTTag* child, const char* new_name) {
+    if (!compound || compound->type != TAG_Compound) return 0;
+    if (!nbt_tag_rename(child, new_name)) return 0;
+    nbt_compound_invalidate_index(compound);
+    return 1;
+}
@@ -11,9 +11,15 @@
 #ifdef _WIN32
 #include <fcntl.h>
 #include <io.h>
+#include <process.h>
 #include <wchar.h>
 #include <windows.h>
 #else
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include <unistd.h>
 #endif
 
@@ -369,3 +375,468 @@ int nbt_fileno(FILE* stream) {
     return fileno(stream);
 #endif
 }
+
+int nbt_fseek64(FILE* stream, uint64_t offset) {
+    if (!stream) return 0;
+#ifdef _WIN32
+    if (offset > (uint64_t)INT64_MAX) return 0;
+    return _fseeki64(stream, (__int64)offset, SEEK_SET) == 0;
+#else
+    if ((uint64_t)(off_t)offset != offset || (off_t)offset < 0) return 0;
+    return fseeko(stream, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+int nbt_file_size(FILE* stream, uint64_t* out_size) {
+#ifdef _WIN32
+    __int64 position;
+#else
+    off_t position;
+#endif
+
+    if (!stream || !out_size) return 0;
+#ifdef _WIN32
+    if (_fseeki64(stream, 0, SEEK_END) != 0) return 0;
+    position = _ftelli64(stream);
+#else
+    if (fseeko(stream, 0, SEEK_END) != 0) return 0;
+    position = ftello(stream);
+#endif
+    if (position < 0) return 0;
+    *out_size = (uint64_t)position;
+    return nbt_fseek64(stream, 0);
+}
+
+unsigned char* nbt_read_file(const char* path, size_t* out_size, char* err, size_t err_sz) {
+    enum { READ_CHUNK = 16384 };
+    FILE* file;
+    unsigned char* buffer = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    if (out_size) *out_size = 0;
+    file = nbt_fopen(path, "rb");
+    if (!file) {
+        if (err && err_sz > 0) {
+            snprintf(err, err_sz, "fopen(%s) failed: %s", path, strerror(errno));
+        }
+        return NULL;
+    }
+
+    while (1) {
+        size_t read_count;
+
+        if (size == capacity) {
+            unsigned char* grown;
+            if (capacity > SIZE_MAX - READ_CHUNK) {
+                set_err(err, err_sz, "input file too large");
+                free(buffer);
+                fclose(file);
+                return NULL;
+            }
+            grown = realloc(buffer, capacity + READ_CHUNK);
+            if (!grown) {
+                set_err(err, err_sz, "out of memory");
+                free(buffer);
+                fclose(file);
+                return NULL;
+            }
+            buffer = grown;
+            capacity += READ_CHUNK;
+        }
+
+        read_count = fread(buffer + size, 1, capacity - size, file);
+        size += read_count;
+        if (read_count == 0) {
+            if (ferror(file)) {
+                set_err(err, err_sz, "failed to read input file");
+                free(buffer);
+                fclose(file);
+                return NULL;
+            }
+            break;
+        }
+    }
+
+    fclose(file);
+    if (out_size) *out_size = size;
+    return buffer;
+}
+
+int nbt_fsync_file(FILE* stream) {
+    if (!stream || fflush(stream) != 0) return 0;
+#ifdef _WIN32
+    return _commit(_fileno(stream)) == 0;
+#else
+    return fsync(fileno(stream)) == 0;
+#endif
+}
+
+int nbt_sync_parent_directory(const char* path) {
+#ifdef _WIN32
+    /* MoveFileEx(MOVEFILE_WRITE_THROUGH) already flushes the rename. */
+    (void)path;
+    return 1;
+#else
+    const char* separator;
+    char* directory;
+    int fd;
+    int ok;
+
+    if (!path) return 0;
+    separator = last_path_separator(path);
+    if (!separator) {
+        directory = nbt_strdup(".");
+    } else {
+        size_t length = separator == path ? 1U : (size_t)(separator - path);
+        directory = malloc(length + 1);
+        if (directory) {
+            memcpy(directory, path, length);
+            directory[length] = '\0';
+        }
+    }
+    if (!directory) return 0;
+
+    fd = open(directory, O_RDONLY);
+    free(directory);
+    if (fd < 0) return 0;
+    /* Some file systems cannot sync directories; their renames are already durable. */
+    ok = fsync(fd) == 0 || errno == EINVAL || errno == EBADF;
+    close(fd);
+    return ok;
+#endif
+}
+
+int nbt_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 && count < 1024 ? (int)count : 1;
+#else
+    return 1;
+#endif
+}
+
+int nbt_is_directory(const char* path) {
+    if (!path) return 0;
+#ifdef _WIN32
+    {
+        wchar_t* wide_path = utf8_to_wide(path);
+        DWORD attributes;
+
+        if (!wide_path) return 0;
+        attributes = GetFileAttributesW(wide_path);
+        free(wide_path);
+        return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    }
+#else
+    {
+        struct stat info;
+        return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+    }
+#endif
+}
+
+int nbt_make_directory(const char* path) {
+    if (!path) return 0;
+    if (nbt_is_directory(path)) return 1;
+#ifdef _WIN32
+    {
+        wchar_t* wide_path = utf8_to_wide(path);
+        BOOL created;
+
+        if (!wide_path) return 0;
+        created = CreateDirectoryW(wide_path, NULL);
+        free(wide_path);
+        return created || GetLastError() == ERROR_ALREADY_EXISTS;
+    }
+#else
+    return mkdir(path, 0777) == 0 || errno == EEXIST;
+#endif
+}
+
+int nbt_list_directory(
+    const char* directory,
+    NBTDirectoryEntryFn fn,
+    void* user,
+    char* err,
+    size_t err_sz
+) {
+    if (!directory || !fn) {
+        set_err(err, err_sz, "invalid directory listing arguments");
+        return 0;
+    }
+
+#ifdef _WIN32
+    {
+        size_t length = strlen(directory);
+        char* pattern = malloc(length + 3);
+        wchar_t* wide_pattern;
+        WIN32_FIND_DATAW entry;
+        HANDLE handle;
+        int keep_going = 1;
+
+        if (!pattern) {
+            set_err(err, err_sz, "out of memory");
+            return 0;
+        }
+        memcpy(pattern, directory, length);
+        if (length > 0 && directory[length - 1] != '/' && directory[length - 1] != '\\') {
+            pattern[length++] = '\\';
+        }
+        pattern[length++] = '*';
+        pattern[length] = '\0';
+        wide_pattern = utf8_to_wide(pattern);
+        free(pattern);
+        if (!wide_pattern) {
+            set_err(err, err_sz, "directory path is not valid UTF-8");
+            return 0;
+        }
+        handle = FindFirstFileW(wide_pattern, &entry);
+        free(wide_pattern);
+        if (handle == INVALID_HANDLE_VALUE) {
+            set_windows_err(err, err_sz, "FindFirstFile", GetLastError());
+            return 0;
+        }
+        do {
+            char* name;
+            if (!wcscmp(entry.cFileName, L".") || !wcscmp(entry.cFileName, L"..")) continue;
+            name = wide_to_utf8(entry.cFileName);
+            if (!name) continue;
+            keep_going = fn(name, user);
+            free(name);
+        } while (keep_going && FindNextFileW(handle, &entry));
+        FindClose(handle);
+        return 1;
+    }
+#else
+    {
+        DIR* handle = opendir(directory);
+        struct dirent* entry;
+
+        if (!handle) {
+            if (err && err_sz > 0) {
+                snprintf(err, err_sz, "opendir(%s) failed: %s", directory, strerror(errno));
+            }
+            return 0;
+        }
+        while ((entry = readdir(handle)) != NULL) {
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) continue;
+            if (!fn(entry->d_name, user)) break;
+        }
+        closedir(handle);
+        return 1;
+    }
+#endif
+}
+
+typedef struct {
+    NBTTaskFn fn;
+    void* task;
+} NBTQueuedTask;
+
+struct NBTWorkQueue {
+    int max_workers;
+    int worker_count;
+    int closing;
+    int failed;
+    size_t head;
+    size_t count;
+    size_t capacity;
+    NBTQueuedTask* tasks;
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE ready;
+    HANDLE* workers;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_t* workers;
+#endif
+};
+
+static void queue_lock(NBTWorkQueue* queue) {
+#ifdef _WIN32
+    EnterCriticalSection(&queue->lock);
+#else
+    pthread_mutex_lock(&queue->lock);
+#endif
+}
+
+static void queue_unlock(NBTWorkQueue* queue) {
+#ifdef _WIN32
+    LeaveCriticalSection(&queue->lock);
+#else
+    pthread_mutex_unlock(&queue->lock);
+#endif
+}
+
+static void queue_run_worker(NBTWorkQueue* queue) {
+    while (1) {
+        NBTQueuedTask item;
+
+        queue_lock(queue);
+        while (queue->head == queue->count && !queue->closing) {
+#ifdef _WIN32
+            SleepConditionVariableCS(&queue->ready, &queue->lock, INFINITE);
+#else
+            pthread_cond_wait(&queue->ready, &queue->lock);
+#endif
+        }
+        if (queue->head == queue->count) {
+            queue_unlock(queue);
+            return;
+        }
+        item = queue->tasks[queue->head++];
+        queue_unlock(queue);
+
+        if (!item.fn(item.task)) {
+            queue_lock(queue);
+            queue->failed = 1;
+            queue_unlock(queue);
+        }
+    }
+}
+
+#ifdef _WIN32
+static unsigned __stdcall queue_worker_main(void* argument) {
+    queue_run_worker(argument);
+    return 0;
+}
+#else
+static void* queue_worker_main(void* argument) {
+    queue_run_worker(argument);
+    return NULL;
+}
+#endif
+
+/* Called with the lock held. */
+static int queue_spawn_worker(NBTWorkQueue* queue) {
+#ifdef _WIN32
+    uintptr_t handle = _beginthreadex(NULL, 0, queue_worker_main, queue, 0, NULL);
+    if (handle == 0) return 0;
+    queue->workers[queue->worker_count++] = (HANDLE)handle;
+#else
+    if (pthread_create(&queue->workers[queue->worker_count], NULL, queue_worker_main, queue) != 0) return 0;
+    queue->worker_count++;
+#endif
+    return 1;
+}
+
+NBTWorkQueue* nbt_work_queue_create(int max_workers) {
+    NBTWorkQueue* queue = calloc(1, sizeof(*queue));
+
+    if (!queue) return NULL;
+    queue->max_workers = max_workers > 0 ? max_workers : 0;
+    if (queue->max_workers > 0) {
+        queue->workers = calloc((size_t)queue->max_workers, sizeof(*queue->workers));
+        if (!queue->workers) {
+            free(queue);
+            return NULL;
+        }
+    }
+#ifdef _WIN32
+    InitializeCriticalSection(&queue->lock);
+    InitializeConditionVariable(&queue->ready);
+#else
+    if (pthread_mutex_init(&queue->lock, NULL) != 0) {
+        free(queue->workers);
+        free(queue);
+        return NULL;
+    }
+    if (pthread_cond_init(&queue->ready, NULL) != 0) {
+        pthread_mutex_destroy(&queue->lock);
+        free(queue->workers);
+        free(queue);
+        return NULL;
+    }
+#endif
+    return queue;
+}
+
+void nbt_work_queue_submit(NBTWorkQueue* queue, NBTTaskFn fn, void* task) {
+    int run_inline = 0;
+
+    if (!fn) return;
+    if (!queue) {
+        fn(task);
+        return;
+    }
+
+    queue_lock(queue);
+    if (queue->head == queue->count) {
+        queue->head = 0;
+        queue->count = 0;
+    }
+    if (queue->count == queue->capacity) {
+        size_t capacity = queue->capacity ? queue->capacity * 2 : 16;
+        NBTQueuedTask* grown = realloc(queue->tasks, capacity * sizeof(*grown));
+        if (grown) {
+            queue->tasks = grown;
+            queue->capacity = capacity;
+        }
+    }
+    if (queue->count == queue->capacity) {
+        run_inline = 1;
+    } else {
+        queue->tasks[queue->count].fn = fn;
+        queue->tasks[queue->count].task = task;
+        queue->count++;
+        if (queue->worker_count < queue->max_workers) queue_spawn_worker(queue);
+        if (queue->worker_count == 0) {
+            queue->count--;
+            run_inline = 1;
+        }
+    }
+#ifdef _WIN32
+    WakeConditionVariable(&queue->ready);
+#else
+    pthread_cond_signal(&queue->ready);
+#endif
+    queue_unlock(queue);
+
+    if (run_inline && !fn(task)) {
+        queue_lock(queue);
+        queue->failed = 1;
+        queue_unlock(queue);
+    }
+}
+
+int nbt_work_queue_finish(NBTWorkQueue* queue) {
+    int index;
+    int ok;
+
+    if (!queue) return 1;
+    queue_lock(queue);
+    queue->closing = 1;
+#ifdef _WIN32
+    WakeAllConditionVariable(&queue->ready);
+#else
+    pthread_cond_broadcast(&queue->ready);
+#endif
+    queue_unlock(queue);
+
+    for (index = 0; index < queue->worker_count; index++) {
+#ifdef _WIN32
+        WaitForSingleObject(queue->workers[index], INFINITE);
+        CloseHandle(queue->workers[index]);
+#else
+        pthread_join(queue->workers[index], NULL);
+#endif
+    }
+
+    ok = !queue->failed;
+#ifdef _WIN32
+    DeleteCriticalSection(&queue->lock);
+#else
+    pthread_cond_destroy(&queue->ready);
+    pthread_mutex_destroy(&queue->lock);
+#endif
+    free(queue->workers);
+    free(queue->tasks);
+    free(queue);
+    return ok;
+}
@@ -0,0 +1,526 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "platform.h"
+#include "region_index.h"
+
+#define REGION_INDEX_VERSION 1U
+#define REGION_INDEX_PREAMBLE_BYTES 32U
+#define REGION_INDEX_ENTRY_BYTES 24U
+#define REGION_INDEX_FILE_BYTES \
+    (REGION_INDEX_PREAMBLE_BYTES + REGION_INDEX_ENTRY_BYTES * REGION_CHUNK_COUNT + 8U)
+
+static const unsigned char REGION_INDEX_MAGIC[8] = {'C', 'N', 'B', 'T', 'R', 'I', 'D', 'X'};
+
+#define XXH64_PRIME1 0x9E3779B185EBCA87ULL
+#define XXH64_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define XXH64_PRIME3 0x165667B19E3779F9ULL
+#define XXH64_PRIME4 0x85EBCA77C2B2AE63ULL
+#define XXH64_PRIME5 0x27D4EB2F165667C5ULL
+
+static void set_err(char* err, size_t err_sz, const char* msg) {
+    if (err && err_sz > 0) snprintf(err, err_sz, "%s", msg);
+}
+
+static void set_chunk_err(char* err, size_t err_sz, int index, const char* msg) {
+    if (err && err_sz > 0) {
+        snprintf(err, err_sz, "corrupt region file: chunk (%d, %d) %s",
+                 index % REGION_CHUNK_GRID, index / REGION_CHUNK_GRID, msg);
+    }
+}
+
+static uint32_t read_be_u32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) |
+           ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) |
+           (uint32_t)p[3];
+}
+
+static uint32_t read_le_u32(const unsigned char* p) {
+    return (uint32_t)p[0] |
+           ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static uint64_t read_le_u64(const unsigned char* p) {
+    return (uint64_t)read_le_u32(p) | ((uint64_t)read_le_u32(p + 4) << 32);
+}
+
+static void write_le_u32(unsigned char* p, uint32_t value) {
+    p[0] = (unsigned char)(value & 0xFFU);
+    p[1] = (unsigned char)((value >> 8) & 0xFFU);
+    p[2] = (unsigned char)((value >> 16) & 0xFFU);
+    p[3] = (unsigned char)((value >> 24) & 0xFFU);
+}
+
+static void write_le_u64(unsigned char* p, uint64_t value) {
+    write_le_u32(p, (uint32_t)(value & 0xFFFFFFFFU));
+    write_le_u32(p + 4, (uint32_t)(value >> 32));
+}
+
+static uint64_t rotate_left_u64(uint64_t value, unsigned int count) {
+    return (value << count) | (value >> (64U - count));
+}
+
+static uint64_t xxhash64_round(uint64_t accumulator, uint64_t lane) {
+    accumulator += lane * XXH64_PRIME2;
+    accumulator = rotate_left_u64(accumulator, 31U);
+    return accumulator * XXH64_PRIME1;
+}
+
+static uint64_t xxhash64_merge(uint64_t hash, uint64_t lane) {
+    hash ^= xxhash64_round(0, lane);
+    return hash * XXH64_PRIME1 + XXH64_PRIME4;
+}
+
+uint64_t region_index_hash(const void* data, size_t size, uint64_t seed) {
+    static const unsigned char empty = 0;
+    const unsigned char* cursor = data ? (const unsigned char*)data : &empty;
+    const unsigned char* end;
+    uint64_t hash;
+
+    if (!data) size = 0;
+    end = cursor + size;
+
+    if (size >= 32U) {
+        const unsigned char* limit = end - 32U;
+        uint64_t v1 = seed + XXH64_PRIME1 + XXH64_PRIME2;
+        uint64_t v2 = seed + XXH64_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH64_PRIME1;
+
+        do {
+            v1 = xxhash64_round(v1, read_le_u64(cursor));
+            v2 = xxhash64_round(v2, read_le_u64(cursor + 8));
+            v3 = xxhash64_round(v3, read_le_u64(cursor + 16));
+            v4 = xxhash64_round(v4, read_le_u64(cursor + 24));
+            cursor += 32;
+        } while (cursor <= limit);
+
+        hash = rotate_left_u64(v1, 1U) + rotate_left_u64(v2, 7U) +
+               rotate_left_u64(v3, 12U) + rotate_left_u64(v4, 18U);
+        hash = xxhash64_merge(hash, v1);
+        hash = xxhash64_merge(hash, v2);
+        hash = xxhash64_merge(hash, v3);
+        hash = xxhash64_merge(hash, v4);
+    } else {
+        hash = seed + XXH64_PRIME5;
+    }
+
+    hash += (uint64_t)size;
+    while ((size_t)(end - cursor) >= 8U) {
+        hash ^= xxhash64_round(0, read_le_u64(cursor));
+        hash = rotate_left_u64(hash, 27U) * XXH64_PRIME1 + XXH64_PRIME4;
+        cursor += 8;
+    }
+    if ((size_t)(end - cursor) >= 4U) {
+        hash ^= (uint64_t)read_le_u32(cursor) * XXH64_PRIME1;
+        hash = rotate_left_u64(hash, 23U) * XXH64_PRIME2 + XXH64_PRIME3;
+        cursor += 4;
+    }
+    while (cursor < end) {
+        hash ^= (uint64_t)(*cursor++) * XXH64_PRIME5;
+        hash = rotate_left_u64(hash, 11U) * XXH64_PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH64_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXH64_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+char* region_index_path(const char* region_path) {
+    size_t path_len;
+    size_t suffix_len = sizeof(REGION_INDEX_SUFFIX) - 1U;
+    char* path;
+
+    if (!region_path) return NULL;
+    path_len = strlen(region_path);
+    if (path_len > SIZE_MAX - suffix_len - 1U) return NULL;
+    path = malloc(path_len + suffix_len + 1U);
+    if (!path) return NULL;
+    memcpy(path, region_path, path_len);
+    memcpy(path + path_len, REGION_INDEX_SUFFIX, suffix_len + 1U);
+    return path;
+}
+
+int region_index_load(const char* index_path, RegionIndex* out_index, char* err, size_t err_sz) {
+    FILE* probe;
+    unsigned char* data;
+    size_t size = 0;
+    uint32_t layout;
+    int i;
+
+    if (!index_path || !out_index) {
+        set_err(err, err_sz, "invalid region index arguments");
+        return -1;
+    }
+    memset(out_index, 0, sizeof(*out_index));
+
+    probe = nbt_fopen(index_path, "rb");
+    if (!probe) {
+        if (errno == ENOENT) return 0;
+        if (err && err_sz > 0) snprintf(err, err_sz, "fopen(%s) failed: %s", index_path, strerror(errno));
+        return -1;
+    }
+    fclose(probe);
+
+    data = nbt_read_file(index_path, &size, err, err_sz);
+    if (!data) return -1;
+
+    if (size != REGION_INDEX_FILE_BYTES || memcmp(data, REGION_INDEX_MAGIC, sizeof(REGION_INDEX_MAGIC)) != 0) {
+        set_err(err, err_sz, "region index has an unrecognized layout");
+        free(data);
+        return -1;
+    }
+    if (read_le_u32(data + 8) != REGION_INDEX_VERSION) {
+        set_err(err, err_sz, "region index version is not supported");
+        free(data);
+        return -1;
+    }
+    if (region_index_hash(data, size - 8U, 0) != read_le_u64(data + size - 8U)) {
+        set_err(err, err_sz, "region index checksum mismatch");
+        free(data);
+        return -1;
+    }
+
+    layout = read_le_u32(data + 12);
+    if (layout != REGION_LAYOUT_STANDARD && layout != REGION_LAYOUT_CUBIC_R2) {
+        set_err(err, err_sz, "region index names an unknown region layout");
+        free(data);
+        return -1;
+    }
+    out_index->layout = (RegionLayout)layout;
+    out_index->file_size = read_le_u64(data + 16);
+    out_index->header_fingerprint = read_le_u64(data + 24);
+    for (i = 0; i < REGION_CHUNK_COUNT; i++) {
+        const unsigned char* p = data + REGION_INDEX_PREAMBLE_BYTES + (size_t)i * REGION_INDEX_ENTRY_BYTES;
+        RegionIndexEntry* entry = &out_index->entries[i];
+        entry->location = read_le_u32(p);
+        entry->timestamp = read_le_u32(p + 4);
+        entry->stored_length = read_le_u32(p + 8);
+        entry->external = read_le_u32(p + 12);
+        entry->hash = read_le_u64(p + 16);
+    }
+
+    free(data);
+    return 1;
+}
+
+int region_index_save(const char* index_path, const RegionIndex* index, char* err, size_t err_sz) {
+    unsigned char* data;
+    char* temp_path = NULL;
+    FILE* out;
+    int fd;
+    int i;
+
+    if (!index_path || !index) {
+        set_err(err, err_sz, "invalid region index arguments");
+        return 0;
+    }
+
+    data = calloc(1, REGION_INDEX_FILE_BYTES);
+    if (!data) {
+        set_err(err, err_sz, "out of memory");
+        return 0;
+    }
+    memcpy(data, REGION_INDEX_MAGIC, sizeof(REGION_INDEX_MAGIC));
+    write_le_u32(data + 8, REGION_INDEX_VERSION);
+    write_le_u32(data + 12, (uint32_t)index->layout);
+    write_le_u64(data + 16, index->file_size);
+    write_le_u64(data + 24, index->header_fingerprint);
+    for (i = 0; i < REGION_CHUNK_COUNT; i++) {
+        unsigned char* p = data + REGION_INDEX_PREAMBLE_BYTES + (size_t)i * REGION_INDEX_ENTRY_BYTES;
+        const RegionIndexEntry* entry = &index->entries[i];
+        write_le_u32(p, entry->location);
+        write_le_u32(p + 4, entry->timestamp);
+        write_le_u32(p + 8, entry->stored_length);
+        write_le_u32(p + 12, entry->external);
+        write_le_u64(p + 16, entry->hash);
+    }
+    write_le_u64(data + REGION_INDEX_FILE_BYTES - 8U,
+                 region_index_hash(data, REGION_INDEX_FILE_BYTES - 8U, 0));
+
+    fd = nbt_open_temp_file(index_path, "index", &temp_path, err, err_sz);
+    if (fd < 0) {
+        free(data);
+        return 0;
+    }
+    if (nbt_close_fd(fd) != 0) {
+        set_err(err, err_sz, "failed to close temporary index file");
+        goto fail;
+    }
+
+    out = nbt_fopen(temp_path, "wb");
+    if (!out) {
+        if (err && err_sz > 0) snprintf(err, err_sz, "fopen(%s) failed: %s", temp_path, strerror(errno));
+        goto fail;
+    }
+    if (fwrite(data, 1, REGION_INDEX_FILE_BYTES, out) != REGION_INDEX_FILE_BYTES) {
+        set_err(err, err_sz, "failed to write region index");
+        fclose(out);
+        goto fail;
+    }
+    if (fclose(out) != 0) {
+        set_err(err, err_sz, "failed to close region index");
+        goto fail;
+    }
+    if (!nbt_replace_file(temp_path, index_path, err, err_sz)) goto fail;
+
+    free(temp_path);
+    free(data);
+    return 1;
+
+fail:
+    nbt_remove_file(temp_path);
+    free(temp_path);
+    free(data);
+    return 0;
+}
+
+static int hash_external_chunk(
+    const char* region_path,
+    int index,
+    uint64_t* hash,
+    uint64_t* bytes_hashed,
+    char* err,
+    size_t err_sz
+) {
+    char* external_path;
+    unsigned char* payload;
+    size_t payload_size = 0;
+
+    external_path = region_external_chunk_path(region_path, index % REGION_CHUNK_GRID, index / REGION_CHUNK_GRID);
+    if (!external_path) {
+        set_err(err, err_sz, "external chunk requires a conventional r.<x>.<z>.mca/.mcr filename");
+        return 0;
+    }
+    payload = nbt_read_file(external_path, &payload_size, err, err_sz);
+    free(external_path);
+    if (!payload) return 0;
+
+    *hash = region_index_hash(payload, payload_size, *hash);
+    *bytes_hashed += payload_size;
+    free(payload);
+    return 1;
+}
+
+int region_index_verify(
+    const char* region_path,
+    const RegionIndex* previous,
+    int full_rehash,
+    RegionIndex* out_index,
+    RegionVerifyReport* report,
+    char* err,
+    size_t err_sz
+) {
+    RegionVerifyReport local_report;
+    unsigned char header[REGION_HEADER_BYTES];
+    unsigned char* record = NULL;
+    size_t record_capacity = 0;
+    uint8_t* sector_used = NULL;
+    uint64_t file_size = 0;
+    uint64_t total_sectors;
+    uint32_t sector_bytes;
+    uint32_t header_sectors;
+    FILE* file;
+    int i;
+
+    if (!region_path || !out_index) {
+        set_err(err, err_sz, "invalid region verification arguments");
+        return 0;
+    }
+    if (!report) report = &local_report;
+    memset(report, 0, sizeof(*report));
+    memset(out_index, 0, sizeof(*out_index));
+
+    file = nbt_fopen(region_path, "rb");
+    if (!file) {
+        if (err && err_sz > 0) snprintf(err, err_sz, "fopen(%s) failed: %s", region_path, strerror(errno));
+        return 0;
+    }
+    if (!nbt_file_size(file, &file_size)) {
+        set_err(err, err_sz, "failed to determine region file size");
+        goto fail;
+    }
+    if (file_size < REGION_HEADER_BYTES || fread(header, 1, sizeof(header), file) != sizeof(header)) {
+        set_err(err, err_sz, "invalid region file: expected at least 8192 bytes");
+        goto fail;
+    }
+
+    out_index->layout = region_path_is_cubic_r2(region_path)
+        ? REGION_LAYOUT_CUBIC_R2
+        : REGION_LAYOUT_STANDARD;
+    sector_bytes = out_index->layout == REGION_LAYOUT_CUBIC_R2
+        ? REGION_CUBIC_R2_SECTOR_BYTES
+        : REGION_SECTOR_BYTES;
+    header_sectors = REGION_HEADER_BYTES / sector_bytes;
+    out_index->file_size = file_size;
+    out_index->header_fingerprint = region_index_hash(header, sizeof(header), 0);
+    report->header_unchanged = previous &&
+        previous->layout == out_index->layout &&
+        previous->file_size == file_size &&
+        previous->header_fingerprint == out_index->header_fingerprint;
+
+    total_sectors = file_size / sector_bytes + ((file_size % sector_bytes) != 0U);
+    if (total_sectors > UINT32_MAX || total_sectors > SIZE_MAX) {
+        set_err(err, err_sz, "invalid region file: sector count exceeds supported limit");
+        goto fail;
+    }
+    sector_used = calloc((size_t)total_sectors, sizeof(uint8_t));
+    if (!sector_used) {
+        set_err(err, err_sz, "out of memory");
+        goto fail;
+    }
+    memset(sector_used, 1, header_sectors);
+
+    for (i = 0; i < REGION_CHUNK_COUNT; i++) {
+        RegionIndexEntry* entry = &out_index->entries[i];
+        const RegionIndexEntry* cached = previous ? &previous->entries[i] : NULL;
+        uint32_t location = read_be_u32(header + (size_t)i * 4U);
+        uint32_t sector_offset = (location >> 8) & 0x00FFFFFFU;
+        uint32_t sector_count = location & 0x000000FFU;
+        uint64_t chunk_start;
+        uint64_t chunk_span;
+        uint32_t length_field;
+        uint8_t compression_flags;
+        uint8_t compression_type;
+        uint64_t hash;
+        uint32_t s;
+
+        entry->location = location;
+        entry->timestamp = read_be_u32(header + REGION_LOCATION_TABLE_BYTES + (size_t)i * 4U);
+        if (sector_offset == 0 && sector_count == 0) continue;
+
+        if (sector_offset == 0 || sector_count == 0) {
+            set_chunk_err(err, err_sz, i, "has an invalid zero location/count combination");
+            goto fail;
+        }
+        if (sector_offset < header_sectors) {
+            set_chunk_err(err, err_sz, i, "points into header sectors");
+            goto fail;
+        }
+        if (sector_offset >= total_sectors || sector_count > total_sectors - sector_offset) {
+            set_chunk_err(err, err_sz, i, "has a sector range out of bounds");
+            goto fail;
+        }
+        for (s = 0; s < sector_count; s++) {
+            if (sector_used[sector_offset + s]) {
+                set_chunk_err(err, err_sz, i, "overlaps another chunk's sectors");
+                goto fail;
+            }
+            sector_used[sector_offset + s] = 1;
+        }
+        report->populated++;
+
+        if (!full_rehash && previous && cached->stored_length != 0 &&
+            previous->layout == out_index->layout &&
+            cached->location == location && cached->timestamp == entry->timestamp) {
+            entry->stored_length = cached->stored_length;
+            entry->external = cached->external;
+            entry->hash = cached->hash;
+            report->status[i] = REGION_VERIFY_REUSED;
+            report->reused++;
+            continue;
+        }
+
+        chunk_start = (uint64_t)sector_offset * sector_bytes;
+        chunk_span = (uint64_t)sector_count * sector_bytes;
+        if (chunk_start > file_size || chunk_span > file_size - chunk_start) {
+            set_chunk_err(err, err_sz, i, "points outside the file");
+            goto fail;
+        }
+        if (chunk_span < 5U) {
+            set_chunk_err(err, err_sz, i, "has a data block that is too small");
+            goto fail;
+        }
+        if (record_capacity < 5U) {
+            record_capacity = REGION_SECTOR_BYTES;
+            record = malloc(record_capacity);
+            if (!record) {
+                set_err(err, err_sz, "out of memory");
+                goto fail;
+            }
+        }
+        if (!nbt_fseek64(file, chunk_start) || fread(record, 1, 5U, file) != 5U) {
+            set_chunk_err(err, err_sz, i, "could not be read");
+            goto fail;
+        }
+
+        length_field = read_be_u32(record);
+        if (length_field < 1U) {
+            set_chunk_err(err, err_sz, i, "has an invalid length field");
+            goto fail;
+        }
+        if ((uint64_t)length_field + 4U > chunk_span) {
+            set_chunk_err(err, err_sz, i, "has a length that exceeds its allocated sectors");
+            goto fail;
+        }
+        compression_flags = record[4];
+        compression_type = compression_flags & (uint8_t)~REGION_EXTERNAL_STREAM_FLAG;
+        if (compression_type != REGION_COMPRESSION_GZIP &&
+            compression_type != REGION_COMPRESSION_ZLIB &&
+            compression_type != REGION_COMPRESSION_NONE &&
+            compression_type != REGION_COMPRESSION_LZ4) {
+            set_chunk_err(err, err_sz, i, "uses an unsupported compression type");
+            goto fail;
+        }
+
+        if ((size_t)length_field + 4U > record_capacity) {
+            unsigned char* grown = realloc(record, (size_t)length_field + 4U);
+            if (!grown) {
+                set_err(err, err_sz, "out of memory");
+                goto fail;
+            }
+            record = grown;
+            record_capacity = (size_t)length_field + 4U;
+        }
+        if (length_field > 1U &&
+            fread(record + 5, 1, (size_t)length_field - 1U, file) != (size_t)length_field - 1U) {
+            set_chunk_err(err, err_sz, i, "could not be read");
+            goto fail;
+        }
+        hash = region_index_hash(record, (size_t)length_field + 4U, 0);
+        report->bytes_hashed += (uint64_t)length_field + 4U;
+
+        entry->external = (compression_flags & REGION_EXTERNAL_STREAM_FLAG) != 0;
+        if (entry->external) {
+            if (length_field != 1U) {
+                set_chunk_err(err, err_sz, i, "is an external stub with a non-empty payload");
+                goto fail;
+            }
+            if (out_index->layout == REGION_LAYOUT_CUBIC_R2) {
+                set_err(err, err_sz, "corrupt cubic r2 region: external chunk storage is not defined");
+                goto fail;
+            }
+            if (!hash_external_chunk(region_path, i, &hash, &report->bytes_hashed, err, err_sz)) goto fail;
+        }
+        entry->stored_length = length_field;
+        entry->hash = hash;
+
+        if (previous && cached->stored_length != 0 &&
+            cached->timestamp == entry->timestamp && cached->hash != hash) {
+            report->status[i] = REGION_VERIFY_MISMATCH;
+            report->mismatched++;
+        } else {
+            report->status[i] = REGION_VERIFY_HASHED;
+            report->hashed++;
+        }
+    }
+
+    free(record);
+    free(sector_used);
+    fclose(file);
+    return 1;
+
+fail:
+    free(record);
+    free(sector_used);
+    fclose(file);
+    return 0;
+}
@@ -1,4 +1,3 @@
-#include <errno.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,72 +22,6 @@ static uint32_t read_be_u32(const unsigned char* p) {
            (uint32_t)p[3];
 }
 
-static unsigned char* read_file_bytes(const char* filename, size_t* out_size, char* err, size_t err_sz) {
-    FILE* file = NULL;
-    unsigned char* buffer = NULL;
-    size_t size = 0;
-    size_t capacity = 0;
-
-    if (out_size) *out_size = 0;
-
-    file = nbt_fopen(filename, "rb");
-    if (!file) {
-        if (err && err_sz > 0) {
-            snprintf(err, err_sz, "fopen(%s) failed: %s", filename, strerror(errno));
-        }
-        return NULL;
-    }
-
-    capacity = READ_CHUNK;
-    buffer = malloc(capacity);
-    if (!buffer) {
-        fclose(file);
-        set_err(err, err_sz, "out of memory");
-        return NULL;
-    }
-
-    while (1) {
-        size_t read_count;
-
-        if (size > SIZE_MAX - READ_CHUNK) {
-            set_err(err, err_sz, "input file too large");
-            free(buffer);
-            fclose(file);
-            return NULL;
-        }
-
-        if (size + READ_CHUNK > capacity) {
-            size_t new_capacity = size + READ_CHUNK;
-            unsigned char* grown = realloc(buffer, new_capacity);
-            if (!grown) {
-                set_err(err, err_sz, "out of memory");
-                free(buffer);
-                fclose(file);
-                return NULL;
-            }
-            buffer = grown;
-            capacity = new_capacity;
-        }
-
-        read_count = fread(buffer + size, 1, READ_CHUNK, file);
-        if (read_count == 0) {
-            if (ferror(file)) {
-                set_err(err, err_sz, "failed to read input file");
-                free(buffer);
-                fclose(file);
-                return NULL;
-            }
-            break;
-        }
-
-        size += read_count;
-    }
-
-    fclose(file);
-    if (out_size) *out_size = size;
-    return buffer;
-}
-
 static unsigned char* copy_bytes(const unsigned char* data, size_t size) {
     unsigned char* out;
     if (!data && size > 0) return NULL;
@@ -176,6 +109,30 @@ static unsigned char* inflate_buffer(const unsigned char* input, size_t input_si
     return out;
 }
 
+typedef struct {
+    char* path;
+    RegionChunkSlot* slot;
+    int ok;
+    char err[256];
+} SidecarRead;
+
+static int read_sidecar_task(void* task) {
+    SidecarRead* read = task;
+    size_t size = 0;
+
+    read->slot->payload = nbt_read_file(read->path, &size, read->err, sizeof(read->err));
+    read->slot->payload_size = size;
+    read->ok = read->slot->payload != NULL;
+    return read->ok;
+}
+
+static void free_sidecar_reads(SidecarRead* reads, int count) {
+    int i;
+    if (!reads) return;
+    for (i = 0; i < count; i++) free(reads[i].path);
+    free(reads);
+}
+
 static int mark_sector_usage(RegionFile* region, uint32_t start_sector, uint32_t sector_count, char* err, size_t err_sz) {
     uint32_t s;
 
@@ -208,6 +165,9 @@ RegionFile* region_file_read(const char* filename, char* err, size_t err_sz) {
     RegionFile* region = NULL;
     uint32_t sector_bytes;
     uint32_t header_sectors;
+    NBTWorkQueue* sidecar_queue = NULL;
+    SidecarRead* sidecar_reads = NULL;
+    int sidecar_count = 0;
     int i;
 
     if (!filename) {
@@ -215,7 +175,7 @@ RegionFile* region_file_read(const char* filename, char* err, size_t err_sz) {
         return NULL;
     }
 
-    file_data = read_file_bytes(filename, &file_size, err, err_sz);
+    file_data = nbt_read_file(filename, &file_size, err, err_sz);
     if (!file_data) {
         return NULL;
     }
@@ -242,24 +202,18 @@ RegionFile* region_file_read(const char* filename, char* err, size_t err_sz) {
     total_sectors = file_size / sector_bytes + ((file_size % sector_bytes) != 0U);
     if (total_sectors > UINT32_MAX) {
         set_err(err, err_sz, "invalid region file: sector count exceeds supported limit");
-        free(file_data);
-        region_file_free(region);
-        return NULL;
+        goto fail;
     }
     region->total_sectors = (uint32_t)total_sectors;
     if (region->total_sectors < header_sectors) {
         set_err(err, err_sz, "invalid region file: missing header sectors");
-        free(file_data);
-        region_file_free(region);
-        return NULL;
+        goto fail;
     }
 
     region->sector_used = calloc(region->total_sectors, sizeof(uint8_t));
     if (!region->sector_used) {
         set_err(err, err_sz, "out of memory");
-        free(file_data);
-        region_file_free(region);
-        return NULL;
+        goto fail;
     }
 
     for (i = 0; (uint32_t)i < header_sectors; i++) {
@@ -281,22 +235,16 @@ RegionFile* region_file_read(const char* filename, char* err, size_t err_sz) {
 
         if (sector_offset == 0 || sector_count == 0) {
             set_err(err, err_sz, "corrupt region file: invalid zero location/count combination");
-            free(file_data);
-            region_file_free(region);
-            return NULL;
+            goto fail;
         }
 
         if (sector_offset < header_sectors) {
             set_err(err, err_sz, "corrupt region file: chunk points into header sectors");
-            free(file_data);
-            region_file_free(region);
-            return NULL;
+            goto fail;
         }
 
         if (!mark_sector_usage(region, sector_offset, sector_count, err, err_sz)) {
-            free(file_data);
-            region_file_free(region);
-            return NULL;
+            goto fail;
         }
 
         {
@@ -310,31 +258,23 @@ RegionFile* region_file_read(const char* filename, char* err, size_t err_sz) {
 
             if (chunk_start > file_size || chunk_span > file_size - chunk_start) {
                 set_err(err, err_sz, "corrupt region file: chunk data points outside file");
-                free(file_data);
-                region_file_free(region);
-                return NULL;
+                goto fail;
             }
 
             if (chunk_span < 5U) {
                 set_err(err, err_sz, "corrupt region file: chunk data block too small");
-                free(file_data);
-                region_file_free(region);
-                return NULL;
+                goto fail;
             }
 
             length_field = read_be_u32(file_data + chunk_start);
             if (length_field < 1U) {
                 set_err(err, err_sz, "corrupt region file: invalid chunk length field");
-                free(file_data);
-                region_file_free(region);
-                return NULL;
+                goto fail;
             }
 
             if ((size_t)length_field + 4U > chunk_span) {
                 set_err(err, err_sz, "corrupt region file: chunk length exceeds allocated sectors");
-                free(file_data);
-                region_file_free(region);
-                return NULL;
+                goto fail;
             }
 
             compression_flags = file_data[chunk_start + 4U];
@@ -345,17 +285,13 @@ RegionFile* region_file_read(const char* filename, char* err, size_t err_sz) {
                 compression_type != REGION_COMPRESSION_NONE &&
                 compression_type != REGION_COMPRESSION_LZ4) {
                 set_err(err, err_sz, "corrupt region file: unsupported chunk compression type");
-                free(file_data);
-                region_file_free(region);
-                return NULL;
+                goto fail;
             }
 
             payload_size = (size_t)length_field - 1U;
             if (payload_size > chunk_span - 5U) {
                 set_err(err, err_sz, "corrupt region file: invalid chunk payload size");
-                free(file_data);
-                region_file_free(region);
-                return NULL;
+                goto fail;
             }
 
             if (external) {
@@ -363,40 +299,40 @@ RegionFile* region_file_read(const char* filename, char* err, size_t err_sz) {
 
                 if (length_field != 1U) {
                     set_err(err, err_sz, "corrupt region file: external chunk stub must have length 1");
-                    free(file_data);
-                    region_file_free(region);
-                    return NULL;
+                    goto fail;
                 }
 
                 if (region->layout == REGION_LAYOUT_CUBIC_R2) {
                     set_err(err, err_sz, "corrupt cubic r2 region: external chunk storage is not defined");
-                    free(file_data);
-                    region_file_free(region);
-                    return NULL;
+                    goto fail;
                 }
 
                 external_path = region_external_chunk_path(filename, i % REGION_CHUNK_GRID, i / REGION_CHUNK_GRID);
                 if (!external_path) {
                     set_err(err, err_sz, "external chunk requires a conventional r.<x>.<z>.mca/.mcr filename");
-                    free(file_data);
-                    region_file_free(region);
-                    return NULL;
+                    goto fail;
                 }
-                slot->payload = read_file_bytes(external_path, &payload_size, err, err_sz);
-                free(external_path);
-                if (!slot->payload) {
-                    free(file_data);
-                    region_file_free(region);
-                    return NULL;
+                if (!sidecar_reads) {
+                    sidecar_reads = calloc(REGION_CHUNK_COUNT, sizeof(*sidecar_reads));
+                    if (!sidecar_reads) {
+                        free(external_path);
+                        set_err(err, err_sz, "out of memory");
+                        goto fail;
+                    }
+                    sidecar_queue = nbt_work_queue_create(REGION_SIDECAR_IO_WORKERS);
                 }
+                /* The read overlaps the rest of this scan; the slot is not touched again here. */
+                sidecar_reads[sidecar_count].path = external_path;
+                sidecar_reads[sidecar_count].slot = slot;
+                nbt_work_queue_submit(sidecar_queue, read_sidecar_task, &sidecar_reads[sidecar_count]);
+                sidecar_count++;
             } else {
                 slot->payload = copy_bytes(file_data + chunk_start + 5U, payload_size);
                 if (!slot->payload && payload_size > 0) {
                     set_err(err, err_sz, "out of memory");
-                    free(file_data);
-                    region_file_free(region);
-                    return NULL;
+                    goto fail;
                 }
+                slot->payload_size = payload_size;
             }
 
             slot->present = 1;
@@ -405,14 +341,32 @@ RegionFile* region_file_read(const char* filename, char* err, size_t err_sz) {
             slot->compression_type = compression_type;
             slot->external = external;
             slot->stored_length = length_field;
-            slot->payload_size = payload_size;
         }
     }
 
     free(file_data);
+    file_data = NULL;
+    nbt_work_queue_finish(sidecar_queue);
+    sidecar_queue = NULL;
+    for (i = 0; i < sidecar_count; i++) {
+        if (!sidecar_reads[i].ok) {
+            set_err(err, err_sz, sidecar_reads[i].err);
+            goto fail;
+        }
+    }
+    free_sidecar_reads(sidecar_reads, sidecar_count);
     return region;
+
+fail:
+    nbt_work_queue_finish(sidecar_queue);
+    free_sidecar_reads(sidecar_reads, sidecar_count);
+    free(file_data);
+    region_file_free(region);
+    return NULL;
 }
 
+
+
 int region_file_find_first_populated_chunk(const RegionFile* region, int* out_chunk_x, int* out_chunk_z) {
     int i;
 
@@ -450,46 +450,105 @@ static int write_bytes_direct(
     return 1;
 }
 
-static int write_bytes_atomic(
-    const char* output_path,
+/*
+ * Writes data to a fresh temporary file beside target_path and flushes it to
+ * disk. The caller renames *out_temp_path into place (or removes it).
+ */
+static int write_synced_temp_file(
+    const char* target_path,
     const unsigned char* data,
     size_t size,
     const char* temp_prefix,
+    char** out_temp_path,
     char* err,
     size_t err_sz
 ) {
     char* temp_path = NULL;
+    FILE* out;
     int fd;
 
-    fd = nbt_open_temp_file(output_path, temp_prefix, &temp_path, err, err_sz);
+    *out_temp_path = NULL;
+    fd = nbt_open_temp_file(target_path, temp_prefix, &temp_path, err, err_sz);
     if (fd < 0) return 0;
 
     if (nbt_close_fd(fd) != 0) {
         set_err(err, err_sz, "failed to close temporary output file");
-        nbt_remove_file(temp_path);
-        free(temp_path);
-        return 0;
+        goto fail;
     }
 
-    if (!write_bytes_direct(temp_path, data, size, err, err_sz)) {
-        nbt_remove_file(temp_path);
-        free(temp_path);
-        return 0;
+    out = nbt_fopen(temp_path, "wb");
+    if (!out) {
+        if (err && err_sz > 0) {
+            snprintf(err, err_sz, "fopen(%s) failed: %s", temp_path, strerror(errno));
+        }
+        goto fail;
     }
-
-    if (!nbt_replace_file(temp_path, output_path, err, err_sz)) {
-        nbt_remove_file(temp_path);
-        free(temp_path);
-        return 0;
+    if (size > 0 && fwrite(data, 1, size, out) != size) {
+        set_err(err, err_sz, "failed to write region output file");
+        fclose(out);
+        goto fail;
+    }
+    if (!nbt_fsync_file(out)) {
+        set_err(err, err_sz, "failed to flush region output file to disk");
+        fclose(out);
+        goto fail;
+    }
+    if (fclose(out) != 0) {
+        set_err(err, err_sz, "failed to close region output file");
+        goto fail;
     }
 
-    free(temp_path);
+    *out_temp_path = temp_path;
     return 1;
+
+fail:
+    nbt_remove_file(temp_path);
+    free(temp_path);
+    return 0;
+}
+
+typedef struct {
+    char* path;
+    char* temp_path;
+    const unsigned char* data;
+    size_t size;
+    const char* temp_prefix;
+    int ok;
+    char err[256];
+} PendingWrite;
+
+static int pending_write_task(void* task) {
+    PendingWrite* write = task;
+
+    write->ok = write_synced_temp_file(
+        write->path,
+        write->data,
+        write->size,
+        write->temp_prefix,
+        &write->temp_path,
+        write->err,
+        sizeof(write->err)
+    );
+    return write->ok;
 }
 
-static int write_external_chunks(
+static void discard_pending_writes(PendingWrite* writes, int count) {
+    int i;
+
+    if (!writes) return;
+    for (i = 0; i < count; i++) {
+        if (writes[i].temp_path) nbt_remove_file(writes[i].temp_path);
+        free(writes[i].temp_path);
+        free(writes[i].path);
+    }
+    free(writes);
+}
+
+static int collect_external_chunks(
     const RegionFile* region,
     const char* output_path,
+    PendingWrite* writes,
+    int* count,
     char* err,
     size_t err_sz
 ) {
@@ -497,64 +556,122 @@ static int write_external_chunks(
 
     for (i = 0; i < REGION_CHUNK_COUNT; i++) {
         const RegionChunkSlot* slot = &region->chunks[i];
-        char* external_path;
+        PendingWrite* write;
 
         if (!slot->present || !chunk_uses_external_storage(region, slot)) continue;
-        external_path = region_external_chunk_path(
+        write = &writes[*count];
+        write->path = region_external_chunk_path(
             output_path,
             i % REGION_CHUNK_GRID,
             i / REGION_CHUNK_GRID
         );
-        if (!external_path) {
+        if (!write->path) {
             set_err(err, err_sz, "failed to derive external .mcc chunk path");
             return 0;
         }
-
-        if (!write_bytes_atomic(
-                external_path,
-                slot->payload,
-                slot->payload_size,
-                "chunk",
-                err,
-                err_sz)) {
-            free(external_path);
-            return 0;
-        }
-        free(external_path);
+        write->data = slot->payload;
+        write->size = slot->payload_size;
+        write->temp_prefix = "chunk";
+        (*count)++;
     }
 
     return 1;
 }
 
-int region_file_write(const RegionFile* region, const char* output_path, char* err, size_t err_sz) {
+/*
+ * External .mcc sidecars (and, for atomic saves, the region itself) are
+ * written and fsynced concurrently as temporary files. Sidecars are renamed
+ * into place first and the region header remains the commit point.
+ */
+static int write_region_and_sidecars(
+    const RegionFile* region,
+    const char* output_path,
+    int atomic,
+    char* err,
+    size_t err_sz
+) {
     unsigned char* file_data = NULL;
     size_t file_size = 0;
-    int ok;
+    PendingWrite* writes;
+    NBTWorkQueue* queue;
+    int sidecar_count = 0;
+    int count;
+    int ok = 0;
+    int i;
 
     if (!build_region_bytes(region, output_path, &file_data, &file_size, err, err_sz)) return 0;
-    if (!write_external_chunks(region, output_path, err, err_sz)) {
+
+    /* One slot per possible sidecar plus the region file itself. */
+    writes = calloc(REGION_CHUNK_COUNT + 1, sizeof(*writes));
+    if (!writes) {
+        set_err(err, err_sz, "out of memory");
+        free(file_data);
+        return 0;
+    }
+    if (!collect_external_chunks(region, output_path, writes, &sidecar_count, err, err_sz)) {
+        discard_pending_writes(writes, sidecar_count + 1);
         free(file_data);
         return 0;
     }
+    count = sidecar_count;
+    if (atomic) {
+        writes[count].path = nbt_strdup(output_path);
+        if (!writes[count].path) {
+            set_err(err, err_sz, "out of memory");
+            discard_pending_writes(writes, count);
+            free(file_data);
+            return 0;
+        }
+        writes[count].data = file_data;
+        writes[count].size = file_size;
+        writes[count].temp_prefix = "region";
+        count++;
+    }
 
-    ok = write_bytes_direct(output_path, file_data, file_size, err, err_sz);
-    free(file_data);
-    return ok;
-}
+    queue = count > 1 ? nbt_work_queue_create(REGION_SIDECAR_IO_WORKERS) : NULL;
+    for (i = 0; i < count; i++) {
+        nbt_work_queue_submit(queue, pending_write_task, &writes[i]);
+    }
+    nbt_work_queue_finish(queue);
+    for (i = 0; i < count; i++) {
+        if (!writes[i].ok) {
+            set_err(err, err_sz, writes[i].err);
+            goto done;
+        }
+    }
 
-int region_file_write_atomic(const RegionFile* region, const char* output_path, char* err, size_t err_sz) {
-    unsigned char* file_data = NULL;
-    size_t file_size = 0;
-    int ok;
+    for (i = 0; i < sidecar_count; i++) {
+        if (!nbt_replace_file(writes[i].temp_path, writes[i].path, err, err_sz)) goto done;
+        free(writes[i].temp_path);
+        writes[i].temp_path = NULL;
+    }
+    /* One directory sync covers every sidecar rename before the header commits. */
+    if (sidecar_count > 0 && !nbt_sync_parent_directory(output_path)) {
+        set_err(err, err_sz, "failed to sync external chunk directory");
+        goto done;
+    }
 
-    if (!build_region_bytes(region, output_path, &file_data, &file_size, err, err_sz)) return 0;
-    if (!write_external_chunks(region, output_path, err, err_sz)) {
-        free(file_data);
-        return 0;
+    if (atomic) {
+        PendingWrite* region_write = &writes[sidecar_count];
+        if (!nbt_replace_file(region_write->temp_path, region_write->path, err, err_sz)) goto done;
+        free(region_write->temp_path);
+        region_write->temp_path = NULL;
+        ok = nbt_sync_parent_directory(output_path);
+        if (!ok) set_err(err, err_sz, "failed to sync region directory");
+    } else {
+        ok = write_bytes_direct(output_path, file_data, file_size, err, err_sz);
     }
 
-    /* External sidecars are replaced first; the region header is the commit point. */
-    ok = write_bytes_atomic(output_path, file_data, file_size, "region", err, err_sz);
+done:
+    discard_pending_writes(writes, count);
     free(file_data);
     return ok;
 }
+
+int region_file_write(const RegionFile* region, const char* output_path, char* err, size_t err_sz) {
+    return write_region_and_sidecars(region, output_path, 0, err, err_sz);
+}
+
+int region_file_write_atomic(const RegionFile* region, const char* output_path, char* err, size_t err_sz) {
+    return write_region_and_sidecars(region, output_path, 1, err, err_sz);
+}
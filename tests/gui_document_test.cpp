@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include <QCoreApplication>
 #include <QDir>
 #include <QFile>
@@ -64,7 +66,8 @@ int main(int argc, char* argv[]) {
 
     char error[512]{};
     NBTTag* fixture = snbt_parse(
-        "{Data:{SpawnX:1014,LevelName:\"world\",Enabled:1b}}", "", error, sizeof(error));
+        "{Data:{SpawnX:1014,LevelName:\"world\",Enabled:1b},"
+        "Other:{Deep:{Value:7,Name:\"kept\"},Scores:[I;1,2,3]}}", "", error, sizeof(error));
     if (!check(fixture != nullptr, error)) return 1;
     unsigned char* encoded = nullptr;
     size_t encodedSize = 0;
@@ -89,6 +92,18 @@ int main(int argc, char* argv[]) {
     QString qtError;
     NbtDocument document;
     if (!check(document.openFile(sourcePath, &qtError), qPrintable(qtError))) return 1;
+    // Binary files open lazily: children appear only once they are loaded.
+    if (!check(!document.isLoaded(document.root()) && document.childCount(document.root()) == 2 &&
+                   find_tag_by_path(document.root(), "Data") == nullptr,
+               "a binary document was decoded eagerly")) return 1;
+    if (!check(document.loadChildren(document.root(), &qtError), qPrintable(qtError))) return 1;
+    NBTTag* data = find_tag_by_path(document.root(), "Data");
+    NBTTag* other = find_tag_by_path(document.root(), "Other");
+    if (!check(data && other && !document.isLoaded(data) && !document.isLoaded(other) &&
+                   document.childCount(data) == 3 && find_tag_by_path(document.root(), "Data/SpawnX") == nullptr,
+               "loading the root decoded more than its children")) return 1;
+    if (!check(document.loadSubtree(data, &qtError), qPrintable(qtError))) return 1;
+    if (!check(document.isLoaded(data) && !document.isLoaded(other), "loading one subtree loaded another")) return 1;
     NBTTag* spawn = find_tag_by_path(document.root(), "Data/SpawnX");
     if (!check(spawn && spawn->value.int_val == 1014, "initial value mismatch")) return 1;
     if (!check(document.editTag(spawn, QStringLiteral("4242"), &qtError), qPrintable(qtError))) return 1;
@@ -102,7 +117,7 @@ int main(int argc, char* argv[]) {
     spawn = find_tag_by_path(document.root(), "Data/SpawnX");
     if (!check(spawn && spawn->value.int_val == 4242, "redo did not restore edit")) return 1;
 
-    NBTTag* data = find_tag_by_path(document.root(), "Data");
+    data = find_tag_by_path(document.root(), "Data");
     if (!check(document.addTag(data, TAG_String, QStringLiteral("Added"), &qtError), qPrintable(qtError))) return 1;
     NBTTag* added = find_tag_by_path(document.root(), "Data/Added");
     data = find_tag_by_path(document.root(), "Data");
@@ -110,12 +125,29 @@ int main(int argc, char* argv[]) {
         !check(document.renameTag(added, data, QStringLiteral("Renamed"), &qtError), qPrintable(qtError))) return 1;
     if (!check(find_tag_by_path(document.root(), "Data/Renamed") != nullptr, "tag was not renamed")) return 1;
 
+    // A write decodes the collapsed subtrees in its own snapshot, not in the document.
+    std::shared_ptr<NbtDocumentSnapshot> snapshot = document.prepareForWriting(&qtError);
+    if (!check(snapshot && snapshot->materialize(nullptr, &qtError), qPrintable(qtError))) return 1;
+    NBTTag* snapshotValue = find_tag_by_path(snapshot->root, "Other/Deep/Value");
+    if (!check(snapshotValue && snapshotValue->value.int_val == 7 && !document.isLoaded(other),
+               "a write snapshot did not decode collapsed subtrees on its own")) return 1;
+    snapshot.reset();
+
     const QString savedPath = directory.filePath(QStringLiteral("saved.dat"));
     if (!check(document.saveAs(savedPath, &qtError), qPrintable(qtError))) return 1;
+    if (!check(!document.isLoaded(other), "saving decoded the document's collapsed subtrees")) return 1;
     NbtDocument reopened;
-    if (!check(reopened.openFile(savedPath, &qtError), qPrintable(qtError))) return 1;
+    if (!check(reopened.openFile(savedPath, &qtError), qPrintable(qtError)) ||
+        !check(reopened.loadSubtree(reopened.root(), &qtError), qPrintable(qtError))) return 1;
     spawn = find_tag_by_path(reopened.root(), "Data/SpawnX");
     if (!check(spawn && spawn->value.int_val == 4242, "saved edit did not round trip")) return 1;
+    NBTTag* deepValue = find_tag_by_path(reopened.root(), "Other/Deep/Value");
+    NBTTag* deepName = find_tag_by_path(reopened.root(), "Other/Deep/Name");
+    NBTTag* scores = find_tag_by_path(reopened.root(), "Other/Scores");
+    if (!check(deepValue && deepValue->value.int_val == 7 && deepName &&
+                   strcmp(deepName->value.string_val, "kept") == 0 && scores &&
+                   scores->value.int_array.length == 3 && scores->value.int_array.data[2] == 3,
+               "an unloaded subtree did not survive a save unchanged")) return 1;
 
     const QString snbtPath = directory.filePath(QStringLiteral("export.snbt"));
     if (!check(reopened.exportSnbt(snbtPath, &qtError), qPrintable(qtError))) return 1;
@@ -141,6 +173,7 @@ int main(int argc, char* argv[]) {
     if (!check(newBedrockLevel.saveAs(bedrockLevelPath, &qtError), qPrintable(qtError))) return 1;
     NbtDocument reopenedBedrockLevel;
     if (!check(reopenedBedrockLevel.openFile(bedrockLevelPath, &qtError), qPrintable(qtError)) ||
+        !check(reopenedBedrockLevel.loadSubtree(reopenedBedrockLevel.root(), &qtError), qPrintable(qtError)) ||
         !check(reopenedBedrockLevel.binaryFormat() == NBT_BINARY_BEDROCK_LEVEL_DAT,
                "Bedrock level.dat format was not preserved")) return 1;
     storageTest = find_tag_by_path(reopenedBedrockLevel.root(), "StorageTest");
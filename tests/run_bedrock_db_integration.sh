@@ -13,12 +13,15 @@ trap 'rm -f "$test_bin"' EXIT HUP INT TERM
 
 ${CC:-cc} -std=c11 -Wall -Wextra -Wpedantic -I"$project_dir/h" \
     "$project_dir/tests/test_bedrock_db.c" \
+    "$project_dir/src/bedrock_batch.c" \
     "$project_dir/src/bedrock_db.c" \
+    "$project_dir/src/bedrock_keys.c" \
     "$project_dir/src/nbt_binary.c" \
     "$project_dir/src/snbt.c" \
     "$project_dir/src/nbt_builder.c" \
+    "$project_dir/src/nbt_tree.c" \
     "$project_dir/src/nbt_utils.c" \
     "$project_dir/src/platform.c" \
-    -o "$test_bin"
+    -pthread -o "$test_bin"
 
 "$test_bin" "$1" "$2"
@@ -21,7 +21,7 @@ fi
 
 "$CC_BIN" -std=c11 -Wall -Wextra -Wpedantic -Ih \
   tests/test_cubic_region.c src/region_file.c src/region_lz4.c \
-  src/region_write.c src/platform.c "${ZLIB_LINK[@]}" -o "$TMP_DIR/test_cubic_region"
+  src/region_write.c src/platform.c -pthread "${ZLIB_LINK[@]}" -o "$TMP_DIR/test_cubic_region"
 "$TMP_DIR/test_cubic_region" "$TMP_DIR/r2.0.0.0.mca"
 
 python3 - "$TMP_DIR" <<'PY'
@@ -158,4 +158,16 @@ if "$BIN" "$TMP_DIR/r2.-3.4.8.mca" --chunk 5 7 --set xPos 1 \
 fi
 grep -q "cubic r2 output requires" "$TMP_DIR/mislabeled.log"
 
+mkdir "$TMP_DIR/world"
+cp "$TMP_DIR/r2.-3.4.8.mca" "$TMP_DIR/world/r2.-3.4.8.mca"
+cp "$TMP_DIR/r2.-3.4.8.mca" "$TMP_DIR/world/r2.-3.-1.8.mca"
+cp "$TMP_DIR/r2.-3.4.8.mcr" "$TMP_DIR/world/r2.-3.2.8.mcr"
+cp "$TMP_DIR/r2.-3.4.8.mca" "$TMP_DIR/world/r2.5.0.6.mca"
+cp "$TMP_DIR/r2.-3.4.8.mca" "$TMP_DIR/world/r.0.0.mca"
+"$BIN" "$TMP_DIR/world" --list-cubes >"$TMP_DIR/cubes.log" 2>&1
+grep -q "8 cubes in 2 columns (4 region files)" "$TMP_DIR/cubes.log"
+# Columns are grouped by (x, z) and each column streams upward in y.
+awk -F '\t' 'NR > 1 && NF == 7 { print $1 "," $2 "," $3 }' "$TMP_DIR/cubes.log" | uniq >"$TMP_DIR/cube_order.txt"
+printf '%s\n' "-3,8,-1" "-3,8,2" "-3,8,4" "5,6,0" | cmp - "$TMP_DIR/cube_order.txt"
+
 echo "All legacy cubic r2 region tests passed"
@@ -280,4 +280,71 @@ cp "$INPUT" "$WILDCARD_DELETE_INPUT"
 assert_not_grep "String: codex-del-a" "$TMP_DIR/wildcard_delete_dump.txt"
 assert_not_grep "String: codex-del-b" "$TMP_DIR/wildcard_delete_dump.txt"
 
+echo "[26] Wildcard array edit applies one prepared value"
+WILDCARD_ARRAY_INPUT="$TMP_DIR/wildcard_array_level.dat"
+cp "$INPUT" "$WILDCARD_ARRAY_INPUT"
+"$BIN" "$WILDCARD_ARRAY_INPUT" --edit "Data/Player/UUID[*]" "7" --in-place >"$TMP_DIR/wildcard_array_cmd.log" 2>&1
+"$BIN" "$WILDCARD_ARRAY_INPUT" --snbt "$TMP_DIR/wildcard_array.snbt" >"$TMP_DIR/wildcard_array_snbt.log" 2>&1
+assert_grep "\[I;7, 7, 7, 7\]" "$TMP_DIR/wildcard_array.snbt"
+
+echo "[27] Wildcard delete compacts array elements"
+WILDCARD_ARRAY_DELETE_INPUT="$TMP_DIR/wildcard_array_delete_level.dat"
+cp "$INPUT" "$WILDCARD_ARRAY_DELETE_INPUT"
+"$BIN" "$WILDCARD_ARRAY_DELETE_INPUT" --delete "Data/Player/UUID[*]" --in-place >"$TMP_DIR/wildcard_array_delete_cmd.log" 2>&1
+"$BIN" "$WILDCARD_ARRAY_DELETE_INPUT" --snbt "$TMP_DIR/wildcard_array_delete.snbt" >"$TMP_DIR/wildcard_array_delete_snbt.log" 2>&1
+assert_grep "\"UUID\": \[I;\]" "$TMP_DIR/wildcard_array_delete.snbt"
+assert_grep "\"Pos\": \[" "$TMP_DIR/wildcard_array_delete.snbt"
+
+echo "[28] Query predicates, recursion, and projections"
+QUERY_INPUT="$TMP_DIR/query_input.snbt"
+cat >"$QUERY_INPUT" <<'SNBT'
+{"Entities": [{"id": "minecraft:cow", "Health": 10.0f}, {"id": "minecraft:villager", "Health": 4.5f, "Tags": ["trader"]}, {"id": "minecraft:villager", "Health": 20.0f}], "UUID": [I; 1, -2, 3, 4]}
+SNBT
+"$BIN" "$QUERY_INPUT" --query 'Entities[?id=="minecraft:villager" && Health<5]{id, hp: Health}' >"$TMP_DIR/query_filter.json" 2>"$TMP_DIR/query_filter.log"
+assert_grep '"count":1,' "$TMP_DIR/query_filter.json"
+assert_grep '"path":"Entities\[1\]"' "$TMP_DIR/query_filter.json"
+assert_grep '"name":"hp","path":"Entities\[1\]/hp","type":5' "$TMP_DIR/query_filter.json"
+"$BIN" "$QUERY_INPUT" --query '..id' >"$TMP_DIR/query_descent.json" 2>"$TMP_DIR/query_descent.log"
+assert_grep '"count":3,' "$TMP_DIR/query_descent.json"
+"$BIN" "$QUERY_INPUT" --query 'UUID[?@<0]' >"$TMP_DIR/query_array.json" 2>"$TMP_DIR/query_array.log"
+assert_grep '"path":"UUID\[1\]","type":3,"typeName":"Int","value":-2' "$TMP_DIR/query_array.json"
+if "$BIN" "$QUERY_INPUT" --query 'Entities[?id==' >"$TMP_DIR/query_bad.json" 2>"$TMP_DIR/query_bad.log"; then
+  echo "Expected malformed query to fail"
+  exit 1
+fi
+assert_grep "query syntax error at offset" "$TMP_DIR/query_bad.log"
+
+echo "[29] Typed find and replace"
+"$BIN" "$QUERY_INPUT" --find --name Health --type float --max 5 >"$TMP_DIR/find_range.json" 2>"$TMP_DIR/find_range.log"
+assert_grep '"count":1,' "$TMP_DIR/find_range.json"
+assert_grep '"path":"Entities\[1\]/Health"' "$TMP_DIR/find_range.json"
+"$BIN" "$QUERY_INPUT" --find --regex '^MINECRAFT:V.*r$' --ignore-case >"$TMP_DIR/find_regex.json" 2>"$TMP_DIR/find_regex.log"
+assert_grep '"count":2,' "$TMP_DIR/find_regex.json"
+"$BIN" "$QUERY_INPUT" --find --type string --regex '^minecraft:' --replace-text 'mc:' --in-place >"$TMP_DIR/find_text.log" 2>&1
+assert_grep "Replaced 3 of 3 matching tags" "$TMP_DIR/find_text.log"
+"$BIN" "$QUERY_INPUT" --find --name Health --min 10 --replace-value 1 --in-place --backup >"$TMP_DIR/find_value.log" 2>&1
+assert_grep "Replaced 2 of 2 matching tags" "$TMP_DIR/find_value.log"
+"$BIN" "$QUERY_INPUT" --snbt "$TMP_DIR/find_result.snbt" >"$TMP_DIR/find_result.log" 2>&1
+assert_grep '"id": "mc:villager"' "$TMP_DIR/find_result.snbt"
+assert_grep '"Health": 1f' "$TMP_DIR/find_result.snbt"
+assert_grep '"Health": 4.5f' "$TMP_DIR/find_result.snbt"
+if "$BIN" "$QUERY_INPUT" --find --regex '[a-' >"$TMP_DIR/find_bad.json" 2>"$TMP_DIR/find_bad.log"; then
+  echo "Expected malformed regex to fail"
+  exit 1
+fi
+assert_grep "unterminated regex character class" "$TMP_DIR/find_bad.log"
+CASE_INPUT="$TMP_DIR/case_input.snbt"
+cat >"$CASE_INPUT" <<'SNBT'
+{"a": "aaa", "b": "AAA", "c": "xyz"}
+SNBT
+"$BIN" "$CASE_INPUT" --find --regex '^[^a]+$' --ignore-case >"$TMP_DIR/find_negated.json" 2>"$TMP_DIR/find_negated.log"
+assert_grep '"count":1,' "$TMP_DIR/find_negated.json"
+"$BIN" "$CASE_INPUT" --find --regex '^[^a-z]+$' --ignore-case >"$TMP_DIR/find_negated_range.json" 2>"$TMP_DIR/find_negated_range.log"
+assert_grep '"count":0,' "$TMP_DIR/find_negated_range.json"
+"$BIN" "$CASE_INPUT" --find --regex '^[^a]+$' --ignore-case --replace-text 'z' --in-place >"$TMP_DIR/find_negated_replace.log" 2>&1
+assert_grep "Replaced 1 of 1 matching tags" "$TMP_DIR/find_negated_replace.log"
+"$BIN" "$CASE_INPUT" --snbt "$TMP_DIR/case_result.snbt" >"$TMP_DIR/case_result.log" 2>&1
+assert_grep '"b": "AAA"' "$TMP_DIR/case_result.snbt"
+assert_grep '"c": "z"' "$TMP_DIR/case_result.snbt"
+
 echo "All edit tests passed"
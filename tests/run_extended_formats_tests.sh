@@ -7,11 +7,19 @@ trap 'rm -f "$test_bin"' EXIT HUP INT TERM
 
 ${CC:-cc} -std=c11 -Wall -Wextra -Wpedantic -I"$project_dir/h" \
     "$project_dir/tests/test_extended_formats.c" \
+    "$project_dir/src/bedrock_keys.c" \
+    "$project_dir/src/bedrock_subchunk.c" \
+    "$project_dir/src/edit_value.c" \
+    "$project_dir/src/jsmn.c" \
     "$project_dir/src/nbt_binary.c" \
     "$project_dir/src/snbt.c" \
     "$project_dir/src/nbt_builder.c" \
+    "$project_dir/src/nbt_find.c" \
+    "$project_dir/src/nbt_lazy.c" \
+    "$project_dir/src/nbt_query.c" \
+    "$project_dir/src/nbt_tree.c" \
     "$project_dir/src/nbt_utils.c" \
     "$project_dir/src/platform.c" \
-    -o "$test_bin"
+    -pthread -o "$test_bin"
 
 "$test_bin"
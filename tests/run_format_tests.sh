@@ -63,22 +63,22 @@ raw = pathlib.Path(sys.argv[1]).read_bytes()
 pathlib.Path(sys.argv[2]).write_bytes(zlib.compress(raw))
 PY
 
-echo "[1/5] Detect raw NBT for dump"
+echo "[1/6] Detect raw NBT for dump"
 "$BIN" "$RAW_FILE" --dump "$TMP_DIR/raw_dump.txt" >"$TMP_DIR/raw_dump.log" 2>&1
 assert_grep "Detected input format: raw" "$TMP_DIR/raw_dump.log"
 assert_grep "Tag: Data \(Type 0A\)" "$TMP_DIR/raw_dump.txt"
 
-echo "[2/5] Detect zlib NBT for dump"
+echo "[2/6] Detect zlib NBT for dump"
 "$BIN" "$ZLIB_FILE" --dump "$TMP_DIR/zlib_dump.txt" >"$TMP_DIR/zlib_dump.log" 2>&1
 assert_grep "Detected input format: zlib" "$TMP_DIR/zlib_dump.log"
 assert_grep "Tag: Data \(Type 0A\)" "$TMP_DIR/zlib_dump.txt"
 
-echo "[3/5] Edit raw NBT input"
+echo "[3/6] Edit raw NBT input"
 "$BIN" "$RAW_FILE" --edit "Data/SpawnX" "2468" --output "$TMP_DIR/raw_edit_out.dat" >"$TMP_DIR/raw_edit.log" 2>&1
 "$BIN" "$TMP_DIR/raw_edit_out.dat" --dump "$TMP_DIR/raw_edit_dump.txt" >"$TMP_DIR/raw_edit_dump.log" 2>&1
 assert_grep "Int: 2468" "$TMP_DIR/raw_edit_dump.txt"
 
-echo "[4/5] Edit zlib NBT input"
+echo "[4/6] Edit zlib NBT input"
 "$BIN" "$ZLIB_FILE" --edit "Data/SpawnX" "1357" --output "$TMP_DIR/zlib_edit_out.dat" >"$TMP_DIR/zlib_edit.log" 2>&1
 "$BIN" "$TMP_DIR/zlib_edit_out.dat" --dump "$TMP_DIR/zlib_edit_dump.txt" >"$TMP_DIR/zlib_edit_dump.log" 2>&1
 assert_grep "Int: 1357" "$TMP_DIR/zlib_edit_dump.txt"
@@ -92,10 +92,37 @@ if [[ ! -f "$MCA_FILE" ]]; then
   exit 1
 fi
 
-echo "[5/5] Detect .mca chunk load"
+echo "[5/6] Detect .mca chunk load"
 "$BIN" "$MCA_FILE" --dump "$TMP_DIR/mca_dump.txt" >"$TMP_DIR/mca_dump.log" 2>&1
 assert_grep "Detected source: mca_chunk" "$TMP_DIR/mca_dump.log"
 assert_grep "Using region chunk \\(" "$TMP_DIR/mca_dump.log"
 assert_grep "Tag: " "$TMP_DIR/mca_dump.txt"
 
+echo "[6/6] Reject Bedrock commands without a world database"
+mkdir -p "$TMP_DIR/not_a_world"
+if "$BIN" "$TMP_DIR/not_a_world" --bedrock-export "$TMP_DIR/export.jsonl" >"$TMP_DIR/bedrock_export.log" 2>&1; then
+  echo "Bedrock export accepted a folder without a database"
+  exit 1
+fi
+assert_grep "expected CURRENT or db/CURRENT" "$TMP_DIR/bedrock_export.log"
+if [[ -e "$TMP_DIR/export.jsonl" ]]; then
+  echo "Failed Bedrock export left an output file"
+  exit 1
+fi
+if "$BIN" "$TMP_DIR/not_a_world" --bedrock-blocks >"$TMP_DIR/bedrock_blocks.log" 2>&1; then
+  echo "Bedrock block count accepted a folder without a database"
+  exit 1
+fi
+assert_grep "expected CURRENT or db/CURRENT" "$TMP_DIR/bedrock_blocks.log"
+if "$BIN" "$TMP_DIR/not_a_world" --bedrock-restore "$TMP_DIR/bulk.cnbtbak" >"$TMP_DIR/bedrock_restore.log" 2>&1; then
+  echo "Bedrock restore accepted a folder without a database"
+  exit 1
+fi
+assert_grep "expected CURRENT or db/CURRENT" "$TMP_DIR/bedrock_restore.log"
+if "$BIN" "$TMP_DIR/not_a_world" --bedrock-stats >"$TMP_DIR/bedrock_stats.log" 2>&1; then
+  echo "Bedrock statistics accepted a folder without a database"
+  exit 1
+fi
+assert_grep "expected CURRENT or db/CURRENT" "$TMP_DIR/bedrock_stats.log"
+
 echo "All format tests passed"
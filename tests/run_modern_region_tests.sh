@@ -138,4 +138,38 @@ if "$BIN" "$TMP_DIR/output/r.4.-1.mca" --chunk 31 0 --dump "$TMP_DIR/missing.txt
 fi
 grep -q "Failed to load file" "$TMP_DIR/missing.log"
 
+# Many sidecars are read and rewritten through the concurrent I/O queue.
+mkdir "$TMP_DIR/many" "$TMP_DIR/many_out"
+python3 - "$TMP_DIR/many" <<'PY'
+import pathlib
+import struct
+import sys
+import zlib
+
+tmp = pathlib.Path(sys.argv[1])
+count = 12
+data = bytearray((2 + count) * 4096)
+for index in range(count):
+    sector = 2 + index
+    struct.pack_into(">I", data, index * 4, (sector << 8) | 1)
+    struct.pack_into(">I", data, 4096 + index * 4, 1000 + index)
+    struct.pack_into(">I", data, sector * 4096, 1)
+    data[sector * 4096 + 4] = 0x82
+    raw = b"\x0a\x00\x00" + b"\x03\x00\x04xPos" + struct.pack(">i", 700 + index) + b"\x00"
+    (tmp / f"c.{index}.0.mcc").write_bytes(zlib.compress(raw))
+(tmp / "r.0.0.mca").write_bytes(data)
+PY
+"$BIN" "$TMP_DIR/many/r.0.0.mca" --chunk 11 0 --set xPos 999 \
+  --output "$TMP_DIR/many_out/r.0.0.mca" >"$TMP_DIR/many_write.log" 2>&1
+for index in 0 5 10; do
+  "$BIN" "$TMP_DIR/many_out/r.0.0.mca" --chunk "$index" 0 --dump "$TMP_DIR/many_$index.txt" >/dev/null 2>&1
+  grep -q "Int: $((700 + index))" "$TMP_DIR/many_$index.txt"
+done
+"$BIN" "$TMP_DIR/many_out/r.0.0.mca" --chunk 11 0 --dump "$TMP_DIR/many_11.txt" >/dev/null 2>&1
+grep -q "Int: 999" "$TMP_DIR/many_11.txt"
+if ls "$TMP_DIR/many_out"/.chunk_* "$TMP_DIR/many_out"/.region_* >/dev/null 2>&1; then
+  echo "Temporary sidecar files were left behind"
+  exit 1
+fi
+
 echo "All modern region tests passed"
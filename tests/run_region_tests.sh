@@ -115,7 +115,7 @@ orig_dump="$TMP_DIR/orig_dump.txt"
 orig_log="$TMP_DIR/orig.log"
 
 
-echo "[1/7] Load .mca and dump selected chunk"
+echo "[1/12] Load .mca and dump selected chunk"
 "$BIN" "$MCA_FILE" --chunk 0 0 --dump "$orig_dump" >"$orig_log" 2>&1
 assert_grep "Detected source: mca_chunk" "$orig_log"
 assert_grep "Using region chunk \(0, 0\)" "$orig_log"
@@ -130,7 +130,7 @@ fi
 orig_count="$(assert_python_region_valid "$MCA_FILE")"
 
 
-echo "[2/7] Edit chunk and write full .mca output"
+echo "[2/12] Edit chunk and write full .mca output"
 edited_region="$TMP_DIR/edited_region.mca"
 "$BIN" "$MCA_FILE" --chunk 0 0 --set "Level/xPos" "12345" --output "$edited_region" >"$TMP_DIR/edit_out.log" 2>&1
 "$BIN" "$edited_region" --chunk 0 0 --dump "$TMP_DIR/edited_dump.txt" >"$TMP_DIR/edited_dump.log" 2>&1
@@ -138,7 +138,7 @@ assert_grep "Int: 12345" "$TMP_DIR/edited_dump.txt"
 assert_python_region_valid "$edited_region" >/dev/null
 
 
-echo "[3/7] In-place .mca edit with backup"
+echo "[3/12] In-place .mca edit with backup"
 cp "$MCA_FILE" "$TMP_DIR/in_place.mca"
 "$BIN" "$TMP_DIR/in_place.mca" --chunk 0 0 --set "Level/xPos" "22222" --in-place --backup >"$TMP_DIR/in_place.log" 2>&1
 assert_grep "Created backup:" "$TMP_DIR/in_place.log"
@@ -150,7 +150,7 @@ fi
 assert_grep "Int: 22222" "$TMP_DIR/in_place_dump.txt"
 
 
-echo "[4/7] Idempotence sanity (chunk count preserved on no-op write)"
+echo "[4/12] Idempotence sanity (chunk count preserved on no-op write)"
 no_op_region="$TMP_DIR/no_op_region.mca"
 "$BIN" "$MCA_FILE" --chunk 0 0 --set "Level/xPos" "$orig_xpos" --output "$no_op_region" >"$TMP_DIR/no_op.log" 2>&1
 new_count="$(assert_python_region_valid "$no_op_region")"
@@ -160,7 +160,7 @@ if [[ "$orig_count" != "$new_count" ]]; then
 fi
 
 
-echo "[5/7] Reject --in-place .mca without explicit --chunk"
+echo "[5/12] Reject --in-place .mca without explicit --chunk"
 if "$BIN" "$MCA_FILE" --set "Level/xPos" "1" --in-place >"$TMP_DIR/missing_chunk.log" 2>&1; then
   echo "Expected command to fail without explicit --chunk"
   exit 1
@@ -168,7 +168,7 @@ fi
 assert_grep "requires explicit --chunk" "$TMP_DIR/missing_chunk.log"
 
 
-echo "[6/7] Corruption test: out-of-range chunk offset"
+echo "[6/12] Corruption test: out-of-range chunk offset"
 python3 - "$MCA_FILE" "$TMP_DIR/corrupt_oob.mca" <<'PY'
 import pathlib
 import struct
@@ -187,7 +187,7 @@ fi
 assert_grep "Failed to load file" "$TMP_DIR/corrupt_oob.log"
 
 
-echo "[7/7] Corruption test: overlapping sector allocations"
+echo "[7/12] Corruption test: overlapping sector allocations"
 python3 - "$MCA_FILE" "$TMP_DIR/corrupt_overlap.mca" <<'PY'
 import pathlib
 import struct
@@ -206,4 +206,99 @@ if "$BIN" "$TMP_DIR/corrupt_overlap.mca" --dump "$TMP_DIR/ignore2.txt" >"$TMP_DI
 fi
 assert_grep "Failed to load file" "$TMP_DIR/corrupt_overlap.log"
 
+
+echo "[8/12] Incremental --verify builds and reuses the sidecar index"
+cp "$MCA_FILE" "$TMP_DIR/verify.mca"
+"$BIN" "$TMP_DIR/verify.mca" --verify >"$TMP_DIR/verify_first.log" 2>&1
+assert_grep "Updated index:" "$TMP_DIR/verify_first.log"
+assert_grep " 0 reused from index" "$TMP_DIR/verify_first.log"
+if [[ ! -f "$TMP_DIR/verify.mca.cnbtidx" ]]; then
+  echo "Expected --verify to write a sidecar index"
+  exit 1
+fi
+"$BIN" "$TMP_DIR/verify.mca" --verify >"$TMP_DIR/verify_second.log" 2>&1
+assert_grep ": 0 hashed" "$TMP_DIR/verify_second.log"
+assert_grep "Region header unchanged" "$TMP_DIR/verify_second.log"
+"$BIN" "$TMP_DIR/verify.mca" --chunk 0 0 --set "Level/xPos" "333" --in-place >"$TMP_DIR/verify_edit.log" 2>&1
+"$BIN" "$TMP_DIR/verify.mca" --verify >"$TMP_DIR/verify_third.log" 2>&1
+assert_grep ": 1 hashed" "$TMP_DIR/verify_third.log"
+
+
+echo "[9/12] Full --verify detects payload damage behind an unchanged timestamp"
+python3 - "$TMP_DIR/verify.mca" <<'PY'
+import pathlib
+import struct
+import sys
+
+path = pathlib.Path(sys.argv[1])
+data = bytearray(path.read_bytes())
+offset = (struct.unpack_from(">I", data, 0)[0] >> 8) * 4096
+data[offset + 8] ^= 0xFF
+path.write_bytes(data)
+PY
+"$BIN" "$TMP_DIR/verify.mca" --verify >"$TMP_DIR/verify_incremental.log" 2>&1
+if "$BIN" "$TMP_DIR/verify.mca" --verify=full >"$TMP_DIR/verify_full.log" 2>&1; then
+  echo "Expected --verify=full to report the damaged chunk"
+  exit 1
+fi
+assert_grep "Chunk \(0, 0\) changed without a timestamp update" "$TMP_DIR/verify_full.log"
+
+echo "[10/12] Query every chunk of a region and a world folder"
+mkdir -p "$TMP_DIR/query_world/region"
+cp "$MCA_FILE" "$TMP_DIR/query_world/region/r.0.0.mca"
+"$BIN" "$MCA_FILE" --query 'Level[?xPos==0]{x: xPos}' >"$TMP_DIR/query_region.json" 2>"$TMP_DIR/query_region.log"
+assert_grep '"chunk":\[0,0\]' "$TMP_DIR/query_region.json"
+assert_grep '"name":"x","path":"Level/x"' "$TMP_DIR/query_region.json"
+assert_grep '"count":1,"errors":0' "$TMP_DIR/query_region.json"
+"$BIN" "$TMP_DIR/query_world" --query '..zPos' >"$TMP_DIR/query_world.json" 2>"$TMP_DIR/query_world.log"
+assert_grep 'query_world/region/r.0.0.mca' "$TMP_DIR/query_world.json"
+assert_grep '"count":1,"errors":0' "$TMP_DIR/query_world.json"
+
+echo "[11/12] Find and replace across a world folder"
+"$BIN" "$TMP_DIR/query_world" --find --name '?Pos' --type int >"$TMP_DIR/find_world.json" 2>"$TMP_DIR/find_world.log"
+assert_grep '"count":2,"errors":0' "$TMP_DIR/find_world.json"
+if "$BIN" "$TMP_DIR/query_world" --find --name xPos --replace-value 7 >"$TMP_DIR/find_no_in_place.log" 2>&1; then
+  echo "Expected a world replace without --in-place to fail"
+  exit 1
+fi
+"$BIN" "$TMP_DIR/query_world" --find --name xPos --replace-value 7 --in-place --backup >"$TMP_DIR/find_replace.log" 2>&1
+assert_grep "Replaced 1 of 1 matching tags in 1 region files" "$TMP_DIR/find_replace.log"
+[[ -f "$TMP_DIR/query_world/region/r.0.0.mca.bak" ]] || { echo "Missing region backup"; exit 1; }
+"$BIN" "$TMP_DIR/query_world/region/r.0.0.mca" --query 'Level.xPos' >"$TMP_DIR/find_check.json" 2>&1
+assert_grep '"value":7' "$TMP_DIR/find_check.json"
+
+echo "[12/12] A replace with a damaged chunk leaves its region unchanged"
+mkdir -p "$TMP_DIR/damaged_world/region"
+python3 - "$MCA_FILE" "$TMP_DIR/damaged_world/region/r.0.0.mca" <<'PY'
+import pathlib
+import struct
+import sys
+
+# Copy chunk (0, 0) into slot (1, 0) at the end of the file, then damage the copy.
+data = bytearray(pathlib.Path(sys.argv[1]).read_bytes())
+location = struct.unpack_from(">I", data, 0)[0]
+offset, count = (location >> 8) * 4096, location & 0xFF
+copy = bytearray(data[offset:offset + count * 4096])
+copy[8] ^= 0xFF
+struct.pack_into(">I", data, 4, ((len(data) // 4096) << 8) | count)
+data += copy
+pathlib.Path(sys.argv[2]).write_bytes(data)
+PY
+cp "$TMP_DIR/damaged_world/region/r.0.0.mca" "$TMP_DIR/damaged_before.mca"
+if "$BIN" "$TMP_DIR/damaged_world" --find --name xPos --replace-value 7 --in-place >"$TMP_DIR/find_damaged.log" 2>&1; then
+  echo "Expected a replace with a damaged chunk to fail"
+  exit 1
+fi
+assert_grep "Skipped .*r.0.0.mca: 1 chunks failed" "$TMP_DIR/find_damaged.log"
+cmp -s "$TMP_DIR/damaged_before.mca" "$TMP_DIR/damaged_world/region/r.0.0.mca" || {
+  echo "A region with a damaged chunk was rewritten"
+  exit 1
+}
+if "$BIN" "$TMP_DIR/damaged_world" --find --name xPos --replace-value 7 --in-place --allow-partial \
+    >"$TMP_DIR/find_partial.log" 2>&1; then
+  echo "Expected a partial replace to report failure"
+  exit 1
+fi
+assert_grep "Replaced 1 of 1 matching tags in 1 region files \(1 errors\)" "$TMP_DIR/find_partial.log"
+
 echo "All region tests passed"
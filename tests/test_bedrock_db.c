@@ -8,6 +8,7 @@
 #include <unistd.h>
 #endif
 
+#include "bedrock_batch.h"
 #include "bedrock_db.h"
 #include "nbt_builder.h"
 #include "snbt.h"
@@ -41,6 +42,31 @@ static int count_records(
     return 1;
 }
 
+typedef struct {
+    size_t count;
+    size_t value_size;
+    unsigned char prefix[2];
+    size_t prefix_size;
+} ScanResult;
+
+static int record_scan(
+    const unsigned char* key,
+    size_t key_size,
+    size_t value_size,
+    const unsigned char* value_prefix,
+    size_t value_prefix_size,
+    void* user_data
+) {
+    ScanResult* result = user_data;
+    (void)key;
+    (void)key_size;
+    ++result->count;
+    result->value_size = value_size;
+    result->prefix_size = value_prefix_size;
+    if (value_prefix_size <= sizeof(result->prefix)) memcpy(result->prefix, value_prefix, value_prefix_size);
+    return 1;
+}
+
 #ifdef NBT_EXPLORER_TEST_BUNDLED_LEVELDB
 static unsigned long process_id(void) {
 #ifdef _WIN32
@@ -87,10 +113,16 @@ static int destroy_fixture(const char* path, char* err, size_t err_sz) {
 
 int main(int argc, char** argv) {
     static const unsigned char nbt_key[] = "cnbt:test:nbt";
+    static const unsigned char roots_key[] = "cnbt:test:roots";
     static const unsigned char raw_key_a[] = "cnbt:test:raw:a";
     static const unsigned char raw_key_b[] = "cnbt:test:raw:b";
     static const unsigned char large_key[] = "cnbt:test:raw:large";
     static const unsigned char flush_key[] = "cnbt:test:raw:flush";
+    static const unsigned char batch_keys[3][20] = {
+        "cnbt:test:batch:a", "cnbt:test:batch:b", "cnbt:test:raw:a"
+    };
+    static const unsigned char raw_start[] = "cnbt:test:raw:";
+    static const unsigned char raw_end[] = "cnbt:test:raw;";
     static const unsigned char raw_value_a[] = {0, 1, 2, 0, 255};
     static const unsigned char raw_value_b[] = "temporary";
     BedrockDB* db;
@@ -102,6 +134,13 @@ int main(int argc, char** argv) {
     unsigned char* large_value = NULL;
     size_t raw_size = 0;
     size_t record_count = 0;
+    ScanResult scan = {0};
+    BedrockDBScanOptions scan_options = {0};
+    BedrockDBSnapshot* snapshot = NULL;
+    BedrockDBBatch* batch = NULL;
+    BedrockDBRange whole_range = {0};
+    uint64_t table_size = 0;
+    char backup_path[4200];
     int found = 0;
     char err[512] = {0};
     BedrockDBMutation mutations[3];
@@ -162,6 +201,20 @@ int main(int argc, char** argv) {
     free_nbt_tree(source);
     free_nbt_tree(loaded);
 
+    source = snbt_parse("[{id:\"Chest\"},{id:\"Sign\"}]", "", err, sizeof(err));
+    CHECK(source != NULL, err);
+    if (source) {
+        CHECK(bedrock_db_put_nbt_roots(db, roots_key, sizeof(roots_key) - 1,
+                                       source, err, sizeof(err)), err);
+        loaded = bedrock_db_get_nbt_roots(db, roots_key, sizeof(roots_key) - 1,
+                                          &found, err, sizeof(err));
+        CHECK(found && loaded && loaded->value.list.count == 2, err);
+        CHECK(!bedrock_db_get_nbt(db, roots_key, sizeof(roots_key) - 1, &found, err, sizeof(err)),
+              "concatenated roots were read as one NBT document");
+        free_nbt_tree(source);
+        free_nbt_tree(loaded);
+    }
+
     mutations[0] = (BedrockDBMutation){
         BEDROCK_DB_PUT, raw_key_a, sizeof(raw_key_a) - 1,
         raw_value_a, sizeof(raw_value_a)
@@ -187,6 +240,81 @@ int main(int argc, char** argv) {
     free(raw);
     CHECK(bedrock_db_iterate(db, count_records, &record_count, err, sizeof(err)), err);
     CHECK(record_count >= 2, "LevelDB iteration did not return inserted records");
+    scan_options.start = raw_start;
+    scan_options.start_size = sizeof(raw_start) - 1;
+    scan_options.end = raw_end;
+    scan_options.end_size = sizeof(raw_end) - 1;
+    scan_options.value_prefix_size = 2;
+    CHECK(bedrock_db_scan(db, &scan_options, record_scan, &scan, err, sizeof(err)), err);
+    CHECK(scan.count == 1 && scan.value_size == sizeof(raw_value_a) &&
+          scan.prefix_size == 2 && scan.prefix[0] == 0 && scan.prefix[1] == 1,
+          "bounded key scan returned the wrong records or value prefix");
+    record_count = 0;
+    CHECK(bedrock_db_iterate_prefix(db, raw_start, sizeof(raw_start) - 1,
+                                    count_records, &record_count, err, sizeof(err)), err);
+    CHECK(record_count == 1, "prefix iteration returned records outside the prefix");
+    snapshot = bedrock_db_snapshot_create(db, err, sizeof(err));
+    CHECK(snapshot != NULL, err);
+    if (snapshot) {
+        mutations[0] = (BedrockDBMutation){
+            BEDROCK_DB_PUT, raw_key_b, sizeof(raw_key_b) - 1,
+            raw_value_b, sizeof(raw_value_b) - 1
+        };
+        CHECK(bedrock_db_apply_mutations(db, mutations, 1, err, sizeof(err)), err);
+        memset(&scan, 0, sizeof(scan));
+        scan_options.snapshot = snapshot;
+        CHECK(bedrock_db_scan(db, &scan_options, record_scan, &scan, err, sizeof(err)), err);
+        CHECK(scan.count == 1, "snapshot scan saw a record written after the snapshot");
+        scan_options.snapshot = NULL;
+        bedrock_db_snapshot_release(db, snapshot);
+        mutations[0].type = BEDROCK_DB_DELETE;
+        CHECK(bedrock_db_apply_mutations(db, mutations, 1, err, sizeof(err)), err);
+    }
+
+    /* A tiny batch limit forces several unsynced flushes before the final sync;
+       restoring the backup must bring back the value the raw key had before. */
+    snprintf(backup_path, sizeof(backup_path), "%s.cnbtbak", database_path);
+    batch = bedrock_db_batch_create(db, 16, backup_path, err, sizeof(err));
+    CHECK(batch != NULL, err);
+    if (batch) {
+        for (size_t i = 0; i < 3; ++i) {
+            size_t key_size = strlen((const char*)batch_keys[i]);
+            CHECK(bedrock_db_batch_put(batch, batch_keys[i], key_size,
+                                       raw_value_b, sizeof(raw_value_b) - 1, err, sizeof(err)), err);
+        }
+        CHECK(bedrock_db_batch_delete(batch, batch_keys[1], strlen((const char*)batch_keys[1]),
+                                      err, sizeof(err)), err);
+        CHECK(bedrock_db_batch_finish(batch, err, sizeof(err)), err);
+        CHECK(bedrock_db_batch_written(batch) == 4 && bedrock_db_batch_flushes(batch) > 1,
+              "bulk writer did not split records into several batches");
+        bedrock_db_batch_free(batch);
+        CHECK(bedrock_db_get(db, batch_keys[2], strlen((const char*)batch_keys[2]),
+                             &raw, &raw_size, &found, err, sizeof(err)), err);
+        CHECK(found && raw_size == sizeof(raw_value_b) - 1, "bulk write did not replace a record");
+        free(raw);
+        raw = NULL;
+        CHECK(bedrock_db_get(db, batch_keys[1], strlen((const char*)batch_keys[1]),
+                             &raw, &raw_size, &found, err, sizeof(err)), err);
+        CHECK(!found, "bulk delete did not take effect");
+        free(raw);
+        raw = NULL;
+        CHECK(bedrock_db_batch_create(db, 0, backup_path, err, sizeof(err)) == NULL,
+              "a second bulk batch truncated an existing backup");
+        CHECK(bedrock_db_batch_restore(db, backup_path, err, sizeof(err)), err);
+        CHECK(bedrock_db_get(db, batch_keys[2], strlen((const char*)batch_keys[2]),
+                             &raw, &raw_size, &found, err, sizeof(err)), err);
+        CHECK(found && raw_size == sizeof(raw_value_a) &&
+              memcmp(raw, raw_value_a, sizeof(raw_value_a)) == 0,
+              "bulk backup did not restore the original record");
+        free(raw);
+        raw = NULL;
+        CHECK(bedrock_db_get(db, batch_keys[0], strlen((const char*)batch_keys[0]),
+                             &raw, &raw_size, &found, err, sizeof(err)), err);
+        CHECK(!found, "bulk backup did not remove a record that was new");
+        free(raw);
+        raw = NULL;
+        remove(backup_path);
+    }
 
     /* Exceed the default memtable, then write again so the test covers an SST
        block encoded with Bedrock's raw-zlib compressor rather than only WAL IO. */
@@ -205,6 +333,9 @@ int main(int argc, char** argv) {
         };
         CHECK(bedrock_db_apply_mutations(db, mutations, 2, err, sizeof(err)), err);
     }
+    CHECK(bedrock_db_compact_range(db, NULL, err, sizeof(err)), err);
+    CHECK(bedrock_db_approximate_sizes(db, &whole_range, 1, &table_size, err, sizeof(err)), err);
+    CHECK(!large_value || table_size > 0, "compacted tables report no approximate size");
     bedrock_db_close(db);
 
     db = bedrock_db_open(database_path, BEDROCK_DB_LOGICAL_READ_ONLY,
@@ -223,6 +354,8 @@ int main(int argc, char** argv) {
         }
         CHECK(!bedrock_db_apply_mutations(db, mutations, 1, err, sizeof(err)),
               "logical read-only database accepted a write");
+        CHECK(!bedrock_db_compact_range(db, NULL, err, sizeof(err)),
+              "logical read-only database accepted a compaction");
         bedrock_db_close(db);
     }
     free(large_value);
@@ -3,8 +3,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "bedrock_keys.h"
+#include "bedrock_subchunk.h"
 #include "nbt_binary.h"
 #include "nbt_builder.h"
+#include "nbt_find.h"
+#include "nbt_lazy.h"
+#include "nbt_query.h"
+#include "nbt_tree.h"
+#include "platform.h"
 #include "snbt.h"
 
 static int failures = 0;
@@ -143,10 +150,556 @@ static void test_invalid_inputs(void) {
     free_nbt_tree(tag);
 }
 
+static void test_compound_name_index(void) {
+    NBTTag* compound = nbt_tag_create(TAG_Compound, "");
+    NBTTag* child;
+    char name[32];
+    int i;
+    int found_all = 1;
+
+    CHECK(compound != NULL, "compound allocation failed");
+    if (!compound) return;
+    for (i = 0; i < 2000; i++) {
+        snprintf(name, sizeof(name), "key%d", i);
+        child = nbt_tag_create(TAG_Int, name);
+        if (!child || !nbt_compound_append(compound, child)) {
+            free_nbt_tree(child);
+            CHECK(0, "compound append failed");
+            free_nbt_tree(compound);
+            return;
+        }
+        child->value.int_val = i;
+    }
+    CHECK(compound->value.compound.index != NULL, "large compound did not build a name index");
+
+    child = nbt_tag_create(TAG_Int, "key7");
+    CHECK(child && !nbt_compound_append(compound, child), "duplicate compound name was accepted");
+    free_nbt_tree(child);
+
+    for (i = 0; i < 2000; i++) {
+        snprintf(name, sizeof(name), "key%d", i);
+        if (nbt_compound_find_index(compound, name) != i) found_all = 0;
+    }
+    CHECK(found_all, "indexed compound lookup returned the wrong position");
+    CHECK(nbt_compound_find_index(compound, "key2000") < 0, "missing key was found");
+
+    child = nbt_compound_take(compound, 0);
+    CHECK(child && strcmp(child->name, "key0") == 0, "compound take removed the wrong child");
+    free_nbt_tree(child);
+    CHECK(nbt_compound_find_index(compound, "key0") < 0, "removed key is still indexed");
+    CHECK(nbt_compound_find_index(compound, "key1999") == 1998, "index did not follow a removal");
+
+    child = compound->value.compound.items[10];
+    CHECK(nbt_compound_rename_child(compound, child, "renamed"), "rename failed");
+    CHECK(nbt_compound_find_index(compound, "renamed") == 10, "renamed key was not found");
+    CHECK(nbt_compound_find_index(compound, "key11") < 0, "old name survived a rename");
+
+    free_nbt_tree(compound);
+}
+
+typedef struct {
+    char text[4096];
+    size_t len;
+} QueryTranscript;
+
+static int record_match(const NBTTag* match, const char* path, void* user) {
+    QueryTranscript* transcript = user;
+    char* value = canonical(match);
+    int written = snprintf(transcript->text + transcript->len, sizeof(transcript->text) - transcript->len,
+                           "%s=%s;", path, value ? value : "?");
+    free(value);
+    if (written > 0 && (size_t)written < sizeof(transcript->text) - transcript->len) {
+        transcript->len += (size_t)written;
+    }
+    return 1;
+}
+
+static void test_streaming_query(void) {
+    static const char* const queries[] = {
+        "Level.xPos",
+        "Level/Entities[?id==\"minecraft:villager\" && Health<5]{id, hp: Health}",
+        "Level.Entities[-1].Pos[1]",
+        "..id",
+        "..*",
+        "Level.UUID[?@<0]",
+        "Level.Sections[*].Palette[0]",
+        "Level.*.missing",
+        "Level.Entities[?!Tags].id",
+        "Level[?xPos==3]{x: xPos, missing}"
+    };
+    const char* source =
+        "{Level: {xPos: 3, Entities: [{id: \"minecraft:cow\", Health: 10.0f, Pos: [1.0d, 2.0d, 3.0d]},"
+        " {id: \"minecraft:villager\", Health: 4.5f, Tags: [\"trader\"], Pos: [4.0d, 5.0d, 6.0d]}],"
+        " UUID: [I; 1, -2, 3, 4], Sections: [{Palette: [\"air\", \"stone\"]}, {Palette: []}],"
+        " Heights: [L; 7L, 8L], \"odd/key\": 5b}}";
+    static const NBTBinaryFormat formats[] = { NBT_BINARY_JAVA, NBT_BINARY_BEDROCK };
+    char err[256] = {0};
+    NBTTag* root = snbt_parse(source, "", err, sizeof(err));
+    size_t q;
+    int f;
+
+    CHECK(root != NULL, err);
+    if (!root) return;
+    for (f = 0; f < 2; f++) {
+        unsigned char* data = NULL;
+        size_t size = 0;
+
+        CHECK(nbt_binary_serialize(root, formats[f], 0, &data, &size, err, sizeof(err)), err);
+        if (!data) continue;
+        for (q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+            QueryTranscript from_tree;
+            QueryTranscript from_stream;
+            NBTQuery* query = nbt_query_compile(queries[q], err, sizeof(err));
+
+            CHECK(query != NULL, err);
+            if (!query) continue;
+            memset(&from_tree, 0, sizeof(from_tree));
+            memset(&from_stream, 0, sizeof(from_stream));
+            CHECK(nbt_query_run(query, root, record_match, &from_tree, err, sizeof(err)), err);
+            CHECK(nbt_query_run_binary(query, data, size, formats[f], record_match, &from_stream,
+                                       err, sizeof(err)), err);
+            if (strcmp(from_tree.text, from_stream.text) != 0) {
+                fprintf(stderr, "query %s\n  tree:   %s\n  stream: %s\n",
+                        queries[q], from_tree.text, from_stream.text);
+                CHECK(0, "streaming query disagrees with the tree walk");
+            }
+            nbt_query_free(query);
+        }
+        /* A truncated stream must fail instead of reporting partial results. */
+        {
+            QueryTranscript ignored;
+            NBTQuery* query = nbt_query_compile("..*", err, sizeof(err));
+            memset(&ignored, 0, sizeof(ignored));
+            CHECK(query && !nbt_query_run_binary(query, data, size / 2, formats[f], record_match,
+                                                 &ignored, err, sizeof(err)),
+                  "truncated stream was accepted");
+            nbt_query_free(query);
+        }
+        free(data);
+    }
+    free_nbt_tree(root);
+}
+
+static void check_same_tree(const NBTTag* expected, NBTTag* actual, const char* message) {
+    char* before = expected ? canonical(expected) : NULL;
+    char* after = actual ? canonical(actual) : NULL;
+
+    CHECK(before && after && strcmp(before, after) == 0, message);
+    free(before);
+    free(after);
+    free_nbt_tree(actual);
+}
+
+static void test_lazy_document(void) {
+    const char* source =
+        "{Level: {xPos: 3, Entities: [{id: \"minecraft:cow\", Pos: [1.0d, 2.0d]},"
+        " {id: \"minecraft:villager\", Tags: [\"trader\"]}], UUID: [I; 1, -2, 3, 4], Empty: {}}}";
+    static const NBTBinaryFormat formats[] = {
+        NBT_BINARY_JAVA, NBT_BINARY_BEDROCK, NBT_BINARY_BEDROCK_LEVEL_DAT
+    };
+    char err[256] = {0};
+    NBTTag* root = snbt_parse(source, "", err, sizeof(err));
+    int f;
+
+    CHECK(root != NULL, err);
+    if (!root) return;
+    for (f = 0; f < 3; f++) {
+        unsigned char* data = NULL;
+        size_t size = 0;
+        NBTBinaryInfo info;
+        NBTLazyDocument* document;
+        const NBTLazyEntry* level;
+        const NBTLazyEntry* entities;
+        const NBTLazyEntry* children = NULL;
+        const NBTLazyEntry* again = NULL;
+        const NBTTag* level_tag = root->value.compound.items[0];
+        NBTTag* shallow;
+        int count = 0;
+
+        CHECK(nbt_binary_serialize(root, formats[f], 9, &data, &size, err, sizeof(err)), err);
+        if (!data) continue;
+        document = nbt_lazy_open(data, size, NBT_BINARY_AUTO, &info, err, sizeof(err));
+        CHECK(document != NULL, err);
+        if (!document) {
+            free(data);
+            continue;
+        }
+        CHECK(info.format == formats[f], "lazy open detected the wrong format");
+
+        level = nbt_lazy_find_child(document, nbt_lazy_root(document), "Level", err, sizeof(err));
+        CHECK(level && level->type == TAG_Compound, "lazy lookup missed Level");
+        entities = level ? nbt_lazy_find_child(document, level, "Entities", err, sizeof(err)) : NULL;
+        CHECK(entities && nbt_lazy_children(document, entities, &children, &count, err, sizeof(err)) &&
+              count == 2, "lazy list children were not indexed");
+        CHECK(entities && nbt_lazy_children(document, entities, &again, &count, err, sizeof(err)) &&
+              again == children, "lazy child index was rebuilt");
+        if (children && count == 2) {
+            check_same_tree(level_tag->value.compound.items[1]->value.list.items[1],
+                            nbt_lazy_materialize(document, &children[1], err, sizeof(err)),
+                            "lazy list element differs from the full parse");
+        }
+        CHECK(level && !nbt_lazy_find_child(document, level, "missing", err, sizeof(err)) && !err[0],
+              "missing lazy child reported an error");
+
+        shallow = level ? nbt_lazy_materialize_shallow(document, level, err, sizeof(err)) : NULL;
+        CHECK(shallow && shallow->type == TAG_Compound && shallow->value.compound.count == 0 &&
+              strcmp(shallow->name, "Level") == 0, "shallow compound was not empty");
+        free_nbt_tree(shallow);
+        check_same_tree(root, nbt_lazy_materialize(document, nbt_lazy_root(document), err, sizeof(err)),
+                        "lazy root materialization differs from the full parse");
+        nbt_lazy_close(document);
+
+        document = nbt_lazy_open(data, size - 1, formats[f], NULL, err, sizeof(err));
+        CHECK(document == NULL, "truncated document opened lazily");
+        nbt_lazy_close(document);
+        free(data);
+    }
+    free_nbt_tree(root);
+}
+
+static void test_bedrock_chunk_keys(void) {
+    static const unsigned char nether_subchunk[] = {
+        0xFE, 0xFF, 0xFF, 0xFF, 0x05, 0x00, 0x00, 0x00,
+        0x01, 0x00, 0x00, 0x00, 0x2F, 0xFC
+    };
+    static const unsigned char all_ff[] = {0x61, 0xFF, 0xFF};
+    BedrockChunkKey key = {-2, 5, BEDROCK_DIMENSION_NETHER, BEDROCK_TAG_SUBCHUNK_PREFIX, 1, -4};
+    BedrockChunkKey parsed;
+    unsigned char bytes[BEDROCK_CHUNK_KEY_MAX];
+    unsigned char end[8];
+    size_t size;
+
+    size = bedrock_chunk_key_build(&key, bytes);
+    CHECK(size == sizeof(nether_subchunk) && memcmp(bytes, nether_subchunk, size) == 0,
+          "Bedrock subchunk key layout mismatch");
+    CHECK(bedrock_chunk_key_parse(bytes, size, &parsed) && parsed.x == -2 && parsed.z == 5 &&
+          parsed.dimension == 1 && parsed.tag == 0x2F && parsed.has_subchunk && parsed.subchunk == -4,
+          "Bedrock subchunk key did not parse back");
+    key.dimension = BEDROCK_DIMENSION_OVERWORLD;
+    key.tag = BEDROCK_TAG_ENTITY;
+    key.has_subchunk = 0;
+    CHECK(bedrock_chunk_key_build(&key, bytes) == 9, "Overworld chunk keys omit the dimension");
+    CHECK(bedrock_chunk_key_prefix(-2, 5, BEDROCK_DIMENSION_END, bytes) == 12,
+          "other dimensions keep the dimension in the chunk prefix");
+    CHECK(!bedrock_chunk_key_parse((const unsigned char*)"~local_pl", 9, NULL),
+          "a string key was taken for a chunk key");
+    CHECK(bedrock_key_prefix_end(all_ff, sizeof(all_ff), end) == 1 && end[0] == 0x62,
+          "prefix upper bound must skip trailing 0xFF bytes");
+    CHECK(bedrock_key_prefix_end(all_ff + 1, 2, end) == 0, "an all-0xFF prefix has no upper bound");
+}
+
+/* Appends a buffer to a growing byte vector; the test fixture is small. */
+static int append_bytes(unsigned char** data, size_t* size, const void* bytes, size_t count) {
+    unsigned char* grown = realloc(*data, *size + count);
+    if (!grown) return 0;
+    memcpy(grown + *size, bytes, count);
+    *data = grown;
+    *size += count;
+    return 1;
+}
+
+static int append_le32(unsigned char** data, size_t* size, uint32_t value) {
+    unsigned char bytes[4] = {
+        (unsigned char)value, (unsigned char)(value >> 8),
+        (unsigned char)(value >> 16), (unsigned char)(value >> 24)
+    };
+    return append_bytes(data, size, bytes, sizeof(bytes));
+}
+
+static int append_block_state(unsigned char** data, size_t* size, const char* name) {
+    char source[128];
+    char err[256] = {0};
+    unsigned char* root_data = NULL;
+    size_t root_size = 0;
+    NBTTag* root;
+    int ok;
+
+    snprintf(source, sizeof(source), "{name:\"%s\",states:{},version:17959425}", name);
+    root = snbt_parse(source, "", err, sizeof(err));
+    ok = root && nbt_binary_serialize(root, NBT_BINARY_BEDROCK, 0, &root_data, &root_size,
+                                      err, sizeof(err)) &&
+         append_bytes(data, size, root_data, root_size);
+    free(root_data);
+    free_nbt_tree(root);
+    return ok;
+}
+
+/* Packs index(i) for every block at the given width, as Bedrock does. */
+static int append_block_indices(unsigned char** data, size_t* size, int bits,
+                                uint16_t (*index)(size_t)) {
+    size_t per_word = 32u / (unsigned)bits;
+    size_t words = (BEDROCK_SUBCHUNK_VOLUME + per_word - 1) / per_word;
+    size_t w;
+    size_t j;
+    for (w = 0; w < words; w++) {
+        uint32_t word = 0;
+        for (j = 0; j < per_word && w * per_word + j < BEDROCK_SUBCHUNK_VOLUME; j++) {
+            word |= (uint32_t)index(w * per_word + j) << (j * (size_t)bits);
+        }
+        if (!append_le32(data, size, word)) return 0;
+    }
+    return 1;
+}
+
+static uint16_t three_way(size_t i) { return (uint16_t)(i % 3); }
+static uint16_t five_way(size_t i) { return (uint16_t)(i % 5); }
+
+static void test_bedrock_subchunk(void) {
+    static const char* names[] = {"minecraft:air", "minecraft:stone", "minecraft:dirt",
+                                  "minecraft:granite", "minecraft:water"};
+    unsigned char header[] = {9, 2, 0xFC, 2 << 1};
+    unsigned char water_storage = 0;
+    unsigned char v8_header[] = {8, 1, 3 << 1};
+    unsigned char legacy[] = {0, 0, 0};
+    unsigned char* data = NULL;
+    size_t size = 0;
+    char err[256] = {0};
+    BedrockSubChunk* subchunk;
+    int ok = 1;
+    size_t i;
+
+    /* Version 9: a 2-bit storage of three blocks, then a uniform 0-bit storage. */
+    ok = append_bytes(&data, &size, header, sizeof(header)) &&
+         append_block_indices(&data, &size, 2, three_way) &&
+         append_le32(&data, &size, 3);
+    for (i = 0; ok && i < 3; i++) ok = append_block_state(&data, &size, names[i]);
+    ok = ok && append_bytes(&data, &size, &water_storage, 1) &&
+         append_block_state(&data, &size, names[0]);
+    CHECK(ok, "could not build a SubChunkPrefix fixture");
+    subchunk = ok ? bedrock_subchunk_decode(data, size, 0, err, sizeof(err)) : NULL;
+    CHECK(subchunk != NULL, err);
+    if (subchunk) {
+        CHECK(subchunk->version == 9 && subchunk->has_y && subchunk->y == -4 &&
+              subchunk->storage_count == 2 && subchunk->bytes_consumed == size,
+              "SubChunkPrefix header mismatch");
+        CHECK(subchunk->storages[0].palette_size == 3 &&
+              strcmp(subchunk->storages[0].palette[1].name, "minecraft:stone") == 0,
+              "back-to-back palette roots were not all parsed");
+        CHECK(subchunk->storages[0].palette[0].count == 1366 &&
+              subchunk->storages[0].palette[1].count == 1365 &&
+              subchunk->storages[0].palette[2].count == 1365 &&
+              subchunk->storages[0].indices == NULL,
+              "block histogram mismatch");
+        CHECK(subchunk->storages[1].bits_per_block == 0 &&
+              subchunk->storages[1].palette[0].count == BEDROCK_SUBCHUNK_VOLUME,
+              "a 0-bit storage is one uniform block");
+    }
+    bedrock_subchunk_free(subchunk);
+    CHECK(!bedrock_subchunk_decode(data, size - 1, 0, err, sizeof(err)),
+          "a truncated palette decoded");
+    free(data);
+
+    /* Version 8 at 3 bits: padded words and a partial last word. */
+    data = NULL;
+    size = 0;
+    ok = append_bytes(&data, &size, v8_header, sizeof(v8_header)) &&
+         append_block_indices(&data, &size, 3, five_way) &&
+         append_le32(&data, &size, 4);
+    for (i = 0; ok && i < 4; i++) ok = append_block_state(&data, &size, names[i]);
+    CHECK(ok, "could not build a 3-bit SubChunkPrefix fixture");
+    subchunk = ok ? bedrock_subchunk_decode(data, size, BEDROCK_SUBCHUNK_KEEP_INDICES,
+                                            err, sizeof(err)) : NULL;
+    CHECK(subchunk != NULL, err);
+    if (subchunk && subchunk->storages[0].indices) {
+        const BedrockBlockStorage* storage = &subchunk->storages[0];
+        int indices_match = 1;
+        for (i = 0; i < BEDROCK_SUBCHUNK_VOLUME; i++) {
+            if (storage->indices[i] != five_way(i)) indices_match = 0;
+        }
+        CHECK(indices_match, "3-bit block indices did not unpack");
+        CHECK(storage->invalid_count == 819 && storage->palette[3].count == 819,
+              "indices past the palette must be counted as invalid");
+    } else {
+        CHECK(0, "3-bit SubChunkPrefix did not keep its indices");
+    }
+    bedrock_subchunk_free(subchunk);
+    free(data);
+
+    CHECK(!bedrock_subchunk_decode(legacy, sizeof(legacy), 0, err, sizeof(err)) &&
+          strstr(err, "version 0"), "a legacy SubChunkPrefix was accepted");
+}
+
+static void test_concatenated_roots(void) {
+    static const char* sources[] = {"{id:\"Chest\",x:1}", "{id:\"Sign\",x:2}", "{id:\"Bed\",x:3}"};
+    unsigned char* data = NULL;
+    unsigned char* rewritten = NULL;
+    size_t size = 0;
+    size_t rewritten_size = 0;
+    char err[256] = {0};
+    NBTBinaryRoots roots;
+    NBTTag* root = NULL;
+    NBTTag* list;
+    size_t i;
+    int ok = 1;
+
+    for (i = 0; ok && i < 3; i++) {
+        unsigned char* root_data = NULL;
+        size_t root_size = 0;
+        NBTTag* tag = snbt_parse(sources[i], "", err, sizeof(err));
+        ok = tag && nbt_binary_serialize(tag, NBT_BINARY_BEDROCK, 0, &root_data, &root_size,
+                                         err, sizeof(err)) &&
+             append_bytes(&data, &size, root_data, root_size);
+        free(root_data);
+        free_nbt_tree(tag);
+    }
+    CHECK(ok, "could not build concatenated roots");
+    if (!ok) {
+        free(data);
+        return;
+    }
+
+    nbt_binary_roots_init(&roots, data, size, NBT_BINARY_BEDROCK);
+    CHECK(nbt_binary_roots_next(&roots, &root, err, sizeof(err)) == 1 && root &&
+          root->type == TAG_Compound, "first concatenated root did not parse");
+    free_nbt_tree(root);
+    CHECK(nbt_binary_roots_next(&roots, NULL, err, sizeof(err)) == 1, "a root could not be skipped");
+    CHECK(nbt_binary_roots_next(&roots, NULL, err, sizeof(err)) == 1 &&
+          nbt_binary_roots_next(&roots, NULL, err, sizeof(err)) == 0 &&
+          roots.count == 3 && roots.offset == size, "root iteration did not end at the buffer end");
+
+    list = nbt_binary_parse_root_list(data, size, NBT_BINARY_BEDROCK, err, sizeof(err));
+    CHECK(list && list->type == TAG_List && list->value.list.count == 3 &&
+          list->value.list.element_type == TAG_Compound, "roots were not listed");
+    CHECK(list && nbt_binary_serialize_root_list(list, NBT_BINARY_BEDROCK, &rewritten,
+                                                 &rewritten_size, err, sizeof(err)) &&
+          rewritten_size == size && memcmp(rewritten, data, size) == 0,
+          "a root list did not serialize back to the same bytes");
+    free(rewritten);
+    rewritten = NULL;
+    if (list && list->value.list.count == 3) {
+        NBTTag* second = list->value.list.items[1];
+        NBTTag* mismatched = nbt_tag_create(TAG_Int, "");
+        list->value.list.items[1] = mismatched;
+        CHECK(!nbt_binary_serialize_root_list(list, NBT_BINARY_BEDROCK, &rewritten, &rewritten_size,
+                                              err, sizeof(err)) && !rewritten,
+              "roots of different types were serialized");
+        list->value.list.items[1] = second;
+        free_nbt_tree(mismatched);
+        while (list->value.list.count > 0) free_nbt_tree(nbt_list_take(list, 0));
+        CHECK(!nbt_binary_serialize_root_list(list, NBT_BINARY_BEDROCK, &rewritten, &rewritten_size,
+                                              err, sizeof(err)) && !rewritten,
+              "an empty root list was serialized");
+    }
+    free_nbt_tree(list);
+
+    nbt_binary_roots_init(&roots, data, size - 1, NBT_BINARY_BEDROCK);
+    while (nbt_binary_roots_next(&roots, NULL, err, sizeof(err)) == 1) {}
+    CHECK(roots.count == 2 && strstr(err, "byte offset"), "a truncated last root was not reported");
+    CHECK(!nbt_binary_parse_root_list(data, size - 1, NBT_BINARY_BEDROCK, err, sizeof(err)),
+          "a truncated root list parsed");
+    free(data);
+}
+
+/* Runs a regex find over {s: text}; returns the match count, or -1 on error. */
+static int regex_matches(const char* pattern, const char* text, int ignore_case) {
+    NBTFindOptions options;
+    NBTFindStats stats = {0, 0};
+    NBTFind* find;
+    NBTTag* root = nbt_tag_create(TAG_Compound, "");
+    NBTTag* string = nbt_tag_create(TAG_String, "s");
+    char err[256] = {0};
+    int result = -1;
+
+    memset(&options, 0, sizeof(options));
+    options.type = -1;
+    options.value_regex = pattern;
+    options.ignore_case = ignore_case;
+    find = nbt_find_compile(&options, err, sizeof(err));
+    if (root && string && find) {
+        free(string->value.string_val);
+        string->value.string_val = nbt_strdup(text);
+        if (nbt_compound_append(root, string)) {
+            string = NULL;
+            if (nbt_find_run(find, root, NULL, NULL, &stats, err, sizeof(err))) result = (int)stats.matched;
+        }
+    }
+    free_nbt_tree(string);
+    free_nbt_tree(root);
+    nbt_find_free(find);
+    return result;
+}
+
+/* Replaces every match of pattern in text; the caller frees the result. */
+static char* regex_replace(const char* pattern, const char* text, const char* replacement) {
+    NBTFindOptions options;
+    NBTFind* find;
+    NBTTag* string = nbt_tag_create(TAG_String, "s");
+    char err[256] = {0};
+    char* result = NULL;
+
+    memset(&options, 0, sizeof(options));
+    options.type = -1;
+    options.value_regex = pattern;
+    options.replace = NBT_REPLACE_TEXT;
+    options.replacement = replacement;
+    find = nbt_find_compile(&options, err, sizeof(err));
+    if (string && find) {
+        free(string->value.string_val);
+        string->value.string_val = nbt_strdup(text);
+        if (nbt_find_run(find, string, NULL, NULL, NULL, err, sizeof(err))) {
+            result = string->value.string_val;
+            string->value.string_val = NULL;
+        }
+    }
+    free_nbt_tree(string);
+    nbt_find_free(find);
+    return result;
+}
+
+static void check_replace(const char* pattern, const char* text, const char* expected) {
+    char* replaced = regex_replace(pattern, text, "-");
+    CHECK(replaced && strcmp(replaced, expected) == 0, pattern);
+    free(replaced);
+}
+
+static void test_find_regex(void) {
+    char long_text[41];
+
+    /* Quantifiers that reach the end of the subject must stop there. */
+    CHECK(regex_matches(".?.?.?", "a", 0) == 1, "optional nodes ran past the end of the text");
+    CHECK(regex_matches(".?.?.?$", "", 0) == 1, "optional nodes failed on an empty subject");
+    CHECK(regex_matches("a*", "", 0) == 1, "a star did not match an empty subject");
+    CHECK(regex_matches("a+", "", 0) == 0, "a plus matched an empty subject");
+    CHECK(regex_matches("x?$", "abc", 0) == 1, "an optional node before $ failed at the end");
+    CHECK(regex_matches("[0-9]+$", "abc123", 0) == 1, "a class repeat did not reach the end");
+    CHECK(regex_matches("c.+", "abc", 0) == 0, "a plus matched past the end of the text");
+
+    /* Anchors. */
+    CHECK(regex_matches("^$", "", 0) == 1, "^$ did not match an empty subject");
+    CHECK(regex_matches("^$", "a", 0) == 0, "^$ matched a non-empty subject");
+    CHECK(regex_matches("^a?$", "a", 0) == 1, "^a?$ did not match a");
+    CHECK(regex_matches("^a?$", "aa", 0) == 0, "^a?$ matched aa");
+    CHECK(regex_matches("^b", "ab", 0) == 0, "^ matched after the start");
+    CHECK(regex_matches("^ABC", "abcd", 1) == 1, "ignore-case anchored match failed");
+    CHECK(regex_matches("^[^a]+$", "AAA", 1) == 0, "an ignore-case negated class accepted a folded letter");
+    CHECK(regex_matches("^[^a-z]+$", "XYZ", 1) == 0, "an ignore-case negated range accepted upper case");
+    CHECK(regex_matches("^[^a]+$", "xyz", 1) == 1, "an ignore-case negated class rejected other letters");
+    CHECK(regex_matches("^[A-C]+$", "abc", 1) == 1, "an ignore-case class did not fold upper case");
+
+    /* Nested stars must not backtrack exponentially on a failing subject. */
+    memset(long_text, 'a', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+    CHECK(regex_matches("a*a*a*a*a*a*a*a*a*a*a*a*a*a*a*a*b", long_text, 0) == 0,
+          "nested stars matched a subject without b");
+
+    /* Replacement spans stay inside the text. */
+    check_replace(".?", "ab", "---");
+    check_replace("b*$", "abb", "a--");
+    check_replace("x*", "", "-");
+    check_replace("^", "ab", "-ab");
+}
+
 int main(void) {
     test_endian_bytes();
     test_snbt_and_binary_round_trips();
     test_invalid_inputs();
+    test_compound_name_index();
+    test_streaming_query();
+    test_lazy_document();
+    test_bedrock_chunk_keys();
+    test_bedrock_subchunk();
+    test_concatenated_roots();
+    test_find_regex();
     if (failures) {
         fprintf(stderr, "%d extended format test(s) failed\n", failures);
         return 1;